@@ -19,6 +19,8 @@
 #include "qgsmapcanvas.h"
 #include "qgsvectorlayer.h"
 #include "qgssettings.h"
+#include "qgsfeatureiterator.h"
+#include "qgsexpression.h"
 
 #include <QTableWidget>
 #include <QAction>
@@ -59,6 +61,10 @@ QList< QgsDateTimeStatisticalSummary::Statistic > QgsStatisticalSummaryDockWidge
   << QgsDateTimeStatisticalSummary::Range;
 
 #define MISSING_VALUES -1
+#define APPROXIMATE_STATISTICS -2
+
+//! Number of features above which statistics requiring all values are approximated, if enabled
+static const long APPROXIMATE_FEATURE_COUNT = 1000000;
 
 QgsExpressionContext QgsStatisticalSummaryDockWidget::createExpressionContext() const
 {
@@ -145,19 +151,53 @@ void QgsStatisticalSummaryDockWidget::refreshStatistics()
   }
 }
 
-void QgsStatisticalSummaryDockWidget::updateNumericStatistics( bool selectedOnly )
+bool QgsStatisticalSummaryDockWidget::readValues( bool selectedOnly, const std::function< void( const QVariant & ) > &addValue )
 {
-  QString sourceFieldExp = mFieldExpressionWidget->currentField();
+  QString fieldOrExpression = mFieldExpressionWidget->currentField();
 
-  bool ok;
-  int missingValues = 0;
-  QList< double > values = mLayer->getDoubleValues( sourceFieldExp, ok, selectedOnly, &missingValues );
+  std::unique_ptr< QgsExpression > expression;
+  QgsExpressionContext context = createExpressionContext();
 
-  if ( ! ok )
+  int attrNum = mLayer->fields().lookupField( fieldOrExpression );
+  if ( attrNum == -1 )
   {
-    return;
+    expression.reset( new QgsExpression( fieldOrExpression ) );
+    if ( expression->hasParserError() || !expression->prepare( &context ) )
+      return false;
   }
 
+  QSet<QString> lst;
+  if ( !expression )
+    lst.insert( fieldOrExpression );
+  else
+    lst = expression->referencedColumns();
+
+  QgsFeatureRequest request = QgsFeatureRequest()
+                              .setFlags( ( expression && expression->needsGeometry() ) ?
+                                         QgsFeatureRequest::NoFlags :
+                                         QgsFeatureRequest::NoGeometry )
+                              .setSubsetOfAttributes( lst, mLayer->fields() );
+  QgsFeatureIterator fit = selectedOnly ? mLayer->getSelectedFeatures( request ) : mLayer->getFeatures( request );
+
+  // values are summarized as they are read, rather than collected first
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    if ( expression )
+    {
+      context.setFeature( f );
+      addValue( expression->evaluate( &context ) );
+    }
+    else
+    {
+      addValue( f.attribute( attrNum ) );
+    }
+  }
+  return true;
+}
+
+void QgsStatisticalSummaryDockWidget::updateNumericStatistics( bool selectedOnly )
+{
   QList< QgsStatisticalSummary::Statistic > statsToDisplay;
   QgsStatisticalSummary::Statistics statsToCalc = 0;
   Q_FOREACH ( QgsStatisticalSummary::Statistic stat, sDisplayStats )
@@ -173,9 +213,20 @@ void QgsStatisticalSummaryDockWidget::updateNumericStatistics( bool selectedOnly
   if ( mStatsActions.value( MISSING_VALUES )->isChecked() )
     extraRows++;
 
+  // large layers would require all values to be stored for the median, quartiles and variety
+  long featureCount = selectedOnly ? mLayer->selectedFeatureCount() : mLayer->featureCount();
+  bool approximate = mStatsActions.value( APPROXIMATE_STATISTICS )->isChecked() && featureCount > APPROXIMATE_FEATURE_COUNT;
+
   QgsStatisticalSummary stats;
   stats.setStatistics( statsToCalc );
-  stats.calculate( values );
+  stats.setApproximate( approximate );
+  stats.reset();
+  if ( !readValues( selectedOnly, [&stats]( const QVariant & value ) { stats.addVariant( value ); } ) )
+  {
+    return;
+  }
+  stats.finalize();
+  int missingValues = stats.countMissing();
 
   mStatisticsTable->setRowCount( statsToDisplay.count() + extraRows );
   mStatisticsTable->setColumnCount( 2 );
@@ -184,7 +235,14 @@ void QgsStatisticalSummaryDockWidget::updateNumericStatistics( bool selectedOnly
   Q_FOREACH ( QgsStatisticalSummary::Statistic stat, statsToDisplay )
   {
     double val = stats.statistic( stat );
-    addRow( row, QgsStatisticalSummary::displayName( stat ),
+    QString name = QgsStatisticalSummary::displayName( stat );
+    if ( approximate && ( stat == QgsStatisticalSummary::Median || stat == QgsStatisticalSummary::FirstQuartile
+                          || stat == QgsStatisticalSummary::ThirdQuartile || stat == QgsStatisticalSummary::InterQuartileRange
+                          || stat == QgsStatisticalSummary::Variety ) )
+    {
+      name = tr( "%1 (approximate)" ).arg( name );
+    }
+    addRow( row, name,
             std::isnan( val ) ? QString() : QString::number( val ),
             stats.count() != 0 );
     row++;
@@ -201,16 +259,6 @@ void QgsStatisticalSummaryDockWidget::updateNumericStatistics( bool selectedOnly
 
 void QgsStatisticalSummaryDockWidget::updateStringStatistics( bool selectedOnly )
 {
-  QString field = mFieldExpressionWidget->currentField();
-
-  bool ok;
-  QVariantList values = mLayer->getValues( field, ok, selectedOnly );
-
-  if ( ! ok )
-  {
-    return;
-  }
-
   QList< QgsStringStatisticalSummary::Statistic > statsToDisplay;
   QgsStringStatisticalSummary::Statistics statsToCalc = 0;
   Q_FOREACH ( QgsStringStatisticalSummary::Statistic stat, sDisplayStringStats )
@@ -224,7 +272,15 @@ void QgsStatisticalSummaryDockWidget::updateStringStatistics( bool selectedOnly
 
   QgsStringStatisticalSummary stats;
   stats.setStatistics( statsToCalc );
-  stats.calculateFromVariants( values );
+  if ( !readValues( selectedOnly, [&stats]( const QVariant & value )
+  {
+    if ( value.type() == QVariant::String )
+      stats.addString( value.toString() );
+  } ) )
+  {
+    return;
+  }
+  stats.finalize();
 
   mStatisticsTable->setRowCount( statsToDisplay.count() );
   mStatisticsTable->setColumnCount( 2 );
@@ -296,6 +352,10 @@ void QgsStatisticalSummaryDockWidget::statActionTriggered( bool checked )
   {
     settings.setValue( QStringLiteral( "StatisticalSummaryDock/numeric_missing_values" ), checked );
   }
+  else if ( stat == APPROXIMATE_STATISTICS )
+  {
+    settings.setValue( QStringLiteral( "StatisticalSummaryDock/numeric_approximate" ), checked );
+  }
 
   refreshStatistics();
 }
@@ -317,16 +377,6 @@ void QgsStatisticalSummaryDockWidget::layerSelectionChanged()
 
 void QgsStatisticalSummaryDockWidget::updateDateTimeStatistics( bool selectedOnly )
 {
-  QString field = mFieldExpressionWidget->currentField();
-
-  bool ok;
-  QVariantList values = mLayer->getValues( field, ok, selectedOnly );
-
-  if ( ! ok )
-  {
-    return;
-  }
-
   QList< QgsDateTimeStatisticalSummary::Statistic > statsToDisplay;
   QgsDateTimeStatisticalSummary::Statistics statsToCalc = 0;
   Q_FOREACH ( QgsDateTimeStatisticalSummary::Statistic stat, sDisplayDateTimeStats )
@@ -341,7 +391,11 @@ void QgsStatisticalSummaryDockWidget::updateDateTimeStatistics( bool selectedOnl
 
   QgsDateTimeStatisticalSummary stats;
   stats.setStatistics( statsToCalc );
-  stats.calculate( values );
+  if ( !readValues( selectedOnly, [&stats]( const QVariant & value ) { stats.addValue( value ); } ) )
+  {
+    return;
+  }
+  stats.finalize();
 
   mStatisticsTable->setRowCount( statsToDisplay.count() );
   mStatisticsTable->setColumnCount( 2 );
@@ -410,6 +464,16 @@ void QgsStatisticalSummaryDockWidget::refreshStatisticsMenu()
       connect( nullCountAction, &QAction::toggled, this, &QgsStatisticalSummaryDockWidget::statActionTriggered );
       mStatisticsMenu->addAction( nullCountAction );
 
+      //approximate the statistics which require all values to be stored, for large layers
+      mStatisticsMenu->addSeparator();
+      QAction *approximateAction = new QAction( tr( "Approximate Median, Quartiles and Variety for Large Layers" ), mStatisticsMenu );
+      approximateAction->setCheckable( true );
+      approximateAction->setChecked( settings.value( QStringLiteral( "StatisticalSummaryDock/numeric_approximate" ), true ).toBool() );
+      approximateAction->setData( APPROXIMATE_STATISTICS );
+      mStatsActions.insert( APPROXIMATE_STATISTICS, approximateAction );
+      connect( approximateAction, &QAction::toggled, this, &QgsStatisticalSummaryDockWidget::statActionTriggered );
+      mStatisticsMenu->addAction( approximateAction );
+
       break;
     }
     case DataType::String:
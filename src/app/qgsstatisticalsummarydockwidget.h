@@ -16,6 +16,7 @@
 #define QGSSTATISTICALSUMMARYDOCKWIDGET_H
 
 #include <QMap>
+#include <functional>
 #include "ui_qgsstatisticalsummarybase.h"
 
 #include "qgsstatisticalsummary.h"
@@ -77,6 +78,11 @@ class APP_EXPORT QgsStatisticalSummaryDockWidget : public QgsDockWidget, private
     static QList< QgsStringStatisticalSummary::Statistic > sDisplayStringStats;
     static QList< QgsDateTimeStatisticalSummary::Statistic > sDisplayDateTimeStats;
 
+    /** Reads the values of the current field or expression, passing each value to \a addValue.
+     * Returns false if the values could not be read.
+     */
+    bool readValues( bool selectedOnly, const std::function< void( const QVariant & ) > &addValue );
+
     void updateNumericStatistics( bool selectedOnly );
     void updateStringStatistics( bool selectedOnly );
     void updateDateTimeStatistics( bool selectedOnly );
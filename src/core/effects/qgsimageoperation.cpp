@@ -23,14 +23,49 @@
 #include <QColor>
 #include <QPainter>
 
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define HAVE_SSE2_BLUR
+#endif
+
 //determined via trial-and-error. Could possibly be optimised, or varied
 //depending on the image size.
 #define BLOCK_THREADS 16
 
+//minimum number of kernel taps (pixels * kernel size) before a blur is
+//split across threads
+#define BLUR_THREAD_THRESHOLD 400000
+
 #define INF 1E20
 
 /// @cond PRIVATE
 
+#ifdef HAVE_SSE2_BLUR
+
+//only the stack and gaussian blurs have SSE2 paths. The per pixel colour and alpha
+//operations (grayscale, brightness/contrast, hue/saturation, opacity, overlay) are
+//dominated by their per pixel branching and QColor conversions, so they stay scalar.
+
+//unpacks a single ARGB32 pixel into four 32 bit integer lanes (in memory order, ie BGRA)
+static inline __m128i loadPixelEpi32( const unsigned char *ref )
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i pixel = _mm_cvtsi32_si128( static_cast< int >( *reinterpret_cast< const QRgb * >( ref ) ) );
+  pixel = _mm_unpacklo_epi8( pixel, zero );
+  return _mm_unpacklo_epi16( pixel, zero );
+}
+
+//packs four float lanes (in memory order) back into an ARGB32 pixel, truncating
+static inline QRgb storePixelPs( const __m128 pixel )
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i result = _mm_cvttps_epi32( pixel );
+  result = _mm_packus_epi16( _mm_packs_epi32( result, zero ), zero );
+  return static_cast< QRgb >( _mm_cvtsi128_si32( result ) );
+}
+
+#endif
+
 template <typename PixelOperation>
 void QgsImageOperation::runPixelOperation( QImage &image, PixelOperation &operation )
 {
@@ -609,6 +644,32 @@ void QgsImageOperation::StackBlurLineOperation::operator()( QRgb *startRef, cons
     increment = -increment;
   }
 
+#ifdef HAVE_SSE2_BLUR
+  if ( mi1 == 0 && mi2 == 3 )
+  {
+    //all four channels at once. The running sums and differences always fit in 16 bits,
+    //so _mm_madd_epi16 against a zero extended alpha gives the exact 32 bit product
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi32( mAlpha );
+    const __m128i fifteen = _mm_set1_epi32( 15 );
+    __m128i sum = _mm_slli_epi32( loadPixelEpi32( p ), 4 );
+
+    p += increment;
+    for ( int j = 1; j < lineLength; ++j, p += increment )
+    {
+      __m128i diff = _mm_sub_epi32( _mm_slli_epi32( loadPixelEpi32( p ), 4 ), sum );
+      __m128i product = _mm_madd_epi16( diff, alpha );
+      //integer division by 16, rounding towards zero to match the scalar code
+      product = _mm_srai_epi32( _mm_add_epi32( product, _mm_and_si128( _mm_srai_epi32( product, 31 ), fifteen ) ), 4 );
+      sum = _mm_add_epi32( sum, product );
+      __m128i result = _mm_srai_epi32( sum, 4 );
+      result = _mm_packus_epi16( _mm_packs_epi32( result, zero ), zero );
+      *reinterpret_cast< int * >( p ) = _mm_cvtsi128_si32( result );
+    }
+    return;
+  }
+#endif
+
   for ( int i = mi1; i <= mi2; ++i )
   {
     rgba[i] = p[i] << 4;
@@ -638,7 +699,7 @@ QImage *QgsImageOperation::gaussianBlur( QImage &image, const int radius )
     return copy;
   }
 
-  double *kernel = createGaussianKernel( radius );
+  float *kernel = createGaussianKernel( radius );
 
   //ensure correct source format.
   QImage::Format originalFormat = image.format();
@@ -648,15 +709,25 @@ QImage *QgsImageOperation::gaussianBlur( QImage &image, const int radius )
     pImage = new QImage( image.convertToFormat( QImage::Format_ARGB32_Premultiplied ) );
   }
 
+  //the cost of each pass grows with the radius, so large radii are worth
+  //threading even for images which are too small for the per pixel operations
+  bool multiThread = static_cast< qint64 >( width ) * height * ( 2 * radius + 1 ) >= BLUR_THREAD_THRESHOLD;
+
   //blur along rows
   QImage xBlurImage = QImage( width, height, QImage::Format_ARGB32_Premultiplied );
   GaussianBlurOperation rowBlur( radius, QgsImageOperation::ByRow, &xBlurImage, kernel );
-  runRectOperation( *pImage, rowBlur );
+  if ( multiThread )
+    runBlockOperationInThreads( *pImage, rowBlur, ByRow );
+  else
+    runRectOperationOnWholeImage( *pImage, rowBlur );
 
   //blur along columns
   QImage *yBlurImage = new QImage( width, height, QImage::Format_ARGB32_Premultiplied );
   GaussianBlurOperation colBlur( radius, QgsImageOperation::ByColumn, yBlurImage, kernel );
-  runRectOperation( xBlurImage, colBlur );
+  if ( multiThread )
+    runBlockOperationInThreads( xBlurImage, colBlur, ByRow );
+  else
+    runRectOperationOnWholeImage( xBlurImage, colBlur );
 
   delete[] kernel;
 
@@ -691,7 +762,7 @@ void QgsImageOperation::GaussianBlurOperation::operator()( QgsImageOperation::Im
       destRef = reinterpret_cast< QRgb * >( outputLineRef );
       for ( int x = 0; x < width; ++x, ++destRef, sourceRef += 4 )
       {
-        *destRef = gaussianBlurVertical( y, sourceRef, sourceBpl, height );
+        *destRef = blurPixel( y, sourceRef, sourceBpl, height );
       }
     }
   }
@@ -703,62 +774,46 @@ void QgsImageOperation::GaussianBlurOperation::operator()( QgsImageOperation::Im
       destRef = reinterpret_cast< QRgb * >( outputLineRef );
       for ( int x = 0; x < width; ++x, ++destRef )
       {
-        *destRef = gaussianBlurHorizontal( x, sourceRef, width );
+        *destRef = blurPixel( x, sourceRef, 4, width );
       }
     }
   }
 }
 
-inline QRgb QgsImageOperation::GaussianBlurOperation::gaussianBlurVertical( const int posy, unsigned char *sourceFirstLine, const int sourceBpl, const int height )
+inline QRgb QgsImageOperation::GaussianBlurOperation::blurPixel( const int pos, const unsigned char *sourceFirst, const int stride, const int length )
 {
-  double r = 0;
-  double b = 0;
-  double g = 0;
-  double a = 0;
-  int y;
-  unsigned char *ref;
+  //pixels which are further than radius from the image edge don't need clamping
+  const bool interior = pos >= mRadius && pos + mRadius < length;
+  const unsigned char *ref = interior ? sourceFirst + ( pos - mRadius ) * stride : nullptr;
 
+#ifdef HAVE_SSE2_BLUR
+  __m128 sum = _mm_setzero_ps();
   for ( int i = 0; i <= mRadius * 2; ++i )
   {
-    y = qBound( 0, posy + ( i - mRadius ), height - 1 );
-    ref = sourceFirstLine + sourceBpl * y;
-
-    QRgb *refRgb = reinterpret_cast< QRgb * >( ref );
-    r += mKernel[i] * qRed( *refRgb );
-    g += mKernel[i] * qGreen( *refRgb );
-    b += mKernel[i] * qBlue( *refRgb );
-    a += mKernel[i] * qAlpha( *refRgb );
+    const unsigned char *tapRef = interior ? ref + i * stride : sourceFirst + qBound( 0, pos + ( i - mRadius ), length - 1 ) * stride;
+    sum = _mm_add_ps( sum, _mm_mul_ps( _mm_cvtepi32_ps( loadPixelEpi32( tapRef ) ), _mm_set1_ps( mKernel[i] ) ) );
   }
-
-  return qRgba( r, g, b, a );
-}
-
-inline QRgb QgsImageOperation::GaussianBlurOperation::gaussianBlurHorizontal( const int posx, unsigned char *sourceFirstLine, const int width )
-{
-  double r = 0;
-  double b = 0;
-  double g = 0;
-  double a = 0;
-  int x;
-  unsigned char *ref;
-
+  return storePixelPs( sum );
+#else
+  float r = 0;
+  float g = 0;
+  float b = 0;
+  float a = 0;
   for ( int i = 0; i <= mRadius * 2; ++i )
   {
-    x = qBound( 0, posx + ( i - mRadius ), width - 1 );
-    ref = sourceFirstLine + x * 4;
-
-    QRgb *refRgb = reinterpret_cast< QRgb * >( ref );
-    r += mKernel[i] * qRed( *refRgb );
-    g += mKernel[i] * qGreen( *refRgb );
-    b += mKernel[i] * qBlue( *refRgb );
-    a += mKernel[i] * qAlpha( *refRgb );
+    const unsigned char *tapRef = interior ? ref + i * stride : sourceFirst + qBound( 0, pos + ( i - mRadius ), length - 1 ) * stride;
+    QRgb tap = *reinterpret_cast< const QRgb * >( tapRef );
+    r += mKernel[i] * qRed( tap );
+    g += mKernel[i] * qGreen( tap );
+    b += mKernel[i] * qBlue( tap );
+    a += mKernel[i] * qAlpha( tap );
   }
-
   return qRgba( r, g, b, a );
+#endif
 }
 
 
-double *QgsImageOperation::createGaussianKernel( const int radius )
+float *QgsImageOperation::createGaussianKernel( const int radius )
 {
   double *kernel = new double[ radius * 2 + 1 ];
   double sigma = radius / 3.0;
@@ -779,12 +834,15 @@ double *QgsImageOperation::createGaussianKernel( const int radius )
       sum += result;
     }
   }
-  //normalize
+  //normalize. The kernel is stored as float so that the SSE2 taps can use it directly,
+  //which means blurred pixels may differ by a single level from a double precision kernel
+  float *normalizedKernel = new float[ radius * 2 + 1 ];
   for ( int i = 0; i <= radius * 2; ++i )
   {
-    kernel[i] /= sum;
+    normalizedKernel[i] = kernel[i] / sum;
   }
-  return kernel;
+  delete[] kernel;
+  return normalizedKernel;
 }
 
 
@@ -416,12 +416,12 @@ class CORE_EXPORT QgsImageOperation
         int mi2;
     };
 
-    static double *createGaussianKernel( const int radius );
+    static float *createGaussianKernel( const int radius );
 
     class GaussianBlurOperation
     {
       public:
-        GaussianBlurOperation( int radius, LineOperationDirection direction, QImage *destImage, double *kernel )
+        GaussianBlurOperation( int radius, LineOperationDirection direction, QImage *destImage, float *kernel )
           : mRadius( radius )
           , mDirection( direction )
           , mDestImage( destImage )
@@ -438,10 +438,12 @@ class CORE_EXPORT QgsImageOperation
         LineOperationDirection mDirection;
         QImage *mDestImage = nullptr;
         int mDestImageBpl;
-        double *mKernel = nullptr;
+        float *mKernel = nullptr;
 
-        inline QRgb gaussianBlurVertical( const int posy, unsigned char *sourceFirstLine, const int sourceBpl, const int height );
-        inline QRgb gaussianBlurHorizontal( const int posx, unsigned char *sourceFirstLine, const int width );
+        /** Blurs a single pixel, using the pixels spaced stride bytes apart from sourceFirst.
+         * pos is the index of the pixel along the line, and length the number of pixels in the line.
+         */
+        inline QRgb blurPixel( const int pos, const unsigned char *sourceFirst, const int stride, const int length );
     };
 
     //flip
@@ -32,6 +32,7 @@
 #include "qgsogcutils.h"
 #include "qgsdistancearea.h"
 #include "qgsgeometryengine.h"
+#include "qgspreparedgeometrycache.h"
 #include "qgsexpressionsorter.h"
 #include "qgssymbollayerutils.h"
 #include "qgsstyle.h"
@@ -42,6 +43,8 @@
 #include "qgsrasterbandstats.h"
 #include "qgscolorramp.h"
 
+#include <QThreadStorage>
+
 const QString QgsExpressionFunction::helpText() const
 {
   return mHelpText.isEmpty() ? QgsExpression::helpText( mName ) : mHelpText;
@@ -2397,47 +2400,86 @@ static QVariant fcnBbox( const QVariantList &values, const QgsExpressionContext
   QgsGeometry sGeom = QgsExpressionUtils::getGeometry( values.at( 1 ), parent );
   return fGeom.intersects( sGeom.boundingBox() ) ? TVL_True : TVL_False;
 }
-static QVariant fcnDisjoint( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
+/**
+ * Per thread state for expression spatial predicates. Predicates are frequently evaluated
+ * for every feature against the same (static) geometry, which then only needs to be
+ * converted and prepared once. The operands of the previous evaluation are kept to detect
+ * which operand is constant, so that per feature geometries don't flush the cache.
+ */
+struct SpatialPredicateCache
+{
+  QgsPreparedGeometryCache engines{ 4 };
+  QgsGeometry lastFirst;
+  QgsGeometry lastSecond;
+};
+static QThreadStorage< SpatialPredicateCache * > sPredicateGeometryCache;
+
+/**
+ * Tests a spatial \a predicate between the two geometries in \a values. The \a reversedPredicate
+ * is used if the test is made from the second geometry against the first one.
+ */
+static QVariant testSpatialPredicate( const QVariantList &values, QgsExpression *parent, QgsGeometryEngine::SpatialPredicate predicate, QgsGeometryEngine::SpatialPredicate reversedPredicate )
 {
   QgsGeometry fGeom = QgsExpressionUtils::getGeometry( values.at( 0 ), parent );
   QgsGeometry sGeom = QgsExpressionUtils::getGeometry( values.at( 1 ), parent );
-  return fGeom.disjoint( sGeom ) ? TVL_True : TVL_False;
+  if ( fGeom.isNull() || sGeom.isNull() )
+    return TVL_False;
+
+  if ( !sPredicateGeometryCache.hasLocalData() )
+    sPredicateGeometryCache.setLocalData( new SpatialPredicateCache() );
+  SpatialPredicateCache *cache = sPredicateGeometryCache.localData();
+
+  // an operand is constant if it shares its geometry with the previous evaluation. The copies
+  // kept in the cache hold the previous geometries alive, so their addresses can't be reused.
+  const bool firstConstant = cache->lastFirst.geometry() == fGeom.geometry();
+  const bool secondConstant = cache->lastSecond.geometry() == sGeom.geometry();
+  cache->lastFirst = fGeom;
+  cache->lastSecond = sGeom;
+
+  // the constant geometry is usually the second argument, e.g. intersects( $geometry, geom_from_wkt( ... ) )
+  if ( secondConstant )
+  {
+    if ( QgsGeometryEngine *engine = cache->engines.engine( sGeom ) )
+      return engine->testPredicates( fGeom.geometry(), reversedPredicate ) ? TVL_True : TVL_False;
+  }
+  else if ( firstConstant )
+  {
+    if ( QgsGeometryEngine *engine = cache->engines.engine( fGeom ) )
+      return engine->testPredicates( sGeom.geometry(), predicate ) ? TVL_True : TVL_False;
+  }
+
+  // no constant operand (or no cached engine) - use an unprepared engine
+  std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( fGeom.geometry() ) );
+  return engine->testPredicates( sGeom.geometry(), predicate ) ? TVL_True : TVL_False;
+}
+
+static QVariant fcnDisjoint( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
+{
+  return testSpatialPredicate( values, parent, QgsGeometryEngine::Disjoint, QgsGeometryEngine::Disjoint );
 }
 static QVariant fcnIntersects( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
 {
-  QgsGeometry fGeom = QgsExpressionUtils::getGeometry( values.at( 0 ), parent );
-  QgsGeometry sGeom = QgsExpressionUtils::getGeometry( values.at( 1 ), parent );
-  return fGeom.intersects( sGeom ) ? TVL_True : TVL_False;
+  return testSpatialPredicate( values, parent, QgsGeometryEngine::Intersects, QgsGeometryEngine::Intersects );
 }
 static QVariant fcnTouches( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
 {
-  QgsGeometry fGeom = QgsExpressionUtils::getGeometry( values.at( 0 ), parent );
-  QgsGeometry sGeom = QgsExpressionUtils::getGeometry( values.at( 1 ), parent );
-  return fGeom.touches( sGeom ) ? TVL_True : TVL_False;
+  return testSpatialPredicate( values, parent, QgsGeometryEngine::Touches, QgsGeometryEngine::Touches );
 }
 static QVariant fcnCrosses( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
 {
-  QgsGeometry fGeom = QgsExpressionUtils::getGeometry( values.at( 0 ), parent );
-  QgsGeometry sGeom = QgsExpressionUtils::getGeometry( values.at( 1 ), parent );
-  return fGeom.crosses( sGeom ) ? TVL_True : TVL_False;
+  return testSpatialPredicate( values, parent, QgsGeometryEngine::Crosses, QgsGeometryEngine::Crosses );
 }
 static QVariant fcnContains( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
 {
-  QgsGeometry fGeom = QgsExpressionUtils::getGeometry( values.at( 0 ), parent );
-  QgsGeometry sGeom = QgsExpressionUtils::getGeometry( values.at( 1 ), parent );
-  return fGeom.contains( sGeom ) ? TVL_True : TVL_False;
+  return testSpatialPredicate( values, parent, QgsGeometryEngine::Contains, QgsGeometryEngine::Within );
 }
 static QVariant fcnOverlaps( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
 {
-  QgsGeometry fGeom = QgsExpressionUtils::getGeometry( values.at( 0 ), parent );
-  QgsGeometry sGeom = QgsExpressionUtils::getGeometry( values.at( 1 ), parent );
-  return fGeom.overlaps( sGeom ) ? TVL_True : TVL_False;
+  return testSpatialPredicate( values, parent, QgsGeometryEngine::Overlaps, QgsGeometryEngine::Overlaps );
 }
 static QVariant fcnWithin( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
 {
-  QgsGeometry fGeom = QgsExpressionUtils::getGeometry( values.at( 0 ), parent );
-  QgsGeometry sGeom = QgsExpressionUtils::getGeometry( values.at( 1 ), parent );
-  return fGeom.within( sGeom ) ? TVL_True : TVL_False;
+  return testSpatialPredicate( values, parent, QgsGeometryEngine::Within, QgsGeometryEngine::Contains );
 }
 static QVariant fcnBuffer( const QVariantList &values, const QgsExpressionContext *, QgsExpression *parent )
 {
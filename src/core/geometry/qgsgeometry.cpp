@@ -18,6 +18,8 @@ email                : morb at ozemail dot com dot au
 #include <cstdio>
 #include <cmath>
 
+#include <QSharedPointer>
+
 #include "qgis.h"
 #include "qgsgeometry.h"
 #include "qgsgeometryeditutils.h"
@@ -32,6 +34,7 @@ email                : morb at ozemail dot com dot au
 #include "qgsmessagelog.h"
 #include "qgspointxy.h"
 #include "qgsrectangle.h"
+#include "qgswkbptr.h"
 
 #include "qgsvectorlayer.h"
 #include "qgsgeometryvalidator.h"
@@ -48,12 +51,341 @@ email                : morb at ozemail dot com dot au
 
 struct QgsGeometryPrivate
 {
-  QgsGeometryPrivate(): ref( 1 ), geometry( nullptr ) {}
-  ~QgsGeometryPrivate() { delete geometry; }
+  QgsGeometryPrivate(): ref( 1 ) {}
+  ~QgsGeometryPrivate() { delete mGeometry.load(); }
   QAtomicInt ref;
-  QgsAbstractGeometry *geometry = nullptr;
+
+  /**
+   * WKB the geometry was created from. Until the geometry is parsed the type, bounding
+   * box and vertices are read directly from these bytes.
+   */
+  QByteArray wkb;
+  //! Owner of the bytes of wkb, if it wraps a buffer passed to QgsGeometry::fromWkb() without copying it
+  QSharedPointer< unsigned char > wkbBuffer;
+  //! Size of the geometry within wkb, in bytes
+  int wkbSize = 0;
+  //! Geometry type read from wkb
+  QgsWkbTypes::Type wkbType = QgsWkbTypes::Unknown;
+  //! True if wkb uses the native byte order throughout, so it can be exported as is
+  bool wkbIsNative = false;
+  //! True if the geometry within wkb is empty
+  bool wkbIsEmpty = false;
+
+  /**
+   * Returns true if the geometry is still only stored as WKB.
+   */
+  bool hasUnparsedWkb() const
+  {
+    return !mGeometry.loadAcquire() && !wkb.isEmpty();
+  }
+
+  /**
+   * Returns the geometry, parsing the stored WKB first if required.
+   */
+  QgsAbstractGeometry *geometry() const
+  {
+    QgsAbstractGeometry *geom = mGeometry.loadAcquire();
+    if ( geom || wkb.isEmpty() )
+      return geom;
+
+    QgsConstWkbPtr ptr( wkb );
+    geom = QgsGeometryFactory::geomFromWkb( ptr ).release();
+    if ( !mGeometry.testAndSetOrdered( nullptr, geom ) )
+    {
+      // another thread sharing this geometry parsed it first
+      delete geom;
+      geom = mGeometry.loadAcquire();
+    }
+    return geom;
+  }
+
+  /**
+   * Replaces the geometry with \a geom, deleting the existing geometry and any stored WKB.
+   */
+  void reset( QgsAbstractGeometry *geom )
+  {
+    delete mGeometry.fetchAndStoreOrdered( geom );
+    wkb.clear();
+    wkbBuffer.clear();
+    wkbSize = 0;
+    wkbType = QgsWkbTypes::Unknown;
+  }
+
+  /**
+   * Releases ownership of the geometry, leaving this null.
+   */
+  QgsAbstractGeometry *take()
+  {
+    QgsAbstractGeometry *geom = geometry();
+    mGeometry.store( nullptr );
+    reset( nullptr );
+    return geom;
+  }
+
+  private:
+
+    mutable QAtomicPointer< QgsAbstractGeometry > mGeometry;
 };
 
+/**
+ * Returns true if geometries of \a type can be stored as unparsed WKB. Only
+ * the simple feature types, which make up the bulk of the geometries read
+ * from providers, are handled.
+ */
+static bool isLazyWkbType( QgsWkbTypes::Type type )
+{
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    case QgsWkbTypes::LineString:
+    case QgsWkbTypes::Polygon:
+    case QgsWkbTypes::MultiPoint:
+    case QgsWkbTypes::MultiLineString:
+    case QgsWkbTypes::MultiPolygon:
+      return true;
+    default:
+      return false;
+  }
+}
+
+//! Skips over a sequence of points, throwing QgsWkbException if the count is invalid
+static void skipWkbPoints( QgsConstWkbPtr &wkbPtr, int coordBytes, bool &isEmpty )
+{
+  int nPoints = 0;
+  wkbPtr >> nPoints;
+  if ( nPoints < 0 || nPoints > wkbPtr.remaining() / coordBytes )
+    throw QgsWkbException( QStringLiteral( "invalid point count" ) );
+  wkbPtr += nPoints * coordBytes;
+  isEmpty = nPoints == 0;
+}
+
+/**
+ * Walks over a WKB geometry without parsing it, checking that it is well formed, only uses
+ * types handled by isLazyWkbType() and that each part is of the type expected
+ * by its collection. Throws QgsWkbException on invalid WKB.
+ */
+static bool scanWkb( QgsConstWkbPtr &wkbPtr, QgsWkbTypes::Type expectedType, bool &isNative, bool &isEmpty )
+{
+  if ( wkbPtr.remaining() < 1 )
+    return false;
+  if ( *static_cast< const unsigned char * >( wkbPtr ) != QgsApplication::endian() )
+    isNative = false;
+
+  QgsWkbTypes::Type type = wkbPtr.readHeader();
+  if ( !isLazyWkbType( type ) || ( expectedType != QgsWkbTypes::Unknown && type != expectedType ) )
+    return false;
+
+  const int coordBytes = QgsWkbTypes::coordDimensions( type ) * sizeof( double );
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+      wkbPtr += coordBytes;
+      isEmpty = false;
+      return true;
+
+    case QgsWkbTypes::LineString:
+      skipWkbPoints( wkbPtr, coordBytes, isEmpty );
+      return true;
+
+    case QgsWkbTypes::Polygon:
+    {
+      int nRings = 0;
+      wkbPtr >> nRings;
+      isEmpty = true;
+      for ( int i = 0; i < nRings; ++i )
+      {
+        bool ringIsEmpty = false;
+        skipWkbPoints( wkbPtr, coordBytes, ringIsEmpty );
+        // emptiness only depends on the exterior ring
+        if ( i == 0 )
+          isEmpty = ringIsEmpty;
+      }
+      return true;
+    }
+
+    default:
+    {
+      int nParts = 0;
+      wkbPtr >> nParts;
+      isEmpty = true;
+      const QgsWkbTypes::Type partType = QgsWkbTypes::singleType( type );
+      for ( int i = 0; i < nParts; ++i )
+      {
+        bool partIsEmpty = false;
+        if ( !scanWkb( wkbPtr, partType, isNative, partIsEmpty ) )
+          return false;
+        isEmpty = isEmpty && partIsEmpty;
+      }
+      return true;
+    }
+  }
+}
+
+//! Returns the bounding box of a sequence of points, matching QgsLineString::calculateBoundingBox()
+static QgsRectangle wkbPointsBoundingBox( QgsConstWkbPtr &wkbPtr, int coordBytes )
+{
+  double xmin = std::numeric_limits<double>::max();
+  double ymin = std::numeric_limits<double>::max();
+  double xmax = -std::numeric_limits<double>::max();
+  double ymax = -std::numeric_limits<double>::max();
+
+  int nPoints = 0;
+  wkbPtr >> nPoints;
+  const int skip = coordBytes - 2 * sizeof( double );
+  double x, y;
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    wkbPtr >> x >> y;
+    if ( skip )
+      wkbPtr += skip;
+    if ( x < xmin )
+      xmin = x;
+    if ( x > xmax )
+      xmax = x;
+    if ( y < ymin )
+      ymin = y;
+    if ( y > ymax )
+      ymax = y;
+  }
+  return QgsRectangle( xmin, ymin, xmax, ymax );
+}
+
+/**
+ * Calculates the bounding box of a WKB geometry previously checked by scanWkb(),
+ * giving the same result as the bounding box of the parsed geometry.
+ */
+static QgsRectangle wkbBoundingBox( QgsConstWkbPtr &wkbPtr )
+{
+  QgsWkbTypes::Type type = wkbPtr.readHeader();
+  const int coordBytes = QgsWkbTypes::coordDimensions( type ) * sizeof( double );
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    {
+      double x, y;
+      wkbPtr >> x >> y;
+      wkbPtr += coordBytes - 2 * sizeof( double );
+      return QgsRectangle( x, y, x, y );
+    }
+
+    case QgsWkbTypes::LineString:
+      return wkbPointsBoundingBox( wkbPtr, coordBytes );
+
+    case QgsWkbTypes::Polygon:
+    {
+      int nRings = 0;
+      wkbPtr >> nRings;
+      if ( nRings < 1 )
+        return QgsRectangle();
+
+      // only the exterior ring contributes to the bounds
+      QgsRectangle bbox = wkbPointsBoundingBox( wkbPtr, coordBytes );
+      for ( int i = 1; i < nRings; ++i )
+      {
+        int nPoints = 0;
+        wkbPtr >> nPoints;
+        wkbPtr += nPoints * coordBytes;
+      }
+      return bbox;
+    }
+
+    default:
+    {
+      int nParts = 0;
+      wkbPtr >> nParts;
+      if ( nParts < 1 )
+        return QgsRectangle();
+
+      QgsRectangle bbox = wkbBoundingBox( wkbPtr );
+      for ( int i = 1; i < nParts; ++i )
+      {
+        bbox.combineExtentWith( wkbBoundingBox( wkbPtr ) );
+      }
+      return bbox;
+    }
+  }
+}
+
+//! Returns the type of the vertices of a geometry, matching QgsPoint and QgsLineString::pointN()
+static QgsWkbTypes::Type wkbVertexType( QgsWkbTypes::Type type )
+{
+  switch ( type )
+  {
+    case QgsWkbTypes::Point25D:
+    case QgsWkbTypes::LineString25D:
+    case QgsWkbTypes::Polygon25D:
+      return QgsWkbTypes::Point25D;
+    default:
+      return QgsWkbTypes::zmType( QgsWkbTypes::Point, QgsWkbTypes::hasZ( type ), QgsWkbTypes::hasM( type ) );
+  }
+}
+
+/**
+ * Finds a vertex in a WKB geometry previously checked by scanWkb(). \a vertex is
+ * the number of the vertex to find, and is decreased by the number of vertices skipped
+ * over. Returns true if the vertex was found.
+ */
+static bool wkbVertexAt( QgsConstWkbPtr &wkbPtr, int &vertex, QgsPoint &point )
+{
+  QgsWkbTypes::Type type = wkbPtr.readHeader();
+  const int coordBytes = QgsWkbTypes::coordDimensions( type ) * sizeof( double );
+  const bool hasZ = QgsWkbTypes::hasZ( type );
+  const bool hasM = QgsWkbTypes::hasM( type );
+
+  int nRings = 1;
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+      break;
+
+    case QgsWkbTypes::Polygon:
+      wkbPtr >> nRings;
+      break;
+
+    case QgsWkbTypes::LineString:
+      break;
+
+    default:
+    {
+      int nParts = 0;
+      wkbPtr >> nParts;
+      for ( int i = 0; i < nParts; ++i )
+      {
+        if ( wkbVertexAt( wkbPtr, vertex, point ) )
+          return true;
+      }
+      return false;
+    }
+  }
+
+  for ( int ring = 0; ring < nRings; ++ring )
+  {
+    int nPoints = 1;
+    if ( QgsWkbTypes::flatType( type ) != QgsWkbTypes::Point )
+      wkbPtr >> nPoints;
+
+    if ( vertex >= nPoints )
+    {
+      vertex -= nPoints;
+      wkbPtr += nPoints * coordBytes;
+      continue;
+    }
+
+    wkbPtr += vertex * coordBytes;
+    double x, y;
+    double z = std::numeric_limits<double>::quiet_NaN();
+    double m = std::numeric_limits<double>::quiet_NaN();
+    wkbPtr >> x >> y;
+    if ( hasZ )
+      wkbPtr >> z;
+    if ( hasM )
+      wkbPtr >> m;
+    point = QgsPoint( wkbVertexType( type ), x, y, z, m );
+    return true;
+  }
+  return false;
+}
+
 QgsGeometry::QgsGeometry()
   : d( new QgsGeometryPrivate() )
 {
@@ -67,7 +399,7 @@ QgsGeometry::~QgsGeometry()
 
 QgsGeometry::QgsGeometry( QgsAbstractGeometry *geom ): d( new QgsGeometryPrivate() )
 {
-  d->geometry = geom;
+  d->reset( geom );
   d->ref = QAtomicInt( 1 );
 }
 
@@ -96,43 +428,58 @@ void QgsGeometry::detach( bool cloneGeom )
   if ( d->ref > 1 )
   {
     ( void )d->ref.deref();
-    QgsAbstractGeometry *cGeom = nullptr;
+    QgsGeometryPrivate *old = d;
+    d = new QgsGeometryPrivate();
 
-    if ( d->geometry && cloneGeom )
+    if ( cloneGeom )
     {
-      cGeom = d->geometry->clone();
+      if ( old->hasUnparsedWkb() )
+      {
+        // sharing the wkb is cheaper than parsing and cloning the geometry
+        d->wkb = old->wkb;
+        d->wkbBuffer = old->wkbBuffer;
+        d->wkbSize = old->wkbSize;
+        d->wkbType = old->wkbType;
+        d->wkbIsNative = old->wkbIsNative;
+        d->wkbIsEmpty = old->wkbIsEmpty;
+      }
+      else if ( old->geometry() )
+      {
+        d->reset( old->geometry()->clone() );
+      }
     }
+  }
 
-    d = new QgsGeometryPrivate();
-    d->geometry = cGeom;
+  if ( cloneGeom && d->hasUnparsedWkb() )
+  {
+    // the geometry is about to be modified, so the wkb will no longer match it
+    QgsAbstractGeometry *geom = d->take();
+    d->reset( geom );
   }
 }
 
 QgsAbstractGeometry *QgsGeometry::geometry() const
 {
-  return d->geometry;
+  return d->geometry();
 }
 
 void QgsGeometry::setGeometry( QgsAbstractGeometry *geometry )
 {
-  if ( d->geometry == geometry )
+  if ( !d->hasUnparsedWkb() && d->geometry() == geometry )
   {
     return;
   }
 
   detach( false );
-  if ( d->geometry )
-  {
-    delete d->geometry;
-    d->geometry = nullptr;
-  }
-
-  d->geometry = geometry;
+  d->reset( geometry );
 }
 
 bool QgsGeometry::isNull() const
 {
-  return !d->geometry;
+  if ( d->hasUnparsedWkb() )
+    return false;
+
+  return !d->geometry();
 }
 
 QgsGeometry QgsGeometry::fromWkt( const QString &wkt )
@@ -242,92 +589,122 @@ QgsGeometry QgsGeometry::collectGeometry( const QList< QgsGeometry > &geometries
 
 void QgsGeometry::fromWkb( unsigned char *wkb, int length )
 {
-  detach( false );
-
-  if ( d->geometry )
-  {
-    delete d->geometry;
-  }
-  QgsConstWkbPtr ptr( wkb, length );
-  d->geometry = QgsGeometryFactory::geomFromWkb( ptr ).release();
-  delete [] wkb;
+  // wrap the buffer instead of copying it. It is kept alive for as long as the
+  // geometry (or a copy of it) reads from it, and deleted right away otherwise
+  QSharedPointer< unsigned char > buffer( wkb, []( unsigned char * b ) { delete [] b; } );
+  fromWkb( QByteArray::fromRawData( reinterpret_cast< const char * >( wkb ), length ) );
+  if ( d->hasUnparsedWkb() )
+    d->wkbBuffer = buffer;
 }
 
 void QgsGeometry::fromWkb( const QByteArray &wkb )
 {
   detach( false );
+  d->reset( nullptr );
+
+  // simple geometries are kept as wkb, and only parsed when required
+  bool isNative = true;
+  bool isEmpty = false;
+  QgsConstWkbPtr scanPtr( wkb );
+  bool canDefer = false;
+  try
+  {
+    canDefer = scanWkb( scanPtr, QgsWkbTypes::Unknown, isNative, isEmpty );
+  }
+  catch ( const QgsWkbException & )
+  {
+    canDefer = false;
+  }
 
-  if ( d->geometry )
+  if ( canDefer )
   {
-    delete d->geometry;
+    d->wkb = wkb;
+    d->wkbSize = wkb.size() - scanPtr.remaining();
+    d->wkbIsNative = isNative;
+    d->wkbIsEmpty = isEmpty;
+    QgsConstWkbPtr headerPtr( wkb );
+    d->wkbType = headerPtr.readHeader();
+    return;
   }
+
   QgsConstWkbPtr ptr( wkb );
-  d->geometry = QgsGeometryFactory::geomFromWkb( ptr ).release();
+  d->reset( QgsGeometryFactory::geomFromWkb( ptr ).release() );
 }
 
 GEOSGeometry *QgsGeometry::exportToGeos( double precision ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return nullptr;
   }
 
-  return QgsGeos::asGeos( d->geometry, precision );
+  return QgsGeos::asGeos( d->geometry(), precision );
 }
 
 
 QgsWkbTypes::Type QgsGeometry::wkbType() const
 {
-  if ( !d->geometry )
+  if ( d->hasUnparsedWkb() )
+    return d->wkbType;
+
+  if ( !d->geometry() )
   {
     return QgsWkbTypes::Unknown;
   }
   else
   {
-    return d->geometry->wkbType();
+    return d->geometry()->wkbType();
   }
 }
 
 
 QgsWkbTypes::GeometryType QgsGeometry::type() const
 {
-  if ( !d->geometry )
+  if ( d->hasUnparsedWkb() )
+    return QgsWkbTypes::geometryType( d->wkbType );
+
+  if ( !d->geometry() )
   {
     return QgsWkbTypes::UnknownGeometry;
   }
-  return static_cast< QgsWkbTypes::GeometryType >( QgsWkbTypes::geometryType( d->geometry->wkbType() ) );
+  return static_cast< QgsWkbTypes::GeometryType >( QgsWkbTypes::geometryType( d->geometry()->wkbType() ) );
 }
 
 bool QgsGeometry::isEmpty() const
 {
-  if ( !d->geometry )
+  if ( d->hasUnparsedWkb() )
+    return d->wkbIsEmpty;
+
+  if ( !d->geometry() )
   {
     return true;
   }
 
-  return d->geometry->isEmpty();
+  return d->geometry()->isEmpty();
 }
 
 bool QgsGeometry::isMultipart() const
 {
-  if ( !d->geometry )
+  if ( d->hasUnparsedWkb() )
+    return QgsWkbTypes::isMultiType( d->wkbType );
+
+  if ( !d->geometry() )
   {
     return false;
   }
-  return QgsWkbTypes::isMultiType( d->geometry->wkbType() );
+  return QgsWkbTypes::isMultiType( d->geometry()->wkbType() );
 }
 
 void QgsGeometry::fromGeos( GEOSGeometry *geos )
 {
   detach( false );
-  delete d->geometry;
-  d->geometry = QgsGeos::fromGeos( geos );
+  d->reset( QgsGeos::fromGeos( geos ) );
   GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), geos );
 }
 
 QgsPointXY QgsGeometry::closestVertex( const QgsPointXY &point, int &atVertex, int &beforeVertex, int &afterVertex, double &sqrDist ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     sqrDist = -1;
     return QgsPointXY( 0, 0 );
@@ -336,7 +713,7 @@ QgsPointXY QgsGeometry::closestVertex( const QgsPointXY &point, int &atVertex, i
   QgsPoint pt( point.x(), point.y() );
   QgsVertexId id;
 
-  QgsPoint vp = QgsGeometryUtils::closestVertex( *( d->geometry ), pt, id );
+  QgsPoint vp = QgsGeometryUtils::closestVertex( *( d->geometry() ), pt, id );
   if ( !id.isValid() )
   {
     sqrDist = -1;
@@ -351,7 +728,7 @@ QgsPointXY QgsGeometry::closestVertex( const QgsPointXY &point, int &atVertex, i
 
 double QgsGeometry::distanceToVertex( int vertex ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return -1;
   }
@@ -362,12 +739,12 @@ double QgsGeometry::distanceToVertex( int vertex ) const
     return -1;
   }
 
-  return QgsGeometryUtils::distanceToVertex( *( d->geometry ), id );
+  return QgsGeometryUtils::distanceToVertex( *( d->geometry() ), id );
 }
 
 double QgsGeometry::angleAtVertex( int vertex ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return 0;
   }
@@ -380,26 +757,26 @@ double QgsGeometry::angleAtVertex( int vertex ) const
 
   QgsVertexId v1;
   QgsVertexId v3;
-  QgsGeometryUtils::adjacentVertices( *d->geometry, v2, v1, v3 );
+  QgsGeometryUtils::adjacentVertices( *d->geometry(), v2, v1, v3 );
   if ( v1.isValid() && v3.isValid() )
   {
-    QgsPoint p1 = d->geometry->vertexAt( v1 );
-    QgsPoint p2 = d->geometry->vertexAt( v2 );
-    QgsPoint p3 = d->geometry->vertexAt( v3 );
+    QgsPoint p1 = d->geometry()->vertexAt( v1 );
+    QgsPoint p2 = d->geometry()->vertexAt( v2 );
+    QgsPoint p3 = d->geometry()->vertexAt( v3 );
     double angle1 = QgsGeometryUtils::lineAngle( p1.x(), p1.y(), p2.x(), p2.y() );
     double angle2 = QgsGeometryUtils::lineAngle( p2.x(), p2.y(), p3.x(), p3.y() );
     return QgsGeometryUtils::averageAngle( angle1, angle2 );
   }
   else if ( v3.isValid() )
   {
-    QgsPoint p1 = d->geometry->vertexAt( v2 );
-    QgsPoint p2 = d->geometry->vertexAt( v3 );
+    QgsPoint p1 = d->geometry()->vertexAt( v2 );
+    QgsPoint p2 = d->geometry()->vertexAt( v3 );
     return QgsGeometryUtils::lineAngle( p1.x(), p1.y(), p2.x(), p2.y() );
   }
   else if ( v1.isValid() )
   {
-    QgsPoint p1 = d->geometry->vertexAt( v1 );
-    QgsPoint p2 = d->geometry->vertexAt( v2 );
+    QgsPoint p1 = d->geometry()->vertexAt( v1 );
+    QgsPoint p2 = d->geometry()->vertexAt( v2 );
     return QgsGeometryUtils::lineAngle( p1.x(), p1.y(), p2.x(), p2.y() );
   }
   return 0.0;
@@ -407,7 +784,7 @@ double QgsGeometry::angleAtVertex( int vertex ) const
 
 void QgsGeometry::adjacentVertices( int atVertex, int &beforeVertex, int &afterVertex ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return;
   }
@@ -421,14 +798,14 @@ void QgsGeometry::adjacentVertices( int atVertex, int &beforeVertex, int &afterV
   }
 
   QgsVertexId beforeVertexId, afterVertexId;
-  QgsGeometryUtils::adjacentVertices( *( d->geometry ), id, beforeVertexId, afterVertexId );
+  QgsGeometryUtils::adjacentVertices( *( d->geometry() ), id, beforeVertexId, afterVertexId );
   beforeVertex = vertexNrFromVertexId( beforeVertexId );
   afterVertex = vertexNrFromVertexId( afterVertexId );
 }
 
 bool QgsGeometry::moveVertex( double x, double y, int atVertex )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
@@ -441,12 +818,12 @@ bool QgsGeometry::moveVertex( double x, double y, int atVertex )
 
   detach( true );
 
-  return d->geometry->moveVertex( id, QgsPoint( x, y ) );
+  return d->geometry()->moveVertex( id, QgsPoint( x, y ) );
 }
 
 bool QgsGeometry::moveVertex( const QgsPoint &p, int atVertex )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
@@ -459,30 +836,29 @@ bool QgsGeometry::moveVertex( const QgsPoint &p, int atVertex )
 
   detach( true );
 
-  return d->geometry->moveVertex( id, p );
+  return d->geometry()->moveVertex( id, p );
 }
 
 bool QgsGeometry::deleteVertex( int atVertex )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
 
   //maintain compatibility with < 2.10 API
-  if ( QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::MultiPoint )
+  if ( QgsWkbTypes::flatType( d->geometry()->wkbType() ) == QgsWkbTypes::MultiPoint )
   {
     detach( true );
     //delete geometry instead of point
-    return static_cast< QgsGeometryCollection * >( d->geometry )->removeGeometry( atVertex );
+    return static_cast< QgsGeometryCollection * >( d->geometry() )->removeGeometry( atVertex );
   }
 
   //if it is a point, set the geometry to nullptr
-  if ( QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::Point )
+  if ( QgsWkbTypes::flatType( d->geometry()->wkbType() ) == QgsWkbTypes::Point )
   {
     detach( false );
-    delete d->geometry;
-    d->geometry = nullptr;
+    d->reset( nullptr );
     return true;
   }
 
@@ -494,22 +870,22 @@ bool QgsGeometry::deleteVertex( int atVertex )
 
   detach( true );
 
-  return d->geometry->deleteVertex( id );
+  return d->geometry()->deleteVertex( id );
 }
 
 bool QgsGeometry::insertVertex( double x, double y, int beforeVertex )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
 
   //maintain compatibility with < 2.10 API
-  if ( QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::MultiPoint )
+  if ( QgsWkbTypes::flatType( d->geometry()->wkbType() ) == QgsWkbTypes::MultiPoint )
   {
     detach( true );
     //insert geometry instead of point
-    return static_cast< QgsGeometryCollection * >( d->geometry )->insertGeometry( new QgsPoint( x, y ), beforeVertex );
+    return static_cast< QgsGeometryCollection * >( d->geometry() )->insertGeometry( new QgsPoint( x, y ), beforeVertex );
   }
 
   QgsVertexId id;
@@ -520,22 +896,22 @@ bool QgsGeometry::insertVertex( double x, double y, int beforeVertex )
 
   detach( true );
 
-  return d->geometry->insertVertex( id, QgsPoint( x, y ) );
+  return d->geometry()->insertVertex( id, QgsPoint( x, y ) );
 }
 
 bool QgsGeometry::insertVertex( const QgsPoint &point, int beforeVertex )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
 
   //maintain compatibility with < 2.10 API
-  if ( QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::MultiPoint )
+  if ( QgsWkbTypes::flatType( d->geometry()->wkbType() ) == QgsWkbTypes::MultiPoint )
   {
     detach( true );
     //insert geometry instead of point
-    return static_cast< QgsGeometryCollection * >( d->geometry )->insertGeometry( new QgsPoint( point ), beforeVertex );
+    return static_cast< QgsGeometryCollection * >( d->geometry() )->insertGeometry( new QgsPoint( point ), beforeVertex );
   }
 
   QgsVertexId id;
@@ -546,12 +922,22 @@ bool QgsGeometry::insertVertex( const QgsPoint &point, int beforeVertex )
 
   detach( true );
 
-  return d->geometry->insertVertex( id, point );
+  return d->geometry()->insertVertex( id, point );
 }
 
 QgsPoint QgsGeometry::vertexAt( int atVertex ) const
 {
-  if ( !d->geometry )
+  if ( d->hasUnparsedWkb() )
+  {
+    QgsConstWkbPtr ptr( d->wkb );
+    QgsPoint point;
+    int vertex = atVertex;
+    if ( atVertex < 0 || !wkbVertexAt( ptr, vertex, point ) )
+      return QgsPoint();
+    return point;
+  }
+
+  if ( !d->geometry() )
   {
     return QgsPoint();
   }
@@ -562,7 +948,7 @@ QgsPoint QgsGeometry::vertexAt( int atVertex ) const
   {
     return QgsPoint();
   }
-  return d->geometry->vertexAt( vId );
+  return d->geometry()->vertexAt( vId );
 }
 
 double QgsGeometry::sqrDistToVertexAt( QgsPointXY &point, int atVertex ) const
@@ -573,7 +959,7 @@ double QgsGeometry::sqrDistToVertexAt( QgsPointXY &point, int atVertex ) const
 
 QgsGeometry QgsGeometry::nearestPoint( const QgsGeometry &other ) const
 {
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsGeometry result = geos.closestPoint( other );
   result.mLastError = mLastError;
@@ -582,7 +968,7 @@ QgsGeometry QgsGeometry::nearestPoint( const QgsGeometry &other ) const
 
 QgsGeometry QgsGeometry::shortestLine( const QgsGeometry &other ) const
 {
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsGeometry result = geos.shortestLine( other, &mLastError );
   result.mLastError = mLastError;
@@ -591,14 +977,14 @@ QgsGeometry QgsGeometry::shortestLine( const QgsGeometry &other ) const
 
 double QgsGeometry::closestVertexWithContext( const QgsPointXY &point, int &atVertex ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return -1;
   }
 
   QgsVertexId vId;
   QgsPoint pt( point.x(), point.y() );
-  QgsPoint closestPoint = QgsGeometryUtils::closestVertex( *( d->geometry ), pt, vId );
+  QgsPoint closestPoint = QgsGeometryUtils::closestVertex( *( d->geometry() ), pt, vId );
   if ( !vId.isValid() )
     return -1;
   atVertex = vertexNrFromVertexId( vId );
@@ -612,7 +998,7 @@ double QgsGeometry::closestSegmentWithContext(
   double *leftOf,
   double epsilon ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return -1;
   }
@@ -621,7 +1007,7 @@ double QgsGeometry::closestSegmentWithContext(
   QgsVertexId vertexAfter;
   bool leftOfBool;
 
-  double sqrDist = d->geometry->closestSegment( QgsPoint( point.x(), point.y() ), segmentPt,  vertexAfter, &leftOfBool, epsilon );
+  double sqrDist = d->geometry()->closestSegment( QgsPoint( point.x(), point.y() ), segmentPt,  vertexAfter, &leftOfBool, epsilon );
   if ( sqrDist < 0 )
     return -1;
 
@@ -645,7 +1031,7 @@ QgsGeometry::OperationResult QgsGeometry::addRing( const QList<QgsPointXY> &ring
 
 QgsGeometry::OperationResult QgsGeometry::addRing( QgsCurve *ring )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     delete ring;
     return InvalidInput;
@@ -653,7 +1039,7 @@ QgsGeometry::OperationResult QgsGeometry::addRing( QgsCurve *ring )
 
   detach( true );
 
-  return QgsGeometryEditUtils::addRing( d->geometry, ring );
+  return QgsGeometryEditUtils::addRing( d->geometry(), ring );
 }
 
 QgsGeometry::OperationResult QgsGeometry::addPart( const QList<QgsPointXY> &points, QgsWkbTypes::GeometryType geomType )
@@ -681,19 +1067,19 @@ QgsGeometry::OperationResult QgsGeometry::addPart( const QgsPointSequence &point
 
 QgsGeometry::OperationResult QgsGeometry::addPart( QgsAbstractGeometry *part, QgsWkbTypes::GeometryType geomType )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     detach( false );
     switch ( geomType )
     {
       case QgsWkbTypes::PointGeometry:
-        d->geometry = new QgsMultiPointV2();
+        d->reset( new QgsMultiPointV2() );
         break;
       case QgsWkbTypes::LineGeometry:
-        d->geometry = new QgsMultiLineString();
+        d->reset( new QgsMultiLineString() );
         break;
       case QgsWkbTypes::PolygonGeometry:
-        d->geometry = new QgsMultiPolygonV2();
+        d->reset( new QgsMultiPolygonV2() );
         break;
       default:
         return QgsGeometry::AddPartNotMultiGeometry;
@@ -705,31 +1091,31 @@ QgsGeometry::OperationResult QgsGeometry::addPart( QgsAbstractGeometry *part, Qg
   }
 
   convertToMultiType();
-  return QgsGeometryEditUtils::addPart( d->geometry, part );
+  return QgsGeometryEditUtils::addPart( d->geometry(), part );
 }
 
 QgsGeometry::OperationResult QgsGeometry::addPart( const QgsGeometry &newPart )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry::InvalidBaseGeometry;
   }
-  if ( !newPart || !newPart.d->geometry )
+  if ( !newPart || !newPart.d->geometry() )
   {
     return QgsGeometry::AddPartNotMultiGeometry;
   }
 
-  return addPart( newPart.d->geometry->clone() );
+  return addPart( newPart.d->geometry()->clone() );
 }
 
 QgsGeometry QgsGeometry::removeInteriorRings( double minimumRingArea ) const
 {
-  if ( !d->geometry || type() != QgsWkbTypes::PolygonGeometry )
+  if ( !d->geometry() || type() != QgsWkbTypes::PolygonGeometry )
   {
     return QgsGeometry();
   }
 
-  if ( QgsWkbTypes::isMultiType( d->geometry->wkbType() ) )
+  if ( QgsWkbTypes::isMultiType( d->geometry()->wkbType() ) )
   {
     QList<QgsGeometry> parts = asGeometryCollection();
     QList<QgsGeometry> results;
@@ -751,7 +1137,7 @@ QgsGeometry QgsGeometry::removeInteriorRings( double minimumRingArea ) const
   }
   else
   {
-    QgsCurvePolygon *newPoly = static_cast< QgsCurvePolygon * >( d->geometry->clone() );
+    QgsCurvePolygon *newPoly = static_cast< QgsCurvePolygon * >( d->geometry()->clone() );
     newPoly->removeInteriorRings( minimumRingArea );
     return QgsGeometry( newPoly );
   }
@@ -759,7 +1145,7 @@ QgsGeometry QgsGeometry::removeInteriorRings( double minimumRingArea ) const
 
 QgsGeometry::OperationResult QgsGeometry::addPart( GEOSGeometry *newPart )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry::InvalidBaseGeometry;
   }
@@ -771,25 +1157,25 @@ QgsGeometry::OperationResult QgsGeometry::addPart( GEOSGeometry *newPart )
   detach( true );
 
   QgsAbstractGeometry *geom = QgsGeos::fromGeos( newPart );
-  return QgsGeometryEditUtils::addPart( d->geometry, geom );
+  return QgsGeometryEditUtils::addPart( d->geometry(), geom );
 }
 
 QgsGeometry::OperationResult QgsGeometry::translate( double dx, double dy )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry::InvalidBaseGeometry;
   }
 
   detach( true );
 
-  d->geometry->transform( QTransform::fromTranslate( dx, dy ) );
+  d->geometry()->transform( QTransform::fromTranslate( dx, dy ) );
   return QgsGeometry::Success;
 }
 
 QgsGeometry::OperationResult QgsGeometry::rotate( double rotation, const QgsPointXY &center )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry::InvalidBaseGeometry;
   }
@@ -799,13 +1185,13 @@ QgsGeometry::OperationResult QgsGeometry::rotate( double rotation, const QgsPoin
   QTransform t = QTransform::fromTranslate( center.x(), center.y() );
   t.rotate( -rotation );
   t.translate( -center.x(), -center.y() );
-  d->geometry->transform( t );
+  d->geometry()->transform( t );
   return QgsGeometry::Success;
 }
 
 QgsGeometry::OperationResult QgsGeometry::splitGeometry( const QList<QgsPointXY> &splitLine, QList<QgsGeometry> &newGeometries, bool topological, QList<QgsPointXY> &topologyTestPoints )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return InvalidBaseGeometry;
   }
@@ -814,14 +1200,14 @@ QgsGeometry::OperationResult QgsGeometry::splitGeometry( const QList<QgsPointXY>
   QgsLineString splitLineString( splitLine );
   QgsPointSequence tp;
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsGeometryEngine::EngineOperationResult result = geos.splitGeometry( splitLineString, newGeoms, topological, tp, &mLastError );
 
   if ( result == QgsGeometryEngine::Success )
   {
     detach( false );
-    d->geometry = newGeoms.at( 0 );
+    d->reset( newGeoms.at( 0 ) );
 
     newGeometries.clear();
     for ( int i = 1; i < newGeoms.size(); ++i )
@@ -858,20 +1244,19 @@ QgsGeometry::OperationResult QgsGeometry::splitGeometry( const QList<QgsPointXY>
 
 QgsGeometry::OperationResult QgsGeometry::reshapeGeometry( const QgsLineString &reshapeLineString )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return InvalidBaseGeometry;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   QgsGeometryEngine::EngineOperationResult errorCode = QgsGeometryEngine::Success;
   mLastError.clear();
   QgsAbstractGeometry *geom = geos.reshapeGeometry( reshapeLineString, &errorCode, &mLastError );
   if ( errorCode == QgsGeometryEngine::Success && geom )
   {
     detach( false );
-    delete d->geometry;
-    d->geometry = geom;
+    d->reset( geom );
     return Success;
   }
 
@@ -899,12 +1284,12 @@ QgsGeometry::OperationResult QgsGeometry::reshapeGeometry( const QgsLineString &
 
 int QgsGeometry::makeDifferenceInPlace( const QgsGeometry &other )
 {
-  if ( !d->geometry || !other.d->geometry )
+  if ( !d->geometry() || !other.d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
   mLastError.clear();
   QgsAbstractGeometry *diffGeom = geos.intersection( other.geometry(), &mLastError );
@@ -914,20 +1299,18 @@ int QgsGeometry::makeDifferenceInPlace( const QgsGeometry &other )
   }
 
   detach( false );
-
-  delete d->geometry;
-  d->geometry = diffGeom;
+  d->reset( diffGeom );
   return 0;
 }
 
 QgsGeometry QgsGeometry::makeDifference( const QgsGeometry &other ) const
 {
-  if ( !d->geometry || other.isNull() )
+  if ( !d->geometry() || other.isNull() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
   mLastError.clear();
   QgsAbstractGeometry *diffGeom = geos.intersection( other.geometry(), &mLastError );
@@ -943,9 +1326,15 @@ QgsGeometry QgsGeometry::makeDifference( const QgsGeometry &other ) const
 
 QgsRectangle QgsGeometry::boundingBox() const
 {
-  if ( d->geometry )
+  if ( d->hasUnparsedWkb() )
+  {
+    QgsConstWkbPtr ptr( d->wkb );
+    return wkbBoundingBox( ptr );
+  }
+
+  if ( d->geometry() )
   {
-    return d->geometry->boundingBox();
+    return d->geometry()->boundingBox();
   }
   return QgsRectangle();
 }
@@ -958,7 +1347,7 @@ QgsGeometry QgsGeometry::orientedMinimumBoundingBox( double &area, double &angle
   width = DBL_MAX;
   height = DBL_MAX;
 
-  if ( !d->geometry || d->geometry->nCoordinates() < 2 )
+  if ( !d->geometry() || d->geometry()->nCoordinates() < 2 )
     return QgsGeometry();
 
   QgsGeometry hull = convexHull();
@@ -1068,7 +1457,7 @@ QgsGeometry QgsGeometry::minimalEnclosingCircle( QgsPointXY &center, double &rad
   center = QgsPointXY( );
   radius = 0;
 
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
@@ -1113,129 +1502,129 @@ bool QgsGeometry::intersects( const QgsRectangle &r ) const
 
 bool QgsGeometry::intersects( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.intersects( geometry.d->geometry, &mLastError );
+  return geos.intersects( geometry.d->geometry(), &mLastError );
 }
 
 bool QgsGeometry::contains( const QgsPointXY *p ) const
 {
-  if ( !d->geometry || !p )
+  if ( !d->geometry() || !p )
   {
     return false;
   }
 
   QgsPoint pt( p->x(), p->y() );
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   return geos.contains( &pt, &mLastError );
 }
 
 bool QgsGeometry::contains( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.contains( geometry.d->geometry, &mLastError );
+  return geos.contains( geometry.d->geometry(), &mLastError );
 }
 
 bool QgsGeometry::disjoint( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.disjoint( geometry.d->geometry, &mLastError );
+  return geos.disjoint( geometry.d->geometry(), &mLastError );
 }
 
 bool QgsGeometry::equals( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.isEqual( geometry.d->geometry, &mLastError );
+  return geos.isEqual( geometry.d->geometry(), &mLastError );
 }
 
 bool QgsGeometry::touches( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.touches( geometry.d->geometry, &mLastError );
+  return geos.touches( geometry.d->geometry(), &mLastError );
 }
 
 bool QgsGeometry::overlaps( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.overlaps( geometry.d->geometry, &mLastError );
+  return geos.overlaps( geometry.d->geometry(), &mLastError );
 }
 
 bool QgsGeometry::within( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.within( geometry.d->geometry, &mLastError );
+  return geos.within( geometry.d->geometry(), &mLastError );
 }
 
 bool QgsGeometry::crosses( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.crosses( geometry.d->geometry, &mLastError );
+  return geos.crosses( geometry.d->geometry(), &mLastError );
 }
 
 QString QgsGeometry::exportToWkt( int precision ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QString();
   }
-  return d->geometry->asWkt( precision );
+  return d->geometry()->asWkt( precision );
 }
 
 QString QgsGeometry::exportToGeoJSON( int precision ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QStringLiteral( "null" );
   }
-  return d->geometry->asJSON( precision );
+  return d->geometry()->asJSON( precision );
 }
 
 QgsGeometry QgsGeometry::convertToType( QgsWkbTypes::GeometryType destType, bool destMultipart ) const
@@ -1258,7 +1647,7 @@ QgsGeometry QgsGeometry::convertToType( QgsWkbTypes::GeometryType destType, bool
 
 bool QgsGeometry::convertToMultiType()
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
@@ -1268,7 +1657,7 @@ bool QgsGeometry::convertToMultiType()
     return true;
   }
 
-  std::unique_ptr< QgsAbstractGeometry >geom = QgsGeometryFactory::geomFromWkbType( QgsWkbTypes::multiType( d->geometry->wkbType() ) );
+  std::unique_ptr< QgsAbstractGeometry >geom = QgsGeometryFactory::geomFromWkbType( QgsWkbTypes::multiType( d->geometry()->wkbType() ) );
   QgsGeometryCollection *multiGeom = qgsgeometry_cast<QgsGeometryCollection *>( geom.get() );
   if ( !multiGeom )
   {
@@ -1276,14 +1665,14 @@ bool QgsGeometry::convertToMultiType()
   }
 
   detach( true );
-  multiGeom->addGeometry( d->geometry );
-  d->geometry = geom.release();
+  multiGeom->addGeometry( d->take() );
+  d->reset( geom.release() );
   return true;
 }
 
 bool QgsGeometry::convertToSingleType()
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
@@ -1293,24 +1682,23 @@ bool QgsGeometry::convertToSingleType()
     return true;
   }
 
-  QgsGeometryCollection *multiGeom = qgsgeometry_cast<QgsGeometryCollection *>( d->geometry );
+  QgsGeometryCollection *multiGeom = qgsgeometry_cast<QgsGeometryCollection *>( d->geometry() );
   if ( !multiGeom || multiGeom->partCount() < 1 )
     return false;
 
   QgsAbstractGeometry *firstPart = multiGeom->geometryN( 0 )->clone();
   detach( false );
-
-  d->geometry = firstPart;
+  d->reset( firstPart );
   return true;
 }
 
 QgsPointXY QgsGeometry::asPoint() const
 {
-  if ( !d->geometry || QgsWkbTypes::flatType( d->geometry->wkbType() ) != QgsWkbTypes::Point )
+  if ( !d->geometry() || QgsWkbTypes::flatType( d->geometry()->wkbType() ) != QgsWkbTypes::Point )
   {
     return QgsPointXY();
   }
-  QgsPoint *pt = qgsgeometry_cast<QgsPoint *>( d->geometry );
+  QgsPoint *pt = qgsgeometry_cast<QgsPoint *>( d->geometry() );
   if ( !pt )
   {
     return QgsPointXY();
@@ -1322,17 +1710,17 @@ QgsPointXY QgsGeometry::asPoint() const
 QgsPolyline QgsGeometry::asPolyline() const
 {
   QgsPolyline polyLine;
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return polyLine;
   }
 
-  bool doSegmentation = ( QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::CompoundCurve
-                          || QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::CircularString );
+  bool doSegmentation = ( QgsWkbTypes::flatType( d->geometry()->wkbType() ) == QgsWkbTypes::CompoundCurve
+                          || QgsWkbTypes::flatType( d->geometry()->wkbType() ) == QgsWkbTypes::CircularString );
   QgsLineString *line = nullptr;
   if ( doSegmentation )
   {
-    QgsCurve *curve = qgsgeometry_cast<QgsCurve *>( d->geometry );
+    QgsCurve *curve = qgsgeometry_cast<QgsCurve *>( d->geometry() );
     if ( !curve )
     {
       return polyLine;
@@ -1341,7 +1729,7 @@ QgsPolyline QgsGeometry::asPolyline() const
   }
   else
   {
-    line = qgsgeometry_cast<QgsLineString *>( d->geometry );
+    line = qgsgeometry_cast<QgsLineString *>( d->geometry() );
     if ( !line )
     {
       return polyLine;
@@ -1366,15 +1754,15 @@ QgsPolyline QgsGeometry::asPolyline() const
 
 QgsPolygon QgsGeometry::asPolygon() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
     return QgsPolygon();
 
-  bool doSegmentation = ( QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::CurvePolygon );
+  bool doSegmentation = ( QgsWkbTypes::flatType( d->geometry()->wkbType() ) == QgsWkbTypes::CurvePolygon );
 
   QgsPolygonV2 *p = nullptr;
   if ( doSegmentation )
   {
-    QgsCurvePolygon *curvePoly = qgsgeometry_cast<QgsCurvePolygon *>( d->geometry );
+    QgsCurvePolygon *curvePoly = qgsgeometry_cast<QgsCurvePolygon *>( d->geometry() );
     if ( !curvePoly )
     {
       return QgsPolygon();
@@ -1383,7 +1771,7 @@ QgsPolygon QgsGeometry::asPolygon() const
   }
   else
   {
-    p = qgsgeometry_cast<QgsPolygonV2 *>( d->geometry );
+    p = qgsgeometry_cast<QgsPolygonV2 *>( d->geometry() );
   }
 
   if ( !p )
@@ -1403,12 +1791,12 @@ QgsPolygon QgsGeometry::asPolygon() const
 
 QgsMultiPoint QgsGeometry::asMultiPoint() const
 {
-  if ( !d->geometry || QgsWkbTypes::flatType( d->geometry->wkbType() ) != QgsWkbTypes::MultiPoint )
+  if ( !d->geometry() || QgsWkbTypes::flatType( d->geometry()->wkbType() ) != QgsWkbTypes::MultiPoint )
   {
     return QgsMultiPoint();
   }
 
-  const QgsMultiPointV2 *mp = qgsgeometry_cast<QgsMultiPointV2 *>( d->geometry );
+  const QgsMultiPointV2 *mp = qgsgeometry_cast<QgsMultiPointV2 *>( d->geometry() );
   if ( !mp )
   {
     return QgsMultiPoint();
@@ -1427,12 +1815,12 @@ QgsMultiPoint QgsGeometry::asMultiPoint() const
 
 QgsMultiPolyline QgsGeometry::asMultiPolyline() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsMultiPolyline();
   }
 
-  QgsGeometryCollection *geomCollection = qgsgeometry_cast<QgsGeometryCollection *>( d->geometry );
+  QgsGeometryCollection *geomCollection = qgsgeometry_cast<QgsGeometryCollection *>( d->geometry() );
   if ( !geomCollection )
   {
     return QgsMultiPolyline();
@@ -1476,12 +1864,12 @@ QgsMultiPolyline QgsGeometry::asMultiPolyline() const
 
 QgsMultiPolygon QgsGeometry::asMultiPolygon() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsMultiPolygon();
   }
 
-  QgsGeometryCollection *geomCollection = qgsgeometry_cast<QgsGeometryCollection *>( d->geometry );
+  QgsGeometryCollection *geomCollection = qgsgeometry_cast<QgsGeometryCollection *>( d->geometry() );
   if ( !geomCollection )
   {
     return QgsMultiPolygon();
@@ -1519,17 +1907,17 @@ QgsMultiPolygon QgsGeometry::asMultiPolygon() const
 
 double QgsGeometry::area() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return -1.0;
   }
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
 
 #if 0
   //debug: compare geos area with calculation in QGIS
   double geosArea = g.area();
   double qgisArea = 0;
-  QgsSurface *surface = qgsgeometry_cast<QgsSurface *>( d->geometry );
+  QgsSurface *surface = qgsgeometry_cast<QgsSurface *>( d->geometry() );
   if ( surface )
   {
     qgisArea = surface->area();
@@ -1542,59 +1930,59 @@ double QgsGeometry::area() const
 
 double QgsGeometry::length() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return -1.0;
   }
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   mLastError.clear();
   return g.length( &mLastError );
 }
 
 double QgsGeometry::distance( const QgsGeometry &geom ) const
 {
-  if ( !d->geometry || !geom.d->geometry )
+  if ( !d->geometry() || !geom.d->geometry() )
   {
     return -1.0;
   }
 
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   mLastError.clear();
-  return g.distance( geom.d->geometry, &mLastError );
+  return g.distance( geom.d->geometry(), &mLastError );
 }
 
 double QgsGeometry::hausdorffDistance( const QgsGeometry &geom ) const
 {
-  if ( !d->geometry || !geom.d->geometry )
+  if ( !d->geometry() || !geom.d->geometry() )
   {
     return -1.0;
   }
 
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   mLastError.clear();
-  return g.hausdorffDistance( geom.d->geometry, &mLastError );
+  return g.hausdorffDistance( geom.d->geometry(), &mLastError );
 }
 
 double QgsGeometry::hausdorffDistanceDensify( const QgsGeometry &geom, double densifyFraction ) const
 {
-  if ( !d->geometry || !geom.d->geometry )
+  if ( !d->geometry() || !geom.d->geometry() )
   {
     return -1.0;
   }
 
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   mLastError.clear();
-  return g.hausdorffDistanceDensify( geom.d->geometry, densifyFraction, &mLastError );
+  return g.hausdorffDistanceDensify( geom.d->geometry(), densifyFraction, &mLastError );
 }
 
 QgsGeometry QgsGeometry::buffer( double distance, int segments ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   mLastError.clear();
   std::unique_ptr<QgsAbstractGeometry> geom( g.buffer( distance, segments, &mLastError ) );
   if ( !geom )
@@ -1608,12 +1996,12 @@ QgsGeometry QgsGeometry::buffer( double distance, int segments ) const
 
 QgsGeometry QgsGeometry::buffer( double distance, int segments, EndCapStyle endCapStyle, JoinStyle joinStyle, double miterLimit ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   mLastError.clear();
   QgsAbstractGeometry *geom = g.buffer( distance, segments, endCapStyle, joinStyle, miterLimit, &mLastError );
   if ( !geom )
@@ -1627,12 +2015,12 @@ QgsGeometry QgsGeometry::buffer( double distance, int segments, EndCapStyle endC
 
 QgsGeometry QgsGeometry::offsetCurve( double distance, int segments, JoinStyle joinStyle, double miterLimit ) const
 {
-  if ( !d->geometry || type() != QgsWkbTypes::LineGeometry )
+  if ( !d->geometry() || type() != QgsWkbTypes::LineGeometry )
   {
     return QgsGeometry();
   }
 
-  if ( QgsWkbTypes::isMultiType( d->geometry->wkbType() ) )
+  if ( QgsWkbTypes::isMultiType( d->geometry()->wkbType() ) )
   {
     QList<QgsGeometry> parts = asGeometryCollection();
     QList<QgsGeometry> results;
@@ -1654,7 +2042,7 @@ QgsGeometry QgsGeometry::offsetCurve( double distance, int segments, JoinStyle j
   }
   else
   {
-    QgsGeos geos( d->geometry );
+    QgsGeos geos( d->geometry() );
     mLastError.clear();
     QgsAbstractGeometry *offsetGeom = geos.offsetCurve( distance, segments, joinStyle, miterLimit, &mLastError );
     if ( !offsetGeom )
@@ -1669,12 +2057,12 @@ QgsGeometry QgsGeometry::offsetCurve( double distance, int segments, JoinStyle j
 
 QgsGeometry QgsGeometry::singleSidedBuffer( double distance, int segments, BufferSide side, JoinStyle joinStyle, double miterLimit ) const
 {
-  if ( !d->geometry || type() != QgsWkbTypes::LineGeometry )
+  if ( !d->geometry() || type() != QgsWkbTypes::LineGeometry )
   {
     return QgsGeometry();
   }
 
-  if ( QgsWkbTypes::isMultiType( d->geometry->wkbType() ) )
+  if ( QgsWkbTypes::isMultiType( d->geometry()->wkbType() ) )
   {
     QList<QgsGeometry> parts = asGeometryCollection();
     QList<QgsGeometry> results;
@@ -1696,7 +2084,7 @@ QgsGeometry QgsGeometry::singleSidedBuffer( double distance, int segments, Buffe
   }
   else
   {
-    QgsGeos geos( d->geometry );
+    QgsGeos geos( d->geometry() );
     mLastError.clear();
     QgsAbstractGeometry *bufferGeom = geos.singleSidedBuffer( distance, segments, side,
                                       joinStyle, miterLimit, &mLastError );
@@ -1712,12 +2100,12 @@ QgsGeometry QgsGeometry::singleSidedBuffer( double distance, int segments, Buffe
 
 QgsGeometry QgsGeometry::extendLine( double startDistance, double endDistance ) const
 {
-  if ( !d->geometry || type() != QgsWkbTypes::LineGeometry )
+  if ( !d->geometry() || type() != QgsWkbTypes::LineGeometry )
   {
     return QgsGeometry();
   }
 
-  if ( QgsWkbTypes::isMultiType( d->geometry->wkbType() ) )
+  if ( QgsWkbTypes::isMultiType( d->geometry()->wkbType() ) )
   {
     QList<QgsGeometry> parts = asGeometryCollection();
     QList<QgsGeometry> results;
@@ -1739,7 +2127,7 @@ QgsGeometry QgsGeometry::extendLine( double startDistance, double endDistance )
   }
   else
   {
-    QgsLineString *line = qgsgeometry_cast< QgsLineString * >( d->geometry );
+    QgsLineString *line = qgsgeometry_cast< QgsLineString * >( d->geometry() );
     if ( !line )
       return QgsGeometry();
 
@@ -1751,12 +2139,12 @@ QgsGeometry QgsGeometry::extendLine( double startDistance, double endDistance )
 
 QgsGeometry QgsGeometry::simplify( double tolerance ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsAbstractGeometry *simplifiedGeom = geos.simplify( tolerance, &mLastError );
   if ( !simplifiedGeom )
@@ -1784,12 +2172,12 @@ QgsGeometry QgsGeometry::densifyByDistance( double distance ) const
 
 QgsGeometry QgsGeometry::centroid() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
   mLastError.clear();
   QgsGeometry result( geos.centroid( &mLastError ) );
@@ -1799,12 +2187,12 @@ QgsGeometry QgsGeometry::centroid() const
 
 QgsGeometry QgsGeometry::pointOnSurface() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
   mLastError.clear();
   QgsGeometry result( geos.pointOnSurface( &mLastError ) );
@@ -1821,11 +2209,11 @@ QgsGeometry QgsGeometry::poleOfInaccessibility( double precision, double *distan
 
 QgsGeometry QgsGeometry::convexHull() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsAbstractGeometry *cHull = geos.convexHull( &mLastError );
   if ( !cHull )
@@ -1839,12 +2227,12 @@ QgsGeometry QgsGeometry::convexHull() const
 
 QgsGeometry QgsGeometry::voronoiDiagram( const QgsGeometry &extent, double tolerance, bool edgesOnly ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsGeometry result = geos.voronoiDiagram( extent.geometry(), tolerance, edgesOnly, &mLastError );
   result.mLastError = mLastError;
@@ -1853,12 +2241,12 @@ QgsGeometry QgsGeometry::voronoiDiagram( const QgsGeometry &extent, double toler
 
 QgsGeometry QgsGeometry::delaunayTriangulation( double tolerance, bool edgesOnly ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsGeometry result = geos.delaunayTriangulation( tolerance, edgesOnly );
   result.mLastError = mLastError;
@@ -1867,16 +2255,16 @@ QgsGeometry QgsGeometry::delaunayTriangulation( double tolerance, bool edgesOnly
 
 QgsGeometry QgsGeometry::subdivide( int maxNodes ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  const QgsAbstractGeometry *geom = d->geometry;
+  const QgsAbstractGeometry *geom = d->geometry();
   std::unique_ptr< QgsAbstractGeometry > segmentizedCopy;
-  if ( QgsWkbTypes::isCurvedType( d->geometry->wkbType() ) )
+  if ( QgsWkbTypes::isCurvedType( d->geometry()->wkbType() ) )
   {
-    segmentizedCopy.reset( d->geometry->segmentize() );
+    segmentizedCopy.reset( d->geometry()->segmentize() );
     geom = segmentizedCopy.get();
   }
 
@@ -1894,14 +2282,14 @@ QgsGeometry QgsGeometry::subdivide( int maxNodes ) const
 
 QgsGeometry QgsGeometry::interpolate( double distance ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
   QgsGeometry line = *this;
   if ( type() == QgsWkbTypes::PolygonGeometry )
-    line = QgsGeometry( d->geometry->boundary() );
+    line = QgsGeometry( d->geometry()->boundary() );
 
   QgsGeos geos( line.geometry() );
   mLastError.clear();
@@ -1926,24 +2314,24 @@ double QgsGeometry::lineLocatePoint( const QgsGeometry &point ) const
   QgsGeometry segmentized = *this;
   if ( QgsWkbTypes::isCurvedType( wkbType() ) )
   {
-    segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry )->segmentize() );
+    segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry() )->segmentize() );
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.lineLocatePoint( *( static_cast< QgsPoint * >( point.d->geometry ) ), &mLastError );
+  return geos.lineLocatePoint( *( static_cast< QgsPoint * >( point.d->geometry() ) ), &mLastError );
 }
 
 double QgsGeometry::interpolateAngle( double distance ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
     return 0.0;
 
   // always operate on segmentized geometries
   QgsGeometry segmentized = *this;
   if ( QgsWkbTypes::isCurvedType( wkbType() ) )
   {
-    segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry )->segmentize() );
+    segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry() )->segmentize() );
   }
 
   QgsVertexId previous;
@@ -1990,15 +2378,15 @@ double QgsGeometry::interpolateAngle( double distance ) const
 
 QgsGeometry QgsGeometry::intersection( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
   mLastError.clear();
-  QgsAbstractGeometry *resultGeom = geos.intersection( geometry.d->geometry, &mLastError );
+  QgsAbstractGeometry *resultGeom = geos.intersection( geometry.d->geometry(), &mLastError );
 
   if ( !resultGeom )
   {
@@ -2012,14 +2400,14 @@ QgsGeometry QgsGeometry::intersection( const QgsGeometry &geometry ) const
 
 QgsGeometry QgsGeometry::combine( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  QgsAbstractGeometry *resultGeom = geos.combine( geometry.d->geometry, &mLastError );
+  QgsAbstractGeometry *resultGeom = geos.combine( geometry.d->geometry(), &mLastError );
   if ( !resultGeom )
   {
     QgsGeometry geom;
@@ -2031,18 +2419,18 @@ QgsGeometry QgsGeometry::combine( const QgsGeometry &geometry ) const
 
 QgsGeometry QgsGeometry::mergeLines() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry();
   }
 
-  if ( QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::LineString )
+  if ( QgsWkbTypes::flatType( d->geometry()->wkbType() ) == QgsWkbTypes::LineString )
   {
     // special case - a single linestring was passed
     return QgsGeometry( *this );
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsGeometry result = geos.mergeLines( &mLastError );
   result.mLastError = mLastError;
@@ -2051,15 +2439,15 @@ QgsGeometry QgsGeometry::mergeLines() const
 
 QgsGeometry QgsGeometry::difference( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
   mLastError.clear();
-  QgsAbstractGeometry *resultGeom = geos.difference( geometry.d->geometry, &mLastError );
+  QgsAbstractGeometry *resultGeom = geos.difference( geometry.d->geometry(), &mLastError );
   if ( !resultGeom )
   {
     QgsGeometry geom;
@@ -2071,15 +2459,15 @@ QgsGeometry QgsGeometry::difference( const QgsGeometry &geometry ) const
 
 QgsGeometry QgsGeometry::symDifference( const QgsGeometry &geometry ) const
 {
-  if ( !d->geometry || geometry.isNull() )
+  if ( !d->geometry() || geometry.isNull() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
   mLastError.clear();
-  QgsAbstractGeometry *resultGeom = geos.symDifference( geometry.d->geometry, &mLastError );
+  QgsAbstractGeometry *resultGeom = geos.symDifference( geometry.d->geometry(), &mLastError );
   if ( !resultGeom )
   {
     QgsGeometry geom;
@@ -2098,18 +2486,26 @@ QgsGeometry QgsGeometry::extrude( double x, double y )
 
 QByteArray QgsGeometry::exportToWkb() const
 {
-  return d->geometry ? d->geometry->asWkb() : QByteArray();
+  if ( d->hasUnparsedWkb() && d->wkbIsNative )
+  {
+    // a wrapped buffer must be copied, as it does not outlive the geometry
+    if ( d->wkbSize == d->wkb.size() && !d->wkbBuffer )
+      return d->wkb;
+    return QByteArray( d->wkb.constData(), d->wkbSize );
+  }
+
+  return d->geometry() ? d->geometry()->asWkb() : QByteArray();
 }
 
 QList<QgsGeometry> QgsGeometry::asGeometryCollection() const
 {
   QList<QgsGeometry> geometryList;
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return geometryList;
   }
 
-  QgsGeometryCollection *gc = qgsgeometry_cast<QgsGeometryCollection *>( d->geometry );
+  QgsGeometryCollection *gc = qgsgeometry_cast<QgsGeometryCollection *>( d->geometry() );
   if ( gc )
   {
     int numGeom = gc->numGeometries();
@@ -2121,7 +2517,7 @@ QList<QgsGeometry> QgsGeometry::asGeometryCollection() const
   }
   else //a singlepart geometry
   {
-    geometryList.append( QgsGeometry( d->geometry->clone() ) );
+    geometryList.append( QgsGeometry( d->geometry()->clone() ) );
   }
 
   return geometryList;
@@ -2164,19 +2560,19 @@ QPolygonF QgsGeometry::asQPolygonF() const
 
 bool QgsGeometry::deleteRing( int ringNum, int partNum )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
 
   detach( true );
-  bool ok = QgsGeometryEditUtils::deleteRing( d->geometry, ringNum, partNum );
+  bool ok = QgsGeometryEditUtils::deleteRing( d->geometry(), ringNum, partNum );
   return ok;
 }
 
 bool QgsGeometry::deletePart( int partNum )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
@@ -2188,22 +2584,22 @@ bool QgsGeometry::deletePart( int partNum )
   }
 
   detach( true );
-  bool ok = QgsGeometryEditUtils::deletePart( d->geometry, partNum );
+  bool ok = QgsGeometryEditUtils::deletePart( d->geometry(), partNum );
   return ok;
 }
 
 int QgsGeometry::avoidIntersections( const QList<QgsVectorLayer *> &avoidIntersectionsLayers, const QHash<QgsVectorLayer *, QSet<QgsFeatureId> > &ignoreFeatures )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return 1;
   }
 
-  std::unique_ptr< QgsAbstractGeometry > diffGeom = QgsGeometryEditUtils::avoidIntersections( *( d->geometry ), avoidIntersectionsLayers, ignoreFeatures );
+  std::unique_ptr< QgsAbstractGeometry > diffGeom = QgsGeometryEditUtils::avoidIntersections( *( d->geometry() ), avoidIntersectionsLayers, ignoreFeatures );
   if ( diffGeom )
   {
     detach( false );
-    d->geometry = diffGeom.release();
+    d->reset( diffGeom.release() );
   }
   return 0;
 }
@@ -2211,11 +2607,11 @@ int QgsGeometry::avoidIntersections( const QList<QgsVectorLayer *> &avoidInterse
 
 QgsGeometry QgsGeometry::makeValid()
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
     return QgsGeometry();
 
   mLastError.clear();
-  QgsAbstractGeometry *g = _qgis_lwgeom_make_valid( d->geometry, mLastError );
+  QgsAbstractGeometry *g = _qgis_lwgeom_make_valid( d->geometry(), mLastError );
 
   QgsGeometry result = QgsGeometry( g );
   result.mLastError = mLastError;
@@ -2230,36 +2626,36 @@ void QgsGeometry::validateGeometry( QList<QgsGeometry::Error> &errors, Validatio
 
 bool QgsGeometry::isGeosValid() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   return geos.isValid( &mLastError );
 }
 
 bool QgsGeometry::isSimple() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
     return false;
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   return geos.isSimple( &mLastError );
 }
 
 bool QgsGeometry::isGeosEqual( const QgsGeometry &g ) const
 {
-  if ( !d->geometry || !g.d->geometry )
+  if ( !d->geometry() || !g.d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
-  return geos.isEqual( g.d->geometry, &mLastError );
+  return geos.isEqual( g.d->geometry(), &mLastError );
 }
 
 QgsGeometry QgsGeometry::unaryUnion( const QList<QgsGeometry> &geometries )
@@ -2305,68 +2701,67 @@ QgsGeometry QgsGeometry::polygonize( const QList<QgsGeometry> &geometryList )
 
 void QgsGeometry::convertToStraightSegment()
 {
-  if ( !d->geometry || !requiresConversionToStraightSegments() )
+  if ( !d->geometry() || !requiresConversionToStraightSegments() )
   {
     return;
   }
 
-  QgsAbstractGeometry *straightGeom = d->geometry->segmentize();
+  QgsAbstractGeometry *straightGeom = d->geometry()->segmentize();
   detach( false );
-
-  d->geometry = straightGeom;
+  d->reset( straightGeom );
 }
 
 bool QgsGeometry::requiresConversionToStraightSegments() const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
 
-  return d->geometry->hasCurvedSegments();
+  return d->geometry()->hasCurvedSegments();
 }
 
 QgsGeometry::OperationResult QgsGeometry::transform( const QgsCoordinateTransform &ct )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry::InvalidBaseGeometry;
   }
 
   detach();
-  d->geometry->transform( ct );
+  d->geometry()->transform( ct );
   return QgsGeometry::Success;
 }
 
 QgsGeometry::OperationResult QgsGeometry::transform( const QTransform &ct )
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return QgsGeometry::InvalidBaseGeometry;
   }
 
   detach();
-  d->geometry->transform( ct );
+  d->geometry()->transform( ct );
   return QgsGeometry::Success;
 }
 
 void QgsGeometry::mapToPixel( const QgsMapToPixel &mtp )
 {
-  if ( d->geometry )
+  if ( d->geometry() )
   {
     detach();
-    d->geometry->transform( mtp.transform() );
+    d->geometry()->transform( mtp.transform() );
   }
 }
 
 QgsGeometry QgsGeometry::clipped( const QgsRectangle &rectangle )
 {
-  if ( !d->geometry || rectangle.isNull() || rectangle.isEmpty() )
+  if ( !d->geometry() || rectangle.isNull() || rectangle.isEmpty() )
   {
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   mLastError.clear();
   QgsAbstractGeometry *resultGeom = geos.clip( rectangle, &mLastError );
   if ( !resultGeom )
@@ -2380,9 +2775,9 @@ QgsGeometry QgsGeometry::clipped( const QgsRectangle &rectangle )
 
 void QgsGeometry::draw( QPainter &p ) const
 {
-  if ( d->geometry )
+  if ( d->geometry() )
   {
-    d->geometry->draw( p );
+    d->geometry()->draw( p );
   }
 }
 
@@ -2465,19 +2860,19 @@ static bool vertexIndexInfo( const QgsAbstractGeometry *g, int vertexIndex, int
 
 bool QgsGeometry::vertexIdFromVertexNr( int nr, QgsVertexId &id ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return false;
   }
 
   id.type = QgsVertexId::SegmentVertex;
 
-  bool res = vertexIndexInfo( d->geometry, nr, id.part, id.ring, id.vertex );
+  bool res = vertexIndexInfo( d->geometry(), nr, id.part, id.ring, id.vertex );
   if ( !res )
     return false;
 
   // now let's find out if it is a straight or circular segment
-  const QgsAbstractGeometry *g = d->geometry;
+  const QgsAbstractGeometry *g = d->geometry();
   if ( const QgsGeometryCollection *geomCollection = qgsgeometry_cast<const QgsGeometryCollection *>( g ) )
   {
     g = geomCollection->geometryN( id.part );
@@ -2501,12 +2896,12 @@ bool QgsGeometry::vertexIdFromVertexNr( int nr, QgsVertexId &id ) const
 
 int QgsGeometry::vertexNrFromVertexId( QgsVertexId id ) const
 {
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     return -1;
   }
 
-  QgsCoordinateSequence coords = d->geometry->coordinateSequence();
+  QgsCoordinateSequence coords = d->geometry()->coordinateSequence();
 
   int vertexCount = 0;
   for ( int part = 0; part < coords.size(); ++part )
@@ -2555,7 +2950,7 @@ void QgsGeometry::convertPointList( const QgsPointSequence &input, QList<QgsPoin
 
 QgsGeometry::operator bool() const
 {
-  return d->geometry;
+  return !isNull();
 }
 
 void QgsGeometry::convertToPolyline( const QgsPointSequence &input, QgsPolyline &output )
@@ -2669,12 +3064,12 @@ bool QgsGeometry::compare( const QgsMultiPolygon &p1, const QgsMultiPolygon &p2,
 
 QgsGeometry QgsGeometry::smooth( const unsigned int iterations, const double offset, double minimumDistance, double maxAngle ) const
 {
-  if ( d->geometry->isEmpty() )
+  if ( d->geometry()->isEmpty() )
     return QgsGeometry();
 
   QgsGeometry geom = *this;
   if ( QgsWkbTypes::isCurvedType( wkbType() ) )
-    geom = QgsGeometry( d->geometry->segmentize() );
+    geom = QgsGeometry( d->geometry()->segmentize() );
 
   switch ( QgsWkbTypes::flatType( geom.wkbType() ) )
   {
@@ -2685,13 +3080,13 @@ QgsGeometry QgsGeometry::smooth( const unsigned int iterations, const double off
 
     case QgsWkbTypes::LineString:
     {
-      QgsLineString *lineString = static_cast< QgsLineString * >( d->geometry );
+      QgsLineString *lineString = static_cast< QgsLineString * >( d->geometry() );
       return QgsGeometry( smoothLine( *lineString, iterations, offset, minimumDistance, maxAngle ) );
     }
 
     case QgsWkbTypes::MultiLineString:
     {
-      QgsMultiLineString *multiLine = static_cast< QgsMultiLineString * >( d->geometry );
+      QgsMultiLineString *multiLine = static_cast< QgsMultiLineString * >( d->geometry() );
 
       QgsMultiLineString *resultMultiline = new QgsMultiLineString();
       for ( int i = 0; i < multiLine->numGeometries(); ++i )
@@ -2703,13 +3098,13 @@ QgsGeometry QgsGeometry::smooth( const unsigned int iterations, const double off
 
     case QgsWkbTypes::Polygon:
     {
-      QgsPolygonV2 *poly = static_cast< QgsPolygonV2 * >( d->geometry );
+      QgsPolygonV2 *poly = static_cast< QgsPolygonV2 * >( d->geometry() );
       return QgsGeometry( smoothPolygon( *poly, iterations, offset, minimumDistance, maxAngle ) );
     }
 
     case QgsWkbTypes::MultiPolygon:
     {
-      QgsMultiPolygonV2 *multiPoly = static_cast< QgsMultiPolygonV2 * >( d->geometry );
+      QgsMultiPolygonV2 *multiPoly = static_cast< QgsMultiPolygonV2 * >( d->geometry() );
 
       QgsMultiPolygonV2 *resultMultiPoly = new QgsMultiPolygonV2();
       for ( int i = 0; i < multiPoly->numGeometries(); ++i )
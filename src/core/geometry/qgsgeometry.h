@@ -139,7 +139,8 @@ class CORE_EXPORT QgsGeometry
     ~QgsGeometry();
 
     /**
-     * Returns the underlying geometry store.
+     * Returns the underlying geometry store. If the geometry was created from WKB
+     * which has not yet been parsed, calling this method parses it.
     * \since QGIS 2.10
     * \see setGeometry
     */
@@ -189,13 +190,20 @@ class CORE_EXPORT QgsGeometry
 
     /**
      * Set the geometry, feeding in the buffer containing OGC Well-Known Binary and the buffer's length.
-     * This class will take ownership of the buffer.
+     * This class will take ownership of the buffer, which must have been allocated with new[].
+     * Like fromWkb( const QByteArray & ), simple geometries are read directly from the buffer,
+     * without copying it.
      * \note not available in Python bindings
      */
     void fromWkb( unsigned char *wkb, int length ) SIP_SKIP;
 
     /**
-     * Set the geometry, feeding in the buffer containing OGC Well-Known Binary
+     * Set the geometry, feeding in the buffer containing OGC Well-Known Binary.
+     *
+     * Points, linestrings, polygons and their multi-part variants are not parsed
+     * immediately. Their type, bounding box, vertices and WKB are read directly from
+     * the buffer, and the geometry is only parsed when it is modified or required
+     * by a more complex operation.
      * \since QGIS 3.0
      */
     void fromWkb( const QByteArray &wkb );
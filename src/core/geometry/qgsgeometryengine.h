@@ -50,6 +50,23 @@ class CORE_EXPORT QgsGeometryEngine
       SplitCannotSplitPoint, //!< Points cannot be split
     };
 
+    /**
+     * Spatial relationships which can be tested using testPredicates().
+     * \since QGIS 3.0
+     */
+    enum SpatialPredicate
+    {
+      Intersects = 1 << 0, //!< Geometries intersect
+      Touches = 1 << 1, //!< Geometries touch
+      Crosses = 1 << 2, //!< Geometries cross
+      Within = 1 << 3, //!< This geometry is within the tested geometry
+      Overlaps = 1 << 4, //!< Geometries overlap
+      Contains = 1 << 5, //!< This geometry contains the tested geometry
+      Disjoint = 1 << 6, //!< Geometries are disjoint
+      Equals = 1 << 7 //!< Geometries are equal
+    };
+    Q_DECLARE_FLAGS( SpatialPredicates, SpatialPredicate )
+
     virtual ~QgsGeometryEngine() = default;
 
     virtual void geometryChanged() = 0;
@@ -172,6 +189,57 @@ class CORE_EXPORT QgsGeometryEngine
      */
     virtual bool disjoint( const QgsAbstractGeometry *geom, QString *errorMsg = nullptr ) const = 0;
 
+    /**
+     * Tests several spatial \a predicates between this and \a geom, returning the
+     * subset of \a predicates which are satisfied.
+     *
+     * This is faster than calling the individual predicate methods in turn,
+     * as engines only need to convert \a geom once.
+     * \see filterByPredicate()
+     * \since QGIS 3.0
+     */
+    virtual SpatialPredicates testPredicates( const QgsAbstractGeometry *geom, SpatialPredicates predicates, QString *errorMsg = nullptr ) const
+    {
+      SpatialPredicates result;
+      if ( predicates.testFlag( Intersects ) && intersects( geom, errorMsg ) )
+        result |= Intersects;
+      if ( predicates.testFlag( Touches ) && touches( geom, errorMsg ) )
+        result |= Touches;
+      if ( predicates.testFlag( Crosses ) && crosses( geom, errorMsg ) )
+        result |= Crosses;
+      if ( predicates.testFlag( Within ) && within( geom, errorMsg ) )
+        result |= Within;
+      if ( predicates.testFlag( Overlaps ) && overlaps( geom, errorMsg ) )
+        result |= Overlaps;
+      if ( predicates.testFlag( Contains ) && contains( geom, errorMsg ) )
+        result |= Contains;
+      if ( predicates.testFlag( Disjoint ) && disjoint( geom, errorMsg ) )
+        result |= Disjoint;
+      if ( predicates.testFlag( Equals ) && isEqual( geom, errorMsg ) )
+        result |= Equals;
+      return result;
+    }
+
+    /**
+     * Tests a spatial \a predicate between this and each of a list of \a geometries,
+     * returning the indices of the geometries which satisfy the predicate.
+     *
+     * Call prepareGeometry() first when testing many geometries.
+     * \see testPredicates()
+     * \since QGIS 3.0
+     */
+    QList< int > filterByPredicate( const QList< QgsGeometry > &geometries, SpatialPredicate predicate, QString *errorMsg = nullptr ) const
+    {
+      QList< int > matches;
+      for ( int i = 0; i < geometries.count(); ++i )
+      {
+        const QgsAbstractGeometry *geom = geometries.at( i ).geometry();
+        if ( geom && testPredicates( geom, predicate, errorMsg ) )
+          matches << i;
+      }
+      return matches;
+    }
+
     /** Returns the Dimensional Extended 9 Intersection Model (DE-9IM) representation of the
      * relationship between the geometries.
      * \param geom geometry to relate to
@@ -232,4 +300,6 @@ class CORE_EXPORT QgsGeometryEngine
     {}
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS( QgsGeometryEngine::SpatialPredicates )
+
 #endif // QGSGEOMETRYENGINE_H
@@ -1412,75 +1412,102 @@ bool QgsGeos::relation( const QgsAbstractGeometry *geom, Relation r, QString *er
     return false;
   }
 
-  bool result = false;
   try
   {
-    if ( mGeosPrepared ) //use faster version with prepared geometry
+    return relation( geosGeom.get(), r );
+  }
+  catch ( GEOSException &e )
+  {
+    if ( errorMsg )
     {
-      switch ( r )
-      {
-        case INTERSECTS:
-          result = ( GEOSPreparedIntersects_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
-          break;
-        case TOUCHES:
-          result = ( GEOSPreparedTouches_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
-          break;
-        case CROSSES:
-          result = ( GEOSPreparedCrosses_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
-          break;
-        case WITHIN:
-          result = ( GEOSPreparedWithin_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
-          break;
-        case CONTAINS:
-          result = ( GEOSPreparedContains_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
-          break;
-        case DISJOINT:
-          result = ( GEOSPreparedDisjoint_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
-          break;
-        case OVERLAPS:
-          result = ( GEOSPreparedOverlaps_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
-          break;
-        default:
-          return false;
-      }
-      return result;
+      *errorMsg = e.what();
     }
+    return false;
+  }
+}
 
+bool QgsGeos::relation( const GEOSGeometry *geosGeom, Relation r ) const
+{
+  if ( mGeosPrepared ) //use faster version with prepared geometry
+  {
     switch ( r )
     {
       case INTERSECTS:
-        result = ( GEOSIntersects_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
-        break;
+        return GEOSPreparedIntersects_r( geosinit.ctxt, mGeosPrepared, geosGeom ) == 1;
       case TOUCHES:
-        result = ( GEOSTouches_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
-        break;
+        return GEOSPreparedTouches_r( geosinit.ctxt, mGeosPrepared, geosGeom ) == 1;
       case CROSSES:
-        result = ( GEOSCrosses_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
-        break;
+        return GEOSPreparedCrosses_r( geosinit.ctxt, mGeosPrepared, geosGeom ) == 1;
       case WITHIN:
-        result = ( GEOSWithin_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
-        break;
+        return GEOSPreparedWithin_r( geosinit.ctxt, mGeosPrepared, geosGeom ) == 1;
       case CONTAINS:
-        result = ( GEOSContains_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
-        break;
+        return GEOSPreparedContains_r( geosinit.ctxt, mGeosPrepared, geosGeom ) == 1;
       case DISJOINT:
-        result = ( GEOSDisjoint_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
-        break;
+        return GEOSPreparedDisjoint_r( geosinit.ctxt, mGeosPrepared, geosGeom ) == 1;
       case OVERLAPS:
-        result = ( GEOSOverlaps_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
-        break;
+        return GEOSPreparedOverlaps_r( geosinit.ctxt, mGeosPrepared, geosGeom ) == 1;
       default:
         return false;
     }
   }
-  catch ( GEOSException &e )
+
+  switch ( r )
+  {
+    case INTERSECTS:
+      return GEOSIntersects_r( geosinit.ctxt, mGeos, geosGeom ) == 1;
+    case TOUCHES:
+      return GEOSTouches_r( geosinit.ctxt, mGeos, geosGeom ) == 1;
+    case CROSSES:
+      return GEOSCrosses_r( geosinit.ctxt, mGeos, geosGeom ) == 1;
+    case WITHIN:
+      return GEOSWithin_r( geosinit.ctxt, mGeos, geosGeom ) == 1;
+    case CONTAINS:
+      return GEOSContains_r( geosinit.ctxt, mGeos, geosGeom ) == 1;
+    case DISJOINT:
+      return GEOSDisjoint_r( geosinit.ctxt, mGeos, geosGeom ) == 1;
+    case OVERLAPS:
+      return GEOSOverlaps_r( geosinit.ctxt, mGeos, geosGeom ) == 1;
+    default:
+      return false;
+  }
+}
+
+QgsGeometryEngine::SpatialPredicates QgsGeos::testPredicates( const QgsAbstractGeometry *geom, SpatialPredicates predicates, QString *errorMsg ) const
+{
+  SpatialPredicates result;
+  if ( !mGeos || !geom )
   {
-    if ( errorMsg )
+    return result;
+  }
+
+  // convert the geometry once, and reuse it for all predicates
+  GEOSGeomScopedPtr geosGeom( asGeos( geom, mPrecision ) );
+  if ( !geosGeom )
+  {
+    return result;
+  }
+
+  try
+  {
+    static const QPair< SpatialPredicate, Relation > RELATIONS[] =
     {
-      *errorMsg = e.what();
+      qMakePair( Intersects, INTERSECTS ),
+      qMakePair( Touches, TOUCHES ),
+      qMakePair( Crosses, CROSSES ),
+      qMakePair( Within, WITHIN ),
+      qMakePair( Overlaps, OVERLAPS ),
+      qMakePair( Contains, CONTAINS ),
+      qMakePair( Disjoint, DISJOINT )
+    };
+    for ( const QPair< SpatialPredicate, Relation > &relationPair : RELATIONS )
+    {
+      if ( predicates.testFlag( relationPair.first ) && relation( geosGeom.get(), relationPair.second ) )
+        result |= relationPair.first;
     }
-    return false;
+    if ( predicates.testFlag( Equals ) && GEOSEquals_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 )
+      result |= Equals;
   }
+  CATCH_GEOS_WITH_ERRMSG( SpatialPredicates() );
 
   return result;
 }
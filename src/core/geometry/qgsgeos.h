@@ -127,6 +127,7 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     bool overlaps( const QgsAbstractGeometry *geom, QString *errorMsg = nullptr ) const override;
     bool contains( const QgsAbstractGeometry *geom, QString *errorMsg = nullptr ) const override;
     bool disjoint( const QgsAbstractGeometry *geom, QString *errorMsg = nullptr ) const override;
+    SpatialPredicates testPredicates( const QgsAbstractGeometry *geom, SpatialPredicates predicates, QString *errorMsg = nullptr ) const override;
     QString relate( const QgsAbstractGeometry *geom, QString *errorMsg = nullptr ) const override;
     bool relatePattern( const QgsAbstractGeometry *geom, const QString &pattern, QString *errorMsg = nullptr ) const override;
     double area( QString *errorMsg = nullptr ) const override;
@@ -288,6 +289,12 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     void cacheGeos() const;
     QgsAbstractGeometry *overlay( const QgsAbstractGeometry *geom, Overlay op, QString *errorMsg = nullptr ) const;
     bool relation( const QgsAbstractGeometry *geom, Relation r, QString *errorMsg = nullptr ) const;
+
+    /**
+     * Tests a relation against an already converted GEOS geometry, using the prepared
+     * geometry if available. Throws GEOSException on failure.
+     */
+    bool relation( const GEOSGeometry *geosGeom, Relation r ) const;
     static GEOSCoordSequence *createCoordinateSequence( const QgsCurve *curve, double precision, bool forceClose = false );
     static QgsLineString *sequenceToLinestring( const GEOSGeometry *geos, bool hasZ, bool hasM );
     static int numberOfGeometries( GEOSGeometry *g );
@@ -0,0 +1,55 @@
+/***************************************************************************
+                         qgspreparedgeometrycache.cpp
+                         ----------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspreparedgeometrycache.h"
+
+QgsPreparedGeometryCache::QgsPreparedGeometryCache( int maximumSize )
+  : mEntries( maximumSize )
+{
+}
+
+QgsGeometryEngine *QgsPreparedGeometryCache::engine( const QgsGeometry &geometry )
+{
+  const QgsAbstractGeometry *geom = geometry.geometry();
+  if ( !geom )
+    return nullptr;
+
+  Entry *entry = mEntries.object( geom );
+  if ( !entry )
+  {
+    entry = new Entry();
+    // keep a copy of the geometry, so that the geometry can't be deleted (and
+    // its address reused) while it is in the cache
+    entry->geometry = geometry;
+    entry->engine.reset( QgsGeometry::createGeometryEngine( geom ) );
+    mEntries.insert( geom, entry );
+    return entry->engine.get();
+  }
+
+  if ( !entry->prepared )
+  {
+    // geometry is being reused - worth preparing
+    entry->engine->prepareGeometry();
+    entry->prepared = true;
+  }
+  return entry->engine.get();
+}
+
+bool QgsPreparedGeometryCache::contains( const QgsGeometry &geometry ) const
+{
+  const QgsAbstractGeometry *geom = geometry.geometry();
+  return geom && mEntries.contains( geom );
+}
@@ -0,0 +1,93 @@
+/***************************************************************************
+                         qgspreparedgeometrycache.h
+                         --------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPREPAREDGEOMETRYCACHE_H
+#define QGSPREPAREDGEOMETRYCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsgeometry.h"
+#include "qgsgeometryengine.h"
+
+#include <QCache>
+#include <memory>
+
+/** \ingroup core
+ * \class QgsPreparedGeometryCache
+ * \brief A least recently used cache of geometry engines, keyed by geometry identity.
+ *
+ * The cache avoids repeatedly converting a geometry which is tested against many
+ * other geometries, such as a mask polygon used in a filter expression. Geometries are
+ * identified by their shared geometry data, so implicitly shared copies of a
+ * QgsGeometry share a single cache entry. The cache keeps a copy of each cached
+ * geometry, so modifying a geometry after caching it detaches it from the cached
+ * entry rather than leaving a stale engine behind.
+ *
+ * Engines are converted on first use, and prepared when the same geometry is
+ * requested again.
+ *
+ * The cache is not thread safe.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsPreparedGeometryCache
+{
+  public:
+
+    /** Constructor for QgsPreparedGeometryCache.
+     * \param maximumSize maximum number of geometries to keep in the cache
+     */
+    explicit QgsPreparedGeometryCache( int maximumSize = DEFAULT_MAXIMUM_SIZE );
+
+    /** Returns a geometry engine for \a geometry, creating it if the geometry is
+     * not already in the cache. The engine is prepared if the geometry has been
+     * requested before. Returns a nullptr for null geometries.
+     *
+     * The returned engine is owned by the cache, and is only valid until the next
+     * call to engine() or clear().
+     */
+    QgsGeometryEngine *engine( const QgsGeometry &geometry );
+
+    /** Returns true if the cache contains an engine for \a geometry.
+     */
+    bool contains( const QgsGeometry &geometry ) const;
+
+    //! Removes all engines from the cache
+    void clear() { mEntries.clear(); }
+
+    //! Returns the number of geometries stored in the cache
+    int count() const { return mEntries.count(); }
+
+    //! Default maximum number of cached geometries
+    static const int DEFAULT_MAXIMUM_SIZE = 16;
+
+  private:
+
+    struct Entry
+    {
+      QgsGeometry geometry;
+      std::unique_ptr< QgsGeometryEngine > engine;
+      bool prepared = false;
+    };
+
+    QCache< const QgsAbstractGeometry *, Entry > mEntries;
+
+    Q_DISABLE_COPY( QgsPreparedGeometryCache )
+};
+
+#endif // QGSPREPAREDGEOMETRYCACHE_H
@@ -512,11 +512,14 @@ QVariantMap QgsClipAlgorithm::processAlgorithm( const QVariantMap &parameters, Q
       }
       testedFeatureIds.insert( inputFeature.id() );
 
-      if ( !engine->intersects( inputFeature.geometry().geometry() ) )
+      // test both predicates at once, to avoid converting the input geometry twice
+      const QgsGeometryEngine::SpatialPredicates matches = engine->testPredicates( inputFeature.geometry().geometry(),
+          QgsGeometryEngine::Intersects | QgsGeometryEngine::Contains );
+      if ( !matches.testFlag( QgsGeometryEngine::Intersects ) )
         continue;
 
       QgsGeometry newGeometry;
-      if ( !engine->contains( inputFeature.geometry().geometry() ) )
+      if ( !matches.testFlag( QgsGeometryEngine::Contains ) )
       {
         QgsGeometry currentGeometry = inputFeature.geometry();
         newGeometry = combinedClipGeom.intersection( currentGeometry );
@@ -1416,6 +1419,13 @@ void QgsLocationBasedAlgorithm::process( QgsFeatureSource *targetSource,
   if ( predicates.contains( Disjoint ) )
     disjointSet = targetSource->allFeatureIds();
 
+  // all predicates are tested in a single call, so that each target geometry is only converted once
+  QgsGeometryEngine::SpatialPredicates enginePredicates;
+  for ( Predicate predicate : qgsAsConst( predicates ) )
+  {
+    enginePredicates |= enginePredicate( predicate );
+  }
+
   QgsFeatureIds foundSet;
   QgsFeatureRequest request = QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ).setDestinationCrs( targetSource->sourceCrs() );
   QgsFeatureIterator fIt = intersectSource->getFeatures( request );
@@ -1462,38 +1472,20 @@ void QgsLocationBasedAlgorithm::process( QgsFeatureSource *targetSource,
         engine->prepareGeometry();
       }
 
+      const QgsGeometryEngine::SpatialPredicates matches = engine->testPredicates( testFeature.geometry().geometry(), enginePredicates );
       for ( Predicate predicate : qgsAsConst( predicates ) )
       {
         bool isMatch = false;
-        switch ( predicate )
+        if ( predicate == Disjoint )
+        {
+          if ( matches.testFlag( QgsGeometryEngine::Intersects ) )
+          {
+            disjointSet.remove( testFeature.id() );
+          }
+        }
+        else
         {
-          case Intersects:
-            isMatch = engine->intersects( testFeature.geometry().geometry() );
-            break;
-          case Contains:
-            isMatch = engine->contains( testFeature.geometry().geometry() );
-            break;
-          case Disjoint:
-            if ( engine->intersects( testFeature.geometry().geometry() ) )
-            {
-              disjointSet.remove( testFeature.id() );
-            }
-            break;
-          case IsEqual:
-            isMatch = engine->isEqual( testFeature.geometry().geometry() );
-            break;
-          case Touches:
-            isMatch = engine->touches( testFeature.geometry().geometry() );
-            break;
-          case Overlaps:
-            isMatch = engine->overlaps( testFeature.geometry().geometry() );
-            break;
-          case Within:
-            isMatch = engine->within( testFeature.geometry().geometry() );
-            break;
-          case Crosses:
-            isMatch = engine->crosses( testFeature.geometry().geometry() );
-            break;
+          isMatch = matches.testFlag( enginePredicate( predicate ) );
         }
         if ( isMatch )
         {
@@ -1548,6 +1540,31 @@ QgsLocationBasedAlgorithm::Predicate QgsLocationBasedAlgorithm::reversePredicate
   return Intersects;
 }
 
+QgsGeometryEngine::SpatialPredicate QgsLocationBasedAlgorithm::enginePredicate( QgsLocationBasedAlgorithm::Predicate predicate )
+{
+  switch ( predicate )
+  {
+    case Intersects:
+      return QgsGeometryEngine::Intersects;
+    case Contains:
+      return QgsGeometryEngine::Contains;
+    case Disjoint:
+      // disjoint features are found by testing for intersection
+      return QgsGeometryEngine::Intersects;
+    case IsEqual:
+      return QgsGeometryEngine::Equals;
+    case Touches:
+      return QgsGeometryEngine::Touches;
+    case Overlaps:
+      return QgsGeometryEngine::Overlaps;
+    case Within:
+      return QgsGeometryEngine::Within;
+    case Crosses:
+      return QgsGeometryEngine::Crosses;
+  }
+  return QgsGeometryEngine::Intersects;
+}
+
 QStringList QgsLocationBasedAlgorithm::predicateOptionsList() const
 {
   return QStringList() << QObject::tr( "intersects" )
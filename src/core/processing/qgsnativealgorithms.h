@@ -24,6 +24,7 @@
 #include "qgis.h"
 #include "qgsprocessingalgorithm.h"
 #include "qgsprocessingprovider.h"
+#include "qgsgeometryengine.h"
 
 ///@cond PRIVATE
 
@@ -504,6 +505,7 @@ class QgsLocationBasedAlgorithm : public QgsProcessingAlgorithm
     };
 
     Predicate reversePredicate( Predicate predicate ) const;
+    static QgsGeometryEngine::SpatialPredicate enginePredicate( Predicate predicate );
     QStringList predicateOptionsList() const;
     void process( QgsFeatureSource *targetSource, QgsFeatureSource *intersectSource, const QList<int> &selectedPredicates, std::function<void ( const QgsFeature & )> handleFeatureFunction, bool onlyRequireTargetIds, QgsFeedback *feedback );
 };
@@ -22,6 +22,49 @@
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
 
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <vector>
+
+//! Number of values read before they are summarized by the numeric aggregate workers
+static const int NUMERIC_AGGREGATE_BATCH_SIZE = 10000;
+
+//! Minimum number of values summarized by a numeric aggregate worker
+static const int NUMERIC_AGGREGATE_MINIMUM_SLICE_SIZE = 1000;
+
+//! Maximum number of workers summarizing numeric aggregate values in parallel
+static const int NUMERIC_AGGREGATE_MAXIMUM_WORKERS = 8;
+
+//! Reads the values of up to NUMERIC_AGGREGATE_BATCH_SIZE features into \a batch
+static void readNumericBatch( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
+                              QgsExpressionContext *context, QVector< QVariant > &batch )
+{
+  batch.resize( 0 );
+  QgsFeature f;
+  while ( batch.size() < NUMERIC_AGGREGATE_BATCH_SIZE && fit.nextFeature( f ) )
+  {
+    if ( expression )
+    {
+      Q_ASSERT( context );
+      context->setFeature( f );
+      batch << expression->evaluate( context );
+    }
+    else
+    {
+      batch << f.attribute( attr );
+    }
+  }
+}
+
+//! Adds values \a begin to \a end of a \a batch to a partial \a summary
+static void summarizeNumericBatch( QgsStatisticalSummary *summary, const QVector< QVariant > *batch, int begin, int end )
+{
+  for ( int i = begin; i < end; ++i )
+    summary->addVariant( batch->at( i ) );
+}
+
 
 
 QgsAggregateCalculator::QgsAggregateCalculator( const QgsVectorLayer *layer )
@@ -415,23 +458,39 @@ QVariant QgsAggregateCalculator::calculateNumericAggregate( QgsFeatureIterator &
 {
   Q_ASSERT( expression || attr >= 0 );
 
-  QgsStatisticalSummary s( stat );
-  QgsFeature f;
+  // features are read and expressions evaluated in this thread, as expressions are not
+  // thread safe. Meanwhile the values of the previous batch are summarized in parallel into
+  // partial summaries, which are merged at the end
+  const int workerCount = qBound( 1, QThreadPool::globalInstance()->maxThreadCount(), NUMERIC_AGGREGATE_MAXIMUM_WORKERS );
+  std::vector< QgsStatisticalSummary > summaries( workerCount, QgsStatisticalSummary( stat ) );
 
-  while ( fit.nextFeature( f ) )
+  QVector< QVariant > batches[2];
+  int current = 0;
+  readNumericBatch( fit, attr, expression, context, batches[current] );
+  while ( !batches[current].isEmpty() )
   {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addVariant( v );
-    }
-    else
+    const QVector< QVariant > &batch = batches[current];
+    const int sliceCount = qBound( 1, batch.size() / NUMERIC_AGGREGATE_MINIMUM_SLICE_SIZE, workerCount );
+    const int sliceSize = ( batch.size() + sliceCount - 1 ) / sliceCount;
+
+    QList< QFuture< void > > futures;
+    for ( int i = 0; i < sliceCount; ++i )
     {
-      s.addVariant( f.attribute( attr ) );
+      futures << QtConcurrent::run( summarizeNumericBatch, &summaries[i], &batch,
+                                    i * sliceSize, std::min( batch.size(), ( i + 1 ) * sliceSize ) );
     }
+
+    readNumericBatch( fit, attr, expression, context, batches[1 - current] );
+
+    Q_FOREACH ( QFuture< void > future, futures )
+      future.waitForFinished();
+
+    current = 1 - current;
   }
+
+  QgsStatisticalSummary &s = summaries[0];
+  for ( int i = 1; i < workerCount; ++i )
+    s.merge( summaries[i] );
   s.finalize();
   double val = s.statistic( stat );
   return std::isnan( val ) ? QVariant() : val;
@@ -29,6 +29,7 @@
 #include "qgstaskmanager.h"
 #include "qgsfieldformatterregistry.h"
 #include "qgssvgcache.h"
+#include "qgsdatasourcemetadatacache.h"
 #include "qgscolorschemeregistry.h"
 #include "qgspainteffectregistry.h"
 #include "qgsrasterrendererregistry.h"
@@ -867,6 +868,10 @@ void QgsApplication::initQgis()
 
   // initialize authentication manager and connect to database
   QgsAuthManager::instance()->init( pluginPath() );
+
+  // persist the metadata computed by providers across sessions
+  QDir().mkpath( qgisSettingsDirPath() );
+  dataSourceMetadataCache()->setDatabasePath( qgisSettingsDirPath() + QStringLiteral( "datasourcemetadata.db" ) );
 }
 
 void QgsApplication::exitQgis()
@@ -1526,6 +1531,11 @@ QgsSvgCache *QgsApplication::svgCache()
   return members()->mSvgCache;
 }
 
+QgsDataSourceMetadataCache *QgsApplication::dataSourceMetadataCache()
+{
+  return members()->mDataSourceMetadataCache;
+}
+
 QgsSymbolLayerRegistry *QgsApplication::symbolLayerRegistry()
 {
   return members()->mSymbolLayerRegistry;
@@ -1581,6 +1591,7 @@ QgsApplication::ApplicationMembers::ApplicationMembers()
   mActionScopeRegistry = new QgsActionScopeRegistry();
   mFieldFormatterRegistry = new QgsFieldFormatterRegistry();
   mSvgCache = new QgsSvgCache();
+  mDataSourceMetadataCache = new QgsDataSourceMetadataCache();
   mColorSchemeRegistry = new QgsColorSchemeRegistry();
   mColorSchemeRegistry->addDefaultSchemes();
   mPaintEffectRegistry = new QgsPaintEffectRegistry();
@@ -1602,6 +1613,7 @@ QgsApplication::ApplicationMembers::~ApplicationMembers()
   delete mActionScopeRegistry;
   delete mAnnotationRegistry;
   delete mColorSchemeRegistry;
+  delete mDataSourceMetadataCache;
   delete mFieldFormatterRegistry;
   delete mGpsConnectionRegistry;
   delete mMessageLog;
@@ -31,6 +31,7 @@ class QgsColorSchemeRegistry;
 class QgsPaintEffectRegistry;
 class QgsRendererRegistry;
 class QgsSvgCache;
+class QgsDataSourceMetadataCache;
 class QgsSymbolLayerRegistry;
 class QgsRasterRendererRegistry;
 class QgsGPSConnectionRegistry;
@@ -515,6 +516,14 @@ class CORE_EXPORT QgsApplication : public QApplication
      */
     static QgsSvgCache *svgCache();
 
+    /**
+     * Returns the application's data source metadata cache, used by providers to avoid
+     * recomputing expensive metadata such as extents and feature counts. initQgis()
+     * persists it to a database in the QGIS settings directory.
+     * \since QGIS 3.0
+     */
+    static QgsDataSourceMetadataCache *dataSourceMetadataCache();
+
     /**
      * Returns the application's symbol layer registry, used for managing symbol layers.
      * \since QGIS 3.0
@@ -701,6 +710,7 @@ class CORE_EXPORT QgsApplication : public QApplication
       QgsActionScopeRegistry *mActionScopeRegistry = nullptr;
       QgsAnnotationRegistry *mAnnotationRegistry = nullptr;
       QgsColorSchemeRegistry *mColorSchemeRegistry = nullptr;
+      QgsDataSourceMetadataCache *mDataSourceMetadataCache = nullptr;
       QgsFieldFormatterRegistry *mFieldFormatterRegistry = nullptr;
       QgsGPSConnectionRegistry *mGpsConnectionRegistry = nullptr;
       QgsMessageLog *mMessageLog = nullptr;
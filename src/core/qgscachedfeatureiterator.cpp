@@ -21,25 +21,8 @@ QgsCachedFeatureIterator::QgsCachedFeatureIterator( QgsVectorLayerCache *vlCache
   : QgsAbstractFeatureIterator( featureRequest )
   , mVectorLayerCache( vlCache )
 {
-  if ( mRequest.destinationCrs().isValid() && mRequest.destinationCrs() != mVectorLayerCache->sourceCrs() )
-  {
-    mTransform = QgsCoordinateTransform( mVectorLayerCache->sourceCrs(), mRequest.destinationCrs() );
-  }
-  try
-  {
-    mFilterRect = filterRectToSourceCrs( mTransform );
-  }
-  catch ( QgsCsException & )
-  {
-    // can't reproject mFilterRect
-    mClosed = true;
+  if ( !prepareFilterRect() )
     return;
-  }
-  if ( !mFilterRect.isNull() )
-  {
-    // update request to be the unprojected filter rect
-    mRequest.setFilterRect( mFilterRect );
-  }
 
   switch ( featureRequest.filterType() )
   {
@@ -62,6 +45,44 @@ QgsCachedFeatureIterator::QgsCachedFeatureIterator( QgsVectorLayerCache *vlCache
     close();
 }
 
+QgsCachedFeatureIterator::QgsCachedFeatureIterator( QgsVectorLayerCache *vlCache, const QgsFeatureRequest &featureRequest, const QgsFeatureIds &featureIds )
+  : QgsAbstractFeatureIterator( featureRequest )
+  , mFeatureIds( featureIds )
+  , mVectorLayerCache( vlCache )
+{
+  if ( !prepareFilterRect() )
+    return;
+
+  mFeatureIdIterator = mFeatureIds.constBegin();
+
+  if ( mFeatureIdIterator == mFeatureIds.constEnd() )
+    close();
+}
+
+bool QgsCachedFeatureIterator::prepareFilterRect()
+{
+  if ( mRequest.destinationCrs().isValid() && mRequest.destinationCrs() != mVectorLayerCache->sourceCrs() )
+  {
+    mTransform = QgsCoordinateTransform( mVectorLayerCache->sourceCrs(), mRequest.destinationCrs() );
+  }
+  try
+  {
+    mFilterRect = filterRectToSourceCrs( mTransform );
+  }
+  catch ( QgsCsException & )
+  {
+    // can't reproject mFilterRect
+    mClosed = true;
+    return false;
+  }
+  if ( !mFilterRect.isNull() )
+  {
+    // update request to be the unprojected filter rect
+    mRequest.setFilterRect( mFilterRect );
+  }
+  return true;
+}
+
 bool QgsCachedFeatureIterator::fetchFeature( QgsFeature &f )
 {
   f.setValid( false );
@@ -71,14 +92,16 @@ bool QgsCachedFeatureIterator::fetchFeature( QgsFeature &f )
 
   while ( mFeatureIdIterator != mFeatureIds.constEnd() )
   {
-    if ( !mVectorLayerCache->mCache.contains( *mFeatureIdIterator ) )
-    {
-      ++mFeatureIdIterator;
+    QgsVectorLayerCache::QgsCachedFeature *cachedFeature = mVectorLayerCache->cachedFeature( *mFeatureIdIterator );
+    ++mFeatureIdIterator;
+    if ( !cachedFeature )
       continue;
-    }
 
-    f = QgsFeature( *mVectorLayerCache->mCache[*mFeatureIdIterator]->feature() );
-    ++mFeatureIdIterator;
+    // the bounding box is stored with the cached feature, no need to decode its geometry
+    if ( !mFilterRect.isNull() && ( !cachedFeature->hasGeometry() || !cachedFeature->boundingBox().intersects( mFilterRect ) ) )
+      continue;
+
+    f = cachedFeature->feature();
     if ( mRequest.acceptFeature( f ) )
     {
       f.setValid( true );
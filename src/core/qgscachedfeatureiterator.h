@@ -39,6 +39,18 @@ class CORE_EXPORT QgsCachedFeatureIterator : public QgsAbstractFeatureIterator
      */
     QgsCachedFeatureIterator( QgsVectorLayerCache *vlCache, const QgsFeatureRequest &featureRequest );
 
+    /**
+     * This constructor creates a feature iterator, that delivers the cached features among
+     * a set of candidate features. No request is made to the backend.
+     *
+     * \param vlCache          The vector layer cache to use
+     * \param featureRequest   The feature request to answer
+     * \param featureIds       The ids of the candidate features, e.g. found by a cache index.
+     *                         The features must still match the filters of the request.
+     * \since QGIS 3.0
+     */
+    QgsCachedFeatureIterator( QgsVectorLayerCache *vlCache, const QgsFeatureRequest &featureRequest, const QgsFeatureIds &featureIds );
+
     /**
      * Rewind to the beginning of the iterator
      *
@@ -75,6 +87,10 @@ class CORE_EXPORT QgsCachedFeatureIterator : public QgsAbstractFeatureIterator
     virtual bool nextFeatureFilterFids( QgsFeature &f ) override { return fetchFeature( f ); }
 
   private:
+
+    //! Transforms the filter rectangle to the source CRS, returns false if it cannot be transformed
+    bool prepareFilterRect();
+
     QgsFeatureIds mFeatureIds;
     QgsVectorLayerCache *mVectorLayerCache = nullptr;
     QgsFeatureIds::ConstIterator mFeatureIdIterator;
@@ -0,0 +1,120 @@
+/***************************************************************************
+    qgscacheindexspatial.cpp
+     --------------------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgscacheindexspatial.h"
+#include "qgsfeaturerequest.h"
+#include "qgscachedfeatureiterator.h"
+#include "qgsvectorlayercache.h"
+
+QgsCacheIndexSpatial::QgsCacheIndexSpatial( QgsVectorLayerCache *cache )
+  : mCache( cache )
+{
+}
+
+void QgsCacheIndexSpatial::flushFeature( const QgsFeatureId fid )
+{
+  QHash< QgsFeatureId, QgsRectangle >::iterator it = mBoundingBoxes.find( fid );
+  if ( it == mBoundingBoxes.end() )
+    return;
+
+  QgsRectangle bbox = it.value();
+  mBoundingBoxes.erase( it );
+  mIndex.deleteFeature( fid, bbox );
+
+  // the feature may need to be fetched again for requests around it
+  mCoversAll = false;
+  for ( int i = mCoveredExtents.count() - 1; i >= 0; --i )
+  {
+    if ( mCoveredExtents.at( i ).intersects( bbox ) )
+      mCoveredExtents.removeAt( i );
+  }
+}
+
+void QgsCacheIndexSpatial::flush()
+{
+  mIndex = QgsSpatialIndex();
+  mBoundingBoxes.clear();
+  mCoveredExtents.clear();
+  mCoversAll = false;
+}
+
+void QgsCacheIndexSpatial::requestCompleted( const QgsFeatureRequest &featureRequest, const QgsFeatureIds &fids )
+{
+  // only requests which are not filtered by attributes or ids return all the features in an extent
+  if ( !mCache->cacheGeometry() || featureRequest.filterType() != QgsFeatureRequest::FilterNone )
+    return;
+
+  for ( QgsFeatureId fid : fids )
+  {
+    QgsRectangle bbox;
+    if ( mBoundingBoxes.contains( fid ) || !mCache->cachedBoundingBox( fid, bbox ) )
+      continue;
+
+    mIndex.insertFeature( fid, bbox );
+    mBoundingBoxes.insert( fid, bbox );
+  }
+
+  // limited requests and exact intersection tests may skip features whose bounding box is in the extent
+  if ( featureRequest.limit() >= 0 || featureRequest.flags() & QgsFeatureRequest::ExactIntersect )
+    return;
+
+  QgsRectangle extent = featureRequest.filterRect();
+  if ( extent.isNull() )
+  {
+    mCoversAll = true;
+    mCoveredExtents.clear();
+    return;
+  }
+
+  // forget the extents which are covered by the new one
+  for ( int i = mCoveredExtents.count() - 1; i >= 0; --i )
+  {
+    if ( extent.contains( mCoveredExtents.at( i ) ) )
+      mCoveredExtents.removeAt( i );
+  }
+  mCoveredExtents.prepend( extent );
+  while ( mCoveredExtents.count() > MAXIMUM_COVERED_EXTENTS )
+    mCoveredExtents.removeLast();
+}
+
+bool QgsCacheIndexSpatial::getCacheIterator( QgsFeatureIterator &featureIterator, const QgsFeatureRequest &featureRequest )
+{
+  QgsRectangle rect = featureRequest.filterRect();
+  if ( rect.isNull() || featureRequest.filterType() == QgsFeatureRequest::FilterFid || featureRequest.filterType() == QgsFeatureRequest::FilterFids )
+    return false;
+
+  // the index is built in the layer's CRS
+  if ( featureRequest.destinationCrs().isValid() && featureRequest.destinationCrs() != mCache->sourceCrs() )
+    return false;
+
+  if ( !isCovered( rect ) )
+    return false;
+
+  const QList<QgsFeatureId> candidates = mIndex.intersects( rect );
+  featureIterator = QgsFeatureIterator( new QgsCachedFeatureIterator( mCache, featureRequest, candidates.toSet() ) );
+  return true;
+}
+
+bool QgsCacheIndexSpatial::isCovered( const QgsRectangle &rect ) const
+{
+  if ( mCoversAll )
+    return true;
+
+  for ( const QgsRectangle &extent : mCoveredExtents )
+  {
+    if ( extent.contains( rect ) )
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,75 @@
+/***************************************************************************
+    qgscacheindexspatial.h
+     --------------------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSCACHEINDEXSPATIAL_H
+#define QGSCACHEINDEXSPATIAL_H
+
+#include "qgis_core.h"
+#include "qgscacheindex.h"
+#include "qgsrectangle.h"
+#include "qgsspatialindex.h"
+
+#include <QHash>
+#include <QList>
+
+class QgsVectorLayerCache;
+
+/** \ingroup core
+ * \class QgsCacheIndexSpatial
+ * \brief A cache index which answers requests filtered by a rectangle.
+ *
+ * The index remembers the extents of the completed requests, and the bounding boxes
+ * of the features they returned. A later request whose filter rectangle lies within
+ * one of these extents is answered from the cache, iterating only over the features
+ * whose bounding box intersects the rectangle.
+ *
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsCacheIndexSpatial : public QgsAbstractCacheIndex
+{
+  public:
+
+    /**
+     * Constructor for QgsCacheIndexSpatial, indexing the features of the specified \a cache.
+     */
+    explicit QgsCacheIndexSpatial( QgsVectorLayerCache *cache );
+
+    virtual void flushFeature( const QgsFeatureId fid ) override;
+    virtual void flush() override;
+    virtual void requestCompleted( const QgsFeatureRequest &featureRequest, const QgsFeatureIds &fids ) override;
+    virtual bool getCacheIterator( QgsFeatureIterator &featureIterator, const QgsFeatureRequest &featureRequest ) override;
+
+    //! Maximum number of request extents remembered by the index
+    static const int MAXIMUM_COVERED_EXTENTS = 32;
+
+  private:
+
+    //! Returns true if all features intersecting a rectangle are indexed
+    bool isCovered( const QgsRectangle &rect ) const;
+
+    QgsVectorLayerCache *mCache = nullptr;
+
+    QgsSpatialIndex mIndex;
+
+    //! Bounding boxes of the indexed features, needed to remove them from the spatial index
+    QHash< QgsFeatureId, QgsRectangle > mBoundingBoxes;
+
+    //! Extents of completed requests, most recent first
+    QList< QgsRectangle > mCoveredExtents;
+
+    //! True if all the features of the layer are indexed
+    bool mCoversAll = false;
+};
+
+#endif // QGSCACHEINDEXSPATIAL_H
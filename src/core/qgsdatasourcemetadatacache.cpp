@@ -0,0 +1,236 @@
+/***************************************************************************
+                              qgsdatasourcemetadatacache.cpp
+                              ------------------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsdatasourcemetadatacache.h"
+#include "qgslogger.h"
+
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+#include <sqlite3.h>
+
+///@cond PRIVATE
+// URIs may contain credentials, so the database only stores their hash
+static QByteArray uriKey( const QString &uri )
+{
+  return QCryptographicHash::hash( uri.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+}
+///@endcond
+
+QgsDataSourceMetadataCache::~QgsDataSourceMetadataCache()
+{
+  closeDatabase();
+}
+
+bool QgsDataSourceMetadataCache::isEnabled() const
+{
+  QMutexLocker locker( &mMutex );
+  return mEnabled;
+}
+
+void QgsDataSourceMetadataCache::setEnabled( bool enabled )
+{
+  QMutexLocker locker( &mMutex );
+  mEnabled = enabled;
+  mMetadata.clear();
+}
+
+bool QgsDataSourceMetadataCache::setDatabasePath( const QString &path )
+{
+  QMutexLocker locker( &mMutex );
+  closeDatabase();
+  if ( path.isEmpty() )
+    return true;
+
+  if ( sqlite3_open( path.toUtf8().constData(), &mDatabase ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "Could not open data source metadata cache %1: %2" ).arg( path, QString::fromUtf8( sqlite3_errmsg( mDatabase ) ) ) );
+    closeDatabase();
+    return false;
+  }
+
+  char *errmsg = nullptr;
+  if ( sqlite3_exec( mDatabase, "CREATE TABLE IF NOT EXISTS metadata ("
+                     "uri_hash TEXT PRIMARY KEY,"
+                     "change_token TEXT NOT NULL,"
+                     "xmin REAL,ymin REAL,xmax REAL,ymax REAL,"
+                     "feature_count INTEGER NOT NULL)", nullptr, nullptr, &errmsg ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "Could not create data source metadata cache %1: %2" ).arg( path, QString::fromUtf8( errmsg ) ) );
+    sqlite3_free( errmsg );
+    closeDatabase();
+    return false;
+  }
+
+  mDatabasePath = path;
+  return true;
+}
+
+QString QgsDataSourceMetadataCache::databasePath() const
+{
+  QMutexLocker locker( &mMutex );
+  return mDatabasePath;
+}
+
+QgsDataSourceMetadataCache::Metadata QgsDataSourceMetadataCache::metadata( const QString &uri, const QString &changeToken ) const
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mEnabled || changeToken.isEmpty() )
+    return Metadata();
+
+  fetch( uri );
+  QHash< QString, Metadata >::const_iterator it = mMetadata.constFind( uri );
+  if ( it == mMetadata.constEnd() || it->changeToken != changeToken )
+    return Metadata();
+
+  return it.value();
+}
+
+void QgsDataSourceMetadataCache::setExtent( const QString &uri, const QString &changeToken, const QgsRectangle &extent )
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mEnabled || changeToken.isEmpty() )
+    return;
+
+  Metadata &metadata = entry( uri, changeToken );
+  metadata.extent = extent;
+  store( uri, metadata );
+}
+
+void QgsDataSourceMetadataCache::setFeatureCount( const QString &uri, const QString &changeToken, long count )
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mEnabled || changeToken.isEmpty() || count < 0 )
+    return;
+
+  Metadata &metadata = entry( uri, changeToken );
+  metadata.featureCount = count;
+  store( uri, metadata );
+}
+
+void QgsDataSourceMetadataCache::invalidate( const QString &uri )
+{
+  QMutexLocker locker( &mMutex );
+  mMetadata.remove( uri );
+  remove( uri );
+}
+
+void QgsDataSourceMetadataCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mMetadata.clear();
+  if ( mDatabase )
+    sqlite3_exec( mDatabase, "DELETE FROM metadata", nullptr, nullptr, nullptr );
+}
+
+int QgsDataSourceMetadataCache::count() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMetadata.count();
+}
+
+QgsDataSourceMetadataCache::Metadata &QgsDataSourceMetadataCache::entry( const QString &uri, const QString &changeToken )
+{
+  fetch( uri );
+  Metadata &metadata = mMetadata[ uri ];
+  if ( metadata.changeToken != changeToken )
+  {
+    // the data source changed since the metadata was stored
+    metadata = Metadata();
+    metadata.changeToken = changeToken;
+  }
+  return metadata;
+}
+
+void QgsDataSourceMetadataCache::fetch( const QString &uri ) const
+{
+  if ( !mDatabase || mMetadata.contains( uri ) )
+    return;
+
+  sqlite3_stmt *stmt = nullptr;
+  if ( sqlite3_prepare_v2( mDatabase, "SELECT change_token,xmin,ymin,xmax,ymax,feature_count FROM metadata WHERE uri_hash=?", -1, &stmt, nullptr ) != SQLITE_OK )
+    return;
+
+  const QByteArray key = uriKey( uri );
+  sqlite3_bind_text( stmt, 1, key.constData(), key.size(), SQLITE_TRANSIENT );
+  if ( sqlite3_step( stmt ) == SQLITE_ROW )
+  {
+    Metadata metadata;
+    metadata.changeToken = QString::fromUtf8( reinterpret_cast< const char * >( sqlite3_column_text( stmt, 0 ) ) );
+    if ( sqlite3_column_type( stmt, 1 ) != SQLITE_NULL )
+    {
+      metadata.extent = QgsRectangle( sqlite3_column_double( stmt, 1 ), sqlite3_column_double( stmt, 2 ),
+                                      sqlite3_column_double( stmt, 3 ), sqlite3_column_double( stmt, 4 ) );
+    }
+    metadata.featureCount = static_cast< long >( sqlite3_column_int64( stmt, 5 ) );
+    mMetadata.insert( uri, metadata );
+  }
+  sqlite3_finalize( stmt );
+}
+
+void QgsDataSourceMetadataCache::store( const QString &uri, const Metadata &metadata )
+{
+  if ( !mDatabase )
+    return;
+
+  sqlite3_stmt *stmt = nullptr;
+  if ( sqlite3_prepare_v2( mDatabase, "INSERT OR REPLACE INTO metadata(uri_hash,change_token,xmin,ymin,xmax,ymax,feature_count) VALUES (?,?,?,?,?,?,?)", -1, &stmt, nullptr ) != SQLITE_OK )
+    return;
+
+  const QByteArray key = uriKey( uri );
+  const QByteArray token = metadata.changeToken.toUtf8();
+  sqlite3_bind_text( stmt, 1, key.constData(), key.size(), SQLITE_TRANSIENT );
+  sqlite3_bind_text( stmt, 2, token.constData(), token.size(), SQLITE_TRANSIENT );
+  if ( metadata.extent.isNull() )
+  {
+    for ( int i = 3; i <= 6; ++i )
+      sqlite3_bind_null( stmt, i );
+  }
+  else
+  {
+    sqlite3_bind_double( stmt, 3, metadata.extent.xMinimum() );
+    sqlite3_bind_double( stmt, 4, metadata.extent.yMinimum() );
+    sqlite3_bind_double( stmt, 5, metadata.extent.xMaximum() );
+    sqlite3_bind_double( stmt, 6, metadata.extent.yMaximum() );
+  }
+  sqlite3_bind_int64( stmt, 7, metadata.featureCount );
+  if ( sqlite3_step( stmt ) != SQLITE_DONE )
+    QgsDebugMsg( QString( "Could not store data source metadata: %1" ).arg( QString::fromUtf8( sqlite3_errmsg( mDatabase ) ) ) );
+  sqlite3_finalize( stmt );
+}
+
+void QgsDataSourceMetadataCache::remove( const QString &uri )
+{
+  if ( !mDatabase )
+    return;
+
+  sqlite3_stmt *stmt = nullptr;
+  if ( sqlite3_prepare_v2( mDatabase, "DELETE FROM metadata WHERE uri_hash=?", -1, &stmt, nullptr ) != SQLITE_OK )
+    return;
+
+  const QByteArray key = uriKey( uri );
+  sqlite3_bind_text( stmt, 1, key.constData(), key.size(), SQLITE_TRANSIENT );
+  sqlite3_step( stmt );
+  sqlite3_finalize( stmt );
+}
+
+void QgsDataSourceMetadataCache::closeDatabase()
+{
+  if ( mDatabase )
+    sqlite3_close( mDatabase );
+  mDatabase = nullptr;
+  mDatabasePath.clear();
+}
@@ -0,0 +1,166 @@
+/***************************************************************************
+                              qgsdatasourcemetadatacache.h
+                              ----------------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSDATASOURCEMETADATACACHE_H
+#define QGSDATASOURCEMETADATACACHE_H
+
+#include "qgis_core.h"
+#include "qgsrectangle.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+struct sqlite3;
+
+/** \ingroup core
+ * \class QgsDataSourceMetadataCache
+ * \brief A cache of expensive data source metadata, shared by all providers.
+ *
+ * Computing the extent or the feature count of a data source can require a full
+ * scan of the data. Providers store the values they compute in the cache, keyed
+ * by the data source URI, so that other providers opening the same source - e.g. when
+ * a project is reloaded or when QGIS Server reads a project again - can skip the
+ * computation.
+ *
+ * Every entry carries a change token, a cheap provider specific fingerprint of the
+ * data such as the modification time of a file. Entries are only returned while the
+ * token passed by the provider matches the stored one, and are discarded as soon as
+ * a different token is seen. Providers without a reliable change token should not
+ * use the cache.
+ *
+ * Metadata is kept in memory and, once setDatabasePath() was called, written through
+ * to a SQLite database so that it survives the process. QgsApplication::initQgis()
+ * stores it in the QGIS settings directory. Entries in the database are keyed by a
+ * hash of the URI, so that credentials in URIs are not written to disk.
+ *
+ * The cache is accessed via QgsApplication::dataSourceMetadataCache(). It is thread safe.
+ *
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsDataSourceMetadataCache
+{
+  public:
+
+    //! Metadata stored for a single data source
+    struct Metadata
+    {
+      //! Constructor for Metadata, without extent or feature count
+      Metadata()
+        : featureCount( -1 )
+      {}
+
+      //! Change token the metadata is valid for
+      QString changeToken;
+      //! Extent of the data source, or a null rectangle if unknown
+      QgsRectangle extent;
+      //! Number of features of the data source, or -1 if unknown
+      long featureCount;
+    };
+
+    /** Constructor for QgsDataSourceMetadataCache.
+     */
+    QgsDataSourceMetadataCache() = default;
+
+    ~QgsDataSourceMetadataCache();
+
+    //! QgsDataSourceMetadataCache cannot be copied.
+    QgsDataSourceMetadataCache( const QgsDataSourceMetadataCache &rh ) = delete;
+    //! QgsDataSourceMetadataCache cannot be copied.
+    QgsDataSourceMetadataCache &operator=( const QgsDataSourceMetadataCache &rh ) = delete;
+
+    /** Returns true if the cache is enabled.
+     * \see setEnabled()
+     */
+    bool isEnabled() const;
+
+    /** Enables or disables the cache. A disabled cache never returns any metadata.
+     * Disabling the cache clears the metadata held in memory, but not the database.
+     * \see isEnabled()
+     */
+    void setEnabled( bool enabled );
+
+    /** Sets the \a path of the SQLite database the metadata is persisted to. The
+     * database is created if needed. An empty \a path closes the database, after
+     * which metadata is only kept in memory.
+     * \returns true if the database could be opened
+     * \see databasePath()
+     */
+    bool setDatabasePath( const QString &path );
+
+    /** Returns the path of the SQLite database the metadata is persisted to, or an
+     * empty string if metadata is only kept in memory.
+     * \see setDatabasePath()
+     */
+    QString databasePath() const;
+
+    /** Returns the metadata stored for a data source \a uri, if it is still valid for
+     * the \a changeToken. If not, a Metadata value without extent or feature count is
+     * returned.
+     */
+    Metadata metadata( const QString &uri, const QString &changeToken ) const;
+
+    /** Stores the \a extent of the data source \a uri, valid for the \a changeToken.
+     * An empty \a changeToken is ignored.
+     */
+    void setExtent( const QString &uri, const QString &changeToken, const QgsRectangle &extent );
+
+    /** Stores the feature \a count of the data source \a uri, valid for the \a changeToken.
+     * An empty \a changeToken or a negative \a count is ignored.
+     */
+    void setFeatureCount( const QString &uri, const QString &changeToken, long count );
+
+    /** Removes the metadata of the data source \a uri, forcing providers to compute
+     * it again.
+     */
+    void invalidate( const QString &uri );
+
+    //! Removes all metadata from the cache and from its database
+    void clear();
+
+    //! Returns the number of data sources with metadata held in memory
+    int count() const;
+
+  private:
+
+#ifdef SIP_RUN
+    QgsDataSourceMetadataCache( const QgsDataSourceMetadataCache &rh );
+#endif
+
+    //! Returns the entry for a uri, reset if it was stored for a different change token
+    Metadata &entry( const QString &uri, const QString &changeToken );
+
+    //! Reads the entry for a uri from the database into memory, if it is not there yet
+    void fetch( const QString &uri ) const;
+
+    //! Writes the entry for a uri to the database
+    void store( const QString &uri, const Metadata &metadata );
+
+    //! Removes the entry for a uri from the database
+    void remove( const QString &uri );
+
+    //! Closes the database, if any
+    void closeDatabase();
+
+    mutable QMutex mMutex;
+    mutable QHash< QString, Metadata > mMetadata;
+    bool mEnabled = true;
+    sqlite3 *mDatabase = nullptr;
+    QString mDatabasePath;
+
+};
+
+#endif // QGSDATASOURCEMETADATACACHE_H
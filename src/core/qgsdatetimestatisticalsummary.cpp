@@ -88,6 +88,20 @@ void QgsDateTimeStatisticalSummary::finalize()
   //if statistics are implemented which require a post-calculation step
 }
 
+void QgsDateTimeStatisticalSummary::merge( const QgsDateTimeStatisticalSummary &other )
+{
+  mCount += other.mCount;
+  mCountMissing += other.mCountMissing;
+  mValues.unite( other.mValues );
+
+  if ( !mMin.isValid() || ( other.mMin.isValid() && other.mMin < mMin ) )
+    mMin = other.mMin;
+  if ( !mMax.isValid() || ( other.mMax.isValid() && other.mMax > mMax ) )
+    mMax = other.mMax;
+
+  mIsTimes = mIsTimes || other.mIsTimes;
+}
+
 void QgsDateTimeStatisticalSummary::testDateTime( const QDateTime &dateTime )
 {
   mCount++;
@@ -107,6 +107,15 @@ class CORE_EXPORT QgsDateTimeStatisticalSummary
      */
     void finalize();
 
+    /** Merges the values added to \a other into this summary, as if they had been added
+     * to this summary directly. Both summaries must calculate the same statistics.
+     * This allows values to be summarized separately, e.g. on different threads.
+     * Call finalize() after merging to retrieve the calculated statistics.
+     * \see finalize()
+     * \since QGIS 3.0
+     */
+    void merge( const QgsDateTimeStatisticalSummary &other );
+
     /** Returns the value of a specified statistic
      * \param stat statistic to return
      * \returns calculated value of statistic
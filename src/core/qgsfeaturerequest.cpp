@@ -295,6 +295,14 @@ QgsAbstractFeatureSource::~QgsAbstractFeatureSource()
   }
 }
 
+bool QgsAbstractFeatureSource::uniqueValueCounts( int index, QList< QPair< QVariant, long > > &counts )
+{
+  //base implementation does nothing
+  Q_UNUSED( index );
+  Q_UNUSED( counts );
+  return false;
+}
+
 void QgsAbstractFeatureSource::iteratorOpened( QgsAbstractFeatureIterator *it )
 {
   mActiveIterators.insert( it );
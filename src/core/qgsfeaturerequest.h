@@ -626,6 +626,21 @@ class CORE_EXPORT QgsAbstractFeatureSource
      */
     virtual QgsFeatureIterator getFeatures( const QgsFeatureRequest &request = QgsFeatureRequest() ) = 0;
 
+    /**
+     * Counts the features for each unique value of an attribute, using the data source
+     * directly (e.g. with a GROUP BY query). Unlike QgsVectorDataProvider::uniqueValueCounts(),
+     * this does not use the provider, and can be called from the thread the source is used in.
+     * The base implementation does nothing, and returns false to indicate that the features
+     * need to be iterated to count them.
+     * \param index the index of the attribute
+     * \param counts will be set to the unique values of the attribute and their feature counts
+     * eturns true if the counts were calculated by the source
+     * 
+ote not available in Python bindings
+     * \since QGIS 3.0
+     */
+    virtual bool uniqueValueCounts( int index, QList< QPair< QVariant, long > > &counts ) SIP_SKIP;
+
   protected:
     void iteratorOpened( QgsAbstractFeatureIterator *it );
     void iteratorClosed( QgsAbstractFeatureIterator *it );
@@ -17,9 +17,14 @@
 #include "qgsrectangle.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsgeometry.h"
+#include "qgslinestring.h"
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
+#include "qgsmultilinestring.h"
+#include "qgsmultipoint.h"
+#include "qgsmultipolygon.h"
 #include "qgsnetworkaccessmanager.h"
+#include "qgspolygon.h"
 #include "qgswkbptr.h"
 
 #include <QBuffer>
@@ -39,6 +44,104 @@ static const char NS_SEPARATOR = '?';
 static const char *GML_NAMESPACE = "http://www.opengis.net/gml";
 static const char *GML32_NAMESPACE = "http://www.opengis.net/gml/3.2";
 
+//! Powers of ten which are exactly representable as doubles
+static const double EXACT_POWERS_OF_TEN[] =
+{
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isCoordinateSpace( char c )
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline bool isDigit( char c )
+{
+  return c >= '0' && c <= '9';
+}
+
+/**
+ * Parses the number in [begin, end), which may be surrounded by white space.
+ * Plain decimal numbers with up to 15 significant digits, which make up nearly all
+ * GML coordinates, are converted exactly without any allocation. Everything
+ * else is handed to the locale independent QByteArray::toDouble().
+ */
+static bool parseCoordinate( const char *begin, const char *end, double &value )
+{
+  while ( begin < end && isCoordinateSpace( *begin ) )
+    ++begin;
+  while ( end > begin && isCoordinateSpace( end[-1] ) )
+    --end;
+  if ( begin == end )
+    return false;
+
+  const char *p = begin;
+  bool negative = false;
+  if ( *p == '-' || *p == '+' )
+  {
+    negative = *p == '-';
+    ++p;
+  }
+
+  quint64 mantissa = 0;
+  int significantDigits = 0;
+  int exponent = 0;
+  bool hasDigits = false;
+  for ( ; p < end && isDigit( *p ); ++p )
+  {
+    hasDigits = true;
+    mantissa = mantissa * 10 + ( *p - '0' );
+    if ( mantissa )
+      ++significantDigits;
+    if ( significantDigits > 15 )
+      break;
+  }
+  if ( p < end && *p == '.' && significantDigits <= 15 )
+  {
+    for ( ++p; p < end && isDigit( *p ); ++p )
+    {
+      hasDigits = true;
+      mantissa = mantissa * 10 + ( *p - '0' );
+      --exponent;
+      if ( mantissa )
+        ++significantDigits;
+      if ( significantDigits > 15 )
+        break;
+    }
+  }
+  if ( hasDigits && p < end && ( *p == 'e' || *p == 'E' ) && significantDigits <= 15 )
+  {
+    ++p;
+    bool negativeExponent = false;
+    if ( p < end && ( *p == '-' || *p == '+' ) )
+    {
+      negativeExponent = *p == '-';
+      ++p;
+    }
+    int explicitExponent = 0;
+    const char *exponentStart = p;
+    for ( ; p < end && isDigit( *p ) && explicitExponent < 1000; ++p )
+      explicitExponent = explicitExponent * 10 + ( *p - '0' );
+    if ( p == exponentStart )
+      hasDigits = false;
+    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+  }
+
+  if ( hasDigits && p == end && significantDigits <= 15 && exponent >= -22 && exponent <= 22 )
+  {
+    // both the mantissa and the power of ten are exact, so the result is correctly rounded
+    double result = static_cast< double >( mantissa );
+    result = exponent < 0 ? result / EXACT_POWERS_OF_TEN[-exponent] : result * EXACT_POWERS_OF_TEN[exponent];
+    value = negative ? -result : result;
+    return true;
+  }
+
+  bool ok = false;
+  value = QByteArray( begin, static_cast< int >( end - begin ) ).toDouble( &ok );
+  return ok;
+}
+
 QgsGml::QgsGml(
   const QString &typeName,
   const QString &geometryAttribute,
@@ -290,7 +393,6 @@ QgsGmlStreamingParser::QgsGmlStreamingParser( const QString &typeName,
   , mFeatureTupleDepth( 0 )
   , mCurrentFeature( nullptr )
   , mFeatureCount( 0 )
-  , mCurrentWKB( nullptr, 0 )
   , mBoundedByNullFound( false )
   , mDimension( 0 )
   , mCoorMode( Coordinate )
@@ -309,8 +411,6 @@ QgsGmlStreamingParser::QgsGmlStreamingParser( const QString &typeName,
     mThematicAttributes.insert( fields.at( i ).name(), qMakePair( i, fields.at( i ) ) );
   }
 
-  mEndian = QgsApplication::endian();
-
   int index = mTypeName.indexOf( ':' );
   if ( index != -1 && index < mTypeName.length() )
   {
@@ -354,7 +454,6 @@ QgsGmlStreamingParser::QgsGmlStreamingParser( const QList<LayerProperties> &laye
   , mFeatureTupleDepth( 0 )
   , mCurrentFeature( nullptr )
   , mFeatureCount( 0 )
-  , mCurrentWKB( nullptr, 0 )
   , mBoundedByNullFound( false )
   , mDimension( 0 )
   , mCoorMode( Coordinate )
@@ -413,8 +512,6 @@ QgsGmlStreamingParser::QgsGmlStreamingParser( const QList<LayerProperties> &laye
     mTypeNameUTF8Len = strlen( mTypeNamePtr );
   }
 
-  mEndian = QgsApplication::endian();
-
   mParser = XML_ParserCreateNS( nullptr, NS_SEPARATOR );
   XML_SetUserData( mParser, this );
   XML_SetElementHandler( mParser, QgsGmlStreamingParser::start, QgsGmlStreamingParser::end );
@@ -433,6 +530,8 @@ QgsGmlStreamingParser::~QgsGmlStreamingParser()
   }
 
   delete mCurrentFeature;
+  delete mCurrentGeometry;
+  clearGeometryParts();
 }
 
 bool QgsGmlStreamingParser::processData( const QByteArray &data, bool atEnd )
@@ -521,7 +620,7 @@ void QgsGmlStreamingParser::startElement( const XML_Char *el, const XML_Char **a
   {
     mParseModeStack.push( Coordinate );
     mCoorMode = QgsGmlStreamingParser::Coordinate;
-    mStringCash.clear();
+    mCoordinateBuffer.clear();
     mCoordinateSeparator = readAttribute( QStringLiteral( "cs" ), attr );
     if ( mCoordinateSeparator.isEmpty() )
     {
@@ -538,7 +637,7 @@ void QgsGmlStreamingParser::startElement( const XML_Char *el, const XML_Char **a
   {
     mParseModeStack.push( QgsGmlStreamingParser::PosList );
     mCoorMode = QgsGmlStreamingParser::PosList;
-    mStringCash.clear();
+    mCoordinateBuffer.clear();
     if ( elDimension == 0 )
     {
       QString srsDimension = readAttribute( QStringLiteral( "srsDimension" ), attr );
@@ -580,13 +679,13 @@ void QgsGmlStreamingParser::startElement( const XML_Char *el, const XML_Char **a
             isGMLNS && LOCALNAME_EQUALS( "lowerCorner" ) )
   {
     mParseModeStack.push( QgsGmlStreamingParser::LowerCorner );
-    mStringCash.clear();
+    mCoordinateBuffer.clear();
   }
   else if ( parseMode == Envelope &&
             isGMLNS && LOCALNAME_EQUALS( "upperCorner" ) )
   {
     mParseModeStack.push( QgsGmlStreamingParser::UpperCorner );
-    mStringCash.clear();
+    mCoordinateBuffer.clear();
   }
   else if ( parseMode == None && !mTypeNamePtr &&
             LOCALNAME_EQUALS( "Tuple" ) )
@@ -608,7 +707,7 @@ void QgsGmlStreamingParser::startElement( const XML_Char *el, const XML_Char **a
       mFeatureTupleDepth = mParseDepth;
       mCurrentTypename = currentTypename;
       mGeometryAttribute.clear();
-      if ( mCurrentWKB.size() == 0 )
+      if ( !mCurrentGeometry )
       {
         mGeometryAttribute = iter.value().mGeometryAttribute;
       }
@@ -697,21 +796,21 @@ void QgsGmlStreamingParser::startElement( const XML_Char *el, const XML_Char **a
             localNameLen == ( int )strlen( "Polygon" ) && memcmp( pszLocalName, "Polygon", localNameLen ) == 0 )
   {
     isGeom = true;
-    mCurrentWKBFragments.push_back( QList<QgsWkbPtr>() );
+    mCurrentGeometryParts.push_back( QList<QgsAbstractGeometry *>() );
   }
   else if ( isGMLNS && LOCALNAME_EQUALS( "MultiPoint" ) )
   {
     isGeom = true;
     mParseModeStack.push( QgsGmlStreamingParser::MultiPoint );
-    //we need one nested list for intermediate WKB
-    mCurrentWKBFragments.push_back( QList<QgsWkbPtr>() );
+    //we need one nested list for intermediate geometries
+    mCurrentGeometryParts.push_back( QList<QgsAbstractGeometry *>() );
   }
   else if ( isGMLNS && ( LOCALNAME_EQUALS( "MultiLineString" ) || LOCALNAME_EQUALS( "MultiCurve" ) ) )
   {
     isGeom = true;
     mParseModeStack.push( QgsGmlStreamingParser::MultiLine );
-    //we need one nested list for intermediate WKB
-    mCurrentWKBFragments.push_back( QList<QgsWkbPtr>() );
+    //we need one nested list for intermediate geometries
+    mCurrentGeometryParts.push_back( QList<QgsAbstractGeometry *>() );
   }
   else if ( isGMLNS && ( LOCALNAME_EQUALS( "MultiPolygon" ) || LOCALNAME_EQUALS( "MultiSurface" ) ) )
   {
@@ -902,10 +1001,10 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( parseMode == BoundingBox && isGMLNS && LOCALNAME_EQUALS( "boundedBy" ) )
   {
-    //create bounding box from mStringCash
+    //create bounding box from mCoordinateBuffer
     if ( mCurrentExtent.isNull() &&
          !mBoundedByNullFound &&
-         !createBBoxFromCoordinateString( mCurrentExtent, mStringCash ) )
+         !createBBoxFromCoordinateString( mCurrentExtent, mCoordinateBuffer ) )
     {
       QgsDebugMsg( "creation of bounding box failed" );
     }
@@ -928,23 +1027,23 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( parseMode == LowerCorner && isGMLNS && LOCALNAME_EQUALS( "lowerCorner" ) )
   {
-    QList<QgsPointXY> points;
-    pointsFromPosListString( points, mStringCash, 2 );
-    if ( points.size() == 1 )
+    QVector<double> x, y;
+    pointsFromPosListString( x, y, mCoordinateBuffer, 2 );
+    if ( x.size() == 1 )
     {
-      mCurrentExtent.setXMinimum( points[0].x() );
-      mCurrentExtent.setYMinimum( points[0].y() );
+      mCurrentExtent.setXMinimum( x[0] );
+      mCurrentExtent.setYMinimum( y[0] );
     }
     mParseModeStack.pop();
   }
   else if ( parseMode == UpperCorner && isGMLNS && LOCALNAME_EQUALS( "upperCorner" ) )
   {
-    QList<QgsPointXY> points;
-    pointsFromPosListString( points, mStringCash, 2 );
-    if ( points.size() == 1 )
+    QVector<double> x, y;
+    pointsFromPosListString( x, y, mCoordinateBuffer, 2 );
+    if ( x.size() == 1 )
     {
-      mCurrentExtent.setXMaximum( points[0].x() );
-      mCurrentExtent.setYMaximum( points[0].y() );
+      mCurrentExtent.setXMaximum( x[0] );
+      mCurrentExtent.setYMaximum( y[0] );
     }
     mParseModeStack.pop();
   }
@@ -962,18 +1061,19 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
     Q_ASSERT( mCurrentFeature );
     if ( !mCurrentFeature->hasGeometry() )
     {
-      if ( mCurrentWKB.size() > 0 )
+      if ( mCurrentGeometry )
       {
-        QgsGeometry g;
-        g.fromWkb( mCurrentWKB, mCurrentWKB.size() );
-        mCurrentFeature->setGeometry( g );
-        mCurrentWKB = QgsWkbPtr( nullptr, 0 );
+        mCurrentFeature->setGeometry( QgsGeometry( mCurrentGeometry ) );
+        mCurrentGeometry = nullptr;
       }
       else if ( !mCurrentExtent.isEmpty() )
       {
         mCurrentFeature->setGeometry( QgsGeometry::fromRect( mCurrentExtent ) );
       }
     }
+    // do not leak a geometry which was not used into the next feature
+    delete mCurrentGeometry;
+    mCurrentGeometry = nullptr;
     mCurrentFeature->setValid( true );
 
     mFeatureList.push_back( QgsGmlFeaturePtrGmlIdPair( mCurrentFeature, mCurrentFeatureId ) );
@@ -984,109 +1084,66 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( isGMLNS && LOCALNAME_EQUALS( "Point" ) )
   {
-    QList<QgsPointXY> pointList;
-    if ( pointsFromString( pointList, mStringCash ) != 0 )
+    QVector<double> x, y;
+    if ( pointsFromString( x, y, mCoordinateBuffer ) != 0 )
     {
       //error
     }
 
-    if ( pointList.isEmpty() )
+    if ( x.isEmpty() )
       return;  // error
 
+    QgsPoint *point = new QgsPoint( x.at( 0 ), y.at( 0 ) );
     if ( parseMode == QgsGmlStreamingParser::Geometry )
     {
-      //directly add WKB point to the feature
-      if ( getPointWKB( mCurrentWKB, *( pointList.constBegin() ) ) != 0 )
-      {
-        //error
-      }
+      //directly set the point as the feature geometry
+      setCurrentGeometry( point );
 
       if ( mWkbType != QgsWkbTypes::MultiPoint ) //keep multitype in case of geometry type mix
       {
         mWkbType = QgsWkbTypes::Point;
       }
     }
-    else //multipoint, add WKB as fragment
+    else //multipoint, add point as part
     {
-      QgsWkbPtr wkbPtr( nullptr, 0 );
-      if ( getPointWKB( wkbPtr, *( pointList.constBegin() ) ) != 0 )
-      {
-        //error
-      }
-      if ( !mCurrentWKBFragments.isEmpty() )
-      {
-        mCurrentWKBFragments.last().push_back( wkbPtr );
-      }
-      else
-      {
-        QgsDebugMsg( "No wkb fragments" );
-        delete [] wkbPtr;
-      }
+      addGeometryPart( point );
     }
   }
   else if ( isGMLNS && ( LOCALNAME_EQUALS( "LineString" ) || LOCALNAME_EQUALS( "LineStringSegment" ) ) )
   {
-    //add WKB point to the feature
+    //add line to the feature
 
-    QList<QgsPointXY> pointList;
-    if ( pointsFromString( pointList, mStringCash ) != 0 )
+    QVector<double> x, y;
+    if ( pointsFromString( x, y, mCoordinateBuffer ) != 0 )
     {
       //error
     }
+
+    QgsLineString *line = new QgsLineString( x, y );
     if ( parseMode == QgsGmlStreamingParser::Geometry )
     {
-      if ( getLineWKB( mCurrentWKB, pointList ) != 0 )
-      {
-        //error
-      }
+      setCurrentGeometry( line );
 
       if ( mWkbType != QgsWkbTypes::MultiLineString )//keep multitype in case of geometry type mix
       {
         mWkbType = QgsWkbTypes::LineString;
       }
     }
-    else //multiline, add WKB as fragment
+    else //multiline, add line as part
     {
-      QgsWkbPtr wkbPtr( nullptr, 0 );
-      if ( getLineWKB( wkbPtr, pointList ) != 0 )
-      {
-        //error
-      }
-      if ( !mCurrentWKBFragments.isEmpty() )
-      {
-        mCurrentWKBFragments.last().push_back( wkbPtr );
-      }
-      else
-      {
-        QgsDebugMsg( "no wkb fragments" );
-        delete [] wkbPtr;
-      }
+      addGeometryPart( line );
     }
   }
   else if ( ( parseMode == Geometry || parseMode == MultiPolygon ) &&
             isGMLNS && LOCALNAME_EQUALS( "LinearRing" ) )
   {
-    QList<QgsPointXY> pointList;
-    if ( pointsFromString( pointList, mStringCash ) != 0 )
-    {
-      //error
-    }
-
-    QgsWkbPtr wkbPtr( nullptr, 0 );
-    if ( getRingWKB( wkbPtr, pointList ) != 0 )
+    QVector<double> x, y;
+    if ( pointsFromString( x, y, mCoordinateBuffer ) != 0 )
     {
       //error
     }
 
-    if ( !mCurrentWKBFragments.isEmpty() )
-    {
-      mCurrentWKBFragments.last().push_back( wkbPtr );
-    }
-    else
-    {
-      delete[] wkbPtr;
-      QgsDebugMsg( "no wkb fragments" );
-    }
+    addGeometryPart( new QgsLineString( x, y ) );
   }
   else if ( ( parseMode == Geometry || parseMode == MultiPolygon ) && isGMLNS &&
             LOCALNAME_EQUALS( "Polygon" ) )
@@ -1098,7 +1155,7 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
 
     if ( parseMode == Geometry )
     {
-      createPolygonFromFragments();
+      createPolygonFromParts();
     }
   }
   else if ( parseMode == MultiPoint &&  isGMLNS &&
@@ -1106,21 +1163,21 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   {
     mWkbType = QgsWkbTypes::MultiPoint;
     mParseModeStack.pop();
-    createMultiPointFromFragments();
+    createMultiPointFromParts();
   }
   else if ( parseMode == MultiLine && isGMLNS &&
             ( LOCALNAME_EQUALS( "MultiLineString" )  || LOCALNAME_EQUALS( "MultiCurve" ) ) )
   {
     mWkbType = QgsWkbTypes::MultiLineString;
     mParseModeStack.pop();
-    createMultiLineFromFragments();
+    createMultiLineFromParts();
   }
   else if ( parseMode == MultiPolygon && isGMLNS &&
             ( LOCALNAME_EQUALS( "MultiPolygon" )  || LOCALNAME_EQUALS( "MultiSurface" ) ) )
   {
     mWkbType = QgsWkbTypes::MultiPolygon;
     mParseModeStack.pop();
-    createMultiPolygonFromFragments();
+    createMultiPolygonFromParts();
   }
   else if ( mParseDepth == 0 && LOCALNAME_EQUALS( "ExceptionReport" ) )
   {
@@ -1143,7 +1200,7 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
 
 void QgsGmlStreamingParser::characters( const XML_Char *chars, int len )
 {
-  //save chars in mStringCash attribute mode or coordinate mode
+  //save chars in mStringCash in attribute mode, or in mCoordinateBuffer in coordinate mode
   if ( mParseModeStack.isEmpty() )
   {
     return;
@@ -1155,13 +1212,17 @@ void QgsGmlStreamingParser::characters( const XML_Char *chars, int len )
   }
 
   QgsGmlStreamingParser::ParseMode parseMode = mParseModeStack.top();
-  if ( parseMode == QgsGmlStreamingParser::Attribute ||
-       parseMode == QgsGmlStreamingParser::AttributeTuple ||
-       parseMode == QgsGmlStreamingParser::Coordinate ||
+  if ( parseMode == QgsGmlStreamingParser::Coordinate ||
        parseMode == QgsGmlStreamingParser::PosList ||
        parseMode == QgsGmlStreamingParser::LowerCorner ||
-       parseMode == QgsGmlStreamingParser::UpperCorner ||
-       parseMode == QgsGmlStreamingParser::ExceptionText )
+       parseMode == QgsGmlStreamingParser::UpperCorner )
+  {
+    // coordinates are tokenized from the raw UTF-8 bytes, without going through QString
+    mCoordinateBuffer.append( chars, len );
+  }
+  else if ( parseMode == QgsGmlStreamingParser::Attribute ||
+            parseMode == QgsGmlStreamingParser::AttributeTuple ||
+            parseMode == QgsGmlStreamingParser::ExceptionText )
   {
     mStringCash.append( QString::fromUtf8( chars, len ) );
   }
@@ -1262,253 +1323,277 @@ QString QgsGmlStreamingParser::readAttribute( const QString &attributeName, cons
   return QString();
 }
 
-bool QgsGmlStreamingParser::createBBoxFromCoordinateString( QgsRectangle &r, const QString &coordString ) const
+bool QgsGmlStreamingParser::createBBoxFromCoordinateString( QgsRectangle &r, const QByteArray &coordString ) const
 {
-  QList<QgsPointXY> points;
-  if ( pointsFromCoordinateString( points, coordString ) != 0 )
+  QVector<double> x, y;
+  if ( pointsFromCoordinateString( x, y, coordString ) != 0 )
   {
     return false;
   }
 
-  if ( points.size() < 2 )
+  if ( x.size() < 2 )
   {
     return false;
   }
 
-  r.set( points[0], points[1] );
+  r.set( QgsPointXY( x.at( 0 ), y.at( 0 ) ), QgsPointXY( x.at( 1 ), y.at( 1 ) ) );
 
   return true;
 }
 
-int QgsGmlStreamingParser::pointsFromCoordinateString( QList<QgsPointXY> &points, const QString &coordString ) const
+int QgsGmlStreamingParser::pointsFromCoordinateString( QVector<double> &x, QVector<double> &y, const QByteArray &coordString ) const
 {
-  //tuples are separated by space, x/y by ','
-  QStringList tuples = coordString.split( mTupleSeparator, QString::SkipEmptyParts );
-  QStringList tuples_coordinates;
-  double x, y;
-  bool conversionSuccess;
+  if ( mCoordinateSeparator.size() != 1 || mTupleSeparator.size() != 1 ||
+       mCoordinateSeparator.at( 0 ).unicode() >= 0x80 || mTupleSeparator.at( 0 ).unicode() >= 0x80 )
+  {
+    // unusual separators, split the decoded string
+    QStringList tuples = QString::fromUtf8( coordString ).split( mTupleSeparator, QString::SkipEmptyParts );
+    Q_FOREACH ( const QString &tuple, tuples )
+    {
+      QStringList tupleCoordinates = tuple.split( mCoordinateSeparator, QString::SkipEmptyParts );
+      if ( tupleCoordinates.size() < 2 )
+      {
+        continue;
+      }
+      bool xOk, yOk;
+      double coord1 = tupleCoordinates.at( 0 ).toDouble( &xOk );
+      double coord2 = tupleCoordinates.at( 1 ).toDouble( &yOk );
+      if ( xOk && yOk )
+      {
+        appendPoint( x, y, coord1, coord2 );
+      }
+    }
+    return 0;
+  }
 
-  QStringList::const_iterator tupleIterator;
-  for ( tupleIterator = tuples.constBegin(); tupleIterator != tuples.constEnd(); ++tupleIterator )
+  //tuples are separated by space (or by any white space if the tuple separator is a white space), x/y by ','
+  const char coordinateSeparator = mCoordinateSeparator.at( 0 ).toLatin1();
+  const char tupleSeparator = mTupleSeparator.at( 0 ).toLatin1();
+  const bool tupleSeparatorIsSpace = isCoordinateSpace( tupleSeparator );
+  const char *p = coordString.constData();
+  const char *end = p + coordString.size();
+  while ( p < end )
   {
-    tuples_coordinates = tupleIterator->split( mCoordinateSeparator, QString::SkipEmptyParts );
-    if ( tuples_coordinates.size() < 2 )
+    const char *tupleEnd = p;
+    while ( tupleEnd < end && *tupleEnd != tupleSeparator &&
+            !( tupleSeparatorIsSpace && isCoordinateSpace( *tupleEnd ) ) )
     {
-      continue;
+      ++tupleEnd;
     }
-    x = tuples_coordinates.at( 0 ).toDouble( &conversionSuccess );
-    if ( !conversionSuccess )
+
+    // only the first two coordinates of a tuple are used
+    double coords[2];
+    int coordCount = 0;
+    bool conversionSuccess = true;
+    for ( const char *coordStart = p; coordStart < tupleEnd && coordCount < 2; )
     {
-      continue;
+      const char *coordEnd = static_cast< const char * >( memchr( coordStart, coordinateSeparator, tupleEnd - coordStart ) );
+      if ( !coordEnd )
+        coordEnd = tupleEnd;
+      if ( coordEnd > coordStart )
+      {
+        if ( !parseCoordinate( coordStart, coordEnd, coords[coordCount] ) )
+        {
+          conversionSuccess = false;
+          break;
+        }
+        ++coordCount;
+      }
+      coordStart = coordEnd + 1;
     }
-    y = tuples_coordinates.at( 1 ).toDouble( &conversionSuccess );
-    if ( !conversionSuccess )
+    if ( conversionSuccess && coordCount == 2 )
     {
-      continue;
+      appendPoint( x, y, coords[0], coords[1] );
     }
-    points.push_back( ( mInvertAxisOrientation ) ? QgsPointXY( y, x ) : QgsPointXY( x, y ) );
+
+    p = tupleEnd + 1;
   }
   return 0;
 }
 
-int QgsGmlStreamingParser::pointsFromPosListString( QList<QgsPointXY> &points, const QString &coordString, int dimension ) const
+int QgsGmlStreamingParser::pointsFromPosListString( QVector<double> &x, QVector<double> &y, const QByteArray &coordString, int dimension ) const
 {
-  // coordinates separated by spaces
-  QStringList coordinates = coordString.split( ' ', QString::SkipEmptyParts );
-
-  if ( coordinates.size() % dimension != 0 )
+  if ( dimension < 2 )
   {
-    QgsDebugMsg( "Wrong number of coordinates" );
+    dimension = 2;
   }
 
-  int ncoor = coordinates.size() / dimension;
-  for ( int i = 0; i < ncoor; i++ )
+  // coordinates separated by white space, only the first two coordinates of each position are used
+  const char *p = coordString.constData();
+  const char *end = p + coordString.size();
+  int component = 0;
+  double coords[2] = { 0, 0 };
+  bool conversionSuccess = true;
+  while ( true )
   {
-    bool conversionSuccess;
-    double x = coordinates.value( i * dimension ).toDouble( &conversionSuccess );
-    if ( !conversionSuccess )
+    while ( p < end && isCoordinateSpace( *p ) )
+      ++p;
+    if ( p == end )
+      break;
+
+    const char *coordEnd = p;
+    while ( coordEnd < end && !isCoordinateSpace( *coordEnd ) )
+      ++coordEnd;
+
+    if ( component < 2 && !parseCoordinate( p, coordEnd, coords[component] ) )
     {
-      continue;
+      conversionSuccess = false;
     }
-    double y = coordinates.value( i * dimension + 1 ).toDouble( &conversionSuccess );
-    if ( !conversionSuccess )
+    if ( ++component == dimension )
     {
-      continue;
+      if ( conversionSuccess )
+      {
+        appendPoint( x, y, coords[0], coords[1] );
+      }
+      component = 0;
+      conversionSuccess = true;
     }
-    points.append( ( mInvertAxisOrientation ) ? QgsPointXY( y, x ) : QgsPointXY( x, y ) );
+    p = coordEnd;
+  }
+
+  if ( component != 0 )
+  {
+    QgsDebugMsg( "Wrong number of coordinates" );
   }
   return 0;
 }
 
-int QgsGmlStreamingParser::pointsFromString( QList<QgsPointXY> &points, const QString &coordString ) const
+int QgsGmlStreamingParser::pointsFromString( QVector<double> &x, QVector<double> &y, const QByteArray &coordString ) const
 {
   if ( mCoorMode == QgsGmlStreamingParser::Coordinate )
   {
-    return pointsFromCoordinateString( points, coordString );
+    return pointsFromCoordinateString( x, y, coordString );
   }
   else if ( mCoorMode == QgsGmlStreamingParser::PosList )
   {
-    return pointsFromPosListString( points, coordString, mDimension ? mDimension : 2 );
+    return pointsFromPosListString( x, y, coordString, mDimension ? mDimension : 2 );
   }
   return 1;
 }
 
-int QgsGmlStreamingParser::getPointWKB( QgsWkbPtr &wkbPtr, const QgsPointXY &point ) const
-{
-  int wkbSize = 1 + sizeof( int ) + 2 * sizeof( double );
-  wkbPtr = QgsWkbPtr( new unsigned char[wkbSize], wkbSize );
-
-  QgsWkbPtr fillPtr( wkbPtr );
-  fillPtr << mEndian << QgsWkbTypes::Point << point.x() << point.y();
-
-  return 0;
-}
-
-int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &lineCoordinates ) const
+void QgsGmlStreamingParser::appendPoint( QVector<double> &x, QVector<double> &y, double coord1, double coord2 ) const
 {
-  int wkbSize = 1 + 2 * sizeof( int ) + lineCoordinates.size() * 2 * sizeof( double );
-  wkbPtr = QgsWkbPtr( new unsigned char[wkbSize], wkbSize );
-
-  QgsWkbPtr fillPtr( wkbPtr );
-
-  fillPtr << mEndian << QgsWkbTypes::LineString << lineCoordinates.size();
-
-  QList<QgsPointXY>::const_iterator iter;
-  for ( iter = lineCoordinates.constBegin(); iter != lineCoordinates.constEnd(); ++iter )
+  if ( mInvertAxisOrientation )
   {
-    fillPtr << iter->x() << iter->y();
+    x.append( coord2 );
+    y.append( coord1 );
+  }
+  else
+  {
+    x.append( coord1 );
+    y.append( coord2 );
   }
-
-  return 0;
 }
 
-int QgsGmlStreamingParser::getRingWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &ringCoordinates ) const
+void QgsGmlStreamingParser::setCurrentGeometry( QgsAbstractGeometry *geometry )
 {
-  int wkbSize = sizeof( int ) + ringCoordinates.size() * 2 * sizeof( double );
-  wkbPtr = QgsWkbPtr( new unsigned char[wkbSize], wkbSize );
-
-  QgsWkbPtr fillPtr( wkbPtr );
-
-  fillPtr << ringCoordinates.size();
+  delete mCurrentGeometry;
+  mCurrentGeometry = geometry;
+}
 
-  QList<QgsPointXY>::const_iterator iter;
-  for ( iter = ringCoordinates.constBegin(); iter != ringCoordinates.constEnd(); ++iter )
+void QgsGmlStreamingParser::addGeometryPart( QgsAbstractGeometry *part )
+{
+  if ( !mCurrentGeometryParts.isEmpty() )
   {
-    fillPtr << iter->x() << iter->y();
+    mCurrentGeometryParts.last().push_back( part );
+  }
+  else
+  {
+    QgsDebugMsg( "no geometry parts" );
+    delete part;
   }
-
-  return 0;
 }
 
-int QgsGmlStreamingParser::createMultiLineFromFragments()
+int QgsGmlStreamingParser::createMultiLineFromParts()
 {
-  int size = 1 + 2 * sizeof( int ) + totalWKBFragmentSize();
-  mCurrentWKB = QgsWkbPtr( new unsigned char[size], size );
-
-  QgsWkbPtr wkbPtr( mCurrentWKB );
-
-  wkbPtr << mEndian << QgsWkbTypes::MultiLineString << mCurrentWKBFragments.constBegin()->size();
-
-  //copy (and delete) all the wkb fragments
-  QList<QgsWkbPtr>::const_iterator wkbIt = mCurrentWKBFragments.constBegin()->constBegin();
-  for ( ; wkbIt != mCurrentWKBFragments.constBegin()->constEnd(); ++wkbIt )
+  QgsMultiLineString *multiLine = new QgsMultiLineString();
+  if ( !mCurrentGeometryParts.isEmpty() )
   {
-    memcpy( wkbPtr, *wkbIt, wkbIt->size() );
-    wkbPtr += wkbIt->size();
-    delete[] *wkbIt;
+    Q_FOREACH ( QgsAbstractGeometry *line, mCurrentGeometryParts.first() )
+    {
+      multiLine->addGeometry( line );
+    }
+    mCurrentGeometryParts.first().clear();
   }
-
-  mCurrentWKBFragments.clear();
+  clearGeometryParts();
+  setCurrentGeometry( multiLine );
   mWkbType = QgsWkbTypes::MultiLineString;
   return 0;
 }
 
-int QgsGmlStreamingParser::createMultiPointFromFragments()
+int QgsGmlStreamingParser::createMultiPointFromParts()
 {
-  int size = 1 + 2 * sizeof( int ) + totalWKBFragmentSize();
-  mCurrentWKB = QgsWkbPtr( new unsigned char[size], size );
-
-  QgsWkbPtr wkbPtr( mCurrentWKB );
-  wkbPtr << mEndian << QgsWkbTypes::MultiPoint << mCurrentWKBFragments.constBegin()->size();
-
-  QList<QgsWkbPtr>::const_iterator wkbIt = mCurrentWKBFragments.constBegin()->constBegin();
-  for ( ; wkbIt != mCurrentWKBFragments.constBegin()->constEnd(); ++wkbIt )
+  QgsMultiPointV2 *multiPoint = new QgsMultiPointV2();
+  if ( !mCurrentGeometryParts.isEmpty() )
   {
-    memcpy( wkbPtr, *wkbIt, wkbIt->size() );
-    wkbPtr += wkbIt->size();
-    delete[] *wkbIt;
+    Q_FOREACH ( QgsAbstractGeometry *point, mCurrentGeometryParts.first() )
+    {
+      multiPoint->addGeometry( point );
+    }
+    mCurrentGeometryParts.first().clear();
   }
-
-  mCurrentWKBFragments.clear();
+  clearGeometryParts();
+  setCurrentGeometry( multiPoint );
   mWkbType = QgsWkbTypes::MultiPoint;
   return 0;
 }
 
-
-int QgsGmlStreamingParser::createPolygonFromFragments()
+int QgsGmlStreamingParser::createPolygonFromParts()
 {
-  int size = 1 + 2 * sizeof( int ) + totalWKBFragmentSize();
-  mCurrentWKB = QgsWkbPtr( new unsigned char[size], size );
-
-  QgsWkbPtr wkbPtr( mCurrentWKB );
-  wkbPtr << mEndian << QgsWkbTypes::Polygon << mCurrentWKBFragments.constBegin()->size();
-
-  QList<QgsWkbPtr>::const_iterator wkbIt = mCurrentWKBFragments.constBegin()->constBegin();
-  for ( ; wkbIt != mCurrentWKBFragments.constBegin()->constEnd(); ++wkbIt )
+  QgsPolygonV2 *polygon = mCurrentGeometryParts.isEmpty() ? new QgsPolygonV2() : polygonFromRings( mCurrentGeometryParts.first() );
+  if ( !mCurrentGeometryParts.isEmpty() )
   {
-    memcpy( wkbPtr, *wkbIt, wkbIt->size() );
-    wkbPtr += wkbIt->size();
-    delete[] *wkbIt;
+    mCurrentGeometryParts.first().clear();
   }
-
-  mCurrentWKBFragments.clear();
+  clearGeometryParts();
+  setCurrentGeometry( polygon );
   mWkbType = QgsWkbTypes::Polygon;
   return 0;
 }
 
-int QgsGmlStreamingParser::createMultiPolygonFromFragments()
+int QgsGmlStreamingParser::createMultiPolygonFromParts()
 {
-  int size = 0;
-  size += 1 + 2 * sizeof( int );
-  size += totalWKBFragmentSize();
-  size += mCurrentWKBFragments.size() * ( 1 + 2 * sizeof( int ) ); //fragments are just the rings
-
-  mCurrentWKB = QgsWkbPtr( new unsigned char[size], size );
-
-  QgsWkbPtr wkbPtr( mCurrentWKB );
-  wkbPtr << ( char ) mEndian << QgsWkbTypes::MultiPolygon << mCurrentWKBFragments.size();
-
-  //have outer and inner iterators
-  QList< QList<QgsWkbPtr> >::const_iterator outerWkbIt = mCurrentWKBFragments.constBegin();
-
-  for ( ; outerWkbIt != mCurrentWKBFragments.constEnd(); ++outerWkbIt )
+  QgsMultiPolygonV2 *multiPolygon = new QgsMultiPolygonV2();
+  for ( int i = 0; i < mCurrentGeometryParts.size(); ++i )
   {
-    //new polygon
-    wkbPtr << ( char ) mEndian << QgsWkbTypes::Polygon << outerWkbIt->size();
-
-    QList<QgsWkbPtr>::const_iterator innerWkbIt = outerWkbIt->constBegin();
-    for ( ; innerWkbIt != outerWkbIt->constEnd(); ++innerWkbIt )
-    {
-      memcpy( wkbPtr, *innerWkbIt, innerWkbIt->size() );
-      wkbPtr += innerWkbIt->size();
-      delete[] *innerWkbIt;
-    }
+    multiPolygon->addGeometry( polygonFromRings( mCurrentGeometryParts.at( i ) ) );
   }
-
-  mCurrentWKBFragments.clear();
+  mCurrentGeometryParts.clear();
+  setCurrentGeometry( multiPolygon );
   mWkbType = QgsWkbTypes::MultiPolygon;
   return 0;
 }
 
-int QgsGmlStreamingParser::totalWKBFragmentSize() const
+QgsPolygonV2 *QgsGmlStreamingParser::polygonFromRings( const QList<QgsAbstractGeometry *> &rings )
 {
-  int result = 0;
-  Q_FOREACH ( const QList<QgsWkbPtr> &list, mCurrentWKBFragments )
+  QgsPolygonV2 *polygon = new QgsPolygonV2();
+  bool hasExteriorRing = false;
+  Q_FOREACH ( QgsAbstractGeometry *part, rings )
   {
-    Q_FOREACH ( const QgsWkbPtr &i, list )
+    QgsLineString *ring = qgsgeometry_cast< QgsLineString * >( part );
+    if ( !ring )
     {
-      result += i.size();
+      QgsDebugMsg( "ignoring a non ring polygon part" );
+      delete part;
     }
+    else if ( !hasExteriorRing )
+    {
+      polygon->setExteriorRing( ring );
+      hasExteriorRing = true;
+    }
+    else
+    {
+      polygon->addInteriorRing( ring );
+    }
+  }
+  return polygon;
+}
+
+void QgsGmlStreamingParser::clearGeometryParts()
+{
+  Q_FOREACH ( const QList<QgsAbstractGeometry *> &parts, mCurrentGeometryParts )
+  {
+    qDeleteAll( parts );
   }
-  return result;
+  mCurrentGeometryParts.clear();
 }
@@ -32,7 +32,9 @@
 
 #include <string>
 
+class QgsAbstractGeometry;
 class QgsCoordinateReferenceSystem;
+class QgsPolygonV2;
 
 #ifndef SIP_RUN
 
@@ -198,39 +200,50 @@ class CORE_EXPORT QgsGmlStreamingParser
       */
     QString readAttribute( const QString &attributeName, const XML_Char **attr ) const;
     //! Creates a rectangle from a coordinate string.
-    bool createBBoxFromCoordinateString( QgsRectangle &bb, const QString &coordString ) const;
+    bool createBBoxFromCoordinateString( QgsRectangle &bb, const QByteArray &coordString ) const;
 
     /** Creates a set of points from a coordinate string.
-       \param points list that will contain the created points
+       \param x vector that will contain the x coordinates of the created points
+       \param y vector that will contain the y coordinates of the created points
        \param coordString the text containing the coordinates
        \returns 0 in case of success
       */
-    int pointsFromCoordinateString( QList<QgsPointXY> &points, const QString &coordString ) const;
+    int pointsFromCoordinateString( QVector<double> &x, QVector<double> &y, const QByteArray &coordString ) const;
 
     /** Creates a set of points from a gml:posList or gml:pos coordinate string.
-       \param points list that will contain the created points
+       \param x vector that will contain the x coordinates of the created points
+       \param y vector that will contain the y coordinates of the created points
        \param coordString the text containing the coordinates
        \param dimension number of dimensions
        \returns 0 in case of success
       */
-    int pointsFromPosListString( QList<QgsPointXY> &points, const QString &coordString, int dimension ) const;
+    int pointsFromPosListString( QVector<double> &x, QVector<double> &y, const QByteArray &coordString, int dimension ) const;
 
-    int pointsFromString( QList<QgsPointXY> &points, const QString &coordString ) const;
-    int getPointWKB( QgsWkbPtr &wkbPtr, const QgsPointXY & ) const;
-    int getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &lineCoordinates ) const;
-    int getRingWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &ringCoordinates ) const;
+    int pointsFromString( QVector<double> &x, QVector<double> &y, const QByteArray &coordString ) const;
 
-    /** Creates a multiline from the information in mCurrentWKBFragments and
-     * mCurrentWKBFragmentSizes. Assign the result. The multiline is in
-     * mCurrentWKB. The function deletes the memory in
-     * mCurrentWKBFragments. Returns 0 in case of success.
+    //! Appends a point to \a x and \a y, taking care of the axis orientation
+    void appendPoint( QVector<double> &x, QVector<double> &y, double coord1, double coord2 ) const;
+
+    //! Replaces the geometry of the current feature
+    void setCurrentGeometry( QgsAbstractGeometry *geometry );
+
+    //! Adds a point, line or ring to the innermost list of mCurrentGeometryParts
+    void addGeometryPart( QgsAbstractGeometry *part );
+
+    /** Creates a multiline from the lines in mCurrentGeometryParts and makes it
+     * the current geometry. The function empties mCurrentGeometryParts.
+     * Returns 0 in case of success.
      */
-    int createMultiLineFromFragments();
-    int createMultiPointFromFragments();
-    int createPolygonFromFragments();
-    int createMultiPolygonFromFragments();
-    //! Adds all the integers contained in mCurrentWKBFragmentSizes
-    int totalWKBFragmentSize() const;
+    int createMultiLineFromParts();
+    int createMultiPointFromParts();
+    int createPolygonFromParts();
+    int createMultiPolygonFromParts();
+
+    //! Creates a polygon from a list of rings, the first ring being the exterior one
+    static QgsPolygonV2 *polygonFromRings( const QList<QgsAbstractGeometry *> &rings );
+
+    //! Deletes all the geometries contained in mCurrentGeometryParts
+    void clearGeometryParts();
 
     //! Get safely (if empty) top from mode stack
     ParseMode modeStackTop() { return mParseModeStack.isEmpty() ? None : mParseModeStack.top(); }
@@ -278,22 +291,23 @@ class CORE_EXPORT QgsGmlStreamingParser
     QStack<ParseMode> mParseModeStack;
     //! This contains the character data if an important element has been encountered
     QString mStringCash;
+    //! Raw character data of coordinates, pos, posList, lowerCorner and upperCorner elements
+    QByteArray mCoordinateBuffer;
     QgsFeature *mCurrentFeature = nullptr;
     QVector<QVariant> mCurrentAttributes; //attributes of current feature
     QString mCurrentFeatureId;
     int mFeatureCount;
-    //! The total WKB for a feature
-    QgsWkbPtr mCurrentWKB;
+    //! The geometry of the current feature, constructed directly from the parsed coordinates
+    QgsAbstractGeometry *mCurrentGeometry = nullptr;
     QgsRectangle mCurrentExtent;
     bool mBoundedByNullFound;
 
-    /** WKB intermediate storage during parsing. For points and lines, no
-     * intermediate WKB is stored at all. For multipoints and multilines and
-     * polygons, only one nested list is used. For multipolygons, both nested lists
-     * are used*/
-    QList< QList<QgsWkbPtr> > mCurrentWKBFragments;
+    /** Intermediate geometry storage during parsing. For points and lines, no
+     * intermediate geometry is stored at all. For multipoints and multilines and
+     * polygons, only one nested list is used. For multipolygons, one nested
+     * list per polygon is used*/
+    QList< QList<QgsAbstractGeometry *> > mCurrentGeometryParts;
     QString mAttributeName;
-    char mEndian;
     //! Coordinate separator for coordinate strings. Usually ","
     QString mCoordinateSeparator;
     //! Tuple separator for coordinate strings. Usually " "
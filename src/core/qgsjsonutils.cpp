@@ -25,10 +25,332 @@
 #include "qgslogger.h"
 #include "qgsfieldformatterregistry.h"
 #include "qgsfieldformatter.h"
+#include "qgslinestring.h"
+#include "qgsmultilinestring.h"
+#include "qgsmultipoint.h"
+#include "qgsmultipolygon.h"
+#include "qgspolygon.h"
 
+#include <QIODevice>
 #include <QJsonDocument>
 #include <QJsonArray>
 
+#include <cmath>
+#include <limits>
+
+static const char *FEATURE_COLLECTION_START = "{ \"type\": \"FeatureCollection\",\n    \"features\":[\n";
+static const char *FEATURE_SEPARATOR = ",\n";
+static const char *FEATURE_COLLECTION_END = "\n]}";
+
+//! Size above which streamed features are flushed to the output device
+static const int WRITE_BUFFER_SIZE = 1 << 16;
+
+//! Powers of ten which are exactly representable as doubles
+static const double EXACT_POWERS_OF_TEN[] =
+{
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+static bool writeBytes( QIODevice *device, const QByteArray &bytes )
+{
+  return device && device->write( bytes ) == bytes.size();
+}
+
+static void appendInteger( QByteArray &json, qint64 value )
+{
+  char buffer[24];
+  char *end = buffer + sizeof( buffer );
+  char *p = end;
+  quint64 magnitude = value < 0 ? 0 - static_cast< quint64 >( value ) : static_cast< quint64 >( value );
+  do
+  {
+    *--p = static_cast< char >( '0' + magnitude % 10 );
+    magnitude /= 10;
+  }
+  while ( magnitude );
+  if ( value < 0 )
+    *--p = '-';
+  json.append( p, static_cast< int >( end - p ) );
+}
+
+/**
+ * Appends a number formatted exactly like qgsDoubleToString() does. The value is
+ * scaled and rounded to an integer, which is only trusted when the rounding error of
+ * the scaling cannot change the result. Other values use qgsDoubleToString().
+ */
+static void appendDouble( QByteArray &json, double value, int precision )
+{
+  if ( precision >= 0 && precision <= 15 && std::isfinite( value ) )
+  {
+    const double scaled = value * EXACT_POWERS_OF_TEN[precision];
+    const double rounded = std::round( scaled );
+    const double maxError = std::fabs( scaled ) * std::numeric_limits< double >::epsilon();
+    if ( std::fabs( scaled ) < 4503599627370496.0 /* 2^52 */ &&
+         std::fabs( std::fabs( scaled - rounded ) - 0.5 ) > maxError &&
+         ( rounded != 0 || !std::signbit( value ) ) )
+    {
+      const qint64 units = static_cast< qint64 >( rounded );
+      const qint64 divisor = static_cast< qint64 >( EXACT_POWERS_OF_TEN[precision] );
+      const qint64 absUnits = units < 0 ? -units : units;
+      if ( units < 0 )
+        json += '-';
+      appendInteger( json, absUnits / divisor );
+
+      qint64 fraction = absUnits % divisor;
+      if ( fraction )
+      {
+        // trailing zeros are removed, as in qgsDoubleToString()
+        int digits = precision;
+        while ( fraction % 10 == 0 )
+        {
+          fraction /= 10;
+          --digits;
+        }
+        char buffer[16];
+        buffer[0] = '.';
+        for ( int i = digits; i > 0; --i )
+        {
+          buffer[i] = static_cast< char >( '0' + fraction % 10 );
+          fraction /= 10;
+        }
+        json.append( buffer, digits + 1 );
+      }
+      return;
+    }
+  }
+  json += qgsDoubleToString( value, precision ).toUtf8();
+}
+
+//! Appends an UTF-8 string, quoted and escaped like QgsJsonUtils::encodeValue() does
+static void appendString( QByteArray &json, const QByteArray &string )
+{
+  json += '"';
+  const char *p = string.constData();
+  const char *end = p + string.size();
+  const char *chunkStart = p;
+  for ( ; p < end; ++p )
+  {
+    const char *escaped = nullptr;
+    switch ( *p )
+    {
+      case '\\':
+        escaped = "\\\\";
+        break;
+      case '"':
+        escaped = "\\\"";
+        break;
+      case '\r':
+        escaped = "\\r";
+        break;
+      case '\b':
+        escaped = "\\b";
+        break;
+      case '\t':
+        escaped = "\\t";
+        break;
+      case '/':
+        escaped = "\\/";
+        break;
+      case '\n':
+        escaped = "\\n";
+        break;
+      default:
+        continue;
+    }
+    json.append( chunkStart, static_cast< int >( p - chunkStart ) );
+    json += escaped;
+    chunkStart = p + 1;
+  }
+  json.append( chunkStart, static_cast< int >( p - chunkStart ) );
+  json += '"';
+}
+
+//! Appends a value encoded like QgsJsonUtils::encodeValue() does
+static void appendValue( QByteArray &json, const QVariant &value )
+{
+  if ( value.isNull() )
+  {
+    json += "null";
+    return;
+  }
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+      appendInteger( json, value.toLongLong() );
+      break;
+
+    case QVariant::String:
+      appendString( json, value.toString().toUtf8() );
+      break;
+
+    default:
+      json += QgsJsonUtils::encodeValue( value ).toUtf8();
+      break;
+  }
+}
+
+//! Appends the points of a line, in the layout of QgsGeometryUtils::pointsToJSON()
+static void appendPoints( QByteArray &json, const QgsLineString *line, int precision )
+{
+  json += "[ ";
+  for ( int i = 0, n = line->numPoints(); i < n; ++i )
+  {
+    if ( i > 0 )
+      json += ", ";
+    json += '[';
+    appendDouble( json, line->xAt( i ), precision );
+    json += ", ";
+    appendDouble( json, line->yAt( i ), precision );
+    json += ']';
+  }
+  json += ']';
+}
+
+//! Appends the rings of a polygon, or returns false if they are not all line strings
+static bool appendRings( QByteArray &json, const QgsPolygonV2 *polygon, int precision )
+{
+  const QgsLineString *exterior = qgsgeometry_cast< const QgsLineString * >( polygon->exteriorRing() );
+  if ( !exterior )
+    return false;
+  for ( int i = 0, n = polygon->numInteriorRings(); i < n; ++i )
+  {
+    if ( !qgsgeometry_cast< const QgsLineString * >( polygon->interiorRing( i ) ) )
+      return false;
+  }
+
+  appendPoints( json, exterior, precision );
+  for ( int i = 0, n = polygon->numInteriorRings(); i < n; ++i )
+  {
+    json += ", ";
+    appendPoints( json, static_cast< const QgsLineString * >( polygon->interiorRing( i ) ), precision );
+  }
+  return true;
+}
+
+/**
+ * Appends a geometry in the same layout as QgsAbstractGeometry::asJSON(). Linear
+ * geometries are written directly, everything else is converted with asJSON().
+ */
+static void appendGeometry( QByteArray &json, const QgsAbstractGeometry *geometry, int precision )
+{
+  const int start = json.size();
+  switch ( QgsWkbTypes::flatType( geometry->wkbType() ) )
+  {
+    case QgsWkbTypes::Point:
+    {
+      const QgsPoint *point = qgsgeometry_cast< const QgsPoint * >( geometry );
+      if ( !point )
+        break;
+      json += "{\"type\": \"Point\", \"coordinates\": [";
+      appendDouble( json, point->x(), precision );
+      json += ", ";
+      appendDouble( json, point->y(), precision );
+      json += "]}";
+      return;
+    }
+
+    case QgsWkbTypes::LineString:
+    {
+      const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( geometry );
+      if ( !line )
+        break;
+      json += "{\"type\": \"LineString\", \"coordinates\": ";
+      appendPoints( json, line, precision );
+      json += '}';
+      return;
+    }
+
+    case QgsWkbTypes::Polygon:
+    {
+      const QgsPolygonV2 *polygon = qgsgeometry_cast< const QgsPolygonV2 * >( geometry );
+      if ( !polygon )
+        break;
+      json += "{\"type\": \"Polygon\", \"coordinates\": [";
+      if ( !appendRings( json, polygon, precision ) )
+        break;
+      json += "] }";
+      return;
+    }
+
+    case QgsWkbTypes::MultiPoint:
+    {
+      const QgsMultiPointV2 *multiPoint = qgsgeometry_cast< const QgsMultiPointV2 * >( geometry );
+      if ( !multiPoint )
+        break;
+      json += "{\"type\": \"MultiPoint\", \"coordinates\": [ ";
+      for ( int i = 0, n = multiPoint->numGeometries(); i < n; ++i )
+      {
+        const QgsPoint *point = static_cast< const QgsPoint * >( multiPoint->geometryN( i ) );
+        if ( i > 0 )
+          json += ", ";
+        json += '[';
+        appendDouble( json, point->x(), precision );
+        json += ", ";
+        appendDouble( json, point->y(), precision );
+        json += ']';
+      }
+      json += "] }";
+      return;
+    }
+
+    case QgsWkbTypes::MultiLineString:
+    {
+      const QgsMultiLineString *multiLine = qgsgeometry_cast< const QgsMultiLineString * >( geometry );
+      if ( !multiLine )
+        break;
+      json += "{\"type\": \"MultiLineString\", \"coordinates\": [";
+      bool linear = true;
+      for ( int i = 0, n = multiLine->numGeometries(); i < n; ++i )
+      {
+        const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( multiLine->geometryN( i ) );
+        if ( !line )
+        {
+          linear = false;
+          break;
+        }
+        if ( i > 0 )
+          json += ", ";
+        appendPoints( json, line, precision );
+      }
+      if ( !linear )
+        break;
+      json += "] }";
+      return;
+    }
+
+    case QgsWkbTypes::MultiPolygon:
+    {
+      const QgsMultiPolygonV2 *multiPolygon = qgsgeometry_cast< const QgsMultiPolygonV2 * >( geometry );
+      if ( !multiPolygon )
+        break;
+      json += "{\"type\": \"MultiPolygon\", \"coordinates\": [";
+      bool linear = true;
+      for ( int i = 0, n = multiPolygon->numGeometries(); i < n && linear; ++i )
+      {
+        const QgsPolygonV2 *polygon = qgsgeometry_cast< const QgsPolygonV2 * >( multiPolygon->geometryN( i ) );
+        if ( i > 0 )
+          json += ", ";
+        json += '[';
+        linear = polygon && appendRings( json, polygon, precision );
+        json += ']';
+      }
+      if ( !linear )
+        break;
+      json += "] }";
+      return;
+    }
+
+    default:
+      break;
+  }
+
+  // curved or unusual geometry
+  json.truncate( start );
+  json += geometry->asJSON( precision ).toUtf8();
+}
+
 QgsJsonExporter::QgsJsonExporter( QgsVectorLayer *vectorLayer, int precision )
   : mPrecision( precision )
   , mIncludeGeometry( true )
@@ -73,10 +395,95 @@ QgsCoordinateReferenceSystem QgsJsonExporter::sourceCrs() const
 QString QgsJsonExporter::exportFeature( const QgsFeature &feature, const QVariantMap &extraProperties,
                                         const QVariant &id ) const
 {
-  QString s = QStringLiteral( "{\n   \"type\":\"Feature\",\n" );
+  QByteArray json;
+  appendFeature( json, feature, extraProperties, id );
+  return QString::fromUtf8( json );
+}
+
+QString QgsJsonExporter::exportFeatures( const QgsFeatureList &features ) const
+{
+  QByteArray json = FEATURE_COLLECTION_START;
+  for ( int i = 0; i < features.count(); ++i )
+  {
+    if ( i > 0 )
+      json += FEATURE_SEPARATOR;
+    appendFeature( json, features.at( i ), QVariantMap(), QVariant() );
+  }
+  json += FEATURE_COLLECTION_END;
+  return QString::fromUtf8( json );
+}
+
+bool QgsJsonExporter::writeFeature( QIODevice *device, const QgsFeature &feature, const QVariantMap &extraProperties, const QVariant &id ) const
+{
+  QByteArray json;
+  appendFeature( json, feature, extraProperties, id );
+  return writeBytes( device, json );
+}
+
+bool QgsJsonExporter::writeFeatures( QIODevice *device, QgsFeatureIterator &iterator ) const
+{
+  if ( !writeBytes( device, FEATURE_COLLECTION_START ) )
+    return false;
+
+  // the buffer is reused for all features, and flushed once large enough
+  QByteArray json;
+  json.reserve( WRITE_BUFFER_SIZE * 2 );
+  QgsFeature feature;
+  bool first = true;
+  while ( iterator.nextFeature( feature ) )
+  {
+    if ( !first )
+      json += FEATURE_SEPARATOR;
+    first = false;
+    appendFeature( json, feature, QVariantMap(), QVariant() );
+
+    if ( json.size() >= WRITE_BUFFER_SIZE )
+    {
+      if ( !writeBytes( device, json ) )
+        return false;
+      json.resize( 0 );
+    }
+  }
+  json += FEATURE_COLLECTION_END;
+  return writeBytes( device, json );
+}
+
+bool QgsJsonExporter::writeFeatures( QIODevice *device, const QgsFeatureList &features ) const
+{
+  if ( !writeBytes( device, FEATURE_COLLECTION_START ) )
+    return false;
+
+  QByteArray json;
+  json.reserve( WRITE_BUFFER_SIZE * 2 );
+  for ( int i = 0; i < features.count(); ++i )
+  {
+    if ( i > 0 )
+      json += FEATURE_SEPARATOR;
+    appendFeature( json, features.at( i ), QVariantMap(), QVariant() );
+
+    if ( json.size() >= WRITE_BUFFER_SIZE )
+    {
+      if ( !writeBytes( device, json ) )
+        return false;
+      json.resize( 0 );
+    }
+  }
+  json += FEATURE_COLLECTION_END;
+  return writeBytes( device, json );
+}
+
+void QgsJsonExporter::appendFeature( QByteArray &json, const QgsFeature &feature, const QVariantMap &extraProperties,
+                                     const QVariant &id ) const
+{
+  json += "{\n   \"type\":\"Feature\",\n";
 
   // ID
-  s += QStringLiteral( "   \"id\":%1,\n" ).arg( !id.isValid() ? QString::number( feature.id() ) : QgsJsonUtils::encodeValue( id ) );
+  json += "   \"id\":";
+  if ( !id.isValid() )
+    appendInteger( json, feature.id() );
+  else
+    appendValue( json, id );
+  json += ",\n";
 
   QgsGeometry geom = feature.geometry();
   if ( !geom.isNull() && mIncludeGeometry )
@@ -98,22 +505,29 @@ QString QgsJsonExporter::exportFeature( const QgsFeature &feature, const QVarian
 
     if ( QgsWkbTypes::flatType( geom.geometry()->wkbType() ) != QgsWkbTypes::Point )
     {
-      s += QStringLiteral( "   \"bbox\":[%1, %2, %3, %4],\n" ).arg( qgsDoubleToString( box.xMinimum(), mPrecision ),
-           qgsDoubleToString( box.yMinimum(), mPrecision ),
-           qgsDoubleToString( box.xMaximum(), mPrecision ),
-           qgsDoubleToString( box.yMaximum(), mPrecision ) );
+      json += "   \"bbox\":[";
+      appendDouble( json, box.xMinimum(), mPrecision );
+      json += ", ";
+      appendDouble( json, box.yMinimum(), mPrecision );
+      json += ", ";
+      appendDouble( json, box.xMaximum(), mPrecision );
+      json += ", ";
+      appendDouble( json, box.yMaximum(), mPrecision );
+      json += "],\n";
     }
-    s += QLatin1String( "   \"geometry\":\n   " );
-    s += geom.exportToGeoJSON( mPrecision );
-    s += QLatin1String( ",\n" );
+    json += "   \"geometry\":\n   ";
+    appendGeometry( json, geom.geometry(), mPrecision );
+    json += ",\n";
   }
   else
   {
-    s += QLatin1String( "   \"geometry\":null,\n" );
+    json += "   \"geometry\":null,\n";
   }
 
   // build up properties element
-  QString properties;
+  json += "   \"properties\":";
+  const int propertiesStart = json.size();
+  json += "{\n";
   int attributeCounter = 0;
   if ( mIncludeAttributes || !extraProperties.isEmpty() )
   {
@@ -129,7 +543,7 @@ QString QgsJsonExporter::exportFeature( const QgsFeature &feature, const QVarian
           continue;
 
         if ( attributeCounter > 0 )
-          properties += QLatin1String( ",\n" );
+          json += ",\n";
         QVariant val =  feature.attributes().at( i );
 
         if ( mLayer )
@@ -140,7 +554,10 @@ QString QgsJsonExporter::exportFeature( const QgsFeature &feature, const QVarian
             val = fieldFormatter->representValue( mLayer.data(), i, setup.config(), QVariant(), val );
         }
 
-        properties += QStringLiteral( "      \"%1\":%2" ).arg( fields.at( i ).name(), QgsJsonUtils::encodeValue( val ) );
+        json += "      \"";
+        json += fields.at( i ).name().toUtf8();
+        json += "\":";
+        appendValue( json, val );
 
         ++attributeCounter;
       }
@@ -152,9 +569,12 @@ QString QgsJsonExporter::exportFeature( const QgsFeature &feature, const QVarian
       for ( ; it != extraProperties.constEnd(); ++it )
       {
         if ( attributeCounter > 0 )
-          properties += QLatin1String( ",\n" );
+          json += ",\n";
 
-        properties += QStringLiteral( "      \"%1\":%2" ).arg( it.key(), QgsJsonUtils::encodeValue( it.value() ) );
+        json += "      \"";
+        json += it.key().toUtf8();
+        json += "\":";
+        appendValue( json, it.value() );
 
         ++attributeCounter;
       }
@@ -167,12 +587,15 @@ QString QgsJsonExporter::exportFeature( const QgsFeature &feature, const QVarian
       Q_FOREACH ( const QgsRelation &relation, relations )
       {
         if ( attributeCounter > 0 )
-          properties += QLatin1String( ",\n" );
+          json += ",\n";
+
+        json += "      \"";
+        json += relation.name().toUtf8();
+        json += "\":[";
 
         QgsFeatureRequest req = relation.getRelatedFeaturesRequest( feature );
         req.setFlags( QgsFeatureRequest::NoGeometry );
         QgsVectorLayer *childLayer = relation.referencingLayer();
-        QString relatedFeatureAttributes;
         if ( childLayer )
         {
           QgsFeatureIterator it = childLayer->getFeatures( req );
@@ -191,51 +614,32 @@ QString QgsJsonExporter::exportFeature( const QgsFeature &feature, const QVarian
           while ( it.nextFeature( relatedFet ) )
           {
             if ( relationFeatures > 0 )
-              relatedFeatureAttributes += QLatin1String( ",\n" );
+              json += ",\n";
 
-            relatedFeatureAttributes += QgsJsonUtils::exportAttributes( relatedFet, childLayer, attributeWidgetCaches );
+            json += QgsJsonUtils::exportAttributes( relatedFet, childLayer, attributeWidgetCaches ).toUtf8();
             relationFeatures++;
           }
         }
-        relatedFeatureAttributes.prepend( '[' ).append( ']' );
+        json += ']';
 
-        properties += QStringLiteral( "      \"%1\":%2" ).arg( relation.name(), relatedFeatureAttributes );
         attributeCounter++;
       }
     }
   }
 
-  bool hasProperties = attributeCounter > 0;
-
-  s += QLatin1String( "   \"properties\":" );
-  if ( hasProperties )
+  if ( attributeCounter > 0 )
   {
-    //read all attribute values from the feature
-    s += "{\n" + properties + "\n   }\n";
+    json += "\n   }\n";
   }
   else
   {
-    s += QLatin1String( "null\n" );
+    json.truncate( propertiesStart );
+    json += "null\n";
   }
 
-  s += '}';
-
-  return s;
+  json += '}';
 }
 
-QString QgsJsonExporter::exportFeatures( const QgsFeatureList &features ) const
-{
-  QStringList featureJSON;
-  Q_FOREACH ( const QgsFeature &feature, features )
-  {
-    featureJSON << exportFeature( feature );
-  }
-
-  return QStringLiteral( "{ \"type\": \"FeatureCollection\",\n    \"features\":[\n%1\n]}" ).arg( featureJSON.join( QStringLiteral( ",\n" ) ) );
-}
-
-
-
 //
 // QgsJsonUtils
 //
@@ -24,6 +24,8 @@
 #include "qgsvectorlayer.h"
 
 class QTextCodec;
+class QIODevice;
+class QgsFeatureIterator;
 
 /** \ingroup core
  * \class QgsJsonExporter
@@ -31,6 +33,10 @@ class QTextCodec;
  *
  * Note that geometries will be automatically reprojected to WGS84 to match GeoJSON spec
  * if either the source vector layer or source CRS is set.
+ *
+ * Besides returning strings, features can be written as UTF-8 directly to a QIODevice
+ * with writeFeature() and writeFeatures(). The latter streams a feature collection from
+ * a feature iterator, so that collections of any size are exported in constant memory.
  * \since QGIS 2.16
  */
 
@@ -172,8 +178,48 @@ class CORE_EXPORT QgsJsonExporter
      */
     QString exportFeatures( const QgsFeatureList &features ) const;
 
+    /** Writes a GeoJSON representation of a feature to a \a device, encoded as UTF-8.
+     * The output is identical to exportFeature(), without building an intermediate string.
+     * \param device device to write to, which must be open for writing
+     * \param feature feature to convert
+     * \param extraProperties map of extra attributes to include in feature's properties
+     * \param id optional ID to use as GeoJSON feature's ID instead of input feature's ID. If omitted, feature's
+     * ID is used.
+     * \returns true if the feature was completely written
+     * \see exportFeature()
+     * \since QGIS 3.0
+     */
+    bool writeFeature( QIODevice *device, const QgsFeature &feature,
+                       const QVariantMap &extraProperties = QVariantMap(),
+                       const QVariant &id = QVariant() ) const;
+
+    /** Writes a GeoJSON feature collection containing all features returned by an
+     * \a iterator to a \a device, encoded as UTF-8. Each feature is written as soon as
+     * it is fetched, so the memory used does not depend on the number of features.
+     * \param device device to write to, which must be open for writing
+     * \param iterator iterator for the features to convert
+     * \returns true if the feature collection was completely written
+     * \see exportFeatures()
+     * \since QGIS 3.0
+     */
+    bool writeFeatures( QIODevice *device, QgsFeatureIterator &iterator ) const;
+
+    /** Writes a GeoJSON feature collection of a list of \a features to a \a device,
+     * encoded as UTF-8. The output is identical to exportFeatures().
+     * \param device device to write to, which must be open for writing
+     * \param features features to convert
+     * \returns true if the feature collection was completely written
+     * \see exportFeatures()
+     * \since QGIS 3.0
+     */
+    bool writeFeatures( QIODevice *device, const QgsFeatureList &features ) const;
+
   private:
 
+    //! Appends the UTF-8 GeoJSON representation of a feature to \a json
+    void appendFeature( QByteArray &json, const QgsFeature &feature,
+                        const QVariantMap &extraProperties, const QVariant &id ) const;
+
     //! Maximum number of decimal places for geometry coordinates
     int mPrecision;
 
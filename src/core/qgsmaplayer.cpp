@@ -199,65 +199,43 @@ QPainter::CompositionMode QgsMapLayer::blendMode() const
 }
 
 
-bool QgsMapLayer::readLayerXml( const QDomElement &layerElement, const QgsReadWriteContext &context )
+QString QgsMapLayer::decodedSource( const QString &source, const QString &provider, const QgsReadWriteContext &context )
 {
-  bool layerError;
-
-  QDomNode mnl;
-  QDomElement mne;
-
-  // read provider
-  QString provider;
-  mnl = layerElement.namedItem( QStringLiteral( "provider" ) );
-  mne = mnl.toElement();
-  provider = mne.text();
-
-  // set data source
-  mnl = layerElement.namedItem( QStringLiteral( "datasource" ) );
-  mne = mnl.toElement();
-  mDataSource = mne.text();
-
-  // if the layer needs authentication, ensure the master password is set
-  QRegExp rx( "authcfg=([a-z]|[A-Z]|[0-9]){7}" );
-  if ( ( rx.indexIn( mDataSource ) != -1 )
-       && !QgsAuthManager::instance()->setMasterPassword( true ) )
-  {
-    return false;
-  }
+  QString dataSource = source;
 
   // TODO: this should go to providers
   if ( provider == QLatin1String( "spatialite" ) )
   {
-    QgsDataSourceUri uri( mDataSource );
+    QgsDataSourceUri uri( dataSource );
     uri.setDatabase( context.pathResolver().readPath( uri.database() ) );
-    mDataSource = uri.uri();
+    dataSource = uri.uri();
   }
   else if ( provider == QLatin1String( "ogr" ) )
   {
-    QStringList theURIParts = mDataSource.split( '|' );
+    QStringList theURIParts = dataSource.split( '|' );
     theURIParts[0] = context.pathResolver().readPath( theURIParts[0] );
-    mDataSource = theURIParts.join( QStringLiteral( "|" ) );
+    dataSource = theURIParts.join( QStringLiteral( "|" ) );
   }
   else if ( provider == QLatin1String( "gpx" ) )
   {
-    QStringList theURIParts = mDataSource.split( '?' );
+    QStringList theURIParts = dataSource.split( '?' );
     theURIParts[0] = context.pathResolver().readPath( theURIParts[0] );
-    mDataSource = theURIParts.join( QStringLiteral( "?" ) );
+    dataSource = theURIParts.join( QStringLiteral( "?" ) );
   }
   else if ( provider == QLatin1String( "delimitedtext" ) )
   {
-    QUrl urlSource = QUrl::fromEncoded( mDataSource.toLatin1() );
+    QUrl urlSource = QUrl::fromEncoded( dataSource.toLatin1() );
 
-    if ( !mDataSource.startsWith( QLatin1String( "file:" ) ) )
+    if ( !dataSource.startsWith( QLatin1String( "file:" ) ) )
     {
-      QUrl file = QUrl::fromLocalFile( mDataSource.left( mDataSource.indexOf( '?' ) ) );
+      QUrl file = QUrl::fromLocalFile( dataSource.left( dataSource.indexOf( '?' ) ) );
       urlSource.setScheme( QStringLiteral( "file" ) );
       urlSource.setPath( file.path() );
     }
 
     QUrl urlDest = QUrl::fromLocalFile( context.pathResolver().readPath( urlSource.toLocalFile() ) );
     urlDest.setQueryItems( urlSource.queryItems() );
-    mDataSource = QString::fromLatin1( urlDest.toEncoded() );
+    dataSource = QString::fromLatin1( urlDest.toEncoded() );
   }
   else if ( provider == QLatin1String( "wms" ) )
   {
@@ -273,14 +251,14 @@ bool QgsMapLayer::readLayerXml( const QDomElement &layerElement, const QgsReadWr
     // The new format has always params crs,format,layers,styles and that params
     // should not appear in old format url -> use them to identify version
     // XYZ tile layers do not need to contain crs,format params, but they have type=xyz
-    if ( !mDataSource.contains( QLatin1String( "type=" ) ) &&
-         !mDataSource.contains( QLatin1String( "crs=" ) ) && !mDataSource.contains( QLatin1String( "format=" ) ) )
+    if ( !dataSource.contains( QLatin1String( "type=" ) ) &&
+         !dataSource.contains( QLatin1String( "crs=" ) ) && !dataSource.contains( QLatin1String( "format=" ) ) )
     {
       QgsDebugMsg( "Old WMS URI format detected -> converting to new format" );
       QgsDataSourceUri uri;
-      if ( !mDataSource.startsWith( QLatin1String( "http:" ) ) )
+      if ( !dataSource.startsWith( QLatin1String( "http:" ) ) )
       {
-        QStringList parts = mDataSource.split( ',' );
+        QStringList parts = dataSource.split( ',' );
         QStringListIterator iter( parts );
         while ( iter.hasNext() )
         {
@@ -329,9 +307,9 @@ bool QgsMapLayer::readLayerXml( const QDomElement &layerElement, const QgsReadWr
       }
       else
       {
-        uri.setParam( QStringLiteral( "url" ), mDataSource );
+        uri.setParam( QStringLiteral( "url" ), dataSource );
       }
-      mDataSource = uri.encodedUri();
+      dataSource = uri.encodedUri();
       // At this point, the URI is obviously incomplete, we add additional params
       // in QgsRasterLayer::readXml
     }
@@ -343,65 +321,96 @@ bool QgsMapLayer::readLayerXml( const QDomElement &layerElement, const QgsReadWr
 
     if ( provider == QLatin1String( "gdal" ) )
     {
-      if ( mDataSource.startsWith( QLatin1String( "NETCDF:" ) ) )
+      if ( dataSource.startsWith( QLatin1String( "NETCDF:" ) ) )
       {
         // NETCDF:filename:variable
         // filename can be quoted with " as it can contain colons
         QRegExp r( "NETCDF:(.+):([^:]+)" );
-        if ( r.exactMatch( mDataSource ) )
+        if ( r.exactMatch( dataSource ) )
         {
           QString filename = r.cap( 1 );
           if ( filename.startsWith( '"' ) && filename.endsWith( '"' ) )
             filename = filename.mid( 1, filename.length() - 2 );
-          mDataSource = "NETCDF:\"" + context.pathResolver().readPath( filename ) + "\":" + r.cap( 2 );
+          dataSource = "NETCDF:\"" + context.pathResolver().readPath( filename ) + "\":" + r.cap( 2 );
           handled = true;
         }
       }
-      else if ( mDataSource.startsWith( QLatin1String( "HDF4_SDS:" ) ) )
+      else if ( dataSource.startsWith( QLatin1String( "HDF4_SDS:" ) ) )
       {
         // HDF4_SDS:subdataset_type:file_name:subdataset_index
         // filename can be quoted with " as it can contain colons
         QRegExp r( "HDF4_SDS:([^:]+):(.+):([^:]+)" );
-        if ( r.exactMatch( mDataSource ) )
+        if ( r.exactMatch( dataSource ) )
         {
           QString filename = r.cap( 2 );
           if ( filename.startsWith( '"' ) && filename.endsWith( '"' ) )
             filename = filename.mid( 1, filename.length() - 2 );
-          mDataSource = "HDF4_SDS:" + r.cap( 1 ) + ":\"" + context.pathResolver().readPath( filename ) + "\":" + r.cap( 3 );
+          dataSource = "HDF4_SDS:" + r.cap( 1 ) + ":\"" + context.pathResolver().readPath( filename ) + "\":" + r.cap( 3 );
           handled = true;
         }
       }
-      else if ( mDataSource.startsWith( QLatin1String( "HDF5:" ) ) )
+      else if ( dataSource.startsWith( QLatin1String( "HDF5:" ) ) )
       {
         // HDF5:file_name:subdataset
         // filename can be quoted with " as it can contain colons
         QRegExp r( "HDF5:(.+):([^:]+)" );
-        if ( r.exactMatch( mDataSource ) )
+        if ( r.exactMatch( dataSource ) )
         {
           QString filename = r.cap( 1 );
           if ( filename.startsWith( '"' ) && filename.endsWith( '"' ) )
             filename = filename.mid( 1, filename.length() - 2 );
-          mDataSource = "HDF5:\"" + context.pathResolver().readPath( filename ) + "\":" + r.cap( 2 );
+          dataSource = "HDF5:\"" + context.pathResolver().readPath( filename ) + "\":" + r.cap( 2 );
           handled = true;
         }
       }
-      else if ( mDataSource.contains( QRegExp( "^(NITF_IM|RADARSAT_2_CALIB):" ) ) )
+      else if ( dataSource.contains( QRegExp( "^(NITF_IM|RADARSAT_2_CALIB):" ) ) )
       {
         // NITF_IM:0:filename
         // RADARSAT_2_CALIB:?:filename
         QRegExp r( "([^:]+):([^:]+):(.+)" );
-        if ( r.exactMatch( mDataSource ) )
+        if ( r.exactMatch( dataSource ) )
         {
-          mDataSource = r.cap( 1 ) + ':' + r.cap( 2 ) + ':' + context.pathResolver().readPath( r.cap( 3 ) );
+          dataSource = r.cap( 1 ) + ':' + r.cap( 2 ) + ':' + context.pathResolver().readPath( r.cap( 3 ) );
           handled = true;
         }
       }
     }
 
     if ( !handled )
-      mDataSource = context.pathResolver().readPath( mDataSource );
+      dataSource = context.pathResolver().readPath( dataSource );
   }
 
+  return dataSource;
+}
+
+bool QgsMapLayer::readLayerXml( const QDomElement &layerElement, const QgsReadWriteContext &context )
+{
+  bool layerError;
+
+  QDomNode mnl;
+  QDomElement mne;
+
+  // read provider
+  QString provider;
+  mnl = layerElement.namedItem( QStringLiteral( "provider" ) );
+  mne = mnl.toElement();
+  provider = mne.text();
+
+  // set data source
+  mnl = layerElement.namedItem( QStringLiteral( "datasource" ) );
+  mne = mnl.toElement();
+  mDataSource = mne.text();
+
+  // if the layer needs authentication, ensure the master password is set
+  QRegExp rx( "authcfg=([a-z]|[A-Z]|[0-9]){7}" );
+  if ( ( rx.indexIn( mDataSource ) != -1 )
+       && !QgsAuthManager::instance()->setMasterPassword( true ) )
+  {
+    return false;
+  }
+
+  mDataSource = decodedSource( mDataSource, provider, context );
+
   // Set the CRS from project file, asking the user if necessary.
   // Make it the saved CRS to have WMS layer projected correctly.
   // We will still overwrite whatever GDAL etc picks up anyway
@@ -412,6 +412,17 @@ class CORE_EXPORT QgsMapLayer : public QObject
      */
     bool readLayerXml( const QDomElement &layerElement, const QgsReadWriteContext &context );
 
+    /**
+     * Returns the data source for a layer, decoded from the \a source stored in a
+     * ``maplayer'' element for the specified \a provider. Relative paths are
+     * resolved using the path resolver from \a context.
+     *
+     * This is the data source readLayerXml() assigns to the layer before
+     * calling readXml().
+     * \since QGIS 3.0
+     */
+    static QString decodedSource( const QString &source, const QString &provider, const QgsReadWriteContext &context );
+
     /** Stores state in Dom node
      * \param layerElement is a Dom element corresponding to ``maplayer'' tag
      * \param document is a the dom document being written
@@ -121,6 +121,11 @@ QVariant QgsOgrUtils::getOgrFeatureAttribute( OGRFeatureH ogrFet, const QgsField
     return QVariant();
   }
 
+  return getOgrFeatureAttribute( ogrFet, attIndex, fields.at( attIndex ).type(), encoding, ok );
+}
+
+QVariant QgsOgrUtils::getOgrFeatureAttribute( OGRFeatureH ogrFet, int attIndex, QVariant::Type type, QTextCodec *encoding, bool *ok )
+{
   QVariant value;
 
   if ( ok )
@@ -128,7 +133,7 @@ QVariant QgsOgrUtils::getOgrFeatureAttribute( OGRFeatureH ogrFet, const QgsField
 
   if ( OGR_F_IsFieldSetAndNotNull( ogrFet, attIndex ) )
   {
-    switch ( fields.at( attIndex ).type() )
+    switch ( type )
     {
       case QVariant::String:
       {
@@ -154,9 +159,9 @@ QVariant QgsOgrUtils::getOgrFeatureAttribute( OGRFeatureH ogrFet, const QgsField
         int year, month, day, hour, minute, second, tzf;
 
         OGR_F_GetFieldAsDateTime( ogrFet, attIndex, &year, &month, &day, &hour, &minute, &second, &tzf );
-        if ( fields.at( attIndex ).type() == QVariant::Date )
+        if ( type == QVariant::Date )
           value = QDate( year, month, day );
-        else if ( fields.at( attIndex ).type() == QVariant::Time )
+        else if ( type == QVariant::Time )
           value = QTime( hour, minute, second );
         else
           value = QDateTime( QDate( year, month, day ), QTime( hour, minute, second ) );
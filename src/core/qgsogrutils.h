@@ -63,6 +63,19 @@ class CORE_EXPORT QgsOgrUtils
      */
     static QVariant getOgrFeatureAttribute( OGRFeatureH ogrFet, const QgsFields &fields, int attIndex, QTextCodec *encoding, bool *ok = 0 );
 
+    /** Retrieves an attribute value from an OGR feature, converting it to a specified type.
+     * Unlike the other overload, the field index is not validated against the feature's
+     * definition, which makes this suitable for reading the same fields from many features.
+     * \param ogrFet OGR feature handle
+     * \param attIndex index of OGR field to retrieve, must be valid for the feature
+     * \param type type to convert the attribute to
+     * \param encoding text encoding
+     * \param ok optional storage for success of retrieval
+     * \returns attribute converted to a QVariant object
+     * \since QGIS 3.0
+     */
+    static QVariant getOgrFeatureAttribute( OGRFeatureH ogrFet, int attIndex, QVariant::Type type, QTextCodec *encoding, bool *ok = 0 );
+
     /** Reads all attributes from an OGR feature into a QgsFeature.
      * \param ogrFet OGR feature handle
      * \param fields fields collection corresponding to feature
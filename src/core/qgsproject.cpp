@@ -17,6 +17,7 @@
 
 #include "qgsproject.h"
 
+#include "qgsapplication.h"
 #include "qgsdatasourceuri.h"
 #include "qgslabelingenginesettings.h"
 #include "qgslayertree.h"
@@ -27,6 +28,7 @@
 #include "qgspluginlayer.h"
 #include "qgspluginlayerregistry.h"
 #include "qgsprojectfiletransform.h"
+#include "qgsprojectsnapshot.h"
 #include "qgssnappingconfig.h"
 #include "qgspathresolver.h"
 #include "qgsprojectversion.h"
@@ -44,6 +46,8 @@
 #include "qgstransactiongroup.h"
 #include "qgsvectordataprovider.h"
 #include "qgsprojectbadlayerhandler.h"
+#include "qgsproviderregistry.h"
+#include "qgsruntimeprofiler.h"
 #include "qgssettings.h"
 #include "qgsmaplayerlistutils.h"
 #include "qgslayoutmanager.h"
@@ -51,6 +55,7 @@
 #include "qgsziputils.h"
 
 #include <QApplication>
+#include <QDomElement>
 #include <QFileInfo>
 #include <QDomNode>
 #include <QObject>
@@ -59,6 +64,8 @@
 #include <QDir>
 #include <QUrl>
 
+#include <algorithm>
+
 #ifdef Q_OS_UNIX
 #include <utime.h>
 #elif _MSC_VER
@@ -484,6 +491,10 @@ void QgsProject::clear()
   mCustomVariables.clear();
 
   mEmbeddedLayers.clear();
+  mLazyLayersActive = false;
+  mLazyLayerElements.clear();
+  mLazyLayerLastUse.clear();
+  mLazyLayerDocument = QDomDocument();
   mRelationManager->clear();
   mAnnotationManager->clear();
   mLayoutManager->clear();
@@ -679,6 +690,24 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
 
   QVector<QDomNode> sortedLayerNodes = depSorter.sortedLayerNodes();
 
+  QgsRuntimeProfiler *profiler = QgsApplication::profiler();
+  profiler->beginGroup( QStringLiteral( "Project load" ) );
+
+  // opening a data source (connecting to a database, scanning a file) is usually
+  // the slowest part of restoring a layer, so start all providers in parallel.
+  // Layers are still created and registered in dependency order on this thread,
+  // picking up their provider from the registry when it is ready.
+  bool preloadProviders = !mLazyLayerLoading && QgsSettings().value( QStringLiteral( "qgis/parallelLayerLoading" ), true ).toBool();
+  if ( preloadProviders )
+  {
+    profiler->start( tr( "Start layer providers" ) );
+    QgsReadWriteContext context;
+    context.setPathResolver( pathResolver() );
+    QgsProviderRegistry::instance()->preloadProviders( layerProviderSources( sortedLayerNodes, context ) );
+    profiler->end();
+  }
+
+  profiler->start( tr( "Read layers" ) );
   int i = 0;
   Q_FOREACH ( const QDomNode &node, sortedLayerNodes )
   {
@@ -693,6 +722,12 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
       createEmbeddedLayer( element.attribute( QStringLiteral( "id" ) ), readPath( element.attribute( QStringLiteral( "project" ) ) ), brokenNodes );
       continue;
     }
+    else if ( mLazyLayerLoading )
+    {
+      // only keep the layer's XML, the layer is created when first used
+      mLazyLayerDocument = doc;
+      mLazyLayerElements.insert( node.namedItem( QStringLiteral( "id" ) ).toElement().text(), element );
+    }
     else
     {
       QgsReadWriteContext context;
@@ -705,10 +740,53 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
     emit layerLoaded( i + 1, nl.count() );
     i++;
   }
+  profiler->end();
+
+  // providers for layers which failed to load before reaching their provider
+  if ( preloadProviders )
+    QgsProviderRegistry::instance()->clearPreloadedProviders();
+
+  profiler->endGroup();
 
   return returnStatus;
 }
 
+QList< QPair< QString, QString > > QgsProject::layerProviderSources( const QVector<QDomNode> &layerNodes, const QgsReadWriteContext &context ) const
+{
+  QList< QPair< QString, QString > > sources;
+  Q_FOREACH ( const QDomNode &node, layerNodes )
+  {
+    QDomElement element = node.toElement();
+    if ( element.attribute( QStringLiteral( "embedded" ) ) == QLatin1String( "1" ) )
+      continue;
+
+    QString provider = element.namedItem( QStringLiteral( "provider" ) ).toElement().text();
+    QString source = element.namedItem( QStringLiteral( "datasource" ) ).toElement().text();
+
+    // sources requiring authentication may need to prompt for the master password,
+    // which must happen on the main thread
+    if ( source.contains( QLatin1String( "authcfg=" ) ) )
+      continue;
+
+    // mirror the data source and provider key determination of the layers' readXml
+    QString dataSource = QgsMapLayer::decodedSource( source, provider, context );
+    QString type = element.attribute( QStringLiteral( "type" ) );
+    if ( type == QLatin1String( "vector" ) )
+    {
+      if ( provider.isEmpty() )
+        provider = dataSource.contains( QLatin1String( "dbname=" ) ) ? QStringLiteral( "postgres" ) : QStringLiteral( "ogr" );
+      sources << qMakePair( provider, QgsVectorLayer::providerDataSource( provider, dataSource, mTrustLayerMetadata ) );
+    }
+    else if ( type == QLatin1String( "raster" ) )
+    {
+      if ( provider.isEmpty() )
+        provider = QStringLiteral( "gdal" );
+      sources << qMakePair( provider, dataSource );
+    }
+  }
+  return sources;
+}
+
 bool QgsProject::addLayer( const QDomElement &layerElem, QList<QDomNode> &brokenNodes, const QgsReadWriteContext &context )
 {
   QString type = layerElem.attribute( QStringLiteral( "type" ) );
@@ -786,6 +864,29 @@ bool QgsProject::read()
   return rc;
 }
 
+/**
+ * Removes layer tree nodes of layers which are neither registered nor waiting
+ * to be loaded lazily.
+ */
+static void removeMissingLayers( QgsLayerTreeGroup *group, const QHash< QString, QDomElement > &lazyLayers )
+{
+  QList<QgsLayerTreeNode *> nodesToRemove;
+  Q_FOREACH ( QgsLayerTreeNode *node, group->children() )
+  {
+    if ( QgsLayerTree::isGroup( node ) )
+      removeMissingLayers( QgsLayerTree::toGroup( node ), lazyLayers );
+    else if ( QgsLayerTree::isLayer( node ) )
+    {
+      QgsLayerTreeLayer *nodeLayer = QgsLayerTree::toLayer( node );
+      if ( !nodeLayer->layer() && !lazyLayers.contains( nodeLayer->layerId() ) )
+        nodesToRemove << node;
+    }
+  }
+
+  Q_FOREACH ( QgsLayerTreeNode *node, nodesToRemove )
+    group->removeChildNode( node );
+}
+
 bool QgsProject::readProjectFile( const QString &filename )
 {
   QFile projectFile( filename );
@@ -806,7 +907,13 @@ bool QgsProject::readProjectFile( const QString &filename )
   int line, column;
   QString errorMsg;
 
-  if ( !doc->setContent( &projectFile, &errorMsg, &line, &column ) )
+  // a binary snapshot of an unchanged project is much faster to load than the XML
+  bool useSnapshot = filename == mFile.fileName() && QgsSettings().value( QStringLiteral( "qgis/projectSnapshots" ), false ).toBool();
+  if ( useSnapshot && QgsProjectSnapshot::read( filename, *doc ) )
+  {
+    QgsDebugMsg( "Loaded project snapshot " + QgsProjectSnapshot::snapshotPath( filename ) );
+  }
+  else if ( !doc->setContent( &projectFile, &errorMsg, &line, &column ) )
   {
     // want to make this class as GUI independent as possible; so commented out
 #if 0
@@ -972,7 +1079,10 @@ bool QgsProject::readProjectFile( const QString &filename )
   }
 
   // make sure the are just valid layers
-  QgsLayerTreeUtils::removeInvalidLayers( mRootGroup );
+  if ( mLazyLayerElements.isEmpty() )
+    QgsLayerTreeUtils::removeInvalidLayers( mRootGroup );
+  else
+    removeMissingLayers( mRootGroup, mLazyLayerElements );
 
   mRootGroup->removeCustomProperty( QStringLiteral( "loading" ) );
 
@@ -1017,6 +1127,9 @@ bool QgsProject::readProjectFile( const QString &filename )
   // read the project: used by map canvas and legend
   emit readProject( *doc );
 
+  // from now on, layers read in lazy mode are loaded when retrieved
+  mLazyLayersActive = !mLazyLayerElements.isEmpty();
+
   // if all went well, we're allegedly in pristine state
   if ( clean )
     setDirty( false );
@@ -1208,6 +1321,16 @@ void QgsProject::onMapLayersRemoved( const QList<QgsMapLayer *> &layers )
 {
   if ( mSnappingConfig.removeLayers( layers ) )
     emit snappingConfigChanged( mSnappingConfig );
+
+  // lazily loaded layers removed other than by unloadIdleLayers() are gone for good
+  if ( !mUnloadingLayers && !mLazyLayerLastUse.isEmpty() )
+  {
+    Q_FOREACH ( QgsMapLayer *layer, layers )
+    {
+      if ( mLazyLayerLastUse.remove( layer->id() ) )
+        mLazyLayerElements.remove( layer->id() );
+    }
+  }
 }
 
 void QgsProject::cleanTransactionGroups( bool force )
@@ -1271,6 +1394,10 @@ bool QgsProject::writeProjectFile( const QString &filename )
   QFile projectFile( filename );
   clearError();
 
+  // layers which are not loaded yet would be missing from the written project
+  if ( mLazyLayersActive )
+    loadAllLayers();
+
   // if we have problems creating or otherwise writing to the project file,
   // let's find out up front before we go through all the hand-waving
   // necessary to create all the Dom objects
@@ -1481,6 +1608,13 @@ bool QgsProject::writeProjectFile( const QString &filename )
     return false;
   }
 
+  if ( filename == mFile.fileName() && QgsSettings().value( QStringLiteral( "qgis/projectSnapshots" ), false ).toBool() )
+  {
+    // failing to write the snapshot is harmless, the project is just parsed as XML next time
+    if ( !QgsProjectSnapshot::write( *doc, filename ) )
+      QgsDebugMsg( "Unable to write project snapshot for " + filename );
+  }
+
   setDirty( false );               // reset to pristine state
 
   emit projectSaved();
@@ -2114,6 +2248,177 @@ QList<QgsMapLayer *> QgsProject::mapLayersByName( const QString &layerName ) con
   return mLayerStore->mapLayersByName( layerName );
 }
 
+QgsMapLayer *QgsProject::loadLayer( const QString &layerId )
+{
+  QgsMapLayer *layer = mLayerStore->mapLayer( layerId );
+  if ( !mLazyLayersActive )
+    return layer;
+
+  if ( !layer && mLazyLayerElements.contains( layerId ) )
+  {
+    layer = loadLazyLayer( layerId );
+    readLazyLayerReferences();
+  }
+
+  QHash< QString, quint64 >::iterator lastUseIt = mLazyLayerLastUse.find( layerId );
+  if ( lastUseIt != mLazyLayerLastUse.end() )
+    *lastUseIt = ++mLazyLayerUseCounter;
+
+  return layer;
+}
+
+void QgsProject::loadAllLayers()
+{
+  QStringList layerIds = unloadedLayerIds();
+  if ( layerIds.isEmpty() )
+    return;
+
+  Q_FOREACH ( const QString &layerId, layerIds )
+  {
+    if ( mLazyLayerElements.contains( layerId ) && !mLazyLayerLastUse.contains( layerId ) )
+      loadLazyLayer( layerId );
+  }
+  readLazyLayerReferences();
+}
+
+QStringList QgsProject::unloadedLayerIds() const
+{
+  QStringList ids;
+  for ( QHash< QString, QDomElement >::const_iterator it = mLazyLayerElements.constBegin(); it != mLazyLayerElements.constEnd(); ++it )
+  {
+    if ( !mLazyLayerLastUse.contains( it.key() ) )
+      ids << it.key();
+  }
+  return ids;
+}
+
+QDomElement QgsProject::unloadedLayerElement( const QString &layerId ) const
+{
+  if ( mLazyLayerLastUse.contains( layerId ) )
+    return QDomElement();
+
+  return mLazyLayerElements.value( layerId );
+}
+
+QgsMapLayer *QgsProject::loadLazyLayer( const QString &layerId )
+{
+  QDomElement element = mLazyLayerElements.value( layerId );
+  // mark the layer as loaded up front, so that dependency cycles terminate
+  mLazyLayerLastUse.insert( layerId, ++mLazyLayerUseCounter );
+
+  Q_FOREACH ( const QString &dependency, layerElementDependencies( element ) )
+  {
+    if ( mLazyLayerElements.contains( dependency ) && !mLazyLayerLastUse.contains( dependency ) )
+      loadLazyLayer( dependency );
+  }
+
+  QgsReadWriteContext context;
+  context.setPathResolver( pathResolver() );
+  QList<QDomNode> brokenNodes;
+
+  // the layer already has its node in the layer tree
+  mLayerTreeRegistryBridge->setEnabled( false );
+  bool loaded = addLayer( element, brokenNodes, context );
+  if ( !loaded )
+  {
+    // the layer is no longer managed lazily, whatever the handler does with it
+    mLazyLayerLastUse.remove( layerId );
+    mLazyLayerElements.remove( layerId );
+
+    // let a custom handler decide what to do with the layer, as read() does
+    mBadLayerHandler->handleBadLayers( brokenNodes );
+  }
+  mLayerTreeRegistryBridge->setEnabled( true );
+
+  QgsMapLayer *layer = mLayerStore->mapLayer( layerId );
+  if ( !layer )
+    return nullptr;
+
+  if ( QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer ) )
+    vl->resolveReferences( this );
+  layer->setDependencies( layer->dependencies() );
+
+  if ( QgsLayerTreeLayer *nodeLayer = mRootGroup->findLayer( layerId ) )
+    nodeLayer->resolveReferences( this );
+
+  return layer;
+}
+
+QStringList QgsProject::layerElementDependencies( const QDomElement &layerElement )
+{
+  QStringList dependencies;
+
+  QDomNodeList dependencyNodes = layerElement.firstChildElement( QStringLiteral( "layerDependencies" ) ).elementsByTagName( QStringLiteral( "layer" ) );
+  for ( int i = 0; i < dependencyNodes.size(); ++i )
+    dependencies << dependencyNodes.at( i ).toElement().attribute( QStringLiteral( "id" ) );
+
+  QDomNodeList joinNodes = layerElement.firstChildElement( QStringLiteral( "vectorjoins" ) ).elementsByTagName( QStringLiteral( "join" ) );
+  for ( int i = 0; i < joinNodes.size(); ++i )
+    dependencies << joinNodes.at( i ).toElement().attribute( QStringLiteral( "joinLayerId" ) );
+
+  return dependencies;
+}
+
+void QgsProject::readLazyLayerReferences()
+{
+  // relations, map themes, snapping settings and the custom layer order refer to
+  // layers by ID and skip those which do not exist, so they are read again from
+  // the project each time lazily managed layers are loaded
+  bool dirty = isDirty();
+
+  mRelationManager->readProject( mLazyLayerDocument );
+  mMapThemeCollection->readXml( mLazyLayerDocument );
+
+  mSnappingConfig.readProject( mLazyLayerDocument );
+  emit snappingConfigChanged( mSnappingConfig );
+
+  QDomElement layerTreeElem = mLazyLayerDocument.documentElement().firstChildElement( QStringLiteral( "layer-tree-group" ) );
+  if ( layerTreeElem.isNull() )
+    layerTreeElem = mLazyLayerDocument.documentElement().firstChildElement( QStringLiteral( "layer-tree-canvas" ) );
+  mRootGroup->readLayerOrderFromXml( layerTreeElem );
+
+  setDirty( dirty );
+}
+
+int QgsProject::unloadIdleLayers( int maximumLayers )
+{
+  int excess = mLazyLayerLastUse.count() - maximumLayers;
+  if ( excess <= 0 )
+    return 0;
+
+  // layers needed by other loaded layers must stay loaded
+  QSet<QString> required;
+  for ( QHash< QString, quint64 >::const_iterator it = mLazyLayerLastUse.constBegin(); it != mLazyLayerLastUse.constEnd(); ++it )
+    required.unite( layerElementDependencies( mLazyLayerElements.value( it.key() ) ).toSet() );
+
+  QList< QPair< quint64, QString > > candidates;
+  for ( QHash< QString, quint64 >::const_iterator it = mLazyLayerLastUse.constBegin(); it != mLazyLayerLastUse.constEnd(); ++it )
+  {
+    if ( !required.contains( it.key() ) )
+      candidates << qMakePair( it.value(), it.key() );
+  }
+  std::sort( candidates.begin(), candidates.end() );
+
+  QStringList unloadIds;
+  for ( int i = 0; i < candidates.count() && i < excess; ++i )
+    unloadIds << candidates.at( i ).second;
+
+  if ( unloadIds.isEmpty() )
+    return 0;
+
+  // keep the layer tree nodes, they are attached again when the layers are reloaded
+  mUnloadingLayers = true;
+  mLayerTreeRegistryBridge->setEnabled( false );
+  mLayerStore->removeMapLayers( unloadIds );
+  mLayerTreeRegistryBridge->setEnabled( true );
+  mUnloadingLayers = false;
+
+  Q_FOREACH ( const QString &layerId, unloadIds )
+    mLazyLayerLastUse.remove( layerId );
+
+  return unloadIds.count();
+}
+
 bool QgsProject::unzip( const QString &filename )
 {
   clearError();
@@ -29,8 +29,11 @@
 #include <QList>
 #include <QObject>
 #include <QPair>
+#include <QDomDocument>
+#include <QDomElement>
 #include <QFileInfo>
 #include <QStringList>
+#include <QVector>
 
 #include "qgsunittypes.h"
 #include "qgssnappingconfig.h"
@@ -177,6 +180,8 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
     void clear();
 
     /** Reads given project file from the given file.
+     * If the "qgis/projectSnapshots" setting is enabled and the file has an up to date
+     * binary snapshot (see write()), the snapshot is loaded instead of parsing the XML.
      * \param filename name of project file to read
      * \returns true if project file has been read successfully
      */
@@ -202,6 +207,8 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
      * \param filename destination file
      * \note calling this implicitly sets the project's filename (see setFileName() )
      * \note isDirty() will be set to false if project is successfully written
+     * \note if the "qgis/projectSnapshots" setting is enabled, a compact binary snapshot
+     * of an uncompressed project is written alongside it, speeding up reopening the project
      * \returns true if project was written successfully
      *
      * \since QGIS 3.0
@@ -780,6 +787,89 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
      */
     bool trustLayerMetadata() const { return mTrustLayerMetadata; }
 
+    /**
+     * Sets whether read() restores the project's layers lazily. In lazy mode the
+     * XML of each layer is kept, and the layer (along with its data provider) is
+     * only created when it is requested with loadLayer() or loadAllLayers(). Until
+     * then, mapLayer(), mapLayersByName() and mapLayers() do not return it. Layers
+     * created this way can be released again with unloadIdleLayers().
+     *
+     * Lazy mode is intended for read-only use of large projects, e.g. by QGIS Server.
+     * Relations, map themes, the custom layer order and the snapping configuration
+     * are read again from the project each time layers are loaded, so they only
+     * refer to loaded layers. Layers which fail to load are passed to the bad
+     * layer handler.
+     *
+     * This option must be set before calling read(). It is disabled by default.
+     *
+     * \see lazyLayerLoading()
+     * \since QGIS 3.0
+     */
+    void setLazyLayerLoading( bool lazy ) { mLazyLayerLoading = lazy; }
+
+    /**
+     * Returns true if read() restores the project's layers lazily.
+     *
+     * \see setLazyLayerLoading()
+     * \since QGIS 3.0
+     */
+    bool lazyLayerLoading() const { return mLazyLayerLoading; }
+
+    /**
+     * Returns the IDs of layers read in lazy mode which are not loaded, either
+     * because they were not used yet or because they were unloaded by unloadIdleLayers().
+     *
+     * \see setLazyLayerLoading()
+     * \since QGIS 3.0
+     */
+    QStringList unloadedLayerIds() const;
+
+    /**
+     * Returns the ``maplayer'' element of a layer read in lazy mode which is not
+     * loaded, or a null element if there is no such layer. This allows inspecting
+     * unloaded layers (e.g. their name) without loading them.
+     *
+     * \see unloadedLayerIds()
+     * \since QGIS 3.0
+     */
+    QDomElement unloadedLayerElement( const QString &layerId ) const;
+
+    /**
+     * Returns the layer with the specified \a layerId, creating it first if it was
+     * read in lazy mode and is not loaded. Layers it depends on (e.g. join layers)
+     * are loaded too. Returns nullptr if there is no such layer or if it could not
+     * be loaded.
+     *
+     * If the project is not read in lazy mode, this is the same as mapLayer().
+     *
+     * \see loadAllLayers()
+     * \see setLazyLayerLoading()
+     * \since QGIS 3.0
+     */
+    QgsMapLayer *loadLayer( const QString &layerId );
+
+    /**
+     * Creates all layers read in lazy mode which are not loaded.
+     *
+     * \see loadLayer()
+     * \see setLazyLayerLoading()
+     * \since QGIS 3.0
+     */
+    void loadAllLayers();
+
+    /**
+     * Unloads the least recently used layers among those created lazily, until at
+     * most \a maximumLayers of them remain loaded. Layers which other loaded layers
+     * depend on (e.g. join layers) are kept. Unloaded layers are deleted and will be
+     * created again when they are next requested with loadLayer(). Any pointer to an
+     * unloaded layer becomes invalid.
+     *
+     * \returns the number of unloaded layers
+     * \see setLazyLayerLoading()
+     * \since QGIS 3.0
+     */
+    int unloadIdleLayers( int maximumLayers );
+
   signals:
     //! emitted when project is being read
     void readProject( const QDomDocument & );
@@ -1034,6 +1124,28 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
     */
     bool _getMapLayers( const QDomDocument &doc, QList<QDomNode> &brokenNodes );
 
+    /**
+     * Creates a layer read in lazy mode, after the layers it depends on, and
+     * registers it. Returns the layer or nullptr if it could not be loaded.
+     */
+    QgsMapLayer *loadLazyLayer( const QString &layerId );
+
+    //! Returns the IDs of the layers a ``maplayer'' element depends on
+    static QStringList layerElementDependencies( const QDomElement &layerElement );
+
+    /**
+     * Reads relations, map themes, the snapping configuration and the custom layer order
+     * again from the project, after layers read in lazy mode were loaded.
+     */
+    void readLazyLayerReferences();
+
+    /**
+     * Returns the provider keys and data sources which the layers stored in \a layerNodes
+     * will be bound to, for preloading their providers. Embedded layers and sources
+     * requiring authentication are skipped.
+     */
+    QList< QPair< QString, QString > > layerProviderSources( const QVector<QDomNode> &layerNodes, const QgsReadWriteContext &context ) const;
+
     /** Set error message from read/write operation
      * \note not available in Python bindings
      */
@@ -1108,6 +1220,19 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
     QgsCoordinateReferenceSystem mCrs;
     bool mDirty;                 // project has been modified since it has been read or saved
     bool mTrustLayerMetadata = false;
+
+    bool mLazyLayerLoading = false;
+    //! True once read() completed in lazy mode, until the project is cleared
+    bool mLazyLayersActive = false;
+    //! True while unloadIdleLayers() removes layers
+    bool mUnloadingLayers = false;
+    //! Project document the lazily managed layer elements belong to
+    QDomDocument mLazyLayerDocument;
+    //! XML of the layers managed lazily, by layer ID
+    QHash< QString, QDomElement > mLazyLayerElements;
+    //! Last use of the lazily managed layers which are loaded, by layer ID
+    QHash< QString, quint64 > mLazyLayerLastUse;
+    quint64 mLazyLayerUseCounter = 0;
 };
 
 /** Return the version string found in the given DOM document
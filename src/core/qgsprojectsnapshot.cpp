@@ -0,0 +1,379 @@
+/***************************************************************************
+                              qgsprojectsnapshot.cpp
+                              ----------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsprojectsnapshot.h"
+#include "qgslogger.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStringList>
+
+// 'QGSS'
+static const quint32 SNAPSHOT_MAGIC = 0x51475353;
+static const quint32 SNAPSHOT_VERSION = 2;
+
+namespace
+{
+  enum NodeType
+  {
+    ElementNode = 1,
+    TextNode,
+    CDataNode,
+    CommentNode,
+    ProcessingInstructionNode,
+  };
+
+  //! Size, modification time and content hash of a project file, used to detect stale snapshots
+  struct SourceStamp
+  {
+    qint64 size = -1;
+    qint64 modified = -1;
+    QByteArray hash;
+
+    bool operator==( const SourceStamp &other ) const { return size == other.size && modified == other.modified && hash == other.hash; }
+  };
+
+  SourceStamp sourceStamp( const QString &projectFile )
+  {
+    SourceStamp stamp;
+    QFile file( projectFile );
+    if ( file.open( QIODevice::ReadOnly ) )
+    {
+      // the modification time alone misses edits within its resolution, or by
+      // tools which preserve it, so the content is compared too
+      QCryptographicHash hash( QCryptographicHash::Sha1 );
+      if ( !hash.addData( &file ) )
+        return stamp;
+
+      QFileInfo fi( file );
+      stamp.size = fi.size();
+      stamp.modified = fi.lastModified().toMSecsSinceEpoch();
+      stamp.hash = hash.result();
+    }
+    return stamp;
+  }
+
+  /**
+   * Writes DOM nodes to a stream, replacing every string by its index in a
+   * table of distinct strings. Tag and attribute names and most attribute values
+   * repeat heavily in projects, so this keeps snapshots small.
+   */
+  class Encoder
+  {
+    public:
+
+      explicit Encoder( QDataStream &stream )
+        : mStream( stream )
+      {}
+
+      QStringList strings() const { return mStrings; }
+
+      void writeString( const QString &string )
+      {
+        QHash< QString, quint32 >::const_iterator it = mStringIndex.constFind( string );
+        if ( it != mStringIndex.constEnd() )
+        {
+          mStream << it.value();
+          return;
+        }
+
+        quint32 index = static_cast< quint32 >( mStrings.count() );
+        mStrings << string;
+        mStringIndex.insert( string, index );
+        mStream << index;
+      }
+
+      void writeChildren( const QDomNode &parent )
+      {
+        QList< QDomNode > children;
+        for ( QDomNode child = parent.firstChild(); !child.isNull(); child = child.nextSibling() )
+        {
+          if ( child.isElement() || child.isText() || child.isComment() || child.isProcessingInstruction() )
+            children << child;
+        }
+
+        mStream << static_cast< quint32 >( children.count() );
+        Q_FOREACH ( const QDomNode &child, children )
+          writeNode( child );
+      }
+
+    private:
+
+      void writeNode( const QDomNode &node )
+      {
+        if ( node.isElement() )
+        {
+          QDomElement element = node.toElement();
+          mStream << static_cast< quint8 >( ElementNode );
+          writeString( element.tagName() );
+
+          QDomNamedNodeMap attributes = element.attributes();
+          mStream << static_cast< quint32 >( attributes.count() );
+          for ( int i = 0; i < attributes.count(); ++i )
+          {
+            QDomAttr attribute = attributes.item( i ).toAttr();
+            writeString( attribute.name() );
+            writeString( attribute.value() );
+          }
+
+          writeChildren( node );
+        }
+        else if ( node.isCDATASection() )
+        {
+          mStream << static_cast< quint8 >( CDataNode );
+          writeString( node.nodeValue() );
+        }
+        else if ( node.isText() )
+        {
+          mStream << static_cast< quint8 >( TextNode );
+          writeString( node.nodeValue() );
+        }
+        else if ( node.isComment() )
+        {
+          mStream << static_cast< quint8 >( CommentNode );
+          writeString( node.nodeValue() );
+        }
+        else
+        {
+          QDomProcessingInstruction instruction = node.toProcessingInstruction();
+          mStream << static_cast< quint8 >( ProcessingInstructionNode );
+          writeString( instruction.target() );
+          writeString( instruction.data() );
+        }
+      }
+
+      QDataStream &mStream;
+      QStringList mStrings;
+      QHash< QString, quint32 > mStringIndex;
+  };
+
+  //! Rebuilds DOM nodes written by Encoder
+  class Decoder
+  {
+    public:
+
+      Decoder( QDataStream &stream, const QStringList &strings, QDomDocument &document )
+        : mStream( stream )
+        , mStrings( strings )
+        , mDocument( document )
+      {}
+
+      bool readChildren( QDomNode &parent )
+      {
+        quint32 count = 0;
+        mStream >> count;
+        for ( quint32 i = 0; i < count; ++i )
+        {
+          if ( mStream.status() != QDataStream::Ok || !readNode( parent ) )
+            return false;
+        }
+        return mStream.status() == QDataStream::Ok;
+      }
+
+    private:
+
+      bool readString( QString &string )
+      {
+        quint32 index = 0;
+        mStream >> index;
+        if ( mStream.status() != QDataStream::Ok || index >= static_cast< quint32 >( mStrings.count() ) )
+          return false;
+
+        string = mStrings.at( index );
+        return true;
+      }
+
+      bool readNode( QDomNode &parent )
+      {
+        quint8 type = 0;
+        mStream >> type;
+
+        QString value;
+        switch ( type )
+        {
+          case ElementNode:
+          {
+            if ( !readString( value ) )
+              return false;
+            QDomElement element = mDocument.createElement( value );
+
+            quint32 attributeCount = 0;
+            mStream >> attributeCount;
+            QString name;
+            for ( quint32 i = 0; i < attributeCount; ++i )
+            {
+              if ( !readString( name ) || !readString( value ) )
+                return false;
+              element.setAttribute( name, value );
+            }
+
+            parent.appendChild( element );
+            return readChildren( element );
+          }
+
+          case TextNode:
+            if ( !readString( value ) )
+              return false;
+            parent.appendChild( mDocument.createTextNode( value ) );
+            return true;
+
+          case CDataNode:
+            if ( !readString( value ) )
+              return false;
+            parent.appendChild( mDocument.createCDATASection( value ) );
+            return true;
+
+          case CommentNode:
+            if ( !readString( value ) )
+              return false;
+            parent.appendChild( mDocument.createComment( value ) );
+            return true;
+
+          case ProcessingInstructionNode:
+          {
+            QString target;
+            if ( !readString( target ) || !readString( value ) )
+              return false;
+            parent.appendChild( mDocument.createProcessingInstruction( target, value ) );
+            return true;
+          }
+
+          default:
+            return false;
+        }
+      }
+
+      QDataStream &mStream;
+      const QStringList &mStrings;
+      QDomDocument &mDocument;
+  };
+
+  bool readHeader( QDataStream &stream, SourceStamp &stamp )
+  {
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION )
+      return false;
+
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream >> stamp.size >> stamp.modified >> stamp.hash;
+    return stream.status() == QDataStream::Ok;
+  }
+}
+
+QString QgsProjectSnapshot::snapshotPath( const QString &projectFile )
+{
+  return projectFile + QStringLiteral( ".snapshot" );
+}
+
+bool QgsProjectSnapshot::write( const QDomDocument &document, const QString &projectFile )
+{
+  SourceStamp stamp = sourceStamp( projectFile );
+  if ( stamp.size < 0 )
+    return false;
+
+  QByteArray tree;
+  QDataStream treeStream( &tree, QIODevice::WriteOnly );
+  treeStream.setVersion( QDataStream::Qt_5_0 );
+  Encoder encoder( treeStream );
+  encoder.writeChildren( document );
+
+  QByteArray body;
+  QDataStream bodyStream( &body, QIODevice::WriteOnly );
+  bodyStream.setVersion( QDataStream::Qt_5_0 );
+  bodyStream << document.doctype().name() << encoder.strings() << tree;
+
+  QSaveFile file( snapshotPath( projectFile ) );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    QgsDebugMsg( "Unable to write project snapshot " + file.fileName() );
+    return false;
+  }
+
+  QDataStream stream( &file );
+  stream << SNAPSHOT_MAGIC << SNAPSHOT_VERSION;
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << stamp.size << stamp.modified << stamp.hash << qCompress( body, 1 );
+
+  if ( stream.status() != QDataStream::Ok )
+  {
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+bool QgsProjectSnapshot::read( const QString &projectFile, QDomDocument &document )
+{
+  QFile file( snapshotPath( projectFile ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  SourceStamp stamp;
+  if ( !readHeader( stream, stamp ) || !( stamp == sourceStamp( projectFile ) ) )
+  {
+    QgsDebugMsgLevel( "Ignoring stale or invalid project snapshot " + file.fileName(), 2 );
+    return false;
+  }
+
+  QByteArray compressed;
+  stream >> compressed;
+  QByteArray body = qUncompress( compressed );
+  compressed.clear();
+  if ( stream.status() != QDataStream::Ok || body.isEmpty() )
+    return false;
+
+  QDataStream bodyStream( body );
+  bodyStream.setVersion( QDataStream::Qt_5_0 );
+  QString doctypeName;
+  QStringList strings;
+  QByteArray tree;
+  bodyStream >> doctypeName >> strings >> tree;
+  if ( bodyStream.status() != QDataStream::Ok )
+    return false;
+
+  QDomDocument decoded( doctypeName );
+  QDataStream treeStream( tree );
+  treeStream.setVersion( QDataStream::Qt_5_0 );
+  Decoder decoder( treeStream, strings, decoded );
+  if ( !decoder.readChildren( decoded ) )
+  {
+    QgsDebugMsg( "Corrupt project snapshot " + file.fileName() );
+    return false;
+  }
+
+  document = decoded;
+  return true;
+}
+
+bool QgsProjectSnapshot::isUpToDate( const QString &projectFile )
+{
+  QFile file( snapshotPath( projectFile ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  SourceStamp stamp;
+  return readHeader( stream, stamp ) && stamp == sourceStamp( projectFile );
+}
@@ -0,0 +1,71 @@
+/***************************************************************************
+                              qgsprojectsnapshot.h
+                              --------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPROJECTSNAPSHOT_H
+#define QGSPROJECTSNAPSHOT_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QString>
+
+class QDomDocument;
+
+/** \ingroup core
+ * \class QgsProjectSnapshot
+ * \brief Reads and writes binary snapshots of project documents.
+ *
+ * A snapshot is a compact, compressed binary encoding of the DOM of a project
+ * file, stored alongside the project. Reading a snapshot rebuilds the document
+ * without tokenizing and unescaping XML text, which dominates the parse time
+ * of large projects.
+ *
+ * Each snapshot records the size, modification time and a hash of the content
+ * of the project file it was created from, and is only used while the project
+ * file is unchanged. A snapshot which is missing, stale or unreadable is simply
+ * ignored and the project file is parsed as usual.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsProjectSnapshot
+{
+  public:
+
+    /** Returns the path of the snapshot belonging to a \a projectFile.
+     */
+    static QString snapshotPath( const QString &projectFile );
+
+    /** Writes a snapshot of \a document for the \a projectFile, which must already
+     * have been saved. Returns false if the snapshot could not be written.
+     */
+    static bool write( const QDomDocument &document, const QString &projectFile );
+
+    /** Reads the snapshot of a \a projectFile into \a document. Returns false if
+     * there is no snapshot, if it is stale or if it could not be read, in which
+     * case \a document is left untouched.
+     */
+    static bool read( const QString &projectFile, QDomDocument &document );
+
+    /** Returns true if the \a projectFile has a snapshot matching its current
+     * contents.
+     */
+    static bool isUpToDate( const QString &projectFile );
+
+};
+
+#endif // QGSPROJECTSNAPSHOT_H
@@ -227,8 +227,24 @@ void QgsProviderRegistry::init()
 // typedef for the unload dataprovider function
 typedef void cleanupProviderFunction_t();
 
+/** Returns true if providers of the given type may be created on a background
+ * thread by preloadProviders(). These providers open their sources through
+ * handles which are not shared between threads.
+ *
+ * PostgreSQL is deliberately excluded: off the main thread QgsPostgresConn
+ * never shares connections, so every preloaded layer would open its own, and
+ * a credentials prompt would deadlock against the main thread waiting on the
+ * preloaded provider.
+ */
+static bool isPreloadable( const QString &providerKey )
+{
+  return providerKey == QLatin1String( "ogr" )
+         || providerKey == QLatin1String( "gdal" );
+}
+
 void QgsProviderRegistry::clean()
 {
+  clearPreloadedProviders();
   QgsProject::instance()->removeAllMapLayers();
 
   Providers::const_iterator it = mProviders.begin();
@@ -355,6 +371,28 @@ typedef QgsDataProvider *classFactoryFunction_t( const QString * );
  *        in qgsrasterlayer, qgsvectorlayer, serversourceselect, etc.
  */
 QgsDataProvider *QgsProviderRegistry::createProvider( QString const &providerKey, QString const &dataSource )
+{
+  // take over a matching provider created in the background by preloadProviders()
+  QFuture< QgsDataProvider * > preloaded;
+  bool isPreloaded = false;
+  {
+    QMutexLocker locker( &mPreloadMutex );
+    const QString key = preloadKey( providerKey, dataSource );
+    if ( mPreloadedProviders.contains( key ) )
+    {
+      preloaded = mPreloadedProviders.take( key );
+      isPreloaded = true;
+    }
+  }
+  if ( isPreloaded )
+  {
+    return preloaded.result();
+  }
+
+  return createProviderInternal( providerKey, dataSource );
+}
+
+QgsDataProvider *QgsProviderRegistry::createProviderInternal( const QString &providerKey, const QString &dataSource )
 {
   // XXX should I check for and possibly delete any pre-existing providers?
   // XXX How often will that scenario occur?
@@ -418,6 +456,54 @@ QgsDataProvider *QgsProviderRegistry::createProvider( QString const &providerKey
 
   QgsDebugMsg( QString( "Instantiated the data provider plugin: %1" ).arg( dataProvider->name() ) );
   return dataProvider;
+}
+
+void QgsProviderRegistry::preloadProviders( const QList< QPair< QString, QString > > &sources )
+{
+  QMutexLocker locker( &mPreloadMutex );
+  for ( const QPair< QString, QString > &source : sources )
+  {
+    const QString providerKey = source.first;
+    const QString dataSource = source.second;
+
+    // only providers known to open their sources independently of each other
+    // and of the main thread are initialized in the background
+    if ( !isPreloadable( providerKey ) || !providerMetadata( providerKey ) )
+      continue;
+
+    const QString key = preloadKey( providerKey, dataSource );
+    if ( mPreloadedProviders.contains( key ) )
+      continue;
+
+    QThread *targetThread = QThread::currentThread();
+    mPreloadedProviders.insert( key, QtConcurrent::run( [this, providerKey, dataSource, targetThread]() -> QgsDataProvider *
+    {
+      QgsDataProvider *provider = createProviderInternal( providerKey, dataSource );
+      // hand the provider over to the thread which will eventually use it
+      if ( provider )
+        provider->moveToThread( targetThread );
+      return provider;
+    } ) );
+  }
+}
+
+void QgsProviderRegistry::clearPreloadedProviders()
+{
+  QHash< QString, QFuture< QgsDataProvider * > > preloaded;
+  {
+    QMutexLocker locker( &mPreloadMutex );
+    preloaded.swap( mPreloadedProviders );
+  }
+
+  for ( QFuture< QgsDataProvider * > &future : preloaded )
+  {
+    delete future.result();
+  }
+}
+
+QString QgsProviderRegistry::preloadKey( const QString &providerKey, const QString &dataSource )
+{
+  return providerKey + '\n' + dataSource;
 } // QgsProviderRegistry::setDataProvider
 
 int QgsProviderRegistry::providerCapabilities( const QString &providerKey ) const
@@ -22,7 +22,10 @@
 #include <map>
 
 #include <QDir>
+#include <QFuture>
+#include <QHash>
 #include <QLibrary>
+#include <QMutex>
 #include <QString>
 
 #include "qgis_core.h"
@@ -95,6 +98,31 @@ class CORE_EXPORT QgsProviderRegistry
     QgsDataProvider *createProvider( const QString &providerKey,
                                      const QString &dataSource ) SIP_FACTORY;
 
+    /**
+     * Starts creating providers for a list of (provider key, data source) pairs
+     * in the background, using the global thread pool.
+     *
+     * A later call to createProvider() with a matching provider key and data
+     * source takes over the preloaded provider (waiting for it to finish
+     * initializing if required) instead of creating a new one. Only providers
+     * which are safe to initialize off the main thread are preloaded, other
+     * sources are ignored.
+     *
+     * Providers which were never taken over must be released by calling
+     * clearPreloadedProviders().
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void preloadProviders( const QList< QPair< QString, QString > > &sources ) SIP_SKIP;
+
+    /**
+     * Waits for any providers started by preloadProviders() and deletes those
+     * which were not taken over by createProvider().
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void clearPreloadedProviders() SIP_SKIP;
+
     /** Return the provider capabilities
         \param providerKey identificator of the provider
         \since QGIS 2.6
@@ -207,6 +235,12 @@ class CORE_EXPORT QgsProviderRegistry
     void init();
     void clean();
 
+    //! Creates a provider, ignoring any preloaded providers
+    QgsDataProvider *createProviderInternal( const QString &providerKey, const QString &dataSource );
+
+    //! Returns the key used to match preloaded providers
+    static QString preloadKey( const QString &providerKey, const QString &dataSource );
+
     //! Associative container of provider metadata handles
     Providers mProviders;
 
@@ -247,6 +281,10 @@ class CORE_EXPORT QgsProviderRegistry
      */
     QString mProtocolDrivers;
 
+    //! Providers being created in the background, by preload key
+    QHash< QString, QFuture< QgsDataProvider * > > mPreloadedProviders;
+    QMutex mPreloadMutex;
+
 }; // class QgsProviderRegistry
 
 #endif //QGSPROVIDERREGISTRY_H
@@ -340,6 +340,32 @@ bool QgsSpatialIndex::deleteFeature( const QgsFeature &f )
   return d->mRTree->deleteData( r, FID_TO_NUMBER( id ) );
 }
 
+bool QgsSpatialIndex::deleteFeature( QgsFeatureId id, const QgsRectangle &bounds )
+{
+  SpatialIndex::Region r( rectToRegion( bounds ) );
+
+  try
+  {
+    return d->mRTree->deleteData( r, FID_TO_NUMBER( id ) );
+  }
+  catch ( Tools::Exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "Tools::Exception caught: " ).arg( e.what().c_str() ) );
+  }
+  catch ( const std::exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "std::exception caught: " ).arg( e.what() ) );
+  }
+  catch ( ... )
+  {
+    QgsDebugMsg( "unknown spatial index exception caught" );
+  }
+
+  return false;
+}
+
 QList<QgsFeatureId> QgsSpatialIndex::intersects( const QgsRectangle &rect ) const
 {
   QList<QgsFeatureId> list;
@@ -110,6 +110,13 @@ class CORE_EXPORT QgsSpatialIndex
     //! Remove feature from index
     bool deleteFeature( const QgsFeature &f );
 
+    /**
+     * Removes a feature \a id from the index, using the bounding box it was added with.
+     * \returns true if feature was successfully removed from index.
+     * \since QGIS 3.0
+    */
+    bool deleteFeature( QgsFeatureId id, const QgsRectangle &bounds );
+
 
     /* queries */
 
@@ -38,6 +38,59 @@ QString QgsSqlExpressionCompiler::result()
   return mResult;
 }
 
+QString QgsSqlExpressionCompiler::compileAggregate( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldName )
+{
+  QString column = quotedIdentifier( fieldName );
+
+  switch ( aggregate )
+  {
+    case QgsAggregateCalculator::Count:
+      return QStringLiteral( "COUNT(%1)" ).arg( column );
+    case QgsAggregateCalculator::CountDistinct:
+      return QStringLiteral( "COUNT(DISTINCT %1)" ).arg( column );
+    case QgsAggregateCalculator::CountMissing:
+      return QStringLiteral( "(COUNT(*)-COUNT(%1))" ).arg( column );
+    case QgsAggregateCalculator::Min:
+      return QStringLiteral( "MIN(%1)" ).arg( column );
+    case QgsAggregateCalculator::Max:
+      return QStringLiteral( "MAX(%1)" ).arg( column );
+    case QgsAggregateCalculator::Sum:
+      // the sum of no values is 0, not NULL
+      return QStringLiteral( "COALESCE(SUM(%1),0)" ).arg( column );
+    case QgsAggregateCalculator::Mean:
+    {
+      if ( mFlags.testFlag( IntegerDivisionResultsInInteger ) )
+      {
+        // the average of integers could be an integer too
+        QString real = castToReal( column );
+        if ( real.isEmpty() )
+          return QString();
+        return QStringLiteral( "AVG(%1)" ).arg( real );
+      }
+      return QStringLiteral( "AVG(%1)" ).arg( column );
+    }
+    case QgsAggregateCalculator::Range:
+      return QStringLiteral( "(MAX(%1)-MIN(%1))" ).arg( column );
+
+    case QgsAggregateCalculator::Median:
+    case QgsAggregateCalculator::StDev:
+    case QgsAggregateCalculator::StDevSample:
+    case QgsAggregateCalculator::Minority:
+    case QgsAggregateCalculator::Majority:
+    case QgsAggregateCalculator::FirstQuartile:
+    case QgsAggregateCalculator::ThirdQuartile:
+    case QgsAggregateCalculator::InterQuartileRange:
+    case QgsAggregateCalculator::StringMinimumLength:
+    case QgsAggregateCalculator::StringMaximumLength:
+    case QgsAggregateCalculator::StringConcatenate:
+    case QgsAggregateCalculator::GeometryCollect:
+    case QgsAggregateCalculator::ArrayAggregate:
+      break;
+  }
+
+  return QString();
+}
+
 QString QgsSqlExpressionCompiler::quotedIdentifier( const QString &identifier )
 {
   QString quoted = identifier;
@@ -20,6 +20,7 @@
 
 #include "qgis_core.h"
 #include "qgsfields.h"
+#include "qgsaggregatecalculator.h"
 
 class QgsExpression;
 class QgsExpressionNode;
@@ -75,6 +76,18 @@ class CORE_EXPORT QgsSqlExpressionCompiler
      */
     virtual QString result();
 
+    /**
+     * Compiles an aggregate over a numeric column to an SQL expression, for use in the
+     * select list of a query. Derived classes should override this to support aggregates
+     * which have no common SQL equivalent. The compiled aggregate must give the same result
+     * as QgsAggregateCalculator would calculate from the column's values.
+     * \param aggregate aggregate to compile
+     * \param fieldName name of the column to aggregate
+     * \returns compiled aggregate, or an empty string if the aggregate cannot be compiled
+     * \since QGIS 3.0
+     */
+    virtual QString compileAggregate( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldName );
+
   protected:
 
     /** Returns a quoted column identifier, in the format expected by the provider.
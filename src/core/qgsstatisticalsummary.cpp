@@ -15,9 +15,45 @@
 
 #include "qgsstatisticalsummary.h"
 #include <limits>
+#include <cstring>
 #include <QString>
 #include <QObject>
 
+///@cond PRIVATE
+
+// compression of the t-digest used for approximate quantiles
+static const double DIGEST_COMPRESSION = 100.0;
+// number of values collected before they are merged into the t-digest
+static const int DIGEST_BUFFER_SIZE = 500;
+// precision (bits of the hash used as register index) of the HyperLogLog sketch
+static const int DISTINCT_PRECISION = 12;
+static const int DISTINCT_REGISTERS = 1 << DISTINCT_PRECISION;
+
+// maximum fraction of values which may end up in a t-digest centroid, given the
+// fraction of values in the centroids before it (the "k1" scale function)
+static double digestQuantileLimit( double quantile )
+{
+  double k = DIGEST_COMPRESSION / ( 2 * M_PI ) * std::asin( 2 * quantile - 1 ) + 1;
+  double angle = std::min( k * 2 * M_PI / DIGEST_COMPRESSION, M_PI / 2 );
+  return ( std::sin( angle ) + 1 ) / 2;
+}
+
+static quint64 hashDouble( double value )
+{
+  // +0 and -0 compare equal, so they must hash equally too
+  if ( value == 0 )
+    value = 0;
+  quint64 hash;
+  memcpy( &hash, &value, sizeof( double ) );
+
+  // splitmix64 finalizer
+  hash = ( hash ^ ( hash >> 30 ) ) * Q_UINT64_C( 0xbf58476d1ce4e5b9 );
+  hash = ( hash ^ ( hash >> 27 ) ) * Q_UINT64_C( 0x94d049bb133111eb );
+  return hash ^ ( hash >> 31 );
+}
+
+///@endcond
+
 /***************************************************************************
  * This class is considered CRITICAL and any change MUST be accompanied with
  * full unit tests in testqgsstatisticalsummary.cpp.
@@ -45,8 +81,14 @@ void QgsStatisticalSummary::reset()
   mMajority = 0;
   mFirstQuartile = 0;
   mThirdQuartile = 0;
+  mRunningMean = 0;
+  mSumSquaredDiffs = 0;
+  mVariety = 0;
   mValueCount.clear();
   mValues.clear();
+  mDigest.clear();
+  mDigestBuffer.clear();
+  mDistinctRegisters.clear();
 }
 
 /***************************************************************************
@@ -74,13 +116,35 @@ void QgsStatisticalSummary::addValue( double value )
   mMin = std::min( mMin, value );
   mMax = std::max( mMax, value );
 
-  if ( mStatistics & QgsStatisticalSummary::Majority || mStatistics & QgsStatisticalSummary::Minority || mStatistics & QgsStatisticalSummary::Variety )
+  // Welford's algorithm, so that the standard deviation needs no second pass over the values
+  double diff = value - mRunningMean;
+  mRunningMean += diff / mCount;
+  mSumSquaredDiffs += diff * ( value - mRunningMean );
+
+  if ( mStatistics & QgsStatisticalSummary::Majority || mStatistics & QgsStatisticalSummary::Minority
+       || ( !mApproximate && mStatistics & QgsStatisticalSummary::Variety ) )
     mValueCount.insert( value, mValueCount.value( value, 0 ) + 1 );
 
-  if ( mStatistics & QgsStatisticalSummary::StDev || mStatistics & QgsStatisticalSummary::StDevSample ||
-       mStatistics & QgsStatisticalSummary::Median || mStatistics & QgsStatisticalSummary::FirstQuartile ||
+  if ( mApproximate && mStatistics & QgsStatisticalSummary::Variety )
+    addDistinct( value );
+
+  if ( mStatistics & QgsStatisticalSummary::Median || mStatistics & QgsStatisticalSummary::FirstQuartile ||
        mStatistics & QgsStatisticalSummary::ThirdQuartile || mStatistics & QgsStatisticalSummary::InterQuartileRange )
-    mValues << value;
+  {
+    if ( !mApproximate )
+    {
+      mValues << value;
+    }
+    else
+    {
+      Centroid centroid;
+      centroid.mean = value;
+      centroid.weight = 1;
+      mDigestBuffer << centroid;
+      if ( mDigestBuffer.count() >= DIGEST_BUFFER_SIZE )
+        compressDigest();
+    }
+  }
 }
 
 void QgsStatisticalSummary::addVariant( const QVariant &value )
@@ -119,20 +183,29 @@ void QgsStatisticalSummary::finalize()
 
   if ( mStatistics & QgsStatisticalSummary::StDev || mStatistics & QgsStatisticalSummary::StDevSample )
   {
-    double sumSquared = 0;
-    Q_FOREACH ( double value, mValues )
-    {
-      double diff = value - mMean;
-      sumSquared += diff * diff;
-    }
-    mStdev = std::pow( sumSquared / mValues.count(), 0.5 );
-    mSampleStdev = std::pow( sumSquared / ( mValues.count() - 1 ), 0.5 );
+    mStdev = std::pow( mSumSquaredDiffs / mCount, 0.5 );
+    mSampleStdev = std::pow( mSumSquaredDiffs / ( mCount - 1 ), 0.5 );
   }
 
-  if ( mStatistics & QgsStatisticalSummary::Median
-       || mStatistics & QgsStatisticalSummary::FirstQuartile
-       || mStatistics & QgsStatisticalSummary::ThirdQuartile
-       || mStatistics & QgsStatisticalSummary::InterQuartileRange )
+  if ( mStatistics & QgsStatisticalSummary::Variety )
+  {
+    mVariety = mApproximate && mValueCount.isEmpty() ? qRound( distinctEstimate() ) : mValueCount.count();
+  }
+
+  if ( mApproximate && ( mStatistics & QgsStatisticalSummary::Median
+                         || mStatistics & QgsStatisticalSummary::FirstQuartile
+                         || mStatistics & QgsStatisticalSummary::ThirdQuartile
+                         || mStatistics & QgsStatisticalSummary::InterQuartileRange ) )
+  {
+    compressDigest();
+    mMedian = digestQuantile( 0.5 );
+    mFirstQuartile = digestQuantile( 0.25 );
+    mThirdQuartile = digestQuantile( 0.75 );
+  }
+  else if ( mStatistics & QgsStatisticalSummary::Median
+            || mStatistics & QgsStatisticalSummary::FirstQuartile
+            || mStatistics & QgsStatisticalSummary::ThirdQuartile
+            || mStatistics & QgsStatisticalSummary::InterQuartileRange )
   {
     std::sort( mValues.begin(), mValues.end() );
     bool even = ( mCount % 2 ) < 1;
@@ -146,8 +219,8 @@ void QgsStatisticalSummary::finalize()
     }
   }
 
-  if ( mStatistics & QgsStatisticalSummary::FirstQuartile
-       || mStatistics & QgsStatisticalSummary::InterQuartileRange )
+  if ( !mApproximate && ( mStatistics & QgsStatisticalSummary::FirstQuartile
+                          || mStatistics & QgsStatisticalSummary::InterQuartileRange ) )
   {
     if ( ( mCount % 2 ) < 1 )
     {
@@ -177,8 +250,8 @@ void QgsStatisticalSummary::finalize()
     }
   }
 
-  if ( mStatistics & QgsStatisticalSummary::ThirdQuartile
-       || mStatistics & QgsStatisticalSummary::InterQuartileRange )
+  if ( !mApproximate && ( mStatistics & QgsStatisticalSummary::ThirdQuartile
+                          || mStatistics & QgsStatisticalSummary::InterQuartileRange ) )
   {
     if ( ( mCount % 2 ) < 1 )
     {
@@ -224,6 +297,165 @@ void QgsStatisticalSummary::finalize()
 
 }
 
+void QgsStatisticalSummary::merge( const QgsStatisticalSummary &other )
+{
+  if ( other.mCount > 0 )
+  {
+    // combine the means and squared differences of both parts (Chan et al.)
+    double diff = other.mRunningMean - mRunningMean;
+    double count = static_cast< double >( mCount ) + other.mCount;
+    mRunningMean += diff * other.mCount / count;
+    mSumSquaredDiffs += other.mSumSquaredDiffs + diff * diff * mCount * other.mCount / count;
+  }
+
+  mCount += other.mCount;
+  mMissing += other.mMissing;
+  mSum += other.mSum;
+  mMin = std::min( mMin, other.mMin );
+  mMax = std::max( mMax, other.mMax );
+
+  for ( QMap< double, int >::const_iterator it = other.mValueCount.constBegin(); it != other.mValueCount.constEnd(); ++it )
+  {
+    mValueCount.insert( it.key(), mValueCount.value( it.key(), 0 ) + it.value() );
+  }
+
+  mValues << other.mValues;
+
+  if ( !other.mDigest.isEmpty() || !other.mDigestBuffer.isEmpty() )
+  {
+    mDigestBuffer << other.mDigest << other.mDigestBuffer;
+    if ( mDigestBuffer.count() >= DIGEST_BUFFER_SIZE )
+      compressDigest();
+  }
+
+  if ( !other.mDistinctRegisters.isEmpty() )
+  {
+    if ( mDistinctRegisters.isEmpty() )
+    {
+      mDistinctRegisters = other.mDistinctRegisters;
+    }
+    else
+    {
+      for ( int i = 0; i < DISTINCT_REGISTERS; ++i )
+        mDistinctRegisters[i] = std::max( mDistinctRegisters.at( i ), other.mDistinctRegisters.at( i ) );
+    }
+  }
+}
+
+void QgsStatisticalSummary::compressDigest()
+{
+  if ( mDigestBuffer.isEmpty() )
+    return;
+
+  QVector< Centroid > centroids = mDigest;
+  centroids << mDigestBuffer;
+  mDigestBuffer.clear();
+  std::sort( centroids.begin(), centroids.end(), []( const Centroid & a, const Centroid & b ) { return a.mean < b.mean; } );
+
+  double totalWeight = 0;
+  Q_FOREACH ( const Centroid &centroid, centroids )
+    totalWeight += centroid.weight;
+
+  // merge neighboring centroids, keeping centroids near the tails small so that
+  // quantiles close to the minimum and maximum stay accurate
+  QVector< Centroid > merged;
+  Centroid current = centroids.at( 0 );
+  double weightSoFar = 0;
+  double weightLimit = totalWeight * digestQuantileLimit( 0 );
+  for ( int i = 1; i < centroids.count(); ++i )
+  {
+    const Centroid &next = centroids.at( i );
+    if ( weightSoFar + current.weight + next.weight <= weightLimit )
+    {
+      current.mean += ( next.mean - current.mean ) * next.weight / ( current.weight + next.weight );
+      current.weight += next.weight;
+    }
+    else
+    {
+      weightSoFar += current.weight;
+      merged << current;
+      weightLimit = totalWeight * digestQuantileLimit( weightSoFar / totalWeight );
+      current = next;
+    }
+  }
+  merged << current;
+  mDigest = merged;
+}
+
+double QgsStatisticalSummary::digestQuantile( double quantile ) const
+{
+  if ( mDigest.isEmpty() )
+    return std::numeric_limits<double>::quiet_NaN();
+  if ( mDigest.count() == 1 )
+    return mDigest.at( 0 ).mean;
+
+  double totalWeight = 0;
+  Q_FOREACH ( const Centroid &centroid, mDigest )
+    totalWeight += centroid.weight;
+
+  // interpolate between the centers of the centroids, and between the outermost
+  // centroids and the minimum/maximum values
+  double target = quantile * totalWeight;
+  double previousMean = mMin;
+  double previousCenter = 0;
+  double weightSoFar = 0;
+  Q_FOREACH ( const Centroid &centroid, mDigest )
+  {
+    double center = weightSoFar + centroid.weight / 2;
+    if ( target < center )
+      return previousMean + ( centroid.mean - previousMean ) * ( target - previousCenter ) / ( center - previousCenter );
+
+    previousMean = centroid.mean;
+    previousCenter = center;
+    weightSoFar += centroid.weight;
+  }
+  return previousMean + ( mMax - previousMean ) * ( target - previousCenter ) / ( totalWeight - previousCenter );
+}
+
+void QgsStatisticalSummary::addDistinct( double value )
+{
+  if ( mDistinctRegisters.isEmpty() )
+    mDistinctRegisters = QByteArray( DISTINCT_REGISTERS, 0 );
+
+  // the first bits of the hash pick the register, which stores the longest run
+  // of leading zeros seen in the remaining bits
+  quint64 hash = hashDouble( value );
+  int index = static_cast< int >( hash >> ( 64 - DISTINCT_PRECISION ) );
+  quint64 remaining = hash << DISTINCT_PRECISION;
+  char rank = 1;
+  while ( rank <= 64 - DISTINCT_PRECISION && !( remaining & ( Q_UINT64_C( 1 ) << 63 ) ) )
+  {
+    rank++;
+    remaining <<= 1;
+  }
+  if ( rank > mDistinctRegisters.at( index ) )
+    mDistinctRegisters[index] = rank;
+}
+
+double QgsStatisticalSummary::distinctEstimate() const
+{
+  if ( mDistinctRegisters.isEmpty() )
+    return 0;
+
+  double sum = 0;
+  int emptyRegisters = 0;
+  for ( int i = 0; i < DISTINCT_REGISTERS; ++i )
+  {
+    sum += std::pow( 2.0, -mDistinctRegisters.at( i ) );
+    if ( mDistinctRegisters.at( i ) == 0 )
+      emptyRegisters++;
+  }
+
+  double alpha = 0.7213 / ( 1 + 1.079 / DISTINCT_REGISTERS );
+  double estimate = alpha * DISTINCT_REGISTERS * DISTINCT_REGISTERS / sum;
+  if ( estimate <= 2.5 * DISTINCT_REGISTERS && emptyRegisters > 0 )
+  {
+    // linear counting is more accurate for small cardinalities
+    estimate = DISTINCT_REGISTERS * std::log( static_cast< double >( DISTINCT_REGISTERS ) / emptyRegisters );
+  }
+  return estimate;
+}
+
 /***************************************************************************
  * This class is considered CRITICAL and any change MUST be accompanied with
  * full unit tests in testqgsstatisticalsummary.cpp.
@@ -259,7 +491,7 @@ double QgsStatisticalSummary::statistic( QgsStatisticalSummary::Statistic stat )
     case Majority:
       return mMajority;
     case Variety:
-      return mValueCount.count();
+      return mVariety;
     case FirstQuartile:
       return mFirstQuartile;
     case ThirdQuartile:
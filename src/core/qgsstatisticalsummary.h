@@ -18,6 +18,8 @@
 
 #include <QMap>
 #include <QVariant>
+#include <QVector>
+#include <QByteArray>
 #include <cmath>
 #include "qgis_core.h"
 
@@ -36,6 +38,10 @@
  * are calculated by default. Statistics which require slower computations are only calculated by
  * specifying the statistic in the constructor or via setStatistics().
  *
+ * Values can also be added one at a time, and summaries which were calculated separately (e.g.
+ * on different threads) can be combined with merge(). The median and quartiles require all
+ * values to be stored, unless approximate statistics are enabled via setApproximate().
+ *
  * \since QGIS 2.9
  */
 
@@ -86,6 +92,23 @@ class CORE_EXPORT QgsStatisticalSummary
      */
     void setStatistics( QgsStatisticalSummary::Statistics stats ) { mStatistics = stats; }
 
+    /** Returns true if statistics which require all (distinct) values to be stored are
+     * approximated instead.
+     * \see setApproximate()
+     * \since QGIS 3.0
+     */
+    bool approximate() const { return mApproximate; }
+
+    /** Sets whether statistics which require all (distinct) values to be stored are
+     * approximated instead, using a fixed amount of memory. The median, quartiles and IQR are
+     * estimated from a t-digest, and the variety from a HyperLogLog sketch. Other statistics,
+     * including the minority and majority, are always calculated exactly.
+     * The summary must be reset after changing this setting.
+     * \see approximate()
+     * \since QGIS 3.0
+     */
+    void setApproximate( bool approximate ) { mApproximate = approximate; }
+
     /** Resets the calculated values
      */
     void reset();
@@ -135,6 +158,16 @@ class CORE_EXPORT QgsStatisticalSummary
      */
     void finalize();
 
+    /** Merges the values added to \a other into this summary, as if they had been added
+     * to this summary directly. Both summaries must calculate the same statistics, and
+     * neither must have been finalized. Call finalize() after merging to retrieve the
+     * calculated statistics.
+     * \see addValue()
+     * \see finalize()
+     * \since QGIS 3.0
+     */
+    void merge( const QgsStatisticalSummary &other );
+
     /** Returns the value of a specified statistic
      * \param stat statistic to return
      * \returns calculated value of statistic. A NaN value may be returned for invalid
@@ -199,7 +232,7 @@ class CORE_EXPORT QgsStatisticalSummary
      * This is only calculated if Statistic::Variety has been specified in the constructor
      * or via setStatistics.
      */
-    int variety() const { return mValueCount.count(); }
+    int variety() const { return mVariety; }
 
     /** Returns minority of values. The minority is the value with least occurrences in the list
      * This is only calculated if Statistic::Minority has been specified in the constructor
@@ -248,12 +281,22 @@ class CORE_EXPORT QgsStatisticalSummary
 
   private:
 
+    //! Cluster of values in a t-digest
+    struct Centroid
+    {
+      double mean;
+      double weight;
+    };
+
     Statistics mStatistics;
+    bool mApproximate = false;
 
     int mCount;
     int mMissing;
     double mSum;
     double mMean;
+    double mRunningMean;
+    double mSumSquaredDiffs;
     double mMedian;
     double mMin;
     double mMax;
@@ -263,8 +306,17 @@ class CORE_EXPORT QgsStatisticalSummary
     double mMajority;
     double mFirstQuartile;
     double mThirdQuartile;
+    int mVariety;
     QMap< double, int > mValueCount;
     QList< double > mValues;
+    QVector< Centroid > mDigest;
+    QVector< Centroid > mDigestBuffer;
+    QByteArray mDistinctRegisters;
+
+    void compressDigest();
+    double digestQuantile( double quantile ) const;
+    void addDistinct( double value );
+    double distinctEstimate() const;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsStatisticalSummary::Statistics )
@@ -76,6 +76,22 @@ void QgsStringStatisticalSummary::finalize()
   mMeanLength = mSumLengths / static_cast< double >( mCount );
 }
 
+void QgsStringStatisticalSummary::merge( const QgsStringStatisticalSummary &other )
+{
+  mCount += other.mCount;
+  mCountMissing += other.mCountMissing;
+  mValues.unite( other.mValues );
+
+  if ( mMin.isEmpty() || ( !other.mMin.isEmpty() && other.mMin < mMin ) )
+    mMin = other.mMin;
+  if ( mMax.isEmpty() || ( !other.mMax.isEmpty() && other.mMax > mMax ) )
+    mMax = other.mMax;
+
+  mSumLengths += other.mSumLengths;
+  mMinLength = std::min( mMinLength, other.mMinLength );
+  mMaxLength = std::max( mMaxLength, other.mMaxLength );
+}
+
 void QgsStringStatisticalSummary::calculateFromVariants( const QVariantList &values )
 {
   reset();
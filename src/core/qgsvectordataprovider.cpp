@@ -471,6 +471,14 @@ QStringList QgsVectorDataProvider::uniqueStringsMatching( int index, const QStri
   return results;
 }
 
+bool QgsVectorDataProvider::uniqueValueCounts( int index, QList< QPair< QVariant, long > > &counts ) const
+{
+  //base implementation does nothing
+  Q_UNUSED( index );
+  Q_UNUSED( counts );
+  return false;
+}
+
 QVariant QgsVectorDataProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
     const QgsAggregateCalculator::AggregateParameters &parameters, QgsExpressionContext *context, bool &ok ) const
 {
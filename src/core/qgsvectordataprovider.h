@@ -201,6 +201,19 @@ class CORE_EXPORT QgsVectorDataProvider : public QgsDataProvider, public QgsFeat
     virtual QStringList uniqueStringsMatching( int index, const QString &substring, int limit = -1,
         QgsFeedback *feedback = nullptr ) const;
 
+    /**
+     * Counts the features for each unique value of an attribute, using the data source
+     * directly (e.g. with a GROUP BY query). The base implementation does nothing, and
+     * returns false to indicate that the features need to be iterated to count them.
+     * \param index the index of the attribute
+     * \param counts will be set to the unique values of the attribute and their feature counts
+     * \returns true if the counts were calculated by the data provider
+     * \note not available in Python bindings
+     * \see QgsAbstractFeatureSource::uniqueValueCounts()
+     * \since QGIS 3.0
+     */
+    virtual bool uniqueValueCounts( int index, QList< QPair< QVariant, long > > &counts ) const SIP_SKIP;
+
     /** Calculates an aggregated value from the layer's features. The base implementation does nothing,
      * but subclasses can override this method to handoff calculation of aggregates to the provider.
      * \param aggregate aggregate to calculate
@@ -37,6 +37,9 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
+#include <QQueue>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 #include <QTextCodec>
 #include <QTextStream>
 #include <QSet>
@@ -45,6 +48,7 @@
 #include <cassert>
 #include <cstdlib> // size_t
 #include <limits> // std::numeric_limits
+#include <memory>
 
 #include <ogr_srs_api.h>
 #include <cpl_error.h>
@@ -2318,6 +2322,53 @@ QgsVectorFileWriter::WriterError QgsVectorFileWriter::writeAsVectorFormat( QgsVe
   return writeAsVectorFormat( layer, fileName, options, newFilename, errorMessage );
 }
 
+///@cond PRIVATE
+namespace
+{
+  //! Number of features read, transformed and written together by writeAsVectorFormat()
+  const int FEATURE_BATCH_SIZE = 1000;
+
+  //! A batch of features passing through writeAsVectorFormat()
+  struct FeatureBatch
+  {
+    QgsFeatureList features;
+    //! Index of the first feature which could not be transformed, or -1
+    int transformErrorIndex = -1;
+    //! Description of the transform error
+    QString transformError;
+    //! Finishes when the features have been transformed on a worker thread
+    QFuture< void > transformed;
+  };
+
+  /**
+   * Transforms the geometries of a batch of features. Stops at the first feature which
+   * cannot be transformed, as writing stops there.
+   */
+  void transformFeatureBatch( std::shared_ptr< FeatureBatch > batch, const QgsCoordinateTransform &ct )
+  {
+    for ( int i = 0; i < batch->features.count(); ++i )
+    {
+      QgsFeature &feature = batch->features[i];
+      if ( !feature.hasGeometry() )
+        continue;
+
+      try
+      {
+        QgsGeometry g = feature.geometry();
+        g.transform( ct );
+        feature.setGeometry( g );
+      }
+      catch ( QgsCsException &e )
+      {
+        batch->transformErrorIndex = i;
+        batch->transformError = e.what();
+        return;
+      }
+    }
+  }
+}
+///@endcond
+
 QgsVectorFileWriter::SaveVectorOptions::SaveVectorOptions()
   : driverName( QStringLiteral( "ESRI Shapefile" ) )
   , layerName( QString() )
@@ -2336,6 +2387,8 @@ QgsVectorFileWriter::SaveVectorOptions::SaveVectorOptions()
   , forceMulti( false )
   , includeZ( false )
   , fieldValueConverter( nullptr )
+  , transactionBatchSize( 0 )
+  , parallelProcessing( true )
 {
 }
 
@@ -2588,86 +2641,140 @@ QgsVectorFileWriter::writeAsVectorFormat( QgsVectorLayer *layer,
   writer->mFields = layer->fields();
 
   // write all features
+  //
+  // Features are read and written on this thread, as neither the feature iterator nor
+  // the OGR layer may be shared between threads. Reprojecting is the costliest step of
+  // most exports, so when parallel processing is enabled batches of features are
+  // transformed on the global thread pool while earlier batches are being written.
+  const bool parallelTransform = shallTransform && options.parallelProcessing;
+  const int maxPendingBatches = parallelTransform ? std::max( 1, QThreadPool::globalInstance()->maxThreadCount() ) : 1;
+  QQueue< std::shared_ptr< FeatureBatch > > pendingBatches;
+
   long saved = 0;
+  long transactionFeatures = 0;
   int initialProgress = lastProgressReport;
-  while ( fit.nextFeature( fet ) )
-  {
-    if ( options.feedback && options.feedback->isCanceled() )
-    {
-      delete writer;
-      return Canceled;
-    }
+  WriterError abortError = NoError;
+  bool stopWriting = false;
 
-    saved++;
-    if ( options.feedback )
+  auto writeBatch = [&]( const FeatureBatch & batch )
+  {
+    for ( int i = 0; i < batch.features.count(); ++i )
     {
-      //avoid spamming progress reports
-      int newProgress = initialProgress + ( ( 100.0 - initialProgress ) * saved ) / total;
-      if ( newProgress < 100 && newProgress != lastProgressReport )
+      if ( options.feedback && options.feedback->isCanceled() )
       {
-        lastProgressReport = newProgress;
-        options.feedback->setProgress( lastProgressReport );
+        abortError = Canceled;
+        return;
       }
-    }
 
-    if ( shallTransform )
-    {
-      try
+      if ( i == batch.transformErrorIndex )
       {
-        if ( fet.hasGeometry() )
-        {
-          QgsGeometry g = fet.geometry();
-          g.transform( options.ct );
-          fet.setGeometry( g );
-        }
-      }
-      catch ( QgsCsException &e )
-      {
-        delete writer;
-
         QString msg = QObject::tr( "Failed to transform a point while drawing a feature with ID '%1'. Writing stopped. (Exception: %2)" )
-                      .arg( fet.id() ).arg( e.what() );
+                      .arg( batch.features.at( i ).id() ).arg( batch.transformError );
         QgsLogger::warning( msg );
         if ( errorMessage )
           *errorMessage = msg;
 
-        return ErrProjection;
+        abortError = ErrProjection;
+        return;
       }
-    }
 
-    if ( fet.hasGeometry() && filterRectEngine && !filterRectEngine->intersects( fet.geometry().geometry() ) )
-      continue;
+      saved++;
+      if ( options.feedback )
+      {
+        //avoid spamming progress reports
+        int newProgress = initialProgress + ( ( 100.0 - initialProgress ) * saved ) / total;
+        if ( newProgress < 100 && newProgress != lastProgressReport )
+        {
+          lastProgressReport = newProgress;
+          options.feedback->setProgress( lastProgressReport );
+        }
+      }
 
-    if ( attributes.size() < 1 && options.skipAttributeCreation )
-    {
-      fet.initAttributes( 0 );
-    }
+      QgsFeature fet = batch.features.at( i );
+      if ( fet.hasGeometry() && filterRectEngine && !filterRectEngine->intersects( fet.geometry().geometry() ) )
+        continue;
 
-    if ( !writer->addFeatureWithStyle( fet, layer->renderer(), mapUnits ) )
-    {
-      WriterError err = writer->hasError();
-      if ( err != NoError && errorMessage )
+      if ( attributes.size() < 1 && options.skipAttributeCreation )
       {
-        if ( errorMessage->isEmpty() )
+        fet.initAttributes( 0 );
+      }
+
+      if ( !writer->addFeatureWithStyle( fet, layer->renderer(), mapUnits ) )
+      {
+        WriterError err = writer->hasError();
+        if ( err != NoError && errorMessage )
         {
-          *errorMessage = QObject::tr( "Feature write errors:" );
+          if ( errorMessage->isEmpty() )
+          {
+            *errorMessage = QObject::tr( "Feature write errors:" );
+          }
+          *errorMessage += '\n' + writer->errorMessage();
+        }
+        errors++;
+
+        if ( errors > 1000 )
+        {
+          if ( errorMessage )
+          {
+            *errorMessage += QObject::tr( "Stopping after %1 errors" ).arg( errors );
+          }
+
+          n = -1;
+          stopWriting = true;
+          return;
         }
-        *errorMessage += '\n' + writer->errorMessage();
       }
-      errors++;
+      n++;
 
-      if ( errors > 1000 )
+      if ( transactionsEnabled && options.transactionBatchSize > 0 && ++transactionFeatures >= options.transactionBatchSize )
       {
-        if ( errorMessage )
+        transactionFeatures = 0;
+        if ( OGRERR_NONE != OGR_L_CommitTransaction( writer->mLayer ) )
         {
-          *errorMessage += QObject::tr( "Stopping after %1 errors" ).arg( errors );
+          QgsDebugMsg( "Error while committing transaction on OGRLayer." );
+        }
+        if ( OGRERR_NONE != OGR_L_StartTransaction( writer->mLayer ) )
+        {
+          QgsDebugMsg( "Error when trying to restart transaction on OGRLayer." );
+          transactionsEnabled = false;
         }
-
-        n = -1;
-        break;
       }
     }
-    n++;
+  };
+
+  bool moreFeatures = true;
+  while ( moreFeatures || !pendingBatches.isEmpty() )
+  {
+    if ( moreFeatures )
+    {
+      std::shared_ptr< FeatureBatch > batch = std::make_shared< FeatureBatch >();
+      batch->features.reserve( FEATURE_BATCH_SIZE );
+      while ( batch->features.count() < FEATURE_BATCH_SIZE && fit.nextFeature( fet ) )
+        batch->features << fet;
+      moreFeatures = batch->features.count() == FEATURE_BATCH_SIZE;
+
+      if ( parallelTransform )
+        batch->transformed = QtConcurrent::run( transformFeatureBatch, batch, options.ct );
+      else if ( shallTransform )
+        transformFeatureBatch( batch, options.ct );
+
+      pendingBatches.enqueue( batch );
+      if ( moreFeatures && pendingBatches.count() < maxPendingBatches )
+        continue;
+    }
+
+    std::shared_ptr< FeatureBatch > batch = pendingBatches.dequeue();
+    batch->transformed.waitForFinished();
+    writeBatch( *batch );
+
+    if ( abortError != NoError )
+    {
+      // pending batches own their features, there is no need to wait for them
+      delete writer;
+      return abortError;
+    }
+    if ( stopWriting )
+      break;
   }
 
   if ( transactionsEnabled )
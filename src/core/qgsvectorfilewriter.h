@@ -409,6 +409,17 @@ class CORE_EXPORT QgsVectorFileWriter : public QgsFeatureSink
 
         //! Optional feedback object allowing cancelation of layer save
         QgsFeedback *feedback = nullptr;
+
+        /** Number of features to write per transaction, for formats supporting transactions.
+         * Committing large exports in batches keeps the transaction journal small. Set to 0
+         * to write all features in a single transaction.
+         */
+        int transactionBatchSize;
+
+        /** Set to true to reproject features on worker threads while previously read
+         * features are being written.
+         */
+        bool parallelProcessing;
     };
 
     /** Writes a layer out to a vector file.
@@ -905,7 +905,10 @@ bool QgsVectorLayer::setSubsetString( const QString &subset )
   updateFields();
 
   if ( res )
+  {
+    invalidateSymbolCountedFlag();
     emit repaintRequested();
+  }
 
   return res;
 }
@@ -1479,25 +1482,31 @@ void QgsVectorLayer::setDataSource( const QString &dataSource, const QString &ba
 }
 
 
-bool QgsVectorLayer::setDataProvider( QString const &provider )
+QString QgsVectorLayer::providerDataSource( const QString &provider, const QString &dataSource, bool readExtentFromXml )
 {
-  mProviderKey = provider;     // XXX is this necessary?  Usually already set
-
   // primary key unicity is tested at construction time, so it has to be set
   // before initializing postgres provider
-  QString checkUnicityKey = QStringLiteral( "checkPrimaryKeyUnicity" );
-  QString dataSource = mDataSource;
   if ( provider.compare( QLatin1String( "postgres" ) ) == 0 )
   {
+    QString checkUnicityKey = QStringLiteral( "checkPrimaryKeyUnicity" );
     QgsDataSourceUri uri( dataSource );
 
     if ( uri.hasParam( checkUnicityKey ) )
       uri.removeParam( checkUnicityKey );
 
-    uri.setParam( checkUnicityKey, mReadExtentFromXml ? "0" : "1" );
-    dataSource = uri.uri( false );
+    uri.setParam( checkUnicityKey, readExtentFromXml ? "0" : "1" );
+    return uri.uri( false );
   }
 
+  return dataSource;
+}
+
+bool QgsVectorLayer::setDataProvider( QString const &provider )
+{
+  mProviderKey = provider;     // XXX is this necessary?  Usually already set
+
+  QString dataSource = providerDataSource( provider, mDataSource, mReadExtentFromXml );
+
   // XXX when execution gets here.
 
   //XXX - This was a dynamic cast but that kills the Windows
@@ -1585,6 +1594,7 @@ bool QgsVectorLayer::setDataProvider( QString const &provider )
 
   connect( mDataProvider, &QgsVectorDataProvider::dataChanged, this, &QgsVectorLayer::dataChanged );
   connect( mDataProvider, &QgsVectorDataProvider::dataChanged, this, &QgsVectorLayer::removeSelection );
+  connect( mDataProvider, &QgsVectorDataProvider::dataChanged, this, &QgsVectorLayer::invalidateSymbolCountedFlag );
 
   return true;
 } // QgsVectorLayer:: setDataProvider
@@ -3481,12 +3491,12 @@ QVariant QgsVectorLayer::aggregate( QgsAggregateCalculator::Aggregate aggregate,
   if ( attrIndex >= 0 )
   {
     // aggregate is based on a field - if it's a provider field, we could possibly hand over the calculation
-    // to the provider itself
+    // to the provider itself (unless there are edits which the provider does not know about yet)
     QgsFields::FieldOrigin origin = mFields.fieldOrigin( attrIndex );
-    if ( origin == QgsFields::OriginProvider )
+    if ( origin == QgsFields::OriginProvider && !isModified() )
     {
       bool providerOk = false;
-      QVariant val = mDataProvider->aggregate( aggregate, attrIndex, parameters, context, providerOk );
+      QVariant val = mDataProvider->aggregate( aggregate, mFields.fieldOriginIndex( attrIndex ), parameters, context, providerOk );
       if ( providerOk )
       {
         // provider handled calculation
@@ -4059,6 +4069,14 @@ QString QgsVectorLayer::htmlMetadata() const
 void QgsVectorLayer::invalidateSymbolCountedFlag()
 {
   mSymbolFeatureCounted = false;
+
+  // counts from a running counter would already be outdated
+  if ( mFeatureCounter )
+  {
+    disconnect( mFeatureCounter, nullptr, this, nullptr );
+    mFeatureCounter->cancel();
+    mFeatureCounter = nullptr;
+  }
 }
 
 void QgsVectorLayer::onFeatureCounterCompleted()
@@ -1621,6 +1621,16 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
      */
     bool readExtentFromXml() const;
 
+    /**
+     * Returns the data source passed to a \a provider when binding a layer with
+     * the specified \a dataSource, taking into account whether the layer
+     * reads its extent from the XML document (see setReadExtentFromXml()).
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    static QString providerDataSource( const QString &provider, const QString &dataSource, bool readExtentFromXml ) SIP_SKIP;
+
   public slots:
 
     /**
@@ -21,11 +21,113 @@
 #include "qgsvectorlayerjoininfo.h"
 #include "qgsvectorlayerjoinbuffer.h"
 
+#include <QDataStream>
+
+QgsVectorLayerCache::QgsCachedFeature::QgsCachedFeature( const QgsFeature &feat, QgsVectorLayerCache *vlCache )
+  : mFeatureId( feat.id() )
+  , mFields( feat.fields() )
+  , mCache( vlCache )
+{
+  setGeometry( feat.geometry() );
+  setAttributes( feat.attributes() );
+}
+
+QgsFeature QgsVectorLayerCache::QgsCachedFeature::feature() const
+{
+  QgsFeature feature( mFields, mFeatureId );
+  feature.setAttributes( attributes() );
+  if ( !mWkb.isEmpty() )
+  {
+    QgsGeometry geometry;
+    geometry.fromWkb( mWkb );
+    feature.setGeometry( geometry );
+  }
+  feature.setValid( true );
+  return feature;
+}
+
+void QgsVectorLayerCache::QgsCachedFeature::setAttribute( int field, const QVariant &value )
+{
+  QgsAttributes attrs = attributes();
+  if ( field < 0 || field >= attrs.count() )
+    return;
+
+  attrs[ field ] = value;
+  setAttributes( attrs );
+}
+
+void QgsVectorLayerCache::QgsCachedFeature::setGeometry( const QgsGeometry &geometry )
+{
+  if ( geometry.isNull() )
+  {
+    mWkb.clear();
+    mBoundingBox = QgsRectangle();
+  }
+  else
+  {
+    mWkb = geometry.exportToWkb();
+    mBoundingBox = geometry.boundingBox();
+  }
+}
+
+void QgsVectorLayerCache::QgsCachedFeature::setAttributes( const QgsAttributes &attributes )
+{
+  // values of custom types may not be serializable, keep them as they are
+  mPacked = true;
+  for ( const QVariant &value : attributes )
+  {
+    if ( value.userType() >= QMetaType::User )
+    {
+      mPacked = false;
+      break;
+    }
+  }
+
+  if ( mPacked )
+  {
+    mAttributes.clear();
+    mPackedAttributes.clear();
+    QDataStream stream( &mPackedAttributes, QIODevice::WriteOnly );
+    stream << attributes;
+    mPackedAttributes.squeeze();
+  }
+  else
+  {
+    mPackedAttributes.clear();
+    mAttributes = attributes;
+  }
+}
+
+QgsAttributes QgsVectorLayerCache::QgsCachedFeature::attributes() const
+{
+  if ( !mPacked )
+    return mAttributes;
+
+  QgsAttributes attributes;
+  QDataStream stream( mPackedAttributes );
+  stream >> attributes;
+  return attributes;
+}
+
+qint64 QgsVectorLayerCache::QgsCachedFeature::size() const
+{
+  // entry, plus its node in the cache hash
+  qint64 size = sizeof( QgsCachedFeature ) + sizeof( QgsFeatureId ) + 3 * sizeof( void * );
+  size += mWkb.capacity() + mPackedAttributes.capacity();
+  for ( const QVariant &value : mAttributes )
+  {
+    size += sizeof( QVariant );
+    if ( value.type() == QVariant::String )
+      size += value.toString().size() * sizeof( QChar );
+  }
+  return size;
+}
+
 QgsVectorLayerCache::QgsVectorLayerCache( QgsVectorLayer *layer, int cacheSize, QObject *parent )
   : QObject( parent )
   , mLayer( layer )
 {
-  mCache.setMaxCost( cacheSize );
+  mCacheSize = cacheSize;
 
   connect( mLayer, &QgsVectorLayer::featureDeleted, this, &QgsVectorLayerCache::featureDeleted );
   connect( mLayer, &QgsVectorLayer::featureAdded, this, &QgsVectorLayerCache::onFeatureAdded );
@@ -47,16 +149,24 @@ QgsVectorLayerCache::~QgsVectorLayerCache()
 {
   qDeleteAll( mCacheIndices );
   mCacheIndices.clear();
+  clearCache();
 }
 
 void QgsVectorLayerCache::setCacheSize( int cacheSize )
 {
-  mCache.setMaxCost( cacheSize );
+  mCacheSize = cacheSize;
+  trimCache();
 }
 
 int QgsVectorLayerCache::cacheSize()
 {
-  return mCache.maxCost();
+  return mCacheSize;
+}
+
+void QgsVectorLayerCache::setCacheMemoryLimit( qint64 bytes )
+{
+  mCacheMemoryLimit = bytes;
+  trimCache();
 }
 
 void QgsVectorLayerCache::setCacheGeometry( bool cacheGeometry )
@@ -145,16 +255,16 @@ bool QgsVectorLayerCache::featureAtId( QgsFeatureId featureId, QgsFeature &featu
 {
   bool featureFound = false;
 
-  QgsCachedFeature *cachedFeature = nullptr;
+  QgsCachedFeature *cached = nullptr;
 
   if ( !skipCache )
   {
-    cachedFeature = mCache[ featureId ];
+    cached = cachedFeature( featureId );
   }
 
-  if ( cachedFeature )
+  if ( cached )
   {
-    feature = QgsFeature( *cachedFeature->feature() );
+    feature = cached->feature();
     featureFound = true;
   }
   else if ( mLayer->getFeatures( QgsFeatureRequest()
@@ -172,7 +282,102 @@ bool QgsVectorLayerCache::featureAtId( QgsFeatureId featureId, QgsFeature &featu
 
 bool QgsVectorLayerCache::removeCachedFeature( QgsFeatureId fid )
 {
-  return mCache.remove( fid );
+  return removeFromCache( fid );
+}
+
+bool QgsVectorLayerCache::cachedBoundingBox( QgsFeatureId fid, QgsRectangle &boundingBox ) const
+{
+  QgsCachedFeature *cached = mCache.value( fid );
+  if ( !cached || !cached->hasGeometry() )
+    return false;
+
+  boundingBox = cached->boundingBox();
+  return true;
+}
+
+void QgsVectorLayerCache::cacheFeature( QgsFeature &feat )
+{
+  removeFromCache( feat.id() );
+
+  QgsCachedFeature *cached = new QgsCachedFeature( feat, this );
+  mCache.insert( feat.id(), cached );
+  mCacheMemoryUsage += cached->size();
+
+  // new features are the most recently used ones
+  cached->mNext = mFirstCachedFeature;
+  if ( mFirstCachedFeature )
+    mFirstCachedFeature->mPrevious = cached;
+  mFirstCachedFeature = cached;
+  if ( !mLastCachedFeature )
+    mLastCachedFeature = cached;
+
+  trimCache();
+}
+
+QgsVectorLayerCache::QgsCachedFeature *QgsVectorLayerCache::cachedFeature( QgsFeatureId fid )
+{
+  QgsCachedFeature *cached = mCache.value( fid );
+  if ( !cached || cached == mFirstCachedFeature )
+    return cached;
+
+  // move to the front of the least recently used chain
+  cached->mPrevious->mNext = cached->mNext;
+  if ( cached->mNext )
+    cached->mNext->mPrevious = cached->mPrevious;
+  else
+    mLastCachedFeature = cached->mPrevious;
+
+  cached->mPrevious = nullptr;
+  cached->mNext = mFirstCachedFeature;
+  mFirstCachedFeature->mPrevious = cached;
+  mFirstCachedFeature = cached;
+  return cached;
+}
+
+bool QgsVectorLayerCache::removeFromCache( QgsFeatureId fid )
+{
+  QgsCachedFeature *cached = mCache.take( fid );
+  if ( !cached )
+    return false;
+
+  if ( cached->mPrevious )
+    cached->mPrevious->mNext = cached->mNext;
+  else
+    mFirstCachedFeature = cached->mNext;
+  if ( cached->mNext )
+    cached->mNext->mPrevious = cached->mPrevious;
+  else
+    mLastCachedFeature = cached->mPrevious;
+
+  mCacheMemoryUsage -= cached->size();
+  delete cached;
+  return true;
+}
+
+void QgsVectorLayerCache::clearCache()
+{
+  QHash< QgsFeatureId, QgsCachedFeature * > cache;
+  cache.swap( mCache );
+  mFirstCachedFeature = nullptr;
+  mLastCachedFeature = nullptr;
+  mCacheMemoryUsage = 0;
+  qDeleteAll( cache );
+}
+
+void QgsVectorLayerCache::trimCache()
+{
+  while ( mLastCachedFeature && ( mCache.count() > mCacheSize || ( mCacheMemoryLimit > 0 && mCacheMemoryUsage > mCacheMemoryLimit ) ) )
+  {
+    // the cache does not hold all features anymore
+    mFullCache = false;
+    removeFromCache( mLastCachedFeature->mFeatureId );
+  }
+}
+
+void QgsVectorLayerCache::updateCachedFeatureSize( QgsCachedFeature *cachedFeature, qint64 previousSize )
+{
+  mCacheMemoryUsage += cachedFeature->size() - previousSize;
+  trimCache();
 }
 
 QgsVectorLayer *QgsVectorLayerCache::layer()
@@ -203,17 +408,27 @@ long QgsVectorLayerCache::featureCount() const
 void QgsVectorLayerCache::requestCompleted( const QgsFeatureRequest &featureRequest, const QgsFeatureIds &fids )
 {
   // If a request is too large for the cache don't notify to prevent from indexing incomplete requests
-  if ( fids.count() <= mCache.size() )
+  if ( fids.count() > mCache.size() )
+    return;
+
+  // with a memory limit, some of the features may have been removed again
+  if ( mCacheMemoryLimit > 0 )
   {
-    Q_FOREACH ( QgsAbstractCacheIndex *idx, mCacheIndices )
-    {
-      idx->requestCompleted( featureRequest, fids );
-    }
-    if ( featureRequest.filterType() == QgsFeatureRequest::FilterNone )
+    for ( QgsFeatureId fid : fids )
     {
-      mFullCache = true;
+      if ( !mCache.contains( fid ) )
+        return;
     }
   }
+
+  Q_FOREACH ( QgsAbstractCacheIndex *idx, mCacheIndices )
+  {
+    idx->requestCompleted( featureRequest, fids );
+  }
+  if ( featureRequest.filterType() == QgsFeatureRequest::FilterNone && featureRequest.filterRect().isNull() )
+  {
+    mFullCache = true;
+  }
 }
 
 void QgsVectorLayerCache::featureRemoved( QgsFeatureId fid )
@@ -226,11 +441,13 @@ void QgsVectorLayerCache::featureRemoved( QgsFeatureId fid )
 
 void QgsVectorLayerCache::onAttributeValueChanged( QgsFeatureId fid, int field, const QVariant &value )
 {
-  QgsCachedFeature *cachedFeat = mCache[ fid ];
+  QgsCachedFeature *cachedFeat = mCache.value( fid );
 
   if ( cachedFeat )
   {
-    cachedFeat->mFeature->setAttribute( field, value );
+    qint64 previousSize = cachedFeat->size();
+    cachedFeat->setAttribute( field, value );
+    updateCachedFeatureSize( cachedFeat, previousSize );
   }
 
   emit attributeValueChanged( fid, field, value );
@@ -260,11 +477,17 @@ void QgsVectorLayerCache::onJoinAttributeValueChanged( QgsFeatureId fid, int fie
 
 void QgsVectorLayerCache::featureDeleted( QgsFeatureId fid )
 {
-  mCache.remove( fid );
+  removeFromCache( fid );
 }
 
 void QgsVectorLayerCache::onFeatureAdded( QgsFeatureId fid )
 {
+  // indices do not know about the new feature yet
+  Q_FOREACH ( QgsAbstractCacheIndex *idx, mCacheIndices )
+  {
+    idx->flush();
+  }
+
   if ( mFullCache )
   {
     if ( cacheSize() <= mLayer->featureCount() )
@@ -301,11 +524,19 @@ void QgsVectorLayerCache::attributeDeleted( int field )
 
 void QgsVectorLayerCache::geometryChanged( QgsFeatureId fid, const QgsGeometry &geom )
 {
-  QgsCachedFeature *cachedFeat = mCache[ fid ];
+  QgsCachedFeature *cachedFeat = mCache.value( fid );
 
   if ( cachedFeat )
   {
-    cachedFeat->mFeature->setGeometry( geom );
+    qint64 previousSize = cachedFeat->size();
+    cachedFeat->setGeometry( geom );
+    updateCachedFeatureSize( cachedFeat, previousSize );
+  }
+
+  // the feature may have moved into areas covered by spatial indices
+  Q_FOREACH ( QgsAbstractCacheIndex *idx, mCacheIndices )
+  {
+    idx->flush();
   }
 }
 
@@ -317,7 +548,7 @@ void QgsVectorLayerCache::layerDeleted()
 
 void QgsVectorLayerCache::invalidate()
 {
-  mCache.clear();
+  clearCache();
   mFullCache = false;
   emit invalidated();
 }
@@ -379,8 +610,20 @@ QgsFeatureIterator QgsVectorLayerCache::getFeatures( const QgsFeatureRequest &fe
     // If we have a full cache available, run on this
     if ( mFullCache )
     {
-      it = QgsFeatureIterator( new QgsCachedFeatureIterator( this, featureRequest ) );
       requiresWriterIt = false;
+
+      // indices may still narrow down the cached features to iterate over
+      bool indexed = false;
+      Q_FOREACH ( QgsAbstractCacheIndex *idx, mCacheIndices )
+      {
+        if ( idx->getCacheIterator( it, featureRequest ) )
+        {
+          indexed = true;
+          break;
+        }
+      }
+      if ( !indexed )
+        it = QgsFeatureIterator( new QgsCachedFeatureIterator( this, featureRequest ) );
     }
     else
     {
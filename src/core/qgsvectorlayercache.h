@@ -22,7 +22,7 @@
 #include "qgis_core.h"
 #include "qgis_sip.h"
 #include "qgis.h"
-#include <QCache>
+#include <QHash>
 
 #include "qgsvectorlayer.h"
 
@@ -48,6 +48,10 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
      * This is a wrapper class around a cached QgsFeature, which
      * will inform the cache, when it has been deleted, so indexes can be
      * updated that the wrapped feature needs to be fetched again if needed.
+     *
+     * The feature is stored in a compact form: the geometry as WKB and the
+     * attributes serialized in a single byte array. Cached features are
+     * chained in least recently used order.
      */
     class QgsCachedFeature
     {
@@ -59,25 +63,52 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
          * \param feat     The feature to cache. A copy will be made.
          * \param vlCache  The cache to inform when the feature has been removed from the cache.
          */
-        QgsCachedFeature( const QgsFeature &feat, QgsVectorLayerCache *vlCache )
-          : mCache( vlCache )
-        {
-          mFeature = new QgsFeature( feat );
-        }
+        QgsCachedFeature( const QgsFeature &feat, QgsVectorLayerCache *vlCache );
 
         ~QgsCachedFeature()
         {
           // That's the reason we need this wrapper:
           // Inform the cache that this feature has been removed
-          mCache->featureRemoved( mFeature->id() );
-          delete mFeature;
+          mCache->featureRemoved( mFeatureId );
         }
 
-        inline const QgsFeature *feature() { return mFeature; }
+        //! Returns a copy of the cached feature
+        QgsFeature feature() const;
+
+        //! Returns true if the cached feature has a geometry
+        bool hasGeometry() const { return !mWkb.isEmpty(); }
+
+        //! Returns the bounding box of the cached geometry
+        QgsRectangle boundingBox() const { return mBoundingBox; }
+
+        //! Updates the value of an attribute
+        void setAttribute( int field, const QVariant &value );
+
+        //! Updates the geometry
+        void setGeometry( const QgsGeometry &geometry );
+
+        //! Returns the approximate memory used by the cached feature, in bytes
+        qint64 size() const;
 
       private:
-        QgsFeature *mFeature = nullptr;
+        void setAttributes( const QgsAttributes &attributes );
+        QgsAttributes attributes() const;
+
+        QgsFeatureId mFeatureId;
+        QgsFields mFields;
+        QByteArray mWkb;
+        QgsRectangle mBoundingBox;
+        //! Serialized attributes
+        QByteArray mPackedAttributes;
+        //! Attributes which cannot be serialized are stored as they are
+        QgsAttributes mAttributes;
+        bool mPacked = false;
+
         QgsVectorLayerCache *mCache = nullptr;
+        //! More recently used cached feature
+        QgsCachedFeature *mPrevious = nullptr;
+        //! Less recently used cached feature
+        QgsCachedFeature *mNext = nullptr;
 
         friend class QgsVectorLayerCache;
         Q_DISABLE_COPY( QgsCachedFeature )
@@ -104,6 +135,33 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
      */
     int cacheSize();
 
+    /**
+     * Sets the maximum amount of memory used by the cached features, in bytes. The least
+     * recently used features are removed from the cache if the limit is exceeded.
+     * A limit of 0 means that the memory used by the cache is not limited, apart
+     * from the maximum number of features set by setCacheSize().
+     *
+     * \note a full cache is no longer complete if features have to be removed to fit the limit
+     * \see cacheMemoryLimit()
+     * \since QGIS 3.0
+     */
+    void setCacheMemoryLimit( qint64 bytes );
+
+    /**
+     * Returns the maximum amount of memory used by the cached features, in bytes, or 0 if the
+     * memory used is not limited.
+     * \see setCacheMemoryLimit()
+     * \since QGIS 3.0
+     */
+    qint64 cacheMemoryLimit() const { return mCacheMemoryLimit; }
+
+    /**
+     * Returns the approximate amount of memory currently used by the cached features, in bytes.
+     * \see setCacheMemoryLimit()
+     * \since QGIS 3.0
+     */
+    qint64 cacheMemoryUsage() const { return mCacheMemoryUsage; }
+
     /**
      * Enable or disable the caching of geometries
      *
@@ -227,6 +285,15 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
      */
     QgsFeatureIds cachedFeatureIds() const { return mCache.keys().toSet(); }
 
+    /**
+     * Retrieves the bounding box of a cached feature's geometry. Returns false if the
+     * feature is not cached or has no geometry. The feature is not fetched from the layer
+     * and its position in the cache is not affected.
+     * \see isFidCached()
+     * \since QGIS 3.0
+     */
+    bool cachedBoundingBox( QgsFeatureId fid, QgsRectangle &boundingBox SIP_OUT ) const;
+
     /**
      * Gets the feature at the given feature id. Considers the changed, added, deleted and permanent features
      * \param featureId The id of the feature to query
@@ -377,14 +444,33 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
 
     void connectJoinedLayers() const;
 
-    inline void cacheFeature( QgsFeature &feat )
-    {
-      QgsCachedFeature *cachedFeature = new QgsCachedFeature( feat, this );
-      mCache.insert( feat.id(), cachedFeature );
-    }
+    void cacheFeature( QgsFeature &feat );
+
+    //! Returns a cached feature and marks it as the most recently used one, or nullptr if the feature is not cached
+    QgsCachedFeature *cachedFeature( QgsFeatureId fid );
+
+    //! Removes a feature from the cache, returns false if the feature was not cached
+    bool removeFromCache( QgsFeatureId fid );
+
+    //! Removes all features from the cache
+    void clearCache();
+
+    //! Removes the least recently used features until the cache fits in its size and memory limits
+    void trimCache();
+
+    //! Updates the memory used by a cached feature after it was modified
+    void updateCachedFeatureSize( QgsCachedFeature *cachedFeature, qint64 previousSize );
 
     QgsVectorLayer *mLayer = nullptr;
-    QCache< QgsFeatureId, QgsCachedFeature > mCache;
+    QHash< QgsFeatureId, QgsCachedFeature * > mCache;
+    //! Most recently used cached feature
+    QgsCachedFeature *mFirstCachedFeature = nullptr;
+    //! Least recently used cached feature
+    QgsCachedFeature *mLastCachedFeature = nullptr;
+
+    int mCacheSize = 0;
+    qint64 mCacheMemoryLimit = 0;
+    qint64 mCacheMemoryUsage = 0;
 
     bool mCacheGeometry = true;
     bool mFullCache = false;
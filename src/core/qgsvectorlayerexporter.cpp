@@ -31,7 +31,7 @@
 
 #include <QProgressDialog>
 
-#define FEATURE_BUFFER_SIZE 200
+#define FEATURE_BUFFER_SIZE 1000
 
 typedef QgsVectorLayerExporter::ExportError createEmptyLayer_t(
   const QString &uri,
@@ -1,4 +1,8 @@
 #include "qgsvectorlayerfeaturecounter.h"
+#include "qgsvectordataprovider.h"
+
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
 QgsVectorLayerFeatureCounter::QgsVectorLayerFeatureCounter( QgsVectorLayer *layer, const QgsExpressionContext &context )
   : QgsTask( tr( "Counting features in %1" ).arg( layer->name() ), QgsTask::CanCancel )
@@ -11,6 +15,31 @@ QgsVectorLayerFeatureCounter::QgsVectorLayerFeatureCounter( QgsVectorLayer *laye
   {
     mExpressionContext = layer->createExpressionContext();
   }
+
+  setDependentLayers( QList< QgsMapLayer * >() << layer );
+
+  // simple classifications by a provider attribute can be counted by the provider,
+  // as long as there are no pending edits which the provider does not know about.
+  // The provider belongs to the layer and must not be used from the task, so the
+  // counts are queried in run() through a snapshot of the provider's feature source
+  int fieldIndex = layer->fields().lookupField( mRenderer->legendClassificationAttribute() );
+  if ( mFeatureCount > 0 && mRenderer->type() == QLatin1String( "categorizedSymbol" ) && fieldIndex >= 0
+       && layer->fields().fieldOrigin( fieldIndex ) == QgsFields::OriginProvider
+       && !mRenderer->filterNeedsGeometry() && !layer->isModified() )
+  {
+    mProviderSource.reset( layer->dataProvider()->featureSource() );
+    mClassificationFieldIndex = fieldIndex;
+    mProviderFieldIndex = layer->fields().fieldOriginIndex( fieldIndex );
+  }
+
+  // renderers are not thread safe, so every worker gets its own clone
+  int workerCount = qBound( 1, QThreadPool::globalInstance()->maxThreadCount(), static_cast< int >( MAXIMUM_WORKERS ) );
+  for ( int i = 0; i < workerCount; ++i )
+  {
+    std::unique_ptr< Worker > worker( new Worker() );
+    worker->renderer.reset( layer->renderer()->clone() );
+    mWorkers.push_back( std::move( worker ) );
+  }
 }
 
 bool QgsVectorLayerFeatureCounter::run()
@@ -24,60 +53,153 @@ bool QgsVectorLayerFeatureCounter::run()
   }
 
   // If there are no features to be counted, we can spare us the trouble
-  if ( mFeatureCount > 0 )
+  if ( mFeatureCount > 0 && !countUniqueValues() )
   {
-    int featuresCounted = 0;
+    if ( !countFeatures() )
+      return false;
+  }
 
-    // Renderer (rule based) may depend on context scale, with scale is ignored if 0
-    QgsRenderContext renderContext;
-    renderContext.setRendererScale( 0 );
-    renderContext.setExpressionContext( mExpressionContext );
+  setProgress( 100 );
 
-    QgsFeatureRequest request;
-    if ( !mRenderer->filterNeedsGeometry() )
-      request.setFlags( QgsFeatureRequest::NoGeometry );
-    request.setSubsetOfAttributes( mRenderer->usedAttributes( renderContext ), mSource->fields() );
-    QgsFeatureIterator fit = mSource->getFeatures( request );
+  emit symbolsCounted();
+  return true;
+}
+
+bool QgsVectorLayerFeatureCounter::countUniqueValues()
+{
+  if ( !mProviderSource )
+    return false;
 
-    // TODO: replace QgsInterruptionChecker with QgsFeedback
-    // fit.setInterruptionChecker( mFeedback );
+  QList< QPair< QVariant, long > > counts;
+  if ( !mProviderSource->uniqueValueCounts( mProviderFieldIndex, counts ) )
+    return false;
 
-    mRenderer->startRender( renderContext, mSource->fields() );
+  QgsRenderContext renderContext;
+  renderContext.setRendererScale( 0 );
+  renderContext.setExpressionContext( mExpressionContext );
+  mRenderer->startRender( renderContext, mSource->fields() );
 
-    double progress = 0;
-    QgsFeature f;
-    while ( fit.nextFeature( f ) )
+  // every feature with the same value has the same legend keys
+  QgsFeature f( mSource->fields() );
+  QList< QPair< QVariant, long > >::const_iterator countIt = counts.constBegin();
+  for ( ; countIt != counts.constEnd(); ++countIt )
+  {
+    f.setAttribute( mClassificationFieldIndex, countIt->first );
+    renderContext.expressionContext().setFeature( f );
+    QSet<QString> featureKeyList = mRenderer->legendKeysForFeature( f, renderContext );
+    Q_FOREACH ( const QString &key, featureKeyList )
     {
-      renderContext.expressionContext().setFeature( f );
-      QSet<QString> featureKeyList = mRenderer->legendKeysForFeature( f, renderContext );
-      Q_FOREACH ( const QString &key, featureKeyList )
-      {
-        mSymbolFeatureCountMap[key] += 1;
-      }
-      ++featuresCounted;
-
-      double p = ( static_cast< double >( featuresCounted ) / mFeatureCount ) * 100;
-      if ( p - progress > 1 )
-      {
-        progress = p;
-        setProgress( progress );
-      }
-
-      if ( isCanceled() )
-      {
-        mRenderer->stopRender( renderContext );
-        return false;
-      }
+      mSymbolFeatureCountMap[key] += countIt->second;
     }
-    mRenderer->stopRender( renderContext );
   }
 
-  setProgress( 100 );
-
-  emit symbolsCounted();
+  mRenderer->stopRender( renderContext );
   return true;
 }
 
+bool QgsVectorLayerFeatureCounter::countFeatures()
+{
+  // Renderer (rule based) may depend on context scale, with scale is ignored if 0
+  QgsRenderContext renderContext;
+  renderContext.setRendererScale( 0 );
+  renderContext.setExpressionContext( mExpressionContext );
+
+  QgsFeatureRequest request;
+  if ( !mRenderer->filterNeedsGeometry() )
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+  request.setSubsetOfAttributes( mRenderer->usedAttributes( renderContext ), mSource->fields() );
+  QgsFeatureIterator fit = mSource->getFeatures( request );
+
+  // TODO: replace QgsInterruptionChecker with QgsFeedback
+  // fit.setInterruptionChecker( mFeedback );
+
+  for ( const std::unique_ptr< Worker > &worker : mWorkers )
+  {
+    worker->context.setRendererScale( 0 );
+    worker->context.setExpressionContext( mExpressionContext );
+    worker->renderer->startRender( worker->context, mSource->fields() );
+  }
+
+  // the workers evaluate one batch while the next one is read
+  QVector< QgsFeature > batches[2];
+  int current = 0;
+  readBatch( fit, batches[current] );
+
+  bool canceled = false;
+  int featuresCounted = 0;
+  double progress = 0;
+  while ( !batches[current].isEmpty() )
+  {
+    const QVector< QgsFeature > &batch = batches[current];
+    int workerCount = static_cast< int >( mWorkers.size() );
+    int sliceSize = ( batch.size() + workerCount - 1 ) / workerCount;
+
+    QList< QFuture< void > > futures;
+    for ( int i = 0; i < workerCount && i * sliceSize < batch.size(); ++i )
+    {
+      futures << QtConcurrent::run( &QgsVectorLayerFeatureCounter::countBatch, mWorkers.at( i ).get(), &batch,
+                                    i * sliceSize, std::min( batch.size(), ( i + 1 ) * sliceSize ) );
+    }
+
+    readBatch( fit, batches[1 - current] );
+
+    Q_FOREACH ( QFuture< void > future, futures )
+      future.waitForFinished();
+
+    featuresCounted += batch.size();
+    current = 1 - current;
+
+    double p = ( static_cast< double >( featuresCounted ) / mFeatureCount ) * 100;
+    if ( p - progress > 1 )
+    {
+      progress = p;
+      setProgress( progress );
+    }
+
+    if ( isCanceled() )
+    {
+      canceled = true;
+      break;
+    }
+  }
+
+  for ( const std::unique_ptr< Worker > &worker : mWorkers )
+  {
+    worker->renderer->stopRender( worker->context );
+
+    QHash<QString, long>::const_iterator countIt = worker->counts.constBegin();
+    for ( ; countIt != worker->counts.constEnd(); ++countIt )
+    {
+      mSymbolFeatureCountMap[countIt.key()] += countIt.value();
+    }
+  }
+
+  return !canceled;
+}
+
+void QgsVectorLayerFeatureCounter::readBatch( QgsFeatureIterator &it, QVector<QgsFeature> &batch )
+{
+  batch.clear();
+  batch.reserve( BATCH_SIZE );
+  QgsFeature f;
+  while ( batch.size() < BATCH_SIZE && it.nextFeature( f ) )
+    batch << f;
+}
+
+void QgsVectorLayerFeatureCounter::countBatch( Worker *worker, const QVector<QgsFeature> *batch, int begin, int end )
+{
+  for ( int i = begin; i < end; ++i )
+  {
+    QgsFeature f = batch->at( i );
+    worker->context.expressionContext().setFeature( f );
+    QSet<QString> featureKeyList = worker->renderer->legendKeysForFeature( f, worker->context );
+    Q_FOREACH ( const QString &key, featureKeyList )
+    {
+      worker->counts[key] += 1;
+    }
+  }
+}
+
 QHash<QString, long> QgsVectorLayerFeatureCounter::symbolFeatureCountMap() const
 {
   return mSymbolFeatureCountMap;
@@ -6,9 +6,16 @@
 #include "qgsrenderer.h"
 #include "qgstaskmanager.h"
 
+#include <memory>
+#include <vector>
+
 /** \ingroup core
  *
  * Counts the features in a QgsVectorLayer in task.
+ * When the renderer classifies features by a provider attribute, the counts are
+ * calculated by the data provider if it supports it (see
+ * QgsVectorDataProvider::uniqueValueCounts()). Otherwise the features are read in
+ * batches, and the legend keys of each batch are evaluated on several threads.
  * You should most likely not use this directly and instead call
  * QgsVectorLayer::countSymbolFeatures() and connect to the signal
  * QgsVectorLayer::symbolFeatureCountMapChanged().
@@ -50,12 +57,54 @@ class CORE_EXPORT QgsVectorLayerFeatureCounter : public QgsTask
     void symbolsCounted();
 
   private:
+
+    //! State of a worker evaluating legend keys for a part of each batch of features
+    struct Worker
+    {
+      std::unique_ptr<QgsFeatureRenderer> renderer;
+      QgsRenderContext context;
+      QHash<QString, long> counts;
+    };
+
+    /**
+     * Counts the features from the unique value counts of the classification attribute,
+     * as calculated by the data provider's feature source. Returns false if the source
+     * cannot calculate them.
+     */
+    bool countUniqueValues();
+
+    /**
+     * Counts the features by iterating over them, evaluating the legend keys of each batch
+     * of features in parallel. Returns false if the task was canceled.
+     */
+    bool countFeatures();
+
+    //! Reads up to BATCH_SIZE features from an iterator into \a batch
+    static void readBatch( QgsFeatureIterator &it, QVector< QgsFeature > &batch );
+
+    //! Evaluates the legend keys for features \a begin to \a end of a \a batch
+    static void countBatch( Worker *worker, const QVector< QgsFeature > *batch, int begin, int end );
+
     std::unique_ptr<QgsVectorLayerFeatureSource> mSource;
     std::unique_ptr<QgsFeatureRenderer> mRenderer;
     QgsExpressionContext mExpressionContext;
     QHash<QString, long> mSymbolFeatureCountMap;
     int mFeatureCount;
 
+    //! Workers with their own renderer clones, created in the main thread
+    std::vector< std::unique_ptr<Worker> > mWorkers;
+
+    //! Provider feature source used to count unique values, or nullptr if features must be iterated
+    std::unique_ptr<QgsAbstractFeatureSource> mProviderSource;
+    int mClassificationFieldIndex = -1;
+    int mProviderFieldIndex = -1;
+
+    //! Number of features read and evaluated at once
+    static const int BATCH_SIZE = 2000;
+
+    //! Maximum number of workers evaluating features in parallel
+    static const int MAXIMUM_WORKERS = 8;
+
 };
 
 #endif // QGSVECTORLAYERFEATURECOUNTER_H
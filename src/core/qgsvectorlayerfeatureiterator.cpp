@@ -327,18 +327,8 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
     mProviderIterator.setInterruptionChecker( mInterruptionChecker );
   }
 
-  while ( mProviderIterator.nextFeature( f ) )
+  while ( nextQueuedProviderFeature( f ) )
   {
-    if ( mFetchConsidered.contains( f.id() ) )
-      continue;
-
-    // TODO[MD]: just one resize of attributes
-    f.setFields( mSource->mFields );
-
-    // update attributes
-    if ( mSource->mHasEditBuffer )
-      updateChangedAttributes( f );
-
     if ( mHasVirtualAttributes )
       addVirtualAttributes( f );
 
@@ -369,6 +359,46 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
   return false;
 }
 
+bool QgsVectorLayerFeatureIterator::nextProviderFeature( QgsFeature &f )
+{
+  while ( mProviderIterator.nextFeature( f ) )
+  {
+    if ( mFetchConsidered.contains( f.id() ) )
+      continue;
+
+    // TODO[MD]: just one resize of attributes
+    f.setFields( mSource->mFields );
+
+    // update attributes
+    if ( mSource->mHasEditBuffer )
+      updateChangedAttributes( f );
+
+    return true;
+  }
+  return false;
+}
+
+bool QgsVectorLayerFeatureIterator::nextQueuedProviderFeature( QgsFeature &f )
+{
+  if ( !mBatchJoins )
+    return nextProviderFeature( f );
+
+  if ( mProviderFeatureQueue.isEmpty() )
+  {
+    QgsFeature providerFeature;
+    while ( mProviderFeatureQueue.size() < JOIN_BATCH_SIZE && nextProviderFeature( providerFeature ) )
+      mProviderFeatureQueue.enqueue( providerFeature );
+
+    if ( mProviderFeatureQueue.isEmpty() )
+      return false;
+
+    fetchJoinBatches();
+  }
+
+  f = mProviderFeatureQueue.dequeue();
+  return true;
+}
+
 
 
 bool QgsVectorLayerFeatureIterator::rewind()
@@ -383,6 +413,7 @@ bool QgsVectorLayerFeatureIterator::rewind()
   else
   {
     mProviderIterator.rewind();
+    mProviderFeatureQueue.clear();
     rewindEditBuffer();
   }
 
@@ -395,6 +426,7 @@ bool QgsVectorLayerFeatureIterator::close()
     return false;
 
   mProviderIterator.close();
+  mProviderFeatureQueue.clear();
 
   iteratorClosed();
 
@@ -674,6 +706,7 @@ void QgsVectorLayerFeatureIterator::prepareFields()
   if ( mFetchJoinInfo.size() > 0 )
   {
     createOrderedJoinList();
+    prepareJoinBatches();
   }
 }
 
@@ -808,19 +841,202 @@ void QgsVectorLayerFeatureIterator::prepareField( int fieldIdx )
 
 void QgsVectorLayerFeatureIterator::addJoinedAttributes( QgsFeature &f )
 {
-  QList< FetchJoinInfo >::const_iterator joinIt = mOrderedJoinInfoList.constBegin();
-  for ( ; joinIt != mOrderedJoinInfoList.constEnd(); ++joinIt )
+  for ( int i = 0; i < mOrderedJoinInfoList.size(); ++i )
   {
-    QVariant targetFieldValue = f.attribute( joinIt->targetField );
+    const FetchJoinInfo &info = mOrderedJoinInfoList.at( i );
+    QVariant targetFieldValue = f.attribute( info.targetField );
     if ( !targetFieldValue.isValid() )
       continue;
 
-    const QHash< QString, QgsAttributes> &memoryCache = joinIt->joinInfo->cachedAttributes;
-    if ( memoryCache.isEmpty() )
-      joinIt->addJoinedAttributesDirect( f, targetFieldValue );
-    else
-      joinIt->addJoinedAttributesCached( f, targetFieldValue );
+    const QHash< QString, QgsAttributes> &memoryCache = info.joinInfo->cachedAttributes;
+    if ( !memoryCache.isEmpty() )
+      info.addJoinedAttributesCached( f, targetFieldValue );
+    else if ( !addJoinedAttributesBatched( f, i, targetFieldValue ) )
+      info.addJoinedAttributesDirect( f, targetFieldValue );
+  }
+}
+
+static bool isIntegerJoinType( QVariant::Type type )
+{
+  return type == QVariant::Int || type == QVariant::UInt || type == QVariant::LongLong || type == QVariant::ULongLong;
+}
+
+void QgsVectorLayerFeatureIterator::prepareJoinBatches()
+{
+  mJoinBatches.clear();
+  mJoinBatches.resize( mOrderedJoinInfoList.size() );
+  mBatchJoins = false;
+
+  for ( int i = 0; i < mOrderedJoinInfoList.size(); ++i )
+  {
+    const FetchJoinInfo &info = mOrderedJoinInfoList.at( i );
+    if ( info.joinInfo->isUsingMemoryCache() )
+      continue;
+
+    // the join value must be known when the provider feature is read, so joins
+    // depending on expression fields or on other joins are fetched directly
+    if ( !mSource->mFields.exists( info.targetField ) || mExpressionFieldInfo.contains( info.targetField ) )
+      continue;
+    QgsFields::FieldOrigin origin = mSource->mFields.fieldOrigin( info.targetField );
+    if ( origin != QgsFields::OriginProvider && origin != QgsFields::OriginEdit )
+      continue;
+
+    const QgsFields joinFields = info.joinLayer->fields();
+    if ( !joinFields.exists( info.joinField ) )
+      continue;
+
+    // join values are matched exactly by a typed key, which only gives the same result
+    // as the expression comparison for integers and strings
+    QVariant::Type targetType = mSource->mFields.at( info.targetField ).type();
+    QVariant::Type joinType = joinFields.at( info.joinField ).type();
+    JoinBatch &batch = mJoinBatches[i];
+    if ( isIntegerJoinType( targetType ) && isIntegerJoinType( joinType ) )
+      batch.intKeys = true;
+    else if ( targetType != QVariant::String || joinType != QVariant::String )
+      continue;
+
+    batch.enabled = true;
+    mBatchJoins = true;
+  }
+}
+
+void QgsVectorLayerFeatureIterator::fetchJoinBatches()
+{
+  for ( int i = 0; i < mJoinBatches.size(); ++i )
+  {
+    JoinBatch &batch = mJoinBatches[i];
+    if ( !batch.enabled )
+      continue;
+
+    batch.intValues.clear();
+    batch.stringValues.clear();
+
+    const FetchJoinInfo &info = mOrderedJoinInfoList.at( i );
+
+    // collect the distinct join values of the batch
+    QStringList values;
+    for ( const QgsFeature &f : qgsAsConst( mProviderFeatureQueue ) )
+    {
+      QVariant value = f.attribute( info.targetField );
+      if ( value.isNull() )
+        continue;
+
+      if ( batch.intKeys )
+      {
+        bool ok = false;
+        qint64 key = value.toLongLong( &ok );
+        if ( ok && !batch.intValues.contains( key ) )
+        {
+          batch.intValues.insert( key, QgsAttributes() );
+          values << QString::number( key );
+        }
+      }
+      else
+      {
+        QString key = value.toString();
+        if ( !batch.stringValues.contains( key ) )
+        {
+          batch.stringValues.insert( key, QgsAttributes() );
+          values << QgsExpression::quotedString( key );
+        }
+      }
+    }
+
+    if ( values.isEmpty() )
+      continue;
+
+    bool hasSubset = info.joinInfo->joinFieldNamesSubset();
+    QVector<int> subsetIndices;
+    if ( hasSubset )
+      subsetIndices = QgsVectorLayerJoinBuffer::joinSubsetIndices( info.joinLayer, *info.joinInfo->joinFieldNamesSubset() );
+
+    QgsAttributeList attributes = info.attributes;
+    if ( !attributes.contains( info.joinField ) )
+      attributes << info.joinField;
+
+    // fetch all the joined features of the batch with a single request (no geometry)
+    QgsFeatureRequest request;
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+    request.setSubsetOfAttributes( attributes );
+    request.setFilterExpression( QStringLiteral( "%1 IN (%2)" ).arg( QgsExpression::quotedColumnRef( info.joinInfo->joinFieldName() ), values.join( ',' ) ) );
+    QgsFeatureIterator fi = info.joinLayer->getFeatures( request );
+
+    QgsFeature joinedFeature;
+    while ( fi.nextFeature( joinedFeature ) )
+    {
+      const QgsAttributes attr = joinedFeature.attributes();
+      QVariant value = attr.at( info.joinField );
+
+      QgsAttributes *joinedAttributes = nullptr;
+      if ( batch.intKeys )
+      {
+        bool ok = false;
+        qint64 key = value.toLongLong( &ok );
+        QHash< qint64, QgsAttributes >::iterator it = ok ? batch.intValues.find( key ) : batch.intValues.end();
+        if ( it != batch.intValues.end() )
+          joinedAttributes = &it.value();
+      }
+      else
+      {
+        QHash< QString, QgsAttributes >::iterator it = value.isNull() ? batch.stringValues.end() : batch.stringValues.find( value.toString() );
+        if ( it != batch.stringValues.end() )
+          joinedAttributes = &it.value();
+      }
+
+      // keep the first joined feature found for a value, like the direct lookup does
+      if ( !joinedAttributes || !joinedAttributes->isEmpty() )
+        continue;
+
+      if ( hasSubset )
+      {
+        joinedAttributes->reserve( subsetIndices.count() );
+        for ( int j = 0; j < subsetIndices.count(); ++j )
+          joinedAttributes->append( attr.at( subsetIndices.at( j ) ) );
+      }
+      else
+      {
+        // use all fields except for the one used for join (has same value as exiting field in target layer)
+        *joinedAttributes = attr;
+        joinedAttributes->remove( info.joinField );
+      }
+    }
+  }
+}
+
+bool QgsVectorLayerFeatureIterator::addJoinedAttributesBatched( QgsFeature &f, int joinIndex, const QVariant &joinValue ) const
+{
+  if ( joinIndex >= mJoinBatches.size() || joinValue.isNull() )
+    return false;
+
+  const JoinBatch &batch = mJoinBatches.at( joinIndex );
+  if ( !batch.enabled )
+    return false;
+
+  const QgsAttributes *joinedAttributes = nullptr;
+  if ( batch.intKeys )
+  {
+    bool ok = false;
+    qint64 key = joinValue.toLongLong( &ok );
+    QHash< qint64, QgsAttributes >::const_iterator it = ok ? batch.intValues.constFind( key ) : batch.intValues.constEnd();
+    if ( it == batch.intValues.constEnd() )
+      return false;
+    joinedAttributes = &it.value();
   }
+  else
+  {
+    QHash< QString, QgsAttributes >::const_iterator it = batch.stringValues.constFind( joinValue.toString() );
+    if ( it == batch.stringValues.constEnd() )
+      return false;
+    joinedAttributes = &it.value();
+  }
+
+  // an empty entry means that no joined feature matches -> leaving the attributes empty (null)
+  int index = mOrderedJoinInfoList.at( joinIndex ).indexOffset;
+  for ( int i = 0; i < joinedAttributes->count(); ++i )
+  {
+    f.setAttribute( index++, joinedAttributes->at( i ) );
+  }
+  return true;
 }
 
 void QgsVectorLayerFeatureIterator::addVirtualAttributes( QgsFeature &f )
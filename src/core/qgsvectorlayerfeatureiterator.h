@@ -22,6 +22,8 @@
 #include "qgscoordinatereferencesystem.h"
 #include "qgsfeaturesource.h"
 
+#include <QHash>
+#include <QQueue>
 #include <QSet>
 #include <memory>
 
@@ -243,6 +245,31 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! Join list sorted by dependency
     QList< FetchJoinInfo > mOrderedJoinInfoList;
 
+    //! Joined attributes fetched at once for the features of a batch, for a join without memory cache
+    struct JoinBatch
+    {
+      //! True if the join can be fetched in batches
+      bool enabled = false;
+      //! True if join values are integers, false if they are strings
+      bool intKeys = false;
+      //! Joined attributes for each integer join value of the batch (empty if there is no joined feature)
+      QHash< qint64, QgsAttributes > intValues;
+      //! Joined attributes for each string join value of the batch (empty if there is no joined feature)
+      QHash< QString, QgsAttributes > stringValues;
+    };
+
+    //! Join batches, in the same order as mOrderedJoinInfoList
+    QVector< JoinBatch > mJoinBatches;
+
+    //! True if provider features are read ahead to fetch their joined attributes in batches
+    bool mBatchJoins = false;
+
+    //! Provider features read ahead, waiting to be returned
+    QQueue< QgsFeature > mProviderFeatureQueue;
+
+    //! Number of provider features whose joined attributes are fetched at once
+    static const int JOIN_BATCH_SIZE = 256;
+
     /**
      * Will always return true. We assume that ordering has been done on provider level already.
      *
@@ -254,6 +281,24 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
 
     void createOrderedJoinList();
 
+    //! Decides which of the ordered joins can be fetched in batches
+    void prepareJoinBatches();
+
+    //! Fetches the joined attributes of the queued provider features, for all batched joins
+    void fetchJoinBatches();
+
+    /**
+     * Adds joined attributes from the current batch of a join. Returns false if the
+     * join value is not part of the batch.
+     */
+    bool addJoinedAttributesBatched( QgsFeature &f, int joinIndex, const QVariant &joinValue ) const;
+
+    //! Fetches the next provider feature which has not been handled by the edit buffer
+    bool nextProviderFeature( QgsFeature &f );
+
+    //! Reads ahead a batch of provider features if needed, and returns the next one
+    bool nextQueuedProviderFeature( QgsFeature &f );
+
     /**
      * Performs any post-processing (such as transformation) and feature based validity checking, e.g. checking for geometry validity.
      */
@@ -115,6 +115,21 @@ bool QgsVectorLayerJoinBuffer::removeJoin( const QString &joinLayerId )
   return res;
 }
 
+//! Returns the approximate size in bytes of a memory cache entry
+static qint64 cachedEntrySize( const QString &key, const QgsAttributes &attributes )
+{
+  qint64 size = sizeof( QString ) + key.size() * sizeof( QChar ) + sizeof( QgsAttributes ) + attributes.size() * sizeof( QVariant );
+  for ( const QVariant &value : attributes )
+  {
+    // variants holding strings or byte arrays store their payload outside of the variant
+    if ( value.type() == QVariant::String )
+      size += value.toString().size() * sizeof( QChar );
+    else if ( value.type() == QVariant::ByteArray )
+      size += value.toByteArray().size();
+  }
+  return size;
+}
+
 void QgsVectorLayerJoinBuffer::cacheJoinLayer( QgsVectorLayerJoinInfo &joinInfo )
 {
   //memory cache not required or already done
@@ -132,6 +147,7 @@ void QgsVectorLayerJoinBuffer::cacheJoinLayer( QgsVectorLayerJoinInfo &joinInfo
       return;
 
     joinInfo.cachedAttributes.clear();
+    joinInfo.cachedAttributesSize = 0;
 
     QgsFeatureRequest request;
     request.setFlags( QgsFeatureRequest::NoGeometry );
@@ -161,12 +177,14 @@ void QgsVectorLayerJoinBuffer::cacheJoinLayer( QgsVectorLayerJoinInfo &joinInfo
         QgsAttributes subsetAttrs( subsetIndices.count() );
         for ( int i = 0; i < subsetIndices.count(); ++i )
           subsetAttrs[i] = attrs.at( subsetIndices.at( i ) );
+        joinInfo.cachedAttributesSize += cachedEntrySize( key, subsetAttrs );
         joinInfo.cachedAttributes.insert( key, subsetAttrs );
       }
       else
       {
         QgsAttributes attrs2 = attrs;
         attrs2.remove( joinFieldIndex );  // skip the join field to avoid double field names (fields often have the same name)
+        joinInfo.cachedAttributesSize += cachedEntrySize( key, attrs2 );
         joinInfo.cachedAttributes.insert( key, attrs2 );
       }
     }
@@ -258,6 +276,16 @@ void QgsVectorLayerJoinBuffer::createJoinCaches()
   }
 }
 
+qint64 QgsVectorLayerJoinBuffer::memoryCacheSize() const
+{
+  qint64 size = 0;
+  QList< QgsVectorLayerJoinInfo >::const_iterator joinIt = mVectorJoins.constBegin();
+  for ( ; joinIt != mVectorJoins.constEnd(); ++joinIt )
+  {
+    size += joinIt->cachedAttributesSize;
+  }
+  return size;
+}
 
 void QgsVectorLayerJoinBuffer::writeXml( QDomNode &layer_node, QDomDocument &document ) const
 {
@@ -480,6 +508,7 @@ void QgsVectorLayerJoinBuffer::joinedLayerUpdatedFields()
     if ( joinedLayer == it->joinLayer() )
     {
       it->cachedAttributes.clear();
+      it->cachedAttributesSize = 0;
       cacheJoinLayer( *it );
     }
   }
@@ -54,6 +54,12 @@ class CORE_EXPORT QgsVectorLayerJoinBuffer : public QObject, public QgsFeatureSi
     //! Calls cacheJoinLayer() for all vector joins
     void createJoinCaches();
 
+    /** Returns the approximate memory used by the attributes cached for the joins
+     * which use a memory cache, in bytes.
+     * \since QGIS 3.0
+     */
+    qint64 memoryCacheSize() const;
+
     //! Saves mVectorJoins to xml under the layer node
     void writeXml( QDomNode &layer_node, QDomDocument &document ) const;
 
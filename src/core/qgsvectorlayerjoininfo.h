@@ -187,6 +187,9 @@ class CORE_EXPORT QgsVectorLayerJoinInfo
     //! Cache for joined attributes to provide fast lookup (size is 0 if no memory caching)
     QHash< QString, QgsAttributes> cachedAttributes;
 
+    //! Approximate size in bytes of cachedAttributes
+    qint64 cachedAttributesSize = 0;
+
 };
 
 
@@ -25,13 +25,165 @@
 #include "qgsrasternuller.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QProgressDialog>
+#include <QQueue>
+#include <QRegExp>
 #include <QTextStream>
+#include <QThreadPool>
 #include <QMessageBox>
+#include <QtConcurrentRun>
+
+#include <functional>
+#include <memory>
 
 #include <gdal.h>
 #include <cpl_string.h>
 
+namespace
+{
+  //! A part of the output raster, read through the pipe
+  struct RasterPart
+  {
+    ~RasterPart() { qDeleteAll( blocks ); }
+
+    int left = 0;
+    int top = 0;
+    int cols = 0;
+    int rows = 0;
+    QgsRectangle extent;
+    //! Blocks read for each band, owned by the part
+    QList< QgsRasterBlock * > blocks;
+    //! Pixel data of each output band, for parts which are not written from blocks
+    QList< QByteArray > bandData;
+    //! Seconds spent reading and processing the part
+    double readTime = 0;
+    QFuture< void > done;
+  };
+
+  //! Processing applied to each part after reading it, in the thread which read it
+  typedef std::function< void( RasterPart & ) > RasterPartProcessor;
+
+  void readRasterPart( RasterPart *part, QgsRasterInterface *input, int nBands, QgsRasterBlockFeedback *feedback, const RasterPartProcessor &processor )
+  {
+    QElapsedTimer timer;
+    timer.start();
+    for ( int band = 1; band <= nBands; ++band )
+    {
+      part->blocks << input->block( band, part->extent, part->cols, part->rows, feedback );
+    }
+    if ( processor )
+      processor( *part );
+    part->readTime = timer.elapsed() / 1000.0;
+  }
+
+  /**
+   * Reads the parts of a raster in order. In parallel mode, upcoming parts are read by
+   * worker threads, each with its own copy of the pipe, while the caller writes the
+   * current one: rendering and reprojection dominate the time of most exports, and the
+   * pipe interfaces are not safe to share between threads.
+   */
+  class RasterPartReader
+  {
+    public:
+
+      RasterPartReader( const QgsRasterPipe *pipe, int nBands, int nCols, int nRows, const QgsRectangle &extent,
+                        int maxPartWidth, int maxPartHeight, bool parallel,
+                        QgsRasterBlockFeedback *feedback, const RasterPartProcessor &processor )
+        : mInput( pipe->last() )
+        , mBands( nBands )
+        , mFeedback( feedback )
+        , mProcessor( processor )
+      {
+        // same subdivision as QgsRasterIterator
+        for ( int top = 0; nCols > 0 && top < nRows; top += maxPartHeight )
+        {
+          for ( int left = 0; left < nCols; left += maxPartWidth )
+          {
+            std::shared_ptr< RasterPart > part = std::make_shared< RasterPart >();
+            part->left = left;
+            part->top = top;
+            part->cols = std::min( maxPartWidth, nCols - left );
+            part->rows = std::min( maxPartHeight, nRows - top );
+
+            double xmin = extent.xMinimum() + left / static_cast< double >( nCols ) * extent.width();
+            double xmax = left + part->cols == nCols ? extent.xMaximum() :
+                          extent.xMinimum() + ( left + part->cols ) / static_cast< double >( nCols ) * extent.width();
+            double ymin = top + part->rows == nRows ? extent.yMinimum() :
+                          extent.yMaximum() - ( top + part->rows ) / static_cast< double >( nRows ) * extent.height();
+            double ymax = extent.yMaximum() - top / static_cast< double >( nRows ) * extent.height();
+            part->extent = QgsRectangle( xmin, ymin, xmax, ymax );
+
+            mParts.enqueue( part );
+          }
+        }
+
+        int threads = std::min( QThreadPool::globalInstance()->maxThreadCount(), mParts.count() );
+        if ( parallel && threads > 1 )
+        {
+          for ( int i = 0; i < threads; ++i )
+            mPipes.push_back( std::unique_ptr< QgsRasterPipe >( new QgsRasterPipe( *pipe ) ) );
+        }
+      }
+
+      ~RasterPartReader()
+      {
+        Q_FOREACH ( const std::shared_ptr< RasterPart > &part, mPending )
+          part->done.waitForFinished();
+      }
+
+      //! Returns the number of parts the raster is split into
+      int partCount() const { return mParts.count() + mPending.count() + mRead; }
+
+      //! Returns the next part with its data, or nullptr after the last part
+      std::shared_ptr< RasterPart > next()
+      {
+        std::shared_ptr< RasterPart > part;
+        if ( mPipes.empty() )
+        {
+          if ( mParts.isEmpty() )
+            return part;
+          part = mParts.dequeue();
+          readRasterPart( part.get(), mInput, mBands, mFeedback, mProcessor );
+        }
+        else
+        {
+          // a part is only started once the part which used the same pipe before is done
+          while ( !mParts.isEmpty() && mPending.count() < static_cast< int >( mPipes.size() ) )
+          {
+            std::shared_ptr< RasterPart > pending = mParts.dequeue();
+            QgsRasterInterface *input = mPipes.at( ( mRead + mPending.count() ) % mPipes.size() )->last();
+            pending->done = QtConcurrent::run( readRasterPart, pending.get(), input, mBands, mFeedback, mProcessor );
+            mPending.enqueue( pending );
+          }
+          if ( mPending.isEmpty() )
+            return part;
+          part = mPending.dequeue();
+          part->done.waitForFinished();
+        }
+
+        ++mRead;
+        mReadTime += part->readTime;
+        return part;
+      }
+
+      //! Returns the time spent reading and processing parts so far, summed over all threads
+      double readTime() const { return mReadTime; }
+
+    private:
+
+      QgsRasterInterface *mInput = nullptr;
+      int mBands = 0;
+      QgsRasterBlockFeedback *mFeedback = nullptr;
+      RasterPartProcessor mProcessor;
+      QQueue< std::shared_ptr< RasterPart > > mParts;
+      QQueue< std::shared_ptr< RasterPart > > mPending;
+      std::vector< std::unique_ptr< QgsRasterPipe > > mPipes;
+      int mRead = 0;
+      double mReadTime = 0;
+  };
+}
+
 QgsRasterDataProvider *QgsRasterFileWriter::createOneBandRaster( Qgis::DataType dataType, int width, int height, const QgsRectangle &extent, const QgsCoordinateReferenceSystem &crs )
 {
   if ( mTiledMode )
@@ -66,6 +218,8 @@ QgsRasterFileWriter::QgsRasterFileWriter( const QString &outputUrl )
   , mMaxTileHeight( 500 )
   , mBuildPyramidsFlag( QgsRaster::PyramidsFlagNo )
   , mPyramidsFormat( QgsRaster::PyramidsGTiff )
+  , mParallelProcessing( true )
+  , mCloudOptimized( false )
   , mPipe( nullptr )
   , mInput( nullptr )
 {
@@ -81,6 +235,8 @@ QgsRasterFileWriter::QgsRasterFileWriter()
   , mMaxTileHeight( 500 )
   , mBuildPyramidsFlag( QgsRaster::PyramidsFlagNo )
   , mPyramidsFormat( QgsRaster::PyramidsGTiff )
+  , mParallelProcessing( true )
+  , mCloudOptimized( false )
   , mPipe( nullptr )
   , mInput( nullptr )
 {
@@ -128,6 +284,7 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeRaster( const QgsRast
 #endif
 
   mFeedback = feedback;
+  mStageTimes.clear();
 
   QgsRasterIterator iter( pipe->last() );
 
@@ -146,16 +303,57 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeRaster( const QgsRast
     }
   }
 
-  if ( mMode == Image )
+  WriterError e = NoError;
+  if ( mCloudOptimized && !mTiledMode )
   {
-    WriterError e = writeImageRaster( &iter, nCols, nRows, outputExtent, crs, feedback );
-    return e;
+    if ( mOutputProviderKey != QLatin1String( "gdal" ) || mOutputFormat.compare( QLatin1String( "GTiff" ), Qt::CaseInsensitive ) != 0 )
+    {
+      QgsDebugMsg( "Cloud optimized output requires the GTiff format" );
+      return DestProviderError;
+    }
+
+    // Write the data to a temporary tiled GeoTIFF, add overviews and copy both into
+    // the cloud optimized layout, with the overviews before the full resolution data
+    const QString outputUrl = mOutputUrl;
+    const QStringList createOptions = mCreateOptions;
+    const QgsRaster::RasterBuildPyramids buildPyramidsFlag = mBuildPyramidsFlag;
+    mOutputUrl = outputUrl + QStringLiteral( ".tmp.tif" );
+    mCreateOptions = QStringList() << QStringLiteral( "TILED=YES" ) << QStringLiteral( "BIGTIFF=IF_SAFER" );
+    mCreateOptions << createOptions.filter( QRegExp( "^BLOCK[XY]SIZE=", Qt::CaseInsensitive ) );
+    mBuildPyramidsFlag = QgsRaster::PyramidsFlagNo;
+
+    e = mMode == Image ? writeImageRaster( &iter, nCols, nRows, outputExtent, crs, feedback )
+        : writeDataRaster( pipe, &iter, nCols, nRows, outputExtent, crs, feedback );
+
+    const QString tmpUrl = mOutputUrl;
+    mOutputUrl = outputUrl;
+    mCreateOptions = createOptions;
+    mBuildPyramidsFlag = buildPyramidsFlag;
+
+    if ( e == NoError && !writeCloudOptimized( tmpUrl, mOutputUrl ) )
+    {
+      e = WriteError;
+    }
+    GDALDeleteDataset( GDALGetDriverByName( "GTiff" ), tmpUrl.toUtf8().constData() );
+  }
+  else if ( mMode == Image )
+  {
+    e = writeImageRaster( &iter, nCols, nRows, outputExtent, crs, feedback );
   }
   else
   {
-    WriterError e = writeDataRaster( pipe, &iter, nCols, nRows, outputExtent, crs, feedback );
-    return e;
+    e = writeDataRaster( pipe, &iter, nCols, nRows, outputExtent, crs, feedback );
   }
+
+  QgsDebugMsgLevel( QString( "reading %1 s, writing %2 s, building pyramids %3 s, cloud optimizing %4 s" )
+                    .arg( stageTime( Reading ) ).arg( stageTime( Writing ) )
+                    .arg( stageTime( BuildingPyramids ) ).arg( stageTime( CloudOptimizing ) ), 2 );
+  return e;
+}
+
+double QgsRasterFileWriter::stageTime( Stage stage ) const
+{
+  return mStageTimes.value( stage, 0.0 );
 }
 
 QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const QgsRasterPipe *pipe, QgsRasterIterator *iter, int nCols, int nRows, const QgsRectangle &outputExtent,
@@ -350,8 +548,6 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
     QgsRasterDataProvider *destProvider,
     QgsRasterBlockFeedback *feedback )
 {
-  Q_UNUSED( pipe );
-  Q_UNUSED( destHasNoDataValueList );
   QgsDebugMsgLevel( "Entered", 4 );
 
   const QgsRasterInterface *iface = iter->input();
@@ -359,100 +555,60 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
   int nBands = iface->bandCount();
   QgsDebugMsgLevel( QString( "nBands = %1" ).arg( nBands ), 4 );
 
-  //Get output map units per pixel
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-
-  QList<QgsRasterBlock *> blockList;
-  blockList.reserve( nBands );
   for ( int i = 1; i <= nBands; ++i )
   {
-    iter->startRasterRead( i, nCols, nRows, outputExtent );
-    blockList.push_back( nullptr );
     if ( destProvider && destHasNoDataValueList.value( i - 1 ) ) // no tiles
     {
       destProvider->setNoDataValue( i, destNoDataValueList.value( i - 1 ) );
     }
   }
 
-  int nParts = 0;
-  int fileIndex = 0;
-  if ( feedback )
+  // It may happen that internal data type (dataType) is wider than destDataType
+  QList<bool> convertBlocks;
+  for ( int i = 1; i <= nBands; ++i )
   {
-    int nPartsX = nCols / iter->maximumTileWidth() + 1;
-    int nPartsY = nRows / iter->maximumTileHeight() + 1;
-    nParts = nPartsX * nPartsY;
+    convertBlocks << !( srcProvider && srcProvider->dataType( i ) == destDataType );
   }
 
-  // hmm why is there a for(;;) here ..
-  // not good coding practice IMHO, it might be better to use [ for() and break ] or  [ while (test) ]
-  Q_FOREVER
+  RasterPartReader reader( pipe, nBands, nCols, nRows, outputExtent, iter->maximumTileWidth(), iter->maximumTileHeight(),
+                           mParallelProcessing, nullptr, [convertBlocks, destDataType]( RasterPart & part )
   {
-    for ( int i = 1; i <= nBands; ++i )
+    for ( int i = 0; i < part.blocks.count(); ++i )
     {
-      if ( !iter->readNextRasterPart( i, iterCols, iterRows, &( blockList[i - 1] ), iterLeft, iterTop ) )
-      {
-        // No more parts, create VRT and return
-        if ( mTiledMode )
-        {
-          QString vrtFilePath( mOutputUrl + '/' + vrtFileName() );
-          writeVRT( vrtFilePath );
-          if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
-          {
-            buildPyramids( vrtFilePath );
-          }
-        }
-        else
-        {
-          if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
-          {
-            buildPyramids( mOutputUrl );
-          }
-        }
-
-        QgsDebugMsgLevel( "Done", 4 );
-        return NoError; //reached last tile, bail out
-      }
-      // TODO: verify if NoDataConflict happened, to do that we need the whole pipe or nuller interface
+      // TODO: this conversion should go to QgsRasterDataProvider::write with additional input data type param
+      if ( part.blocks.at( i ) && convertBlocks.value( i ) )
+        part.blocks.at( i )->convert( destDataType );
     }
+  } );
+
+  int nParts = reader.partCount();
+  int fileIndex = 0;
+  QElapsedTimer writeTimer;
 
+  while ( std::shared_ptr< RasterPart > part = reader.next() )
+  {
     if ( feedback && fileIndex < ( nParts - 1 ) )
     {
       feedback->setProgress( 100.0 * fileIndex / static_cast< double >( nParts ) );
       if ( feedback->isCanceled() )
       {
-        for ( int i = 0; i < nBands; ++i )
-        {
-          delete blockList[i];
-        }
         break;
       }
     }
 
-    // It may happen that internal data type (dataType) is wider than destDataType
-    QList<QgsRasterBlock *> destBlockList;
-    for ( int i = 1; i <= nBands; ++i )
+    // TODO: verify if NoDataConflict happened, to do that we need the whole pipe or nuller interface
+    if ( part->blocks.contains( nullptr ) )
     {
-      if ( srcProvider && srcProvider->dataType( i ) == destDataType )
-      {
-        destBlockList.push_back( blockList[i - 1] );
-      }
-      else
-      {
-        // TODO: this conversion should go to QgsRasterDataProvider::write with additional input data type param
-        blockList[i - 1]->convert( destDataType );
-        destBlockList.push_back( blockList[i - 1] );
-      }
-      blockList[i - 1] = nullptr;
+      ++fileIndex;
+      continue;
     }
 
+    writeTimer.start();
     if ( mTiledMode ) //write to file
     {
       QgsRasterDataProvider *partDestProvider = createPartProvider( outputExtent,
-          nCols, iterCols, iterRows,
-          iterLeft, iterTop, mOutputUrl,
+          nCols, part->cols, part->rows,
+          part->left, part->top, mOutputUrl,
           fileIndex, nBands, destDataType, crs );
 
       if ( partDestProvider )
@@ -464,9 +620,8 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
           {
             partDestProvider->setNoDataValue( i, destNoDataValueList.value( i - 1 ) );
           }
-          partDestProvider->write( destBlockList[i - 1]->bits( 0 ), i, iterCols, iterRows, 0, 0 );
-          delete destBlockList[i - 1];
-          addToVRT( partFileName( fileIndex ), i, iterCols, iterRows, iterLeft, iterTop );
+          partDestProvider->write( part->blocks.at( i - 1 )->bits( 0 ), i, part->cols, part->rows, 0, 0 );
+          addToVRT( partFileName( fileIndex ), i, part->cols, part->rows, part->left, part->top );
         }
         delete partDestProvider;
       }
@@ -476,15 +631,39 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
       //loop over data
       for ( int i = 1; i <= nBands; ++i )
       {
-        destProvider->write( destBlockList[i - 1]->bits( 0 ), i, iterCols, iterRows, iterLeft, iterTop );
-        delete destBlockList[i - 1];
+        destProvider->write( part->blocks.at( i - 1 )->bits( 0 ), i, part->cols, part->rows, part->left, part->top );
       }
     }
+    mStageTimes[ Writing ] += writeTimer.elapsed() / 1000.0;
     ++fileIndex;
   }
+  mStageTimes[ Reading ] += reader.readTime();
+
+  if ( feedback && feedback->isCanceled() )
+  {
+    QgsDebugMsgLevel( "Canceled", 4 );
+    return WriteCanceled;
+  }
+
+  if ( mTiledMode )
+  {
+    QString vrtFilePath( mOutputUrl + '/' + vrtFileName() );
+    writeVRT( vrtFilePath );
+    if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
+    {
+      buildPyramids( vrtFilePath );
+    }
+  }
+  else
+  {
+    if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
+    {
+      buildPyramids( mOutputUrl );
+    }
+  }
 
   QgsDebugMsgLevel( "Done", 4 );
-  return ( feedback && feedback->isCanceled() ) ? WriteCanceled : NoError;
+  return NoError;
 }
 
 QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRasterIterator *iter, int nCols, int nRows, const QgsRectangle &outputExtent,
@@ -509,12 +688,6 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
   iter->setMaximumTileWidth( mMaxTileWidth );
   iter->setMaximumTileHeight( mMaxTileHeight );
 
-  void *redData = qgsMalloc( mMaxTileWidth * mMaxTileHeight );
-  void *greenData = qgsMalloc( mMaxTileWidth * mMaxTileHeight );
-  void *blueData = qgsMalloc( mMaxTileWidth * mMaxTileHeight );
-  void *alphaData = qgsMalloc( mMaxTileWidth * mMaxTileHeight );
-  QgsRectangle mapRect;
-  int iterLeft = 0, iterTop = 0, iterCols = 0, iterRows = 0;
   int fileIndex = 0;
 
   //create destProvider for whole dataset here
@@ -525,37 +698,23 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
 
   destProvider = initOutput( nCols, nRows, crs, geoTransform, 4, Qgis::Byte );
 
-  iter->startRasterRead( 1, nCols, nRows, outputExtent, feedback );
-
-  int nParts = 0;
-  if ( feedback )
-  {
-    int nPartsX = nCols / iter->maximumTileWidth() + 1;
-    int nPartsY = nRows / iter->maximumTileHeight() + 1;
-    nParts = nPartsX * nPartsY;
-  }
-
-  QgsRasterBlock *inputBlock = nullptr;
-  while ( iter->readNextRasterPart( 1, iterCols, iterRows, &inputBlock, iterLeft, iterTop ) )
+  RasterPartReader reader( mPipe, 1, nCols, nRows, outputExtent, iter->maximumTileWidth(), iter->maximumTileHeight(),
+                           mParallelProcessing, feedback, [inputDataType]( RasterPart & part )
   {
+    QgsRasterBlock *inputBlock = part.blocks.value( 0 );
     if ( !inputBlock )
-    {
-      continue;
-    }
-
-    if ( feedback && fileIndex < ( nParts - 1 ) )
-    {
-      feedback->setProgress( 100.0 * fileIndex / static_cast< double >( nParts ) );
-      if ( feedback->isCanceled() )
-      {
-        delete inputBlock;
-        break;
-      }
-    }
+      return;
 
     //fill into red/green/blue/alpha channels
-    qgssize nPixels = static_cast< qgssize >( iterCols ) * iterRows;
-    // TODO: should be char not int? we are then copying 1 byte
+    qgssize nPixels = static_cast< qgssize >( part.cols ) * part.rows;
+    QByteArray redData( nPixels, Qt::Uninitialized );
+    QByteArray greenData( nPixels, Qt::Uninitialized );
+    QByteArray blueData( nPixels, Qt::Uninitialized );
+    QByteArray alphaData( nPixels, Qt::Uninitialized );
+    char *redBits = redData.data();
+    char *greenBits = greenData.data();
+    char *blueBits = blueData.data();
+    char *alphaBits = alphaData.data();
     int red = 0;
     int green = 0;
     int blue = 0;
@@ -576,55 +735,77 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
         green /= a;
         blue /= a;
       }
-      memcpy( reinterpret_cast< char * >( redData ) + i, &red, 1 );
-      memcpy( reinterpret_cast< char * >( greenData ) + i, &green, 1 );
-      memcpy( reinterpret_cast< char * >( blueData ) + i, &blue, 1 );
-      memcpy( reinterpret_cast< char * >( alphaData ) + i, &alpha, 1 );
+      redBits[i] = static_cast< char >( red );
+      greenBits[i] = static_cast< char >( green );
+      blueBits[i] = static_cast< char >( blue );
+      alphaBits[i] = static_cast< char >( alpha );
+    }
+
+    qDeleteAll( part.blocks );
+    part.blocks.clear();
+    part.bandData << redData << greenData << blueData << alphaData;
+  } );
+
+  int nParts = reader.partCount();
+  QElapsedTimer writeTimer;
+
+  while ( std::shared_ptr< RasterPart > part = reader.next() )
+  {
+    if ( part->bandData.isEmpty() )
+    {
+      continue;
+    }
+
+    if ( feedback && fileIndex < ( nParts - 1 ) )
+    {
+      feedback->setProgress( 100.0 * fileIndex / static_cast< double >( nParts ) );
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
     }
-    delete inputBlock;
 
     //create output file
+    writeTimer.start();
     if ( mTiledMode )
     {
       //delete destProvider;
       QgsRasterDataProvider *partDestProvider = createPartProvider( outputExtent,
-          nCols, iterCols, iterRows,
-          iterLeft, iterTop, mOutputUrl, fileIndex,
+          nCols, part->cols, part->rows,
+          part->left, part->top, mOutputUrl, fileIndex,
           4, Qgis::Byte, crs );
 
       if ( partDestProvider )
       {
         //write data to output file
-        partDestProvider->write( redData, 1, iterCols, iterRows, 0, 0 );
-        partDestProvider->write( greenData, 2, iterCols, iterRows, 0, 0 );
-        partDestProvider->write( blueData, 3, iterCols, iterRows, 0, 0 );
-        partDestProvider->write( alphaData, 4, iterCols, iterRows, 0, 0 );
-
-        addToVRT( partFileName( fileIndex ), 1, iterCols, iterRows, iterLeft, iterTop );
-        addToVRT( partFileName( fileIndex ), 2, iterCols, iterRows, iterLeft, iterTop );
-        addToVRT( partFileName( fileIndex ), 3, iterCols, iterRows, iterLeft, iterTop );
-        addToVRT( partFileName( fileIndex ), 4, iterCols, iterRows, iterLeft, iterTop );
+        for ( int band = 1; band <= 4; ++band )
+        {
+          partDestProvider->write( part->bandData[ band - 1 ].data(), band, part->cols, part->rows, 0, 0 );
+          addToVRT( partFileName( fileIndex ), band, part->cols, part->rows, part->left, part->top );
+        }
         delete partDestProvider;
       }
     }
     else if ( destProvider )
     {
-      destProvider->write( redData, 1, iterCols, iterRows, iterLeft, iterTop );
-      destProvider->write( greenData, 2, iterCols, iterRows, iterLeft, iterTop );
-      destProvider->write( blueData, 3, iterCols, iterRows, iterLeft, iterTop );
-      destProvider->write( alphaData, 4, iterCols, iterRows, iterLeft, iterTop );
+      for ( int band = 1; band <= 4; ++band )
+      {
+        destProvider->write( part->bandData[ band - 1 ].data(), band, part->cols, part->rows, part->left, part->top );
+      }
     }
+    mStageTimes[ Writing ] += writeTimer.elapsed() / 1000.0;
 
     ++fileIndex;
   }
+  mStageTimes[ Reading ] += reader.readTime();
 
   if ( destProvider )
     delete destProvider;
 
-  qgsFree( redData );
-  qgsFree( greenData );
-  qgsFree( blueData );
-  qgsFree( alphaData );
+  if ( feedback && feedback->isCanceled() )
+  {
+    return WriteCanceled;
+  }
 
   if ( feedback )
   {
@@ -647,7 +828,7 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
       buildPyramids( mOutputUrl );
     }
   }
-  return ( feedback && feedback->isCanceled() ) ? WriteCanceled : NoError;
+  return NoError;
 }
 
 void QgsRasterFileWriter::addToVRT( const QString &filename, int band, int xSize, int ySize, int xOffset, int yOffset )
@@ -733,6 +914,8 @@ void QgsRasterFileWriter::buildPyramids( const QString &filename )
 void QgsRasterFileWriter::buildPyramids( const QString &filename )
 {
   QgsDebugMsgLevel( "filename = " + filename, 4 );
+  QElapsedTimer timer;
+  timer.start();
   // open new dataProvider so we can build pyramids with it
   QgsRasterDataProvider *destProvider = dynamic_cast< QgsRasterDataProvider * >( QgsProviderRegistry::instance()->createProvider( mOutputProviderKey, filename ) );
   if ( !destProvider )
@@ -791,6 +974,81 @@ void QgsRasterFileWriter::buildPyramids( const QString &filename )
     QgsDebugMsgLevel( res + " - " + message, 4 );
   }
   delete destProvider;
+  mStageTimes[ BuildingPyramids ] += timer.elapsed() / 1000.0;
+}
+
+bool QgsRasterFileWriter::writeCloudOptimized( const QString &sourceFile, const QString &destinationFile )
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  GDALDatasetH dataset = GDALOpen( sourceFile.toUtf8().constData(), GA_Update );
+  if ( !dataset )
+  {
+    QgsDebugMsg( "Cannot open " + sourceFile );
+    return false;
+  }
+
+  QVector< int > overviewList = mPyramidsList.toVector();
+  if ( overviewList.isEmpty() )
+  {
+    // add overviews until the smallest one fits into a single block
+    int blockXSize = 0;
+    int blockYSize = 0;
+    GDALGetBlockSize( GDALGetRasterBand( dataset, 1 ), &blockXSize, &blockYSize );
+    int size = std::max( GDALGetRasterXSize( dataset ), GDALGetRasterYSize( dataset ) );
+    for ( int factor = 2; size / ( factor / 2 ) > std::max( blockXSize, blockYSize ); factor *= 2 )
+    {
+      overviewList << factor;
+    }
+  }
+
+  CPLErr err = CE_None;
+  if ( !overviewList.isEmpty() )
+  {
+    QByteArray resampling = mPyramidsResampling.isEmpty() ? QByteArray( "AVERAGE" ) : mPyramidsResampling.toUtf8();
+    // lets GDAL versions which support it compute the overviews with several threads
+    CPLSetThreadLocalConfigOption( "GDAL_NUM_THREADS", "ALL_CPUS" );
+    err = GDALBuildOverviews( dataset, resampling.constData(), overviewList.size(), overviewList.data(), 0, nullptr, nullptr, nullptr );
+    CPLSetThreadLocalConfigOption( "GDAL_NUM_THREADS", nullptr );
+  }
+  mStageTimes[ BuildingPyramids ] += timer.restart() / 1000.0;
+
+  if ( err != CE_None )
+  {
+    QgsDebugMsg( "Cannot build overviews for " + sourceFile );
+    GDALClose( dataset );
+    return false;
+  }
+
+  char **options = nullptr;
+  Q_FOREACH ( const QString &option, mCreateOptions )
+  {
+    options = CSLSetNameValue( options, option.section( '=', 0, 0 ).toUtf8().constData(), option.section( '=', 1 ).toUtf8().constData() );
+  }
+  options = CSLSetNameValue( options, "TILED", "YES" );
+  options = CSLSetNameValue( options, "COPY_SRC_OVERVIEWS", "YES" );
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(2,1,0)
+  if ( !CSLFetchNameValue( options, "NUM_THREADS" ) )
+  {
+    // compress blocks with several threads
+    options = CSLSetNameValue( options, "NUM_THREADS", "ALL_CPUS" );
+  }
+#endif
+
+  GDALDatasetH copy = GDALCreateCopy( GDALGetDriverByName( "GTiff" ), destinationFile.toUtf8().constData(), dataset, FALSE, options, nullptr, nullptr );
+  CSLDestroy( options );
+  GDALClose( dataset );
+
+  if ( !copy )
+  {
+    QgsDebugMsg( "Cannot create " + destinationFile );
+    return false;
+  }
+  GDALClose( copy );
+
+  mStageTimes[ CloudOptimizing ] += timer.elapsed() / 1000.0;
+  return true;
 }
 
 #if 0
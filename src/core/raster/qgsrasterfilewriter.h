@@ -19,6 +19,7 @@
 #include "qgscoordinatereferencesystem.h"
 #include <QDomDocument>
 #include <QDomElement>
+#include <QHash>
 #include <QString>
 #include <QStringList>
 
@@ -53,6 +54,17 @@ class CORE_EXPORT QgsRasterFileWriter
       WriteCanceled = 6, //!< Writing was manually canceled
     };
 
+    /** Stages of writing a raster, see stageTime().
+     * \since QGIS 3.0
+     */
+    enum Stage
+    {
+      Reading = 0, //!< Reading and processing the raster parts through the pipe, summed over all threads
+      Writing, //!< Writing the raster parts to the output
+      BuildingPyramids, //!< Building pyramids
+      CloudOptimizing, //!< Copying data and pyramids into a cloud optimized GeoTIFF
+    };
+
     QgsRasterFileWriter( const QString &outputUrl );
 
     /** Create a raster file with one band without initializing the pixel data.
@@ -130,6 +142,42 @@ class CORE_EXPORT QgsRasterFileWriter
     void setPyramidsConfigOptions( const QStringList &list ) { mPyramidsConfigOptions = list; }
     QStringList pyramidsConfigOptions() const { return mPyramidsConfigOptions; }
 
+    /** Sets whether raster parts are read and processed by several threads, each using
+     * its own copy of the pipe. Parts are still written in order by the calling thread.
+     * Enabled by default.
+     * \see parallelProcessing()
+     * \since QGIS 3.0
+     */
+    void setParallelProcessing( bool enabled ) { mParallelProcessing = enabled; }
+
+    /** Returns true if raster parts are read and processed by several threads.
+     * \see setParallelProcessing()
+     * \since QGIS 3.0
+     */
+    bool parallelProcessing() const { return mParallelProcessing; }
+
+    /** Sets whether the output is written as a cloud optimized GeoTIFF, i.e. a tiled
+     * GeoTIFF with internal overviews stored before the full resolution data, which
+     * clients can read partially using HTTP range requests. Overviews are built for
+     * pyramidsList() if set, or until the smallest overview fits into a single tile,
+     * using pyramidsResampling(). Only supported by the GTiff output format, and
+     * ignored in tiled mode.
+     * \see cloudOptimized()
+     * \since QGIS 3.0
+     */
+    void setCloudOptimized( bool enabled ) { mCloudOptimized = enabled; }
+
+    /** Returns true if the output is written as a cloud optimized GeoTIFF.
+     * \see setCloudOptimized()
+     * \since QGIS 3.0
+     */
+    bool cloudOptimized() const { return mCloudOptimized; }
+
+    /** Returns the time in seconds spent in a \a stage by the last call to writeRaster().
+     * \since QGIS 3.0
+     */
+    double stageTime( Stage stage ) const;
+
     /**
      * Returns the GDAL driver name for a specified file \a extension. E.g. the
      * driver name for the ".tif" extension is "GTiff".
@@ -175,6 +223,9 @@ class CORE_EXPORT QgsRasterFileWriter
     void addToVRT( const QString &filename, int band, int xSize, int ySize, int xOffset, int yOffset );
     void buildPyramids( const QString &filename );
 
+    //! Copies a tiled GeoTIFF into a cloud optimized GeoTIFF, adding overviews to the source first
+    bool writeCloudOptimized( const QString &sourceFile, const QString &destinationFile );
+
     //! Create provider and datasource for a part image (vrt mode)
     QgsRasterDataProvider *createPartProvider( const QgsRectangle &extent, int nCols, int iterCols, int iterRows,
         int iterLeft, int iterTop,
@@ -220,6 +271,10 @@ class CORE_EXPORT QgsRasterFileWriter
     QgsRaster::RasterPyramidsFormat mPyramidsFormat;
     QStringList mPyramidsConfigOptions;
 
+    bool mParallelProcessing;
+    bool mCloudOptimized;
+    QHash< int, double > mStageTimes;
+
     QDomDocument mVRTDocument;
     QList<QDomElement> mVRTBands;
 
@@ -0,0 +1,91 @@
+/***************************************************************************
+                              qgsmarkerspritecache.cpp
+                              ------------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsmarkerspritecache.h"
+#include "qgslogger.h"
+#include "qgis.h"
+
+#include <QPainter>
+
+#include <cmath>
+
+QgsMarkerSpriteCache::QgsMarkerSpriteCache( int maximumSprites )
+  : mMaximumSprites( maximumSprites )
+{
+}
+
+void QgsMarkerSpriteCache::setEnabled( bool enabled )
+{
+  mEnabled = enabled;
+  mSprites.clear();
+}
+
+const QgsMarkerSpriteCache::Sprite *QgsMarkerSpriteCache::sprite( const QString &key ) const
+{
+  if ( !mEnabled )
+    return nullptr;
+
+  QHash< QString, Sprite >::const_iterator it = mSprites.constFind( key );
+  if ( it == mSprites.constEnd() )
+    return nullptr;
+
+  return &it.value();
+}
+
+bool QgsMarkerSpriteCache::insertSprite( const QString &key, const QImage &image, QPointF origin )
+{
+  if ( !mEnabled )
+    return false;
+
+  if ( mSprites.count() >= mMaximumSprites )
+  {
+    // too many distinct markers - caching them is just wasted effort
+    QgsDebugMsgLevel( QString( "Marker sprite cache full (%1 sprites), disabling" ).arg( mSprites.count() ), 2 );
+    setEnabled( false );
+    return false;
+  }
+
+  Sprite sprite;
+  sprite.image = image;
+  sprite.origin = origin;
+  mSprites.insert( key, sprite );
+  return true;
+}
+
+void QgsMarkerSpriteCache::drawSprite( QPainter *painter, const QgsMarkerSpriteCache::Sprite &sprite, QPointF point )
+{
+  QPointF topLeft = point + sprite.origin;
+
+  // sprites landing on whole device pixels are blitted as is
+  const QTransform &transform = painter->transform();
+  if ( transform.type() <= QTransform::TxTranslate )
+  {
+    QPointF deviceTopLeft = transform.map( topLeft );
+    if ( qgsDoubleNear( deviceTopLeft.x(), std::round( deviceTopLeft.x() ), 0.001 ) &&
+         qgsDoubleNear( deviceTopLeft.y(), std::round( deviceTopLeft.y() ), 0.001 ) )
+    {
+      painter->drawImage( topLeft, sprite.image );
+      return;
+    }
+  }
+
+  // otherwise the image would be snapped to the pixel grid, so interpolate it
+  // to keep the fractional position of the marker
+  bool smooth = painter->testRenderHint( QPainter::SmoothPixmapTransform );
+  painter->setRenderHint( QPainter::SmoothPixmapTransform, true );
+  painter->drawImage( QRectF( topLeft, QSizeF( sprite.image.size() ) ), sprite.image );
+  painter->setRenderHint( QPainter::SmoothPixmapTransform, smooth );
+}
@@ -0,0 +1,111 @@
+/***************************************************************************
+                              qgsmarkerspritecache.h
+                              ----------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSMARKERSPRITECACHE_H
+#define QGSMARKERSPRITECACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QHash>
+#include <QImage>
+#include <QPointF>
+#include <QString>
+
+class QPainter;
+
+/** \ingroup core
+ * \class QgsMarkerSpriteCache
+ * \brief A cache of pre-rendered marker images ("sprites"), keyed by the fully
+ * resolved parameters of the marker.
+ *
+ * Marker symbol layers use the cache during a single render to blit markers instead
+ * of painting them from scratch for every point. This is useful whenever the set
+ * of distinct markers is small, including when the marker parameters are data defined.
+ * If the number of distinct sprites exceeds the maximum sprite count the cache
+ * disables itself for the remainder of the render, and the layer should fall
+ * back to painting markers directly.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsMarkerSpriteCache
+{
+  public:
+
+    //! A single pre-rendered marker
+    struct Sprite
+    {
+      //! Rendered marker image
+      QImage image;
+      //! Position of the image's top left corner, relative to the marker point
+      QPointF origin;
+    };
+
+    /** Constructor for QgsMarkerSpriteCache.
+     * \param maximumSprites maximum number of distinct sprites to store before
+     * the cache disables itself
+     */
+    explicit QgsMarkerSpriteCache( int maximumSprites = DEFAULT_MAXIMUM_SPRITES );
+
+    /** Returns true if the cache is enabled.
+     * \see setEnabled()
+     */
+    bool isEnabled() const { return mEnabled; }
+
+    /** Enables or disables the cache. Disabling the cache clears any stored sprites.
+     * \see isEnabled()
+     */
+    void setEnabled( bool enabled );
+
+    /** Returns the sprite matching a key, or a nullptr if no matching sprite exists
+     * in the cache.
+     */
+    const Sprite *sprite( const QString &key ) const;
+
+    /** Inserts a sprite into the cache. Returns false if the cache is disabled or
+     * if the sprite could not be stored because the cache is full, in which case the
+     * cache is disabled.
+     */
+    bool insertSprite( const QString &key, const QImage &image, QPointF origin );
+
+    /** Draws a sprite at the specified point, using a \a painter. Sprites which don't
+     * fall on whole pixels are interpolated, so that markers keep their fractional position.
+     */
+    static void drawSprite( QPainter *painter, const Sprite &sprite, QPointF point );
+
+    //! Removes all sprites from the cache
+    void clear() { mSprites.clear(); }
+
+    //! Returns the number of sprites stored in the cache
+    int count() const { return mSprites.count(); }
+
+    //! Maximum width/height of a sprite image
+    static const int MAXIMUM_SPRITE_WIDTH = 1000;
+
+    //! Default maximum number of distinct sprites
+    static const int DEFAULT_MAXIMUM_SPRITES = 256;
+
+  private:
+
+    QHash< QString, Sprite > mSprites;
+    int mMaximumSprites = DEFAULT_MAXIMUM_SPRITES;
+    bool mEnabled = false;
+
+};
+
+#endif // QGSMARKERSPRITECACHE_H
@@ -854,6 +854,10 @@ void QgsSimpleMarkerSymbolLayer::startRender( QgsSymbolRenderContext &context )
     mCache = QImage();
     mSelCache = QImage();
   }
+
+  // when the single cached image can't be used, fall back to caching one sprite per
+  // distinct combination of the data defined marker properties
+  mSpriteCache.setEnabled( !mUsingCache && !context.renderContext().forceVectorOutput() );
 }
 
 
@@ -1023,12 +1027,132 @@ void QgsSimpleMarkerSymbolLayer::renderPoint( QPointF point, QgsSymbolRenderCont
                           point.y() - s / 2.0 + offset.y(),
                           s, s ), img );
   }
+  else if ( mSpriteCache.isEnabled() )
+  {
+    double size = 0;
+    double strokeWidth = 0;
+    QPointF offset;
+    QString key = spriteKey( context, size, strokeWidth, offset );
+    const QgsMarkerSpriteCache::Sprite *sprite = mSpriteCache.sprite( key );
+    if ( !sprite && renderSprite( key, size, strokeWidth, offset, context ) )
+    {
+      sprite = mSpriteCache.sprite( key );
+    }
+
+    if ( sprite )
+      QgsMarkerSpriteCache::drawSprite( p, *sprite, point );
+    else
+      QgsSimpleMarkerSymbolLayerBase::renderPoint( point, context );
+  }
   else
   {
     QgsSimpleMarkerSymbolLayerBase::renderPoint( point, context );
   }
 }
 
+QString QgsSimpleMarkerSymbolLayer::spriteKey( QgsSymbolRenderContext &context, double &size, double &strokeWidth, QPointF &offset )
+{
+  bool hasDataDefinedSize = false;
+  double scaledSize = calculateSize( context, hasDataDefinedSize );
+  size = context.renderContext().convertToPainterUnits( scaledSize, mSizeUnit, mSizeMapUnitScale );
+
+  bool hasDataDefinedRotation = false;
+  double angle = 0;
+  calculateOffsetAndRotation( context, scaledSize, hasDataDefinedRotation, offset, angle );
+
+  QString shape = encodeShape( mShape );
+  if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyName ) )
+  {
+    context.setOriginalValueVariable( shape );
+    shape = mDataDefinedProperties.valueAsString( QgsSymbolLayer::PropertyName, context.renderContext().expressionContext(), shape );
+  }
+
+  QColor fillColor = mBrush.color();
+  if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyFillColor ) )
+  {
+    context.setOriginalValueVariable( QgsSymbolLayerUtils::encodeColor( mColor ) );
+    fillColor = mDataDefinedProperties.valueAsColor( QgsSymbolLayer::PropertyFillColor, context.renderContext().expressionContext(), fillColor );
+  }
+
+  QColor strokeColor = mPen.color();
+  if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyStrokeColor ) )
+  {
+    context.setOriginalValueVariable( QgsSymbolLayerUtils::encodeColor( mStrokeColor ) );
+    strokeColor = mDataDefinedProperties.valueAsColor( QgsSymbolLayer::PropertyStrokeColor, context.renderContext().expressionContext(), strokeColor );
+  }
+
+  strokeWidth = context.renderContext().convertToPainterUnits( mStrokeWidth, mStrokeWidthUnit, mStrokeWidthMapUnitScale );
+  if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyStrokeWidth ) )
+  {
+    context.setOriginalValueVariable( mStrokeWidth );
+    bool ok = false;
+    double width = mDataDefinedProperties.valueAsDouble( QgsSymbolLayer::PropertyStrokeWidth, context.renderContext().expressionContext(), 0, &ok );
+    if ( ok )
+      strokeWidth = context.renderContext().convertToPainterUnits( width, mStrokeWidthUnit, mStrokeWidthMapUnitScale );
+  }
+
+  QString strokeStyle = QgsSymbolLayerUtils::encodePenStyle( mStrokeStyle );
+  if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyStrokeStyle ) )
+  {
+    context.setOriginalValueVariable( strokeStyle );
+    strokeStyle = mDataDefinedProperties.valueAsString( QgsSymbolLayer::PropertyStrokeStyle, context.renderContext().expressionContext(), strokeStyle );
+  }
+
+  QString joinStyle = QgsSymbolLayerUtils::encodePenJoinStyle( mPenJoinStyle );
+  if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyJoinStyle ) )
+  {
+    context.setOriginalValueVariable( joinStyle );
+    joinStyle = mDataDefinedProperties.valueAsString( QgsSymbolLayer::PropertyJoinStyle, context.renderContext().expressionContext(), joinStyle );
+  }
+
+  // rotations are bucketed to whole degrees, so that continuous rotation values don't
+  // produce a new sprite for every feature
+  QStringList key;
+  key << shape
+      << QString::number( qRound( size * 100 ) )
+      << QString::number( qRound( angle ) % 360 )
+      << QString::number( fillColor.rgba() )
+      << QString::number( strokeColor.rgba() )
+      << QString::number( qRound( strokeWidth * 100 ) )
+      << strokeStyle
+      << joinStyle
+      << QString::number( qRound( offset.x() * 100 ) )
+      << QString::number( qRound( offset.y() * 100 ) )
+      << ( context.selected() ? QStringLiteral( "1" ) : QStringLiteral( "0" ) );
+  return key.join( '|' );
+}
+
+bool QgsSimpleMarkerSymbolLayer::renderSprite( const QString &key, double size, double strokeWidth, QPointF offset, QgsSymbolRenderContext &context )
+{
+  QPainter *p = context.renderContext().painter();
+
+  // shapes are defined within a unit square, so the rotated marker fits in a square of
+  // size * sqrt(2). Add room for the (possibly mitered) stroke and antialiasing.
+  double margin = ( qgsDoubleNear( strokeWidth, 0.0 ) ? 1 : strokeWidth ) + 2;
+  // an even size keeps the marker centered on a pixel corner, like markers drawn directly on whole pixels
+  int imageSize = static_cast< int >( std::ceil( size * M_SQRT2 + 2 * margin ) ) / 2 * 2 + 2;
+  if ( imageSize > QgsMarkerSpriteCache::MAXIMUM_SPRITE_WIDTH )
+  {
+    return false;
+  }
+
+  QImage image( imageSize, imageSize, QImage::Format_ARGB32_Premultiplied );
+  image.fill( 0 );
+
+  // position of image's top left, relative to the rendered point. It keeps the fractional
+  // part of the offset, so that the marker is always centered within the image
+  QPointF origin( offset.x() - imageSize / 2.0, offset.y() - imageSize / 2.0 );
+
+  QPainter spritePainter( &image );
+  spritePainter.setRenderHints( p->renderHints() );
+  context.renderContext().setPainter( &spritePainter );
+  QgsSimpleMarkerSymbolLayerBase::renderPoint( -origin, context );
+  context.renderContext().setPainter( p );
+  spritePainter.end();
+
+  return mSpriteCache.insertSprite( key, image, origin );
+}
+
 QgsStringMap QgsSimpleMarkerSymbolLayer::properties() const
 {
   QgsStringMap map;
@@ -1900,15 +2024,65 @@ QString QgsSvgMarkerSymbolLayer::layerType() const
   return QStringLiteral( "SvgMarker" );
 }
 
+const QgsMarkerSpriteCache::Sprite *QgsSvgMarkerSymbolLayer::svgSprite( const QString &path, double size, const QColor &fillColor, const QColor &strokeColor,
+    double strokeWidth, double angle, QgsSymbolRenderContext &context )
+{
+  // rotations are bucketed to whole degrees, so that continuous rotation values don't
+  // produce a new sprite for every feature
+  int angleBucket = qRound( angle ) % 360;
+
+  QStringList keyParts;
+  keyParts << path
+           << QString::number( qRound( size * 100 ) )
+           << QString::number( fillColor.rgba() )
+           << QString::number( strokeColor.rgba() )
+           << QString::number( qRound( strokeWidth * 100 ) )
+           << QString::number( angleBucket )
+           << QString::number( qRound( context.opacity() * 1000 ) );
+  QString key = keyParts.join( '|' );
+
+  if ( const QgsMarkerSpriteCache::Sprite *sprite = mSpriteCache.sprite( key ) )
+    return sprite;
+
+  const QPicture &pct = QgsApplication::svgCache()->svgAsPicture( path, size, fillColor, strokeColor, strokeWidth,
+                        context.renderContext().scaleFactor(), false );
+  if ( pct.width() <= 1 )
+    return nullptr;
+
+  // size of the sprite must fit the marker at any rotation
+  double height = size * static_cast< double >( pct.height() ) / static_cast< double >( pct.width() );
+  int imageSize = static_cast< int >( std::ceil( std::sqrt( size * size + height * height ) ) ) / 2 * 2 + 4;
+  if ( imageSize > QgsMarkerSpriteCache::MAXIMUM_SPRITE_WIDTH )
+    return nullptr;
+
+  QImage image( imageSize, imageSize, QImage::Format_ARGB32_Premultiplied );
+  image.fill( 0 );
+
+  QPainter spritePainter( &image );
+  spritePainter.setRenderHint( QPainter::Antialiasing );
+  spritePainter.setOpacity( context.opacity() );
+  spritePainter.translate( imageSize / 2.0, imageSize / 2.0 );
+  spritePainter.rotate( angleBucket );
+  _fixQPictureDPI( &spritePainter );
+  spritePainter.drawPicture( 0, 0, pct );
+  spritePainter.end();
+
+  if ( !mSpriteCache.insertSprite( key, image, QPointF( -imageSize / 2.0, -imageSize / 2.0 ) ) )
+    return nullptr;
+
+  return mSpriteCache.sprite( key );
+}
+
 void QgsSvgMarkerSymbolLayer::startRender( QgsSymbolRenderContext &context )
 {
   QgsMarkerSymbolLayer::startRender( context ); // get anchor point expressions
-  Q_UNUSED( context );
+  mSpriteCache.setEnabled( !context.renderContext().forceVectorOutput() );
 }
 
 void QgsSvgMarkerSymbolLayer::stopRender( QgsSymbolRenderContext &context )
 {
   Q_UNUSED( context );
+  mSpriteCache.setEnabled( false );
 }
 
 void QgsSvgMarkerSymbolLayer::renderPoint( QPointF point, QgsSymbolRenderContext &context )
@@ -1971,7 +2145,18 @@ void QgsSvgMarkerSymbolLayer::renderPoint( QPointF point, QgsSymbolRenderContext
   bool fitsInCache = true;
   bool usePict = true;
   double hwRatio = 1.0;
-  if ( !context.renderContext().forceVectorOutput() && !rotated )
+  if ( mSpriteCache.isEnabled() && !context.selected() && ( rotated || !qgsDoubleNear( context.opacity(), 1.0 ) ) )
+  {
+    // rotated and transparent markers are expensive to draw, so reuse a pre-rendered sprite
+    const QgsMarkerSpriteCache::Sprite *sprite = svgSprite( path, size, fillColor, strokeColor, strokeWidth, angle, context );
+    if ( sprite )
+    {
+      usePict = false;
+      p->rotate( -angle );
+      QgsMarkerSpriteCache::drawSprite( p, *sprite, QPointF( 0, 0 ) );
+    }
+  }
+  else if ( !context.renderContext().forceVectorOutput() && !rotated )
   {
     usePict = false;
     const QImage &img = QgsApplication::svgCache()->svgAsImage( path, size, fillColor, strokeColor, strokeWidth,
@@ -20,6 +20,7 @@
 #include "qgis_sip.h"
 #include "qgis.h"
 #include "qgssymbollayer.h"
+#include "qgsmarkerspritecache.h"
 
 #define DEFAULT_SIMPLEMARKER_NAME         "circle"
 #define DEFAULT_SIMPLEMARKER_COLOR        QColor(255,0,0)
@@ -383,6 +384,20 @@ class CORE_EXPORT QgsSimpleMarkerSymbolLayer : public QgsSimpleMarkerSymbolLayer
 
   private:
 
+    //! Cache of pre-rendered markers, used when data defined properties prevent use of mCache
+    QgsMarkerSpriteCache mSpriteCache;
+
+    /** Resolves all data defined properties which affect the rendered marker and returns
+     * a sprite cache key for the marker. The marker size and stroke width in painter units and
+     * the marker offset are stored in \a size, \a strokeWidth and \a offset.
+     */
+    QString spriteKey( QgsSymbolRenderContext &context, double &size, double &strokeWidth, QPointF &offset );
+
+    /** Renders the marker for the current feature into a sprite image and stores it in the
+     * sprite cache. Returns false if the sprite could not be created.
+     */
+    bool renderSprite( const QString &key, double size, double strokeWidth, QPointF offset, QgsSymbolRenderContext &context );
+
     virtual void draw( QgsSymbolRenderContext &context, QgsSimpleMarkerSymbolLayerBase::Shape shape, const QPolygonF &polygon, const QPainterPath &path ) override SIP_FORCE;
 };
 
@@ -531,6 +546,15 @@ class CORE_EXPORT QgsSvgMarkerSymbolLayer : public QgsMarkerSymbolLayer
     double calculateSize( QgsSymbolRenderContext &context, bool &hasDataDefinedSize ) const;
     void calculateOffsetAndRotation( QgsSymbolRenderContext &context, double scaledSize, QPointF &offset, double &angle ) const;
 
+    /** Returns the sprite for a rotated and/or transparent SVG, rendering it into the
+     * sprite cache if required. Returns a nullptr if the sprite could not be created.
+     */
+    const QgsMarkerSpriteCache::Sprite *svgSprite( const QString &path, double size, const QColor &fillColor, const QColor &strokeColor,
+        double strokeWidth, double angle, QgsSymbolRenderContext &context );
+
+    //! Cache of pre-rendered rotated or transparent markers
+    QgsMarkerSpriteCache mSpriteCache;
+
 };
 
 
@@ -45,8 +45,6 @@ QgsSvgCacheEntry::QgsSvgCacheEntry()
   , stroke( Qt::black )
   , image( nullptr )
   , picture( nullptr )
-  , nextEntry( nullptr )
-  , previousEntry( nullptr )
 {
 }
 
@@ -59,8 +57,6 @@ QgsSvgCacheEntry::QgsSvgCacheEntry( const QString &p, double s, double ow, doubl
   , stroke( ou )
   , image( nullptr )
   , picture( nullptr )
-  , nextEntry( nullptr )
-  , previousEntry( nullptr )
 {
 }
 
@@ -86,134 +82,225 @@ int QgsSvgCacheEntry::dataSize() const
   }
   if ( image )
   {
-    size += ( image->width() * image->height() * 32 );
+    size += image->width() * image->height() * 4;
   }
   return size;
 }
 
 QgsSvgCache::QgsSvgCache( QObject *parent )
   : QObject( parent )
-  , mTotalSize( 0 )
-  , mLeastRecentEntry( nullptr )
-  , mMostRecentEntry( nullptr )
 {
+  mMaximumSizes[SvgContent] = 10000000;
+  mMaximumSizes[Picture] = 10000000;
+  mMaximumSizes[Image] = 40000000;
   mMissingSvg = QStringLiteral( "<svg width='10' height='10'><text x='5' y='10' font-size='10' text-anchor='middle'>?</text></svg>" ).toLatin1();
 }
 
 QgsSvgCache::~QgsSvgCache()
 {
-  qDeleteAll( mEntryLookup );
+  for ( int i = 0; i < SHARD_COUNT; ++i )
+  {
+    qDeleteAll( mShards[i].entries );
+  }
 }
 
 
 QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                 double widthScaleFactor, bool &fitsInCache )
 {
-  QMutexLocker locker( &mMutex );
-
   fitsInCache = true;
-  QgsSvgCacheEntry *currentEntry = cacheEntry( file, size, fill, stroke, strokeWidth, widthScaleFactor );
+  Shard &shard = shardForEntry( file, size, fill, stroke, strokeWidth, widthScaleFactor );
+
+  {
+    // fast path - the image has already been rendered, so other threads can read it concurrently
+    QReadLocker locker( &shard.lock );
+    QgsSvgCacheEntry *currentEntry = findEntry( shard, file, size, fill, stroke, strokeWidth, widthScaleFactor );
+    if ( currentEntry && currentEntry->image )
+    {
+      touchEntry( shard, currentEntry );
+      mHits.ref();
+      return *( currentEntry->image );
+    }
+  }
+
+  QWriteLocker locker( &shard.lock );
+  QgsSvgCacheEntry *currentEntry = cacheEntry( shard, file, size, fill, stroke, strokeWidth, widthScaleFactor );
 
   //if current entry image is 0: cache image for entry
   // checks to see if image will fit into cache
   //update stats for memory usage
   if ( !currentEntry->image )
   {
+    mMisses.ref();
     QSvgRenderer r( currentEntry->svgContent );
     double hwRatio = 1.0;
     if ( r.viewBoxF().width() > 0 )
     {
       hwRatio = r.viewBoxF().height() / r.viewBoxF().width();
     }
-    long cachedDataSize = 0;
-    cachedDataSize += currentEntry->svgContent.size();
-    cachedDataSize += static_cast< int >( currentEntry->size * currentEntry->size * hwRatio * 32 );
-    if ( cachedDataSize > MAXIMUM_SIZE / 2 )
+    qint64 cachedDataSize = static_cast< qint64 >( currentEntry->size * currentEntry->size * hwRatio * 4 );
+    if ( cachedDataSize > mMaximumSizes[Image] / SHARD_COUNT / 2 )
     {
       fitsInCache = false;
-      delete currentEntry->image;
-      currentEntry->image = nullptr;
-      //currentEntry->image = new QImage( 0, 0 );
 
       // instead cache picture
       if ( !currentEntry->picture )
       {
         cachePicture( currentEntry, false );
       }
+      trimShard( shard );
+      return QImage();
     }
     else
     {
       cacheImage( currentEntry );
     }
-    trimToMaximumSize();
+  }
+  else
+  {
+    mHits.ref();
   }
 
-  return *( currentEntry->image );
+  QImage image = *( currentEntry->image );
+  trimShard( shard );
+  return image;
 }
 
 QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor, bool forceVectorOutput )
 {
-  QMutexLocker locker( &mMutex );
+  Shard &shard = shardForEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
 
-  QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
+  {
+    QReadLocker locker( &shard.lock );
+    QgsSvgCacheEntry *currentEntry = findEntry( shard, path, size, fill, stroke, strokeWidth, widthScaleFactor );
+    if ( currentEntry && currentEntry->picture )
+    {
+      touchEntry( shard, currentEntry );
+      mHits.ref();
+      return *( currentEntry->picture );
+    }
+  }
+
+  QWriteLocker locker( &shard.lock );
+  QgsSvgCacheEntry *currentEntry = cacheEntry( shard, path, size, fill, stroke, strokeWidth, widthScaleFactor );
 
   //if current entry picture is 0: cache picture for entry
   //update stats for memory usage
   if ( !currentEntry->picture )
   {
+    mMisses.ref();
     cachePicture( currentEntry, forceVectorOutput );
-    trimToMaximumSize();
+  }
+  else
+  {
+    mHits.ref();
   }
 
-  return *( currentEntry->picture );
+  QPicture picture = *( currentEntry->picture );
+  trimShard( shard );
+  return picture;
 }
 
 QByteArray QgsSvgCache::svgContent( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor )
 {
-  QMutexLocker locker( &mMutex );
+  Shard &shard = shardForEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
 
-  QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
+  {
+    QReadLocker locker( &shard.lock );
+    QgsSvgCacheEntry *currentEntry = findEntry( shard, path, size, fill, stroke, strokeWidth, widthScaleFactor );
+    if ( currentEntry )
+    {
+      touchEntry( shard, currentEntry );
+      mHits.ref();
+      return currentEntry->svgContent;
+    }
+  }
 
-  return currentEntry->svgContent;
+  QWriteLocker locker( &shard.lock );
+  mMisses.ref();
+  QgsSvgCacheEntry *currentEntry = cacheEntry( shard, path, size, fill, stroke, strokeWidth, widthScaleFactor );
+  QByteArray content = currentEntry->svgContent;
+  trimShard( shard );
+  return content;
 }
 
 QSizeF QgsSvgCache::svgViewboxSize( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth, double widthScaleFactor )
 {
-  QMutexLocker locker( &mMutex );
+  Shard &shard = shardForEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
 
-  QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
+  {
+    QReadLocker locker( &shard.lock );
+    QgsSvgCacheEntry *currentEntry = findEntry( shard, path, size, fill, stroke, strokeWidth, widthScaleFactor );
+    if ( currentEntry )
+    {
+      touchEntry( shard, currentEntry );
+      mHits.ref();
+      return currentEntry->viewboxSize;
+    }
+  }
 
-  return currentEntry->viewboxSize;
+  QWriteLocker locker( &shard.lock );
+  mMisses.ref();
+  QgsSvgCacheEntry *currentEntry = cacheEntry( shard, path, size, fill, stroke, strokeWidth, widthScaleFactor );
+  QSizeF viewboxSize = currentEntry->viewboxSize;
+  trimShard( shard );
+  return viewboxSize;
 }
 
-QgsSvgCacheEntry *QgsSvgCache::insertSvg( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
-    double widthScaleFactor )
+void QgsSvgCache::setMaximumSize( QgsSvgCache::CacheDataType type, qint64 bytes )
 {
-  QgsSvgCacheEntry *entry = new QgsSvgCacheEntry( path, size, strokeWidth, widthScaleFactor, fill, stroke );
-
-  replaceParamsAndCacheSvg( entry );
-
-  mEntryLookup.insert( path, entry );
-
-  //insert to most recent place in entry list
-  if ( !mMostRecentEntry ) //inserting first entry
+  mMaximumSizes[type] = bytes;
+  for ( int i = 0; i < SHARD_COUNT; ++i )
   {
-    mLeastRecentEntry = entry;
-    mMostRecentEntry = entry;
-    entry->previousEntry = nullptr;
-    entry->nextEntry = nullptr;
+    QWriteLocker locker( &mShards[i].lock );
+    trimShard( mShards[i] );
   }
-  else
+}
+
+qint64 QgsSvgCache::maximumSize( QgsSvgCache::CacheDataType type ) const
+{
+  return mMaximumSizes[type];
+}
+
+qint64 QgsSvgCache::totalSize( QgsSvgCache::CacheDataType type ) const
+{
+  qint64 size = 0;
+  for ( int i = 0; i < SHARD_COUNT; ++i )
   {
-    entry->previousEntry = mMostRecentEntry;
-    entry->nextEntry = nullptr;
-    mMostRecentEntry->nextEntry = entry;
-    mMostRecentEntry = entry;
+    QReadLocker locker( &mShards[i].lock );
+    size += mShards[i].sizes[type];
   }
+  return size;
+}
+
+QgsSvgCache::Shard &QgsSvgCache::shardForEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
+    double widthScaleFactor )
+{
+  uint hash = qHash( path );
+  hash = 31 * hash + qHash( size );
+  hash = 31 * hash + fill.rgba();
+  hash = 31 * hash + stroke.rgba();
+  hash = 31 * hash + qHash( strokeWidth );
+  hash = 31 * hash + qHash( widthScaleFactor );
+  return mShards[ hash & ( SHARD_COUNT - 1 )];
+}
 
-  trimToMaximumSize();
+QgsSvgCache::Shard &QgsSvgCache::shardForEntry( const QgsSvgCacheEntry *entry )
+{
+  return shardForEntry( entry->path, entry->size, entry->fill, entry->stroke, entry->strokeWidth, entry->widthScaleFactor );
+}
+
+QgsSvgCacheEntry *QgsSvgCache::insertSvg( Shard &shard, const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
+    double widthScaleFactor )
+{
+  QgsSvgCacheEntry *entry = new QgsSvgCacheEntry( path, size, strokeWidth, widthScaleFactor, fill, stroke );
+
+  replaceParamsAndCacheSvg( entry );
+
+  shard.entries.insert( path, entry );
+  touchEntry( shard, entry );
   return entry;
 }
 
@@ -303,7 +390,7 @@ void QgsSvgCache::replaceParamsAndCacheSvg( QgsSvgCacheEntry *entry )
   entry->svgContent.replace( "\n<tspan", "<tspan" );
   entry->svgContent.replace( "</tspan>\n", "</tspan>" );
 
-  mTotalSize += entry->svgContent.size();
+  shardForEntry( entry ).sizes[SvgContent] += entry->svgContent.size();
 }
 
 double QgsSvgCache::calcSizeScaleFactor( QgsSvgCacheEntry *entry, const QDomElement &docElem, QSizeF &viewboxSize ) const
@@ -482,8 +569,13 @@ void QgsSvgCache::cacheImage( QgsSvgCacheEntry *entry )
     return;
   }
 
-  delete entry->image;
-  entry->image = nullptr;
+  Shard &shard = shardForEntry( entry );
+  if ( entry->image )
+  {
+    shard.sizes[Image] -= imageSize( entry );
+    delete entry->image;
+    entry->image = nullptr;
+  }
 
   QSvgRenderer r( entry->svgContent );
   double hwRatio = 1.0;
@@ -521,7 +613,7 @@ void QgsSvgCache::cacheImage( QgsSvgCacheEntry *entry )
   }
 
   entry->image = image;
-  mTotalSize += ( image->width() * image->height() * 32 );
+  shard.sizes[Image] += imageSize( entry );
 }
 
 void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput )
@@ -532,8 +624,13 @@ void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput
     return;
   }
 
-  delete entry->picture;
-  entry->picture = nullptr;
+  Shard &shard = shardForEntry( entry );
+  if ( entry->picture )
+  {
+    shard.sizes[Picture] -= entry->picture->size();
+    delete entry->picture;
+    entry->picture = nullptr;
+  }
 
   //correct QPictures dpi correction
   QPicture *picture = new QPicture();
@@ -554,49 +651,40 @@ void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput
   QPainter p( picture );
   r.render( &p, rect );
   entry->picture = picture;
-  mTotalSize += entry->picture->size();
+  shard.sizes[Picture] += entry->picture->size();
 }
 
-QgsSvgCacheEntry *QgsSvgCache::cacheEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
-    double widthScaleFactor )
+QgsSvgCacheEntry *QgsSvgCache::findEntry( const Shard &shard, const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
+    double widthScaleFactor ) const
 {
-  //search entries in mEntryLookup
-  QgsSvgCacheEntry *currentEntry = nullptr;
-  QList<QgsSvgCacheEntry *> entries = mEntryLookup.values( path );
-
-  QList<QgsSvgCacheEntry *>::iterator entryIt = entries.begin();
-  for ( ; entryIt != entries.end(); ++entryIt )
+  QMultiHash< QString, QgsSvgCacheEntry * >::const_iterator entryIt = shard.entries.constFind( path );
+  for ( ; entryIt != shard.entries.constEnd() && entryIt.key() == path; ++entryIt )
   {
-    QgsSvgCacheEntry *cacheEntry = *entryIt;
+    QgsSvgCacheEntry *cacheEntry = entryIt.value();
     if ( qgsDoubleNear( cacheEntry->size, size ) && cacheEntry->fill == fill && cacheEntry->stroke == stroke &&
          qgsDoubleNear( cacheEntry->strokeWidth, strokeWidth ) && qgsDoubleNear( cacheEntry->widthScaleFactor, widthScaleFactor ) )
     {
-      currentEntry = cacheEntry;
-      break;
+      return cacheEntry;
     }
   }
+  return nullptr;
+}
+
+QgsSvgCacheEntry *QgsSvgCache::cacheEntry( Shard &shard, const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
+    double widthScaleFactor )
+{
+  //search entries in shard
+  QgsSvgCacheEntry *currentEntry = findEntry( shard, path, size, fill, stroke, strokeWidth, widthScaleFactor );
 
   //if not found: create new entry
   //cache and replace params in svg content
   if ( !currentEntry )
   {
-    currentEntry = insertSvg( path, size, fill, stroke, strokeWidth, widthScaleFactor );
+    currentEntry = insertSvg( shard, path, size, fill, stroke, strokeWidth, widthScaleFactor );
   }
   else
   {
-    takeEntryFromList( currentEntry );
-    if ( !mMostRecentEntry ) //list is empty
-    {
-      mMostRecentEntry = currentEntry;
-      mLeastRecentEntry = currentEntry;
-    }
-    else
-    {
-      mMostRecentEntry->nextEntry = currentEntry;
-      currentEntry->previousEntry = mMostRecentEntry;
-      currentEntry->nextEntry = nullptr;
-      mMostRecentEntry = currentEntry;
-    }
+    touchEntry( shard, currentEntry );
   }
 
   //debugging
@@ -605,6 +693,42 @@ QgsSvgCacheEntry *QgsSvgCache::cacheEntry( const QString &path, double size, con
   return currentEntry;
 }
 
+void QgsSvgCache::touchEntry( Shard &shard, QgsSvgCacheEntry *entry )
+{
+  // entries are used by several readers at once, which all update the list
+  QMutexLocker locker( &shard.listLock );
+  if ( entry == shard.mostRecentEntry )
+    return;
+
+  takeEntryFromList( shard, entry );
+  if ( shard.mostRecentEntry )
+    shard.mostRecentEntry->nextEntry = entry;
+  else
+    shard.leastRecentEntry = entry;
+  entry->previousEntry = shard.mostRecentEntry;
+  entry->nextEntry = nullptr;
+  shard.mostRecentEntry = entry;
+}
+
+void QgsSvgCache::takeEntryFromList( Shard &shard, QgsSvgCacheEntry *entry )
+{
+  if ( entry->previousEntry )
+    entry->previousEntry->nextEntry = entry->nextEntry;
+  else if ( shard.leastRecentEntry == entry )
+    shard.leastRecentEntry = entry->nextEntry;
+  if ( entry->nextEntry )
+    entry->nextEntry->previousEntry = entry->previousEntry;
+  else if ( shard.mostRecentEntry == entry )
+    shard.mostRecentEntry = entry->previousEntry;
+  entry->previousEntry = nullptr;
+  entry->nextEntry = nullptr;
+}
+
+qint64 QgsSvgCache::imageSize( const QgsSvgCacheEntry *entry )
+{
+  return entry->image ? static_cast< qint64 >( entry->image->width() ) * entry->image->height() * 4 : 0;
+}
+
 void QgsSvgCache::replaceElemParams( QDomElement &elem, const QColor &fill, const QColor &stroke, double strokeWidth )
 {
   if ( elem.isNull() )
@@ -871,69 +995,82 @@ void QgsSvgCache::containsElemParams( const QDomElement &elem, bool &hasFillPara
   }
 }
 
-void QgsSvgCache::removeCacheEntry( const QString &s, QgsSvgCacheEntry *entry )
+void QgsSvgCache::removeCacheEntry( Shard &shard, QgsSvgCacheEntry *entry )
 {
+  shard.sizes[SvgContent] -= entry->svgContent.size();
+  if ( entry->picture )
+    shard.sizes[Picture] -= entry->picture->size();
+  shard.sizes[Image] -= imageSize( entry );
+
+  shard.entries.remove( entry->path, entry );
+  takeEntryFromList( shard, entry );
   delete entry;
-  mEntryLookup.remove( s, entry );
 }
 
 void QgsSvgCache::printEntryList()
 {
   QgsDebugMsg( "****************svg cache entry list*************************" );
-  QgsDebugMsg( "Cache size: " + QString::number( mTotalSize ) );
-  QgsSvgCacheEntry *entry = mLeastRecentEntry;
-  while ( entry )
+  QgsDebugMsg( QStringLiteral( "Cache size: svg %1, pictures %2, images %3" ).arg( totalSize( SvgContent ) ).arg( totalSize( Picture ) ).arg( totalSize( Image ) ) );
+  QgsDebugMsg( QStringLiteral( "Hits: %1, misses %2, evictions %3" ).arg( hitCount() ).arg( missCount() ).arg( evictionCount() ) );
+  for ( int i = 0; i < SHARD_COUNT; ++i )
   {
-    QgsDebugMsg( "***Entry:" );
-    QgsDebugMsg( "File:" + entry->path );
-    QgsDebugMsg( "Size:" + QString::number( entry->size ) );
-    QgsDebugMsg( "Width scale factor" + QString::number( entry->widthScaleFactor ) );
-    entry = entry->nextEntry;
+    QReadLocker locker( &mShards[i].lock );
+    Q_FOREACH ( const QgsSvgCacheEntry *entry, mShards[i].entries )
+    {
+      QgsDebugMsg( "***Entry:" );
+      QgsDebugMsg( "File:" + entry->path );
+      QgsDebugMsg( "Size:" + QString::number( entry->size ) );
+      QgsDebugMsg( "Width scale factor" + QString::number( entry->widthScaleFactor ) );
+    }
   }
 }
 
-void QgsSvgCache::trimToMaximumSize()
+void QgsSvgCache::trimShard( Shard &shard )
 {
-  //only one entry in cache
-  if ( mLeastRecentEntry == mMostRecentEntry )
-  {
-    return;
-  }
-  QgsSvgCacheEntry *entry = mLeastRecentEntry;
-  while ( entry && ( mTotalSize > MAXIMUM_SIZE ) )
-  {
-    QgsSvgCacheEntry *bkEntry = entry;
-    entry = entry->nextEntry;
+  const qint64 maxSvgContent = mMaximumSizes[SvgContent] / SHARD_COUNT;
+  const qint64 maxPicture = mMaximumSizes[Picture] / SHARD_COUNT;
+  const qint64 maxImage = mMaximumSizes[Image] / SHARD_COUNT;
 
-    takeEntryFromList( bkEntry );
-    mEntryLookup.remove( bkEntry->path, bkEntry );
-    mTotalSize -= bkEntry->dataSize();
-    delete bkEntry;
-  }
-}
+  if ( shard.sizes[SvgContent] <= maxSvgContent && shard.sizes[Picture] <= maxPicture && shard.sizes[Image] <= maxImage )
+    return;
 
-void QgsSvgCache::takeEntryFromList( QgsSvgCacheEntry *entry )
-{
-  if ( !entry )
-  {
+  //only one entry in shard
+  if ( shard.entries.count() < 2 )
     return;
-  }
 
-  if ( entry->previousEntry )
-  {
-    entry->previousEntry->nextEntry = entry->nextEntry;
-  }
-  else
-  {
-    mLeastRecentEntry = entry->nextEntry;
-  }
-  if ( entry->nextEntry )
-  {
-    entry->nextEntry->previousEntry = entry->previousEntry;
-  }
-  else
+  // release only the type of data which is over budget, keeping the (cheap to store)
+  // svg content around so that re-rendering doesn't require parsing the file again.
+  // Never release the most recently used entry, it's about to be returned to the caller
+  QgsSvgCacheEntry *entry = shard.leastRecentEntry;
+  while ( entry && entry != shard.mostRecentEntry )
   {
-    mMostRecentEntry = entry->previousEntry;
+    QgsSvgCacheEntry *nextEntry = entry->nextEntry;
+    if ( shard.sizes[SvgContent] > maxSvgContent )
+    {
+      removeCacheEntry( shard, entry );
+      mEvictions.ref();
+      entry = nextEntry;
+      continue;
+    }
+
+    if ( shard.sizes[Image] > maxImage && entry->image )
+    {
+      shard.sizes[Image] -= imageSize( entry );
+      delete entry->image;
+      entry->image = nullptr;
+      mEvictions.ref();
+    }
+    if ( shard.sizes[Picture] > maxPicture && entry->picture )
+    {
+      shard.sizes[Picture] -= entry->picture->size();
+      delete entry->picture;
+      entry->picture = nullptr;
+      mEvictions.ref();
+    }
+
+    if ( shard.sizes[SvgContent] <= maxSvgContent && shard.sizes[Picture] <= maxPicture && shard.sizes[Image] <= maxImage )
+      break;
+    entry = nextEntry;
   }
 }
 
@@ -23,6 +23,8 @@
 #include <QMap>
 #include <QMultiHash>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInt>
 #include <QString>
 #include <QUrl>
 #include <QObject>
@@ -76,10 +78,6 @@ class CORE_EXPORT QgsSvgCacheEntry
     //content (with params replaced)
     QByteArray svgContent;
 
-    //keep entries on a least, sorted by last access
-    QgsSvgCacheEntry *nextEntry = nullptr;
-    QgsSvgCacheEntry *previousEntry = nullptr;
-
     //! Don't consider image, picture, last used timestamp for comparison
     bool operator==( const QgsSvgCacheEntry &other ) const;
     //! Return memory usage in bytes
@@ -90,6 +88,12 @@ class CORE_EXPORT QgsSvgCacheEntry
     QgsSvgCacheEntry( const QgsSvgCacheEntry &rh );
 #endif
 
+    //keep entries on a list, sorted by last access
+    QgsSvgCacheEntry *nextEntry = nullptr;
+    QgsSvgCacheEntry *previousEntry = nullptr;
+
+    friend class QgsSvgCache;
+
 };
 
 /** \ingroup core
@@ -106,6 +110,17 @@ class CORE_EXPORT QgsSvgCache : public QObject
 
   public:
 
+    /**
+     * Types of data stored in the cache, each of which has a separate size budget.
+     * \since QGIS 3.0
+     */
+    enum CacheDataType
+    {
+      SvgContent, //!< SVG content, with parameters replaced
+      Picture, //!< Rendered QPictures
+      Image //!< Rasterized images
+    };
+
     /**
      * Constructor for QgsSvgCache.
      */
@@ -189,52 +204,129 @@ class CORE_EXPORT QgsSvgCache : public QObject
     QByteArray svgContent( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                            double widthScaleFactor );
 
+    /**
+     * Sets the maximum size in bytes of cached data of the specified \a type. The
+     * least recently used data is released once the budget is exceeded.
+     * \see maximumSize()
+     * \since QGIS 3.0
+     */
+    void setMaximumSize( CacheDataType type, qint64 bytes );
+
+    /**
+     * Returns the maximum size in bytes of cached data of the specified \a type.
+     * \see setMaximumSize()
+     * \since QGIS 3.0
+     */
+    qint64 maximumSize( CacheDataType type ) const;
+
+    /**
+     * Returns the current total size in bytes of cached data of the specified \a type.
+     * \since QGIS 3.0
+     */
+    qint64 totalSize( CacheDataType type ) const;
+
+    /**
+     * Returns the number of requests which were satisfied by an existing cache entry.
+     * \see missCount()
+     * \see evictionCount()
+     * \since QGIS 3.0
+     */
+    int hitCount() const { return mHits.load(); }
+
+    /**
+     * Returns the number of requests which required the SVG to be parsed, rendered or rasterized.
+     * \see hitCount()
+     * \see evictionCount()
+     * \since QGIS 3.0
+     */
+    int missCount() const { return mMisses.load(); }
+
+    /**
+     * Returns the number of times cached data was released to keep the cache within its size budgets.
+     * \see hitCount()
+     * \see missCount()
+     * \since QGIS 3.0
+     */
+    int evictionCount() const { return mEvictions.load(); }
+
   signals:
     //! Emit a signal to be caught by qgisapp and display a msg on status bar
     void statusChanged( const QString  &statusQString );
 
   protected:
 
-    /** Creates new cache entry and returns pointer to it
-     * \param path Absolute path to SVG file
-     * \param size size of cached image
-     * \param fill color of fill
-     * \param stroke color of stroke
-     * \param strokeWidth width of stroke
-     * \param widthScaleFactor width scale factor
-     */
-    QgsSvgCacheEntry *insertSvg( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
-                                 double widthScaleFactor );
-
     void replaceParamsAndCacheSvg( QgsSvgCacheEntry *entry );
     void cacheImage( QgsSvgCacheEntry *entry );
     void cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput = false );
-    //! Returns entry from cache or creates a new entry if it does not exist already
-    QgsSvgCacheEntry *cacheEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
-                                  double widthScaleFactor );
-
-    //! Removes the least used items until the maximum size is under the limit
-    void trimToMaximumSize();
-
-    //Removes entry from the ordered list (but does not delete the entry itself)
-    void takeEntryFromList( QgsSvgCacheEntry *entry );
 
   private slots:
     void downloadProgress( qint64, qint64 );
 
   private:
-    //! Entry pointers accessible by file name
-    QMultiHash< QString, QgsSvgCacheEntry * > mEntryLookup;
-    //! Estimated total size of all images, pictures and svgContent
-    long mTotalSize;
 
-    //The svg cache keeps the entries on a double connected list, moving the current entry to the front.
-    //That way, removing entries for more space can start with the least used objects.
-    QgsSvgCacheEntry *mLeastRecentEntry = nullptr;
-    QgsSvgCacheEntry *mMostRecentEntry = nullptr;
+    /**
+     * A partition of the cache. Entries are assigned to shards by a hash of their path and
+     * rendering parameters, so that renders of different symbols don't contend for the same lock.
+     */
+    struct Shard
+    {
+      //! Protects the shard. Held for reading when returning already rendered data
+      mutable QReadWriteLock lock;
+      //! Protects the entry list when entries are used under a read lock
+      QMutex listLock;
+      //! Entry pointers accessible by file name
+      QMultiHash< QString, QgsSvgCacheEntry * > entries;
+      //! Total size in bytes of svg content, pictures and images in the shard
+      qint64 sizes[3] = { 0, 0, 0 };
+
+      //The shard keeps its entries on a double connected list, moving the current entry to the back.
+      //That way, removing entries for more space can start with the least used objects.
+      QgsSvgCacheEntry *leastRecentEntry = nullptr;
+      QgsSvgCacheEntry *mostRecentEntry = nullptr;
+    };
+
+    //! Number of shards, must be a power of two
+    static const int SHARD_COUNT = 8;
+
+    Shard mShards[SHARD_COUNT];
+
+    //! Maximum size in bytes of svg content, pictures and images
+    qint64 mMaximumSizes[3];
+
+    QAtomicInt mHits;
+    QAtomicInt mMisses;
+    QAtomicInt mEvictions;
+
+    //! Returns the shard for the entry matching the specified SVG path and parameters
+    Shard &shardForEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
+                          double widthScaleFactor );
+
+    //! Returns the shard holding an entry
+    Shard &shardForEntry( const QgsSvgCacheEntry *entry );
+
+    //! Returns matching entry from a shard, or nullptr if there is none. The shard must be locked.
+    QgsSvgCacheEntry *findEntry( const Shard &shard, const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
+                                 double widthScaleFactor ) const;
+
+    //! Returns entry from cache or creates a new entry if it does not exist already. The shard must be locked for writing.
+    QgsSvgCacheEntry *cacheEntry( Shard &shard, const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
+                                  double widthScaleFactor );
+
+    //! Creates new cache entry and returns pointer to it. The shard must be locked for writing.
+    QgsSvgCacheEntry *insertSvg( Shard &shard, const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
+                                 double widthScaleFactor );
+
+    //! Moves an entry to the most recently used end of the shard's entry list
+    void touchEntry( Shard &shard, QgsSvgCacheEntry *entry );
 
-    //! Maximum cache size
-    static const long MAXIMUM_SIZE = 20000000;
+    //! Removes an entry from the shard's entry list (but does not delete the entry itself). The shard must be locked for writing.
+    void takeEntryFromList( Shard &shard, QgsSvgCacheEntry *entry );
+
+    //! Releases the least recently used data in a shard until it fits its budgets. The shard must be locked for writing.
+    void trimShard( Shard &shard );
+
+    //! Returns the size in bytes of an entry's cached image
+    static qint64 imageSize( const QgsSvgCacheEntry *entry );
 
     //! Replaces parameters in elements of a dom node and calls method for all child nodes
     void replaceElemParams( QDomElement &elem, const QColor &fill, const QColor &stroke, double strokeWidth );
@@ -249,8 +341,8 @@ class CORE_EXPORT QgsSvgCache : public QObject
     //! Calculates scaling for rendered image sizes to SVG logical sizes
     double calcSizeScaleFactor( QgsSvgCacheEntry *entry, const QDomElement &docElem, QSizeF &viewboxSize ) const;
 
-    //! Release memory and remove cache entry from mEntryLookup
-    void removeCacheEntry( const QString &s, QgsSvgCacheEntry *entry );
+    //! Release memory and remove cache entry from its shard. The shard must be locked for writing.
+    void removeCacheEntry( Shard &shard, QgsSvgCacheEntry *entry );
 
     //! For debugging
     void printEntryList();
@@ -258,9 +350,6 @@ class CORE_EXPORT QgsSvgCache : public QObject
     //! SVG content to be rendered if SVG file was not found.
     QByteArray mMissingSvg;
 
-    //! Mutex to prevent concurrent access to the class from multiple threads at once (may corrupt the entries otherwise).
-    QMutex mMutex;
-
 };
 
 #endif // QGSSVGCACHE_H
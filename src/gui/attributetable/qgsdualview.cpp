@@ -283,6 +283,12 @@ void QgsDualView::initLayerCache( bool cacheGeometry )
     connect( mLayerCache, &QgsVectorLayerCache::invalidated, this, &QgsDualView::rebuildFullLayerCache );
     rebuildFullLayerCache();
   }
+  else
+  {
+    // features can be fetched again by id, so the cache can also be limited by the memory it uses
+    qint64 cacheMemory = settings.value( QStringLiteral( "qgis/attributeTableCacheMemory" ), 256 ).toLongLong();
+    mLayerCache->setCacheMemoryLimit( cacheMemory * 1024 * 1024 );
+  }
 }
 
 void QgsDualView::initModels( QgsMapCanvas *mapCanvas, const QgsFeatureRequest &request, bool loadFeatures )
@@ -28,6 +28,17 @@
 #include <QStringList>
 #include <QRegExp>
 #include <QUrl>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// Interval between lines recorded in the line offset index of memory mapped files
+static const long LINE_INDEX_INTERVAL = 256;
+
+// Minimum size of a chunk worth reading in parallel with other chunks
+static const qint64 MINIMUM_CHUNK_SIZE = 1024 * 1024;
 
 
 QgsDelimitedTextFile::QgsDelimitedTextFile( const QString &url )
@@ -35,6 +46,9 @@ QgsDelimitedTextFile::QgsDelimitedTextFile( const QString &url )
   , mEncoding( QStringLiteral( "UTF-8" ) )
   , mFile( nullptr )
   , mStream( nullptr )
+  , mMappedSize( 0 )
+  , mMappedStart( 0 )
+  , mMappedPos( 0 )
   , mUseWatcher( false )
   , mWatcher( nullptr )
   , mDefinitionValid( false )
@@ -75,9 +89,16 @@ void QgsDelimitedTextFile::close()
   }
   if ( mFile )
   {
+    // also unmaps the file contents
     delete mFile;
     mFile = nullptr;
   }
+  mMappedData = nullptr;
+  mMappedSize = 0;
+  mMappedStart = 0;
+  mMappedPos = 0;
+  mCodec = nullptr;
+  mLineOffsets.clear();
   if ( mWatcher )
   {
     delete mWatcher;
@@ -104,11 +125,48 @@ bool QgsDelimitedTextFile::open()
     }
     if ( mFile )
     {
-      mStream = new QTextStream( mFile );
-      if ( ! mEncoding.isEmpty() )
+      QTextCodec *codec = mEncoding.isEmpty() ? nullptr : QTextCodec::codecForName( mEncoding.toLatin1() );
+      if ( !codec )
+        codec = QTextCodec::codecForLocale();
+
+      // Memory map the file if lines can be split on the raw bytes, ie unless the
+      // file is encoded in UTF-16 or UTF-32 (either declared or detected from a byte
+      // order mark, as QTextStream would). A watched file is expected to be rewritten
+      // while it is open, and truncating a mapped file makes reading the map crash,
+      // so it is streamed instead.
+      int mib = codec->mibEnum();
+      bool wideEncoding = mib == 1013 || mib == 1014 || mib == 1015 || ( mib >= 1017 && mib <= 1019 );
+      const qint64 size = mFile->size();
+      const char *data = !mUseWatcher && !wideEncoding && size > 0 ? reinterpret_cast< const char * >( mFile->map( 0, size ) ) : nullptr;
+      if ( data && size >= 2 && ( ( data[0] == '\xFF' && data[1] == '\xFE' ) || ( data[0] == '\xFE' && data[1] == '\xFF' ) ) )
+      {
+        mFile->unmap( reinterpret_cast< uchar * >( const_cast< char * >( data ) ) );
+        data = nullptr;
+      }
+
+      if ( data )
       {
-        QTextCodec *codec =  QTextCodec::codecForName( mEncoding.toLatin1() );
-        mStream->setCodec( codec );
+        mMappedData = data;
+        mMappedSize = size;
+        mMappedStart = 0;
+        mCodec = codec;
+        if ( size >= 3 && data[0] == '\xEF' && data[1] == '\xBB' && data[2] == '\xBF' )
+        {
+          // UTF-8 byte order mark
+          mMappedStart = 3;
+          mCodec = QTextCodec::codecForName( "UTF-8" );
+        }
+        mMappedPos = mMappedStart;
+        mLineOffsets.clear();
+        mLineOffsets.append( mMappedStart );
+      }
+      else
+      {
+        mStream = new QTextStream( mFile );
+        if ( ! mEncoding.isEmpty() )
+        {
+          mStream->setCodec( codec );
+        }
       }
       if ( mUseWatcher )
       {
@@ -555,16 +613,15 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   if ( ! isValid() || ! open() ) return InvalidDefinition;
 
   // Reset the file pointer
-  mStream->seek( 0 );
-  mLineNumber = 0;
+  seekStart();
   mRecordNumber = -1;
   mRecordLineNumber = -1;
 
   // Skip header lines
+  QString buffer;
   for ( int i = mSkipLines; i-- > 0; )
   {
-    if ( mStream->readLine().isNull() ) return RecordEOF;
-    mLineNumber++;
+    if ( nextLine( buffer, false ) != RecordOk ) return RecordEOF;
   }
   // Read the column names
   Status result = RecordOk;
@@ -580,12 +637,22 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
 
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bool skipBlank )
 {
-  if ( ! mStream )
+  if ( ! mStream && ! mMappedData )
   {
     Status status = reset();
     if ( status != RecordOk ) return status;
   }
 
+  if ( mMappedData )
+  {
+    while ( readMappedLine( buffer ) )
+    {
+      if ( skipBlank && buffer.isEmpty() ) continue;
+      return RecordOk;
+    }
+    return RecordEOF;
+  }
+
   while ( ! mStream->atEnd() )
   {
     buffer = mStream->readLine();
@@ -599,15 +666,59 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
   return RecordEOF;
 }
 
+bool QgsDelimitedTextFile::readMappedLine( QString &buffer )
+{
+  if ( mMappedPos >= mMappedSize ) return false;
+
+  // Lines end with \n or \r\n, as for QTextStream::readLine()
+  const char *start = mMappedData + mMappedPos;
+  const qint64 available = mMappedSize - mMappedPos;
+  const char *end = static_cast< const char * >( memchr( start, '\n', static_cast< size_t >( available ) ) );
+  qint64 length = end ? end - start : available;
+  mMappedPos += end ? length + 1 : length;
+  if ( length > 0 && start[length - 1] == '\r' ) length--;
+
+  buffer = mCodec->toUnicode( start, static_cast< int >( length ) );
+  mLineNumber++;
+
+  // Index the start of the following line
+  if ( mLineNumber % LINE_INDEX_INTERVAL == 0 && mLineNumber / LINE_INDEX_INTERVAL == mLineOffsets.size() )
+  {
+    mLineOffsets.append( mMappedPos );
+  }
+  return true;
+}
+
+void QgsDelimitedTextFile::seekStart()
+{
+  if ( mMappedData )
+    mMappedPos = mMappedStart;
+  else
+    mStream->seek( 0 );
+  mLineNumber = 0;
+}
+
 bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 {
-  if ( ! mStream ) return false;
+  if ( ! mStream && ! mMappedData ) return false;
   if ( mLineNumber > nextLineNumber - 1 )
   {
     mRecordNumber = -1;
-    mStream->seek( 0 );
-    mLineNumber = 0;
+    seekStart();
   }
+
+  // Jump to the closest indexed line rather than reading every line up to it
+  if ( mMappedData )
+  {
+    long indexed = std::min( ( nextLineNumber - 1 ) / LINE_INDEX_INTERVAL, static_cast< long >( mLineOffsets.size() - 1 ) );
+    if ( indexed * LINE_INDEX_INTERVAL > mLineNumber )
+    {
+      mRecordNumber = -1;
+      mMappedPos = mLineOffsets.at( indexed );
+      mLineNumber = indexed * LINE_INDEX_INTERVAL;
+    }
+  }
+
   QString buffer;
   while ( mLineNumber < nextLineNumber - 1 )
   {
@@ -617,6 +728,123 @@ bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 
 }
 
+qint64 QgsDelimitedTextFile::position() const
+{
+  return mMappedData ? mMappedPos : -1;
+}
+
+static long countLines( const char *data, qint64 size )
+{
+  long count = 0;
+  const char *end = data + size;
+  while ( data < end )
+  {
+    data = static_cast< const char * >( memchr( data, '\n', static_cast< size_t >( end - data ) ) );
+    if ( !data ) break;
+    count++;
+    data++;
+  }
+  return count;
+}
+
+QList<QgsDelimitedTextFile::Chunk> QgsDelimitedTextFile::splitIntoChunks( qint64 maxChunkSize )
+{
+  QList<Chunk> chunks;
+  if ( ! mMappedData ) return chunks;
+
+  const qint64 remaining = mMappedSize - mMappedPos;
+  if ( remaining < 2 * MINIMUM_CHUNK_SIZE ) return chunks;
+  const qint64 chunkSize = std::max( maxChunkSize, MINIMUM_CHUNK_SIZE );
+  const int count = static_cast< int >( std::min( ( remaining + chunkSize - 1 ) / chunkSize, static_cast< qint64 >( std::numeric_limits<int>::max() ) ) );
+  if ( count < 2 ) return chunks;
+
+  // Chunks start at the line following an approximately even split of the bytes
+  QVector<qint64> offsets;
+  offsets << mMappedPos;
+  for ( int i = 1; i < count; ++i )
+  {
+    qint64 offset = mMappedPos + remaining * i / count;
+    if ( offset <= offsets.last() ) continue;
+    const char *newline = static_cast< const char * >( memchr( mMappedData + offset, '\n', static_cast< size_t >( mMappedSize - offset ) ) );
+    if ( !newline ) break;
+    offset = newline + 1 - mMappedData;
+    if ( offset > offsets.last() && offset < mMappedSize ) offsets << offset;
+  }
+  offsets << mMappedSize;
+
+  // Count the lines in each chunk in parallel to find the line numbers at which they start
+  QList< QFuture<long> > lineCounts;
+  for ( int i = 0; i < offsets.size() - 1; ++i )
+  {
+    lineCounts << QtConcurrent::run( countLines, mMappedData + offsets.at( i ), offsets.at( i + 1 ) - offsets.at( i ) );
+  }
+
+  long lineNumber = mLineNumber;
+  for ( int i = 0; i < lineCounts.size(); ++i )
+  {
+    Chunk chunk;
+    chunk.offset = offsets.at( i );
+    chunk.startLineNumber = lineNumber;
+    lineNumber += lineCounts[i].result();
+    chunk.endLineNumber = i == lineCounts.size() - 1 ? std::numeric_limits<long>::max() : lineNumber;
+    chunks << chunk;
+  }
+  return chunks;
+}
+
+QgsDelimitedTextFile *QgsDelimitedTextFile::chunkReader( const Chunk &chunk ) const
+{
+  QgsDelimitedTextFile *reader = new QgsDelimitedTextFile();
+  reader->mFileName = mFileName;
+  reader->mEncoding = mEncoding;
+  reader->mParser = mParser;
+  reader->mDefinitionValid = mDefinitionValid;
+  reader->mType = mType;
+  reader->mUseHeader = mUseHeader;
+  reader->mDiscardEmptyFields = mDiscardEmptyFields;
+  reader->mTrimFields = mTrimFields;
+  reader->mSkipLines = mSkipLines;
+  reader->mMaxFields = mMaxFields;
+  reader->mMaxNameLength = mMaxNameLength;
+  reader->mDelimRegexp = mDelimRegexp;
+  reader->mAnchoredRegexp = mAnchoredRegexp;
+  reader->mDelimChars = mDelimChars;
+  reader->mQuoteChar = mQuoteChar;
+  reader->mEscapeChar = mEscapeChar;
+  reader->mFieldNames = mFieldNames;
+
+  if ( ! reader->open() || ! reader->mMappedData || chunk.offset > reader->mMappedSize )
+  {
+    delete reader;
+    return nullptr;
+  }
+
+  reader->mMappedPos = chunk.offset;
+  reader->mLineNumber = chunk.startLineNumber;
+  // Count the records read from the chunk, but not the field names
+  reader->mRecordNumber = 0;
+  reader->mMaxRecordNumber = 0;
+  reader->mMaxFieldCount = 0;
+  // The line index is only valid if built from the start of the file
+  reader->mLineOffsets.clear();
+  return reader;
+}
+
+void QgsDelimitedTextFile::mergeChunk( const QgsDelimitedTextFile *reader )
+{
+  // Continue from the end of the chunk, as if it had been read by this file
+  if ( mRecordNumber >= 0 )
+  {
+    mRecordNumber += reader->mMaxRecordNumber;
+    if ( mRecordNumber > mMaxRecordNumber ) mMaxRecordNumber = mRecordNumber;
+  }
+  if ( reader->mMaxFieldCount > mMaxFieldCount ) mMaxFieldCount = reader->mMaxFieldCount;
+  mMappedPos = reader->mMappedPos;
+  mLineNumber = reader->mLineNumber;
+  mRecordLineNumber = reader->mRecordLineNumber;
+  mHoldCurrentRecord = false;
+}
+
 void QgsDelimitedTextFile::appendField( QStringList &record, QString field, bool quoted )
 {
   if ( mMaxFields > 0 && record.size() >= mMaxFields ) return;
@@ -20,6 +20,7 @@
 
 #include <QStringList>
 #include <QRegExp>
+#include <QVector>
 #include <QUrl>
 #include <QObject>
 
@@ -27,6 +28,7 @@ class QgsFeature;
 class QgsField;
 class QFile;
 class QFileSystemWatcher;
+class QTextCodec;
 class QTextStream;
 
 
@@ -65,6 +67,10 @@ class QTextStream;
 *   The field is ignored for csv and whitespace
 * - quoteChar, optional, a single character used for quoting plain fields
 * - escapeChar, optional, a single character used for escaping (may be the same as quoteChar)
+*
+* Files in an encoding compatible with ASCII line endings are memory mapped rather than read
+* through a QTextStream. This allows records to be located through an index of line offsets,
+* and the file to be split into chunks which can be read in parallel (see splitIntoChunks()).
 */
 
 // Note: this has been implemented as a single class rather than a set of classes based
@@ -94,6 +100,17 @@ class QgsDelimitedTextFile : public QObject
       DelimTypeRegexp
     };
 
+    //! A range of lines of the file, which can be read independently of the rest of the file
+    struct Chunk
+    {
+      //! Byte offset of the first line of the chunk
+      qint64 offset;
+      //! Number of lines preceding the chunk
+      long startLineNumber;
+      //! Number of the last line of the chunk
+      long endLineNumber;
+    };
+
     explicit QgsDelimitedTextFile( const QString &url = QString() );
 
     virtual ~QgsDelimitedTextFile();
@@ -275,6 +292,41 @@ class QgsDelimitedTextFile : public QObject
      */
     Status reset();
 
+    /** Return the number of lines read so far, including lines
+     *  skipped and lines which are part of multi-line records
+     */
+    long lineNumber() const { return mLineNumber; }
+
+    /** Return the byte offset of the next line to read, or -1 if the
+     *  file is not memory mapped
+     */
+    qint64 position() const;
+
+    /** Split the remainder of the file, from the current read position,
+     *  into chunks of about maxChunkSize bytes starting on line boundaries.
+     *  Note that a chunk boundary may fall within a multi-line record.  Returns
+     *  an empty list if the file cannot be split, e.g., if it is not memory
+     *  mapped (as for watched files) or too small to be worth reading in parallel.
+     *  \param maxChunkSize The approximate maximum size of a chunk in bytes
+     */
+    QList<Chunk> splitIntoChunks( qint64 maxChunkSize );
+
+    /** Create a reader for the lines of a chunk.  The reader uses the same
+     *  definition and field names as this file, and is positioned at the start
+     *  of the chunk.  It can be used from another thread than this file.
+     *  The caller takes ownership of the returned reader.  Returns a nullptr
+     *  if the file cannot be memory mapped.
+     *  \param chunk The chunk, as returned by splitIntoChunks()
+     */
+    QgsDelimitedTextFile *chunkReader( const Chunk &chunk ) const;
+
+    /** Continue reading from the end of a chunk read by a chunk reader,
+     *  adding its records to the record count and maximum field count of this
+     *  file.  The chunk must start at the current read position of this file.
+     *  \param reader A reader returned by chunkReader()
+     */
+    void mergeChunk( const QgsDelimitedTextFile *reader );
+
     /** Return a string defining the type of the delimiter as a string
      *  \returns type The delimiter type as a string
      */
@@ -346,6 +398,14 @@ class QgsDelimitedTextFile : public QObject
      */
     Status nextLine( QString &buffer, bool skipBlank = false );
 
+    /** Read the next line from the memory mapped file.  Returns false at the
+     * end of the file.
+     */
+    bool readMappedLine( QString &buffer );
+
+    //! Move to the first line of the file
+    void seekStart();
+
     /** Set the next line to read from the file.
      */
     bool setNextLineNumber( long nextLineNumber );
@@ -362,6 +422,14 @@ class QgsDelimitedTextFile : public QObject
     QString mEncoding;
     QFile *mFile = nullptr;
     QTextStream *mStream = nullptr;
+    // Memory mapped file contents, used instead of mStream if available
+    const char *mMappedData = nullptr;
+    qint64 mMappedSize;
+    qint64 mMappedStart;
+    qint64 mMappedPos;
+    QTextCodec *mCodec = nullptr;
+    // Offsets of the start of every LINE_INDEX_INTERVAL'th line in the mapped file
+    QVector<qint64> mLineOffsets;
     bool mUseWatcher;
     QFileSystemWatcher *mWatcher = nullptr;
 
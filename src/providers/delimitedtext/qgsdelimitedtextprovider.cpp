@@ -27,6 +27,10 @@
 #include <QRegExp>
 #include <QUrl>
 #include <QUrlQuery>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <limits>
 
 #include "qgsapplication.h"
 #include "qgsdataprovider.h"
@@ -60,6 +64,27 @@ static const QString TEXT_PROVIDER_DESCRIPTION = QStringLiteral( "Delimited text
 
 static const int SUBSET_ID_THRESHOLD_FACTOR = 10;
 
+// Maximum size of the chunks a file is split into to scan it in parallel, maximum
+// number of chunks read ahead of the one being processed, and number of records
+// read at a time when scanning a file which cannot be split. The first two bound
+// the memory used by the parsed records waiting to be processed.
+
+static const qint64 MAXIMUM_SCAN_CHUNK_SIZE = 4 * 1024 * 1024;
+static const int MAXIMUM_SCAN_CHUNKS_AHEAD = 8;
+static const int SCAN_BATCH_SIZE = 1000;
+
+struct QgsDelimitedTextProvider::ScannedRecord
+{
+  QgsDelimitedTextFile::Status status;
+  int recordId;
+  QStringList parts;
+  // Geometry read from the WKT field, or point read from the X and Y fields
+  QgsGeometry geometry;
+  bool wktHasPrefix;
+  QgsPointXY point;
+  bool pointOk;
+};
+
 QRegExp QgsDelimitedTextProvider::sWktPrefixRegexp( "^\\s*(?:\\d+\\s+|SRID\\=\\d+\\;)", Qt::CaseInsensitive );
 QRegExp QgsDelimitedTextProvider::sCrdDmsRegexp( "^\\s*(?:([-+nsew])\\s*)?(\\d{1,3})(?:[^0-9.]+([0-5]?\\d))?[^0-9.]+([0-5]?\\d(?:\\.\\d+)?)[^0-9.]*([-+nsew])?\\s*$", Qt::CaseInsensitive );
 
@@ -402,7 +427,6 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   //
   // Also build subset and spatial indexes.
 
-  QStringList parts;
   long nEmptyRecords = 0;
   long nBadFormatRecords = 0;
   long nIncompatibleGeometry = 0;
@@ -417,21 +441,24 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   QList<bool> couldBeDouble;
   bool foundFirstGeometry = false;
 
-  while ( true )
+  // Records are read and their geometries parsed by scanRecords(), possibly in parallel,
+  // and then processed here in file order.
+
+  auto processRecord = [&]( ScannedRecord & record )
   {
-    QgsDelimitedTextFile::Status status = mFile->nextRecord( parts );
-    if ( status == QgsDelimitedTextFile::RecordEOF ) break;
-    if ( status != QgsDelimitedTextFile::RecordOk )
+    if ( record.status != QgsDelimitedTextFile::RecordOk )
     {
       nBadFormatRecords++;
-      recordInvalidLine( tr( "Invalid record format at line %1" ) );
-      continue;
+      recordInvalidLine( tr( "Invalid record format at line %1" ), record.recordId );
+      return;
     }
+    QStringList &parts = record.parts;
+
     // Skip over empty records
     if ( recordIsEmpty( parts ) )
     {
       nEmptyRecords++;
-      continue;
+      return;
     }
 
     // Check geometries are valid
@@ -446,14 +473,12 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
       }
       else
       {
-        // Get the wkt - confirm it is valid, get the type, and
+        // Confirm the wkt is valid, get the type, and
         // if compatible with the rest of file, add to the extents
 
-        QString sWkt = parts[mWktFieldIndex];
-        QgsGeometry geom;
-        if ( !mWktHasPrefix && sWkt.indexOf( sWktPrefixRegexp ) >= 0 )
+        const QgsGeometry &geom = record.geometry;
+        if ( record.wktHasPrefix )
           mWktHasPrefix = true;
-        geom = geomFromWkt( sWkt, mWktHasPrefix );
 
         if ( !geom.isNull() )
         {
@@ -480,7 +505,7 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
               if ( buildSpatialIndex )
               {
                 QgsFeature f;
-                f.setId( mFile->recordId() );
+                f.setId( record.recordId );
                 f.setGeometry( geom );
                 mSpatialIndex->insertFeature( f );
               }
@@ -496,14 +521,13 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
         {
           geomValid = false;
           nInvalidGeometry++;
-          recordInvalidLine( tr( "Invalid WKT at line %1" ) );
+          recordInvalidLine( tr( "Invalid WKT at line %1" ), record.recordId );
         }
       }
     }
     else if ( mGeomRep == GeomAsXy )
     {
-      // Get the x and y values, first checking to make sure they
-      // aren't null.
+      // Check the x and y values were not null.
 
       QString sX = mXFieldIndex < parts.size() ? parts[mXFieldIndex] : QString();
       QString sY = mYFieldIndex < parts.size() ? parts[mYFieldIndex] : QString();
@@ -514,10 +538,9 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
       }
       else
       {
-        QgsPointXY pt;
-        bool ok = pointFromXY( sX, sY, pt, mDecimalPoint, mXyDms );
+        const QgsPointXY &pt = record.point;
 
-        if ( ok )
+        if ( record.pointOk )
         {
           if ( foundFirstGeometry )
           {
@@ -535,7 +558,7 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
           if ( buildSpatialIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
           {
             QgsFeature f;
-            f.setId( mFile->recordId() );
+            f.setId( record.recordId );
             f.setGeometry( QgsGeometry::fromPoint( pt ) );
             mSpatialIndex->insertFeature( f );
           }
@@ -544,7 +567,7 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
         {
           geomValid = false;
           nInvalidGeometry++;
-          recordInvalidLine( tr( "Invalid X or Y fields at line %1" ) );
+          recordInvalidLine( tr( "Invalid X or Y fields at line %1" ), record.recordId );
         }
       }
     }
@@ -554,9 +577,9 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
       mNumberFeatures++;
     }
 
-    if ( ! geomValid ) continue;
+    if ( ! geomValid ) return;
 
-    if ( buildSubsetIndex ) mSubsetIndex.append( mFile->recordId() );
+    if ( buildSubsetIndex ) mSubsetIndex.append( record.recordId );
 
 
     // If we are going to use this record, then assess the potential types of each column
@@ -613,6 +636,63 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
         value.toDouble( &couldBeDouble[i] );
       }
     }
+  };
+
+  // Make sure the shared regular expressions are compiled before they are copied
+  // by the threads reading the file
+  sWktPrefixRegexp.isValid();
+  sCrdDmsRegexp.isValid();
+
+  mFile->reset();
+  QList<QgsDelimitedTextFile::Chunk> chunks = mFile->splitIntoChunks( MAXIMUM_SCAN_CHUNK_SIZE );
+  if ( chunks.isEmpty() )
+  {
+    QList<ScannedRecord> records;
+    do
+    {
+      records = scanRecords( mFile, std::numeric_limits<long>::max(), SCAN_BATCH_SIZE );
+      for ( ScannedRecord &record : records )
+        processRecord( record );
+    }
+    while ( records.size() == SCAN_BATCH_SIZE );
+  }
+  else
+  {
+    // Read a window of chunks ahead of the one being processed
+    const int window = std::min( std::max( QThread::idealThreadCount(), 1 ) + 1, MAXIMUM_SCAN_CHUNKS_AHEAD );
+    QList<QgsDelimitedTextFile *> readers;
+    QList< QFuture< QList<ScannedRecord> > > futures;
+    for ( int i = 0; i < chunks.size(); ++i )
+    {
+      for ( int j = readers.size(); j < chunks.size() && j <= i + window; ++j )
+      {
+        QgsDelimitedTextFile *reader = mFile->chunkReader( chunks.at( j ) );
+        readers << reader;
+        futures << ( reader ? QtConcurrent::run( this, &QgsDelimitedTextProvider::scanRecords, reader, chunks.at( j ).endLineNumber, -1 ) : QFuture< QList<ScannedRecord> >() );
+      }
+
+      QgsDelimitedTextFile *reader = readers.at( i );
+      QList<ScannedRecord> records;
+      if ( reader )
+        records = futures[i].result();
+      futures[i] = QFuture< QList<ScannedRecord> >();
+      readers[i] = nullptr;
+
+      if ( reader && chunks.at( i ).startLineNumber == mFile->lineNumber() )
+      {
+        mFile->mergeChunk( reader );
+      }
+      else
+      {
+        // The previous chunk ended with a record continuing into this chunk, or
+        // skipped blank lines into it, so read it again from where that record ended
+        records = scanRecords( mFile, chunks.at( i ).endLineNumber, -1 );
+      }
+      delete reader;
+
+      for ( ScannedRecord &record : records )
+        processRecord( record );
+    }
   }
 
   // Now create the attribute fields.  Field types are integer by preference,
@@ -715,6 +795,44 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
 }
 
+QList<QgsDelimitedTextProvider::ScannedRecord> QgsDelimitedTextProvider::scanRecords( QgsDelimitedTextFile *file, long endLineNumber, int maxRecords ) const
+{
+  QList<ScannedRecord> records;
+  QRegExp wktPrefixRegexp( sWktPrefixRegexp );
+
+  while ( records.size() != maxRecords && file->lineNumber() < endLineNumber )
+  {
+    ScannedRecord record;
+    record.status = file->nextRecord( record.parts );
+    if ( record.status == QgsDelimitedTextFile::RecordEOF ) break;
+    record.recordId = file->recordId();
+    record.wktHasPrefix = false;
+    record.pointOk = false;
+
+    if ( record.status == QgsDelimitedTextFile::RecordOk && ! recordIsEmpty( record.parts ) )
+    {
+      const QStringList &parts = record.parts;
+      if ( mGeomRep == GeomAsWkt && mWktFieldIndex < parts.size() && ! parts[mWktFieldIndex].isEmpty() )
+      {
+        // Removing the prefix from records which do not have one is harmless, so
+        // each record can be checked on its own
+        QString sWkt = parts[mWktFieldIndex];
+        record.wktHasPrefix = sWkt.indexOf( wktPrefixRegexp ) >= 0;
+        record.geometry = geomFromWkt( sWkt, record.wktHasPrefix );
+      }
+      else if ( mGeomRep == GeomAsXy )
+      {
+        QString sX = mXFieldIndex < parts.size() ? parts[mXFieldIndex] : QString();
+        QString sY = mYFieldIndex < parts.size() ? parts[mYFieldIndex] : QString();
+        if ( ! sX.isEmpty() || ! sY.isEmpty() )
+          record.pointOk = pointFromXY( sX, sY, record.point, mDecimalPoint, mXyDms );
+      }
+    }
+    records.append( record );
+  }
+  return records;
+}
+
 // rescanFile.  Called if something has changed file definition, such as
 // selecting a subset, the file has been changed by another program, etc
 
@@ -927,11 +1045,11 @@ bool QgsDelimitedTextProvider::recordIsEmpty( QStringList &record )
   return true;
 }
 
-void QgsDelimitedTextProvider::recordInvalidLine( const QString &message )
+void QgsDelimitedTextProvider::recordInvalidLine( const QString &message, int recordId )
 {
   if ( mInvalidLines.size() < mMaxInvalidLines )
   {
-    mInvalidLines.append( message.arg( mFile->recordId() ) );
+    mInvalidLines.append( message.arg( recordId ) );
   }
   else
   {
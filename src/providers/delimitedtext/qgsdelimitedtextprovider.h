@@ -191,12 +191,22 @@ class QgsDelimitedTextProvider : public QgsVectorDataProvider
 
     void scanFile( bool buildIndexes );
 
+    //! A record read while scanning the file, with its geometry parsed
+    struct ScannedRecord;
+
+    /** Read records from a file, parsing their geometry.  Reading stops at the end of the
+     * file, after the record containing line endLineNumber, or after maxRecords records.
+     * This is safe to call from another thread than the provider's, on a file which is not
+     * used elsewhere.
+     */
+    QList<ScannedRecord> scanRecords( QgsDelimitedTextFile *file, long endLineNumber, int maxRecords ) const;
+
     //some of these methods const, as they need to be called from const methods such as extent()
     void rescanFile() const;
     void resetCachedSubset() const;
     void resetIndexes() const;
     void clearInvalidLines() const;
-    void recordInvalidLine( const QString &message );
+    void recordInvalidLine( const QString &message, int recordId );
     void reportErrors( const QStringList &messages = QStringList(), bool showDialog = false ) const;
     static bool recordIsEmpty( QStringList &record );
     void setUriParameter( const QString &parameter, const QString &value );
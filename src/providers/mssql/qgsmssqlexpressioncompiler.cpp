@@ -23,6 +23,25 @@ QgsMssqlExpressionCompiler::QgsMssqlExpressionCompiler( QgsMssqlFeatureSource *s
 
 }
 
+QString QgsMssqlExpressionCompiler::compileAggregate( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldName )
+{
+  switch ( aggregate )
+  {
+    case QgsAggregateCalculator::Mean:
+      // avg of integers is truncated to an integer
+      return QStringLiteral( "AVG(CAST(%1 AS FLOAT))" ).arg( quotedIdentifier( fieldName ) );
+    case QgsAggregateCalculator::StDev:
+      return QStringLiteral( "STDEVP(%1)" ).arg( quotedIdentifier( fieldName ) );
+    case QgsAggregateCalculator::StDevSample:
+      return QStringLiteral( "STDEV(%1)" ).arg( quotedIdentifier( fieldName ) );
+    case QgsAggregateCalculator::Sum:
+      // the sum of integer columns overflows on large tables
+      return QStringLiteral( "COALESCE(SUM(CAST(%1 AS FLOAT)),0)" ).arg( quotedIdentifier( fieldName ) );
+    default:
+      return QgsSqlExpressionCompiler::compileAggregate( aggregate, fieldName );
+  }
+}
+
 QgsSqlExpressionCompiler::Result QgsMssqlExpressionCompiler::compileNode( const QgsExpressionNode *node, QString &result )
 {
   if ( node->nodeType() == QgsExpressionNode::ntBinaryOperator )
@@ -26,6 +26,8 @@ class QgsMssqlExpressionCompiler : public QgsSqlExpressionCompiler
 
     explicit QgsMssqlExpressionCompiler( QgsMssqlFeatureSource *source );
 
+    virtual QString compileAggregate( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldName ) override;
+
   protected:
     virtual Result compileNode( const QgsExpressionNode *node, QString &result ) override;
     virtual QString quotedValue( const QVariant &value, bool &ok ) override;
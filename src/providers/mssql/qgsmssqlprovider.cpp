@@ -46,6 +46,8 @@
 
 #include "qgsmssqldataitems.h"
 #include "qgsmssqlfeatureiterator.h"
+#include "qgsmssqlexpressioncompiler.h"
+#include "qgssettings.h"
 
 #ifdef HAVE_GUI
 #include "qgsmssqlsourceselect.h"
@@ -657,6 +659,70 @@ QSet<QVariant> QgsMssqlProvider::uniqueValues( int index, int limit ) const
   return uniqueValues;
 }
 
+QVariant QgsMssqlProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+                                      const QgsAggregateCalculator::AggregateParameters &parameters,
+                                      QgsExpressionContext *context, bool &ok ) const
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  if ( index < 0 || index >= mAttributeFields.count() )
+    return QVariant();
+
+  // only aggregates of numeric fields are guaranteed to match those calculated by QGIS
+  QgsField fld = mAttributeFields.at( index );
+  if ( !fld.isNumeric() )
+    return QVariant();
+
+  if ( !QgsSettings().value( QStringLiteral( "qgis/compileExpressions" ), true ).toBool() )
+    return QVariant();
+
+  QgsMssqlFeatureSource source( this );
+  QgsMssqlExpressionCompiler compiler( &source );
+  QString aggregateSql = compiler.compileAggregate( aggregate, fld.name() );
+  if ( aggregateSql.isEmpty() )
+    return QVariant();
+
+  QString sql = QStringLiteral( "select %1 from [%2].[%3]" ).arg( aggregateSql, mSchemaName, mTableName );
+
+  QStringList whereClauses;
+  if ( !mSqlWhereClause.isEmpty() )
+    whereClauses << QStringLiteral( "(%1)" ).arg( mSqlWhereClause );
+
+  if ( !parameters.filter.isEmpty() )
+  {
+    // the filter must be completely compiled, there is no way to double-check the features
+    QgsExpression filter( parameters.filter );
+    QgsMssqlExpressionCompiler filterCompiler( &source );
+    if ( filter.hasParserError() || filterCompiler.compile( &filter ) != QgsSqlExpressionCompiler::Complete )
+      return QVariant();
+
+    whereClauses << QStringLiteral( "(%1)" ).arg( filterCompiler.result() );
+  }
+
+  if ( !whereClauses.isEmpty() )
+    sql += QStringLiteral( " where %1" ).arg( whereClauses.join( QStringLiteral( " and " ) ) );
+
+  QSqlQuery query = QSqlQuery( mDatabase );
+  query.setForwardOnly( true );
+
+  if ( !query.exec( sql ) )
+  {
+    QgsDebugMsg( query.lastError().text() );
+    return QVariant();
+  }
+
+  if ( !query.isActive() || !query.next() )
+    return QVariant();
+
+  ok = true;
+  QVariant value = query.value( 0 );
+  if ( value.isNull() )
+    return QVariant();
+
+  return QVariant( value.toDouble() );
+}
+
 
 // update the extent, wkb type and srid for this layer
 void QgsMssqlProvider::UpdateStatistics( bool estimate ) const
@@ -67,6 +67,9 @@ class QgsMssqlProvider : public QgsVectorDataProvider
     virtual QVariant minimumValue( int index ) const override;
     virtual QVariant maximumValue( int index ) const override;
     virtual QSet<QVariant> uniqueValues( int index, int limit = -1 ) const override;
+    virtual QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+                                const QgsAggregateCalculator::AggregateParameters &parameters,
+                                QgsExpressionContext *context, bool &ok ) const override;
     virtual QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) const override;
 
     virtual QgsWkbTypes::Type wkbType() const override;
@@ -30,6 +30,11 @@
 #include <QTextCodec>
 #include <QFile>
 
+#include <algorithm>
+
+//! Largest number of OGR features read ahead by a single batch
+static const int MAXIMUM_BATCH_SIZE = 256;
+
 // using from provider:
 // - setRelevantFields(), mRelevantFieldsForNextFeature
 // - ogrLayer
@@ -123,6 +128,21 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
     mFetchGeometry = true;
   }
 
+  // resolve the requested attributes to OGR fields once, instead of for every feature
+  const QgsAttributeList readAttrs = ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+  mColumns.reserve( readAttrs.count() );
+  Q_FOREACH ( int idx, readAttrs )
+  {
+    if ( idx < 0 || idx >= mSource->mFields.count() )
+      continue;
+
+    AttributeColumn column;
+    column.attributeIndex = idx;
+    column.ogrIndex = mSource->mFirstFieldIsFid ? idx - 1 : idx;
+    column.type = mSource->mFields.at( idx ).type();
+    mColumns << column;
+  }
+
   // make sure we fetch just relevant fields
   // unless it's a VRT data source filtered by geometry as we don't know which
   // attributes make up the geometry and OGR won't fetch them to evaluate the
@@ -256,10 +276,36 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
     return false;
   }
 
-  OGRFeatureH fet;
+  while ( mFeatureBatchIndex >= mFeatureBatch.size() )
+  {
+    if ( !fetchBatch() )
+    {
+      close();
+      return false;
+    }
+  }
+
+  feature = mFeatureBatch.at( mFeatureBatchIndex++ );
+  feature.setValid( true );
+  geometryToDestinationCrs( feature, mTransform );
+  return true;
+}
 
-  while ( ( fet = OGR_L_GetNextFeature( ogrLayer ) ) )
+bool QgsOgrFeatureIterator::fetchBatch()
+{
+  // the batch vector keeps its allocation from one batch to the next, and
+  // batches start small and grow, so that requests for just a few features
+  // do not read more than necessary
+  mFeatureBatch.resize( 0 );
+  mFeatureBatchIndex = 0;
+
+  int read = 0;
+  OGRFeatureH fet;
+  while ( read < mBatchSize && ( fet = OGR_L_GetNextFeature( ogrLayer ) ) )
   {
+    read++;
+
+    QgsFeature feature;
     if ( !readFeature( fet, feature ) )
       continue;
     else
@@ -268,15 +314,11 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
     if ( !mFilterRect.isNull() && !feature.hasGeometry() )
       continue;
 
-    // we have a feature, end this cycle
-    feature.setValid( true );
-    geometryToDestinationCrs( feature, mTransform );
-    return true;
-
-  } // while
+    mFeatureBatch.append( feature );
+  }
 
-  close();
-  return false;
+  mBatchSize = std::min( mBatchSize * 2, MAXIMUM_BATCH_SIZE );
+  return read > 0;
 }
 
 
@@ -288,6 +330,9 @@ bool QgsOgrFeatureIterator::rewind()
   OGR_L_ResetReading( ogrLayer );
 
   mFilterFidsIt = mFilterFids.constBegin();
+  mFeatureBatch.resize( 0 );
+  mFeatureBatchIndex = 0;
+  mBatchSize = 1;
 
   return true;
 }
@@ -316,27 +361,33 @@ bool QgsOgrFeatureIterator::close()
 
   mConn = nullptr;
   ogrLayer = nullptr;
+  mFeatureBatch.clear();
+  mFeatureBatchIndex = 0;
 
   mClosed = true;
   return true;
 }
 
 
-void QgsOgrFeatureIterator::getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const
+void QgsOgrFeatureIterator::readAttributes( OGRFeatureH ogrFet, QgsFeature &feature ) const
 {
-  if ( mSource->mFirstFieldIsFid && attindex == 0 )
+  const int fieldCount = OGR_F_GetFieldCount( ogrFet );
+  for ( const AttributeColumn &column : mColumns )
   {
-    f.setAttribute( 0, static_cast<qint64>( OGR_F_GetFID( ogrFet ) ) );
-    return;
-  }
+    if ( column.ogrIndex < 0 )
+    {
+      feature.setAttribute( column.attributeIndex, static_cast<qint64>( OGR_F_GetFID( ogrFet ) ) );
+      continue;
+    }
 
-  int attindexWithoutFid = ( mSource->mFirstFieldIsFid ) ? attindex - 1 : attindex;
-  bool ok = false;
-  QVariant value = QgsOgrUtils::getOgrFeatureAttribute( ogrFet, mSource->mFieldsWithoutFid, attindexWithoutFid, mSource->mEncoding, &ok );
-  if ( !ok )
-    return;
+    if ( column.ogrIndex >= fieldCount )
+      continue;
 
-  f.setAttribute( attindex, value );
+    bool ok = false;
+    QVariant value = QgsOgrUtils::getOgrFeatureAttribute( ogrFet, column.ogrIndex, column.type, mSource->mEncoding, &ok );
+    if ( ok )
+      feature.setAttribute( column.attributeIndex, value );
+  }
 }
 
 bool QgsOgrFeatureIterator::readFeature( OGRFeatureH fet, QgsFeature &feature ) const
@@ -392,22 +443,7 @@ bool QgsOgrFeatureIterator::readFeature( OGRFeatureH fet, QgsFeature &feature )
   }
 
   // fetch attributes
-  if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
-  {
-    QgsAttributeList attrs = mRequest.subsetOfAttributes();
-    for ( QgsAttributeList::const_iterator it = attrs.constBegin(); it != attrs.constEnd(); ++it )
-    {
-      getFeatureAttribute( fet, feature, *it );
-    }
-  }
-  else
-  {
-    // all attributes
-    for ( int idx = 0; idx < mSource->mFields.count(); ++idx )
-    {
-      getFeatureAttribute( fet, feature, idx );
-    }
-  }
+  readAttributes( fet, feature );
 
   return true;
 }
@@ -426,8 +462,6 @@ QgsOgrFeatureSource::QgsOgrFeatureSource( const QgsOgrProvider *p )
   , mCrs( p->crs() )
   , mWkbType( p->wkbType() )
 {
-  for ( int i = ( p->mFirstFieldIsFid ) ? 1 : 0; i < mFields.size(); i++ )
-    mFieldsWithoutFid.append( mFields.at( i ) );
   QgsOgrConnPool::instance()->ref( mDataSource );
 }
 
@@ -19,6 +19,8 @@
 #include "qgsogrconnpool.h"
 #include "qgsfields.h"
 
+#include <QVector>
+
 #include <ogr_api.h>
 
 class QgsOgrFeatureIterator;
@@ -40,7 +42,6 @@ class QgsOgrFeatureSource : public QgsAbstractFeatureSource
     QTextCodec *mEncoding = nullptr;
     QgsFields mFields;
     bool mFirstFieldIsFid;
-    QgsFields mFieldsWithoutFid;
     OGRwkbGeometryType mOgrGeometryTypeFilter;
     QString mDriverName;
     QgsCoordinateReferenceSystem mCrs;
@@ -66,10 +67,27 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
 
   private:
 
+    //! A requested attribute, resolved to the OGR field it is read from
+    struct AttributeColumn
+    {
+      //! Attribute index
+      int attributeIndex;
+      //! OGR field index, or -1 if the attribute holds the feature id
+      int ogrIndex;
+      //! Attribute type
+      QVariant::Type type;
+    };
+
     bool readFeature( OGRFeatureH fet, QgsFeature &feature ) const;
 
-    //! Get an attribute associated with a feature
-    void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const;
+    //! Reads the requested attributes of an OGR feature
+    void readAttributes( OGRFeatureH ogrFet, QgsFeature &feature ) const;
+
+    /**
+     * Reads the next batch of features ahead of the current one. Returns false
+     * if the end of the layer has been reached.
+     */
+    bool fetchBatch();
 
     QgsOgrConn *mConn = nullptr;
     OGRLayerH ogrLayer;
@@ -87,6 +105,18 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
     QgsRectangle mFilterRect;
     QgsCoordinateTransform mTransform;
 
+    //! Requested attributes, resolved once for all features
+    QVector<AttributeColumn> mColumns;
+
+    //! Features read ahead of the current one
+    QVector<QgsFeature> mFeatureBatch;
+
+    //! Index in mFeatureBatch of the next feature to return
+    int mFeatureBatchIndex = 0;
+
+    //! Number of OGR features read by the next batch
+    int mBatchSize = 1;
+
     bool fetchFeatureWithId( QgsFeatureId id, QgsFeature &feature ) const;
 };
 
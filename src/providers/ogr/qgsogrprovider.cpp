@@ -24,6 +24,7 @@ email                : sherman at mrcc.com
 #include "qgsfeedback.h"
 #include "qgssettings.h"
 #include "qgsapplication.h"
+#include "qgsdatasourcemetadatacache.h"
 #include "qgsdataitem.h"
 #include "qgsdataprovider.h"
 #include "qgsfeature.h"
@@ -34,6 +35,8 @@ email                : sherman at mrcc.com
 #include "qgsdataitemprovider.h"
 #include "qgsogrdataitems.h"
 #include "qgsgeopackagedataitems.h"
+#include "qgsexpression.h"
+#include "qgssqliteexpressioncompiler.h"
 #include "qgswkbtypes.h"
 
 #ifdef HAVE_GUI
@@ -1058,6 +1061,19 @@ QgsRectangle QgsOgrProvider::extent() const
   {
     mExtent = new OGREnvelope();
 
+    QgsDataSourceMetadataCache *metadataCache = QgsApplication::dataSourceMetadataCache();
+    const QString changeToken = mForceRecomputeExtent ? QString() : metadataChangeToken();
+    QgsRectangle cachedExtent = metadataCache->metadata( dataSourceUri(), changeToken ).extent;
+    if ( !cachedExtent.isNull() )
+    {
+      mExtent->MinX = cachedExtent.xMinimum();
+      mExtent->MinY = cachedExtent.yMinimum();
+      mExtent->MaxX = cachedExtent.xMaximum();
+      mExtent->MaxY = cachedExtent.yMaximum();
+      mExtentRect = cachedExtent;
+      return mExtentRect;
+    }
+
     // get the extent_ (envelope) of the layer
     QgsDebugMsg( "Starting get extent" );
 
@@ -1107,6 +1123,10 @@ QgsRectangle QgsOgrProvider::extent() const
     }
 
     QgsDebugMsg( "Finished get extent" );
+
+    // an empty layer has an inverted extent, which is not worth caching
+    if ( mExtent->MinX <= mExtent->MaxX && mExtent->MinY <= mExtent->MaxY )
+      metadataCache->setExtent( dataSourceUri(), changeToken, QgsRectangle( mExtent->MinX, mExtent->MinY, mExtent->MaxX, mExtent->MaxY ) );
   }
 
   mExtentRect.set( mExtent->MinX, mExtent->MinY, mExtent->MaxX, mExtent->MaxY );
@@ -1151,6 +1171,38 @@ void QgsOgrProvider::invalidateCachedExtent( bool bForceRecomputeExtent )
   mForceRecomputeExtent = bForceRecomputeExtent;
   delete mExtent;
   mExtent = nullptr;
+
+  if ( bForceRecomputeExtent )
+    QgsApplication::dataSourceMetadataCache()->invalidate( dataSourceUri() );
+}
+
+QString QgsOgrProvider::metadataChangeToken() const
+{
+  QFileInfo fi( mFilePath );
+  if ( !fi.isFile() )
+    return QString();
+
+  QStringList files;
+  files << mFilePath;
+  if ( ogrDriverName == QLatin1String( "ESRI Shapefile" ) )
+  {
+    // deleting features only flags them in the dbf
+    files << fi.path() + '/' + fi.completeBaseName() + ".dbf";
+  }
+  else if ( ogrDriverName == QLatin1String( "GPKG" ) || ogrDriverName == QLatin1String( "SQLite" ) )
+  {
+    // changes may still be in the write-ahead log
+    files << mFilePath + "-wal";
+  }
+
+  QStringList stamps;
+  Q_FOREACH ( const QString &file, files )
+  {
+    QFileInfo info( file );
+    if ( info.exists() )
+      stamps << QStringLiteral( "%1:%2" ).arg( info.size() ).arg( info.lastModified().toMSecsSinceEpoch() );
+  }
+  return stamps.join( ',' );
 }
 
 size_t QgsOgrProvider::layerCount() const
@@ -1411,6 +1463,7 @@ bool QgsOgrProvider::addFeatures( QgsFeatureList &flist, Flags flags )
     returnvalue = false;
   }
 
+  QgsApplication::dataSourceMetadataCache()->invalidate( dataSourceUri() );
   recalculateFeatureCount();
 
   if ( returnvalue )
@@ -1930,6 +1983,7 @@ bool QgsOgrProvider::deleteFeatures( const QgsFeatureIds &id )
     returnvalue = false;
   }
 
+  QgsApplication::dataSourceMetadataCache()->invalidate( dataSourceUri() );
   recalculateFeatureCount();
 
   clearMinMaxCache();
@@ -3148,6 +3202,81 @@ QVariant QgsOgrProvider::maximumValue( int index ) const
   return value;
 }
 
+QVariant QgsOgrProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+                                    const QgsAggregateCalculator::AggregateParameters &parameters,
+                                    QgsExpressionContext *context, bool &ok ) const
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  if ( !mValid || index < 0 || index >= mAttributeFields.count() )
+    return QVariant();
+
+  // only GeoPackage and SQLite data sources are queried with the SQLite dialect,
+  // which the compiled aggregates and filters are written in
+  if ( ogrDriverName != QLatin1String( "GPKG" ) && ogrDriverName != QLatin1String( "SQLite" ) )
+    return QVariant();
+
+  // a subset string which is a complete SELECT statement can't be combined with the aggregate
+  if ( mSubsetString.startsWith( QLatin1String( "SELECT " ), Qt::CaseInsensitive ) )
+    return QVariant();
+
+  // only aggregates of numeric fields are guaranteed to match those calculated by QGIS
+  QgsField fld = mAttributeFields.at( index );
+  if ( !fld.isNumeric() )
+    return QVariant();
+
+  if ( !QgsSettings().value( QStringLiteral( "qgis/compileExpressions" ), true ).toBool() )
+    return QVariant();
+
+  QgsSQLiteExpressionCompiler compiler( mAttributeFields );
+  QString aggregateSql = compiler.compileAggregate( aggregate, fld.name() );
+  if ( aggregateSql.isEmpty() )
+    return QVariant();
+
+  QStringList whereClauses;
+  if ( !mSubsetString.isEmpty() )
+    whereClauses << QStringLiteral( "(%1)" ).arg( mSubsetString );
+
+  if ( !parameters.filter.isEmpty() )
+  {
+    // the filter must be completely compiled, there is no way to double-check the features
+    QgsExpression filter( parameters.filter );
+    QgsSQLiteExpressionCompiler filterCompiler( mAttributeFields );
+    if ( filter.hasParserError() || filterCompiler.compile( &filter ) != QgsSqlExpressionCompiler::Complete )
+      return QVariant();
+
+    whereClauses << QStringLiteral( "(%1)" ).arg( filterCompiler.result() );
+  }
+
+  QByteArray sql = "SELECT " + textEncoding()->fromUnicode( aggregateSql );
+  sql += " FROM " + quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrLayer ) ) );
+  if ( !whereClauses.isEmpty() )
+    sql += " WHERE " + textEncoding()->fromUnicode( whereClauses.join( QStringLiteral( " AND " ) ) );
+
+  QgsDebugMsg( QString( "SQL: %1" ).arg( textEncoding()->toUnicode( sql ) ) );
+  OGRLayerH l = OGR_DS_ExecuteSQL( ogrDataSource, sql.constData(), nullptr, nullptr );
+  if ( !l )
+  {
+    QgsDebugMsg( QString( "Failed to execute SQL: %1" ).arg( textEncoding()->toUnicode( sql ) ) );
+    return QVariant();
+  }
+
+  QVariant value;
+  OGRFeatureH f = OGR_L_GetNextFeature( l );
+  if ( f )
+  {
+    ok = true;
+    if ( OGR_F_IsFieldSetAndNotNull( f, 0 ) )
+      value = OGR_F_GetFieldAsDouble( f, 0 );
+    OGR_F_Destroy( f );
+  }
+
+  OGR_DS_ReleaseResultSet( ogrDataSource, l );
+
+  return value;
+}
+
 QByteArray QgsOgrProvider::quotedIdentifier( const QByteArray &field ) const
 {
   return QgsOgrProviderUtils::quotedIdentifier( field, ogrDriverName );
@@ -3388,6 +3517,15 @@ void QgsOgrProvider::recalculateFeatureCount()
     return;
   }
 
+  QgsDataSourceMetadataCache *metadataCache = QgsApplication::dataSourceMetadataCache();
+  const QString changeToken = metadataChangeToken();
+  long cachedCount = metadataCache->metadata( dataSourceUri(), changeToken ).featureCount;
+  if ( cachedCount >= 0 )
+  {
+    mFeaturesCounted = cachedCount;
+    return;
+  }
+
   OGRGeometryH filter = OGR_L_GetSpatialFilter( ogrLayer );
   if ( filter )
   {
@@ -3434,6 +3572,9 @@ void QgsOgrProvider::recalculateFeatureCount()
     OGR_L_SetSpatialFilter( ogrLayer, filter );
   }
 
+  if ( mFeaturesCounted >= 0 )
+    metadataCache->setFeatureCount( dataSourceUri(), changeToken, mFeaturesCounted );
+
   QgsOgrConnPool::instance()->invalidateConnections( dataSourceUri() );
 }
 
@@ -3730,6 +3871,7 @@ void QgsOgrProvider::close()
 
 void QgsOgrProvider::reloadData()
 {
+  QgsApplication::dataSourceMetadataCache()->invalidate( dataSourceUri() );
   forceReload();
   close();
   open( OpenModeSameAsCurrent );
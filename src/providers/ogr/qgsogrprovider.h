@@ -104,6 +104,9 @@ class QgsOgrProvider : public QgsVectorDataProvider
     QVariant minimumValue( int index ) const override;
     QVariant maximumValue( int index ) const override;
     virtual QSet< QVariant > uniqueValues( int index, int limit = -1 ) const override;
+    virtual QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+                                const QgsAggregateCalculator::AggregateParameters &parameters,
+                                QgsExpressionContext *context, bool &ok ) const override;
     virtual QStringList uniqueStringsMatching( int index, const QString &substring, int limit = -1,
         QgsFeedback *feedback = nullptr ) const override;
 
@@ -152,6 +155,13 @@ class QgsOgrProvider : public QgsVectorDataProvider
     //! Invalidate extent and optionally force its low level recomputation
     void invalidateCachedExtent( bool bForceRecomputeExtent );
 
+    /**
+     * Returns a token identifying the current state of the data source files, used to
+     * validate entries of the data source metadata cache. Returns an empty string
+     * if the data source is not file based.
+     */
+    QString metadataChangeToken() const;
+
     enum OpenMode
     {
       OpenModeInitial,
@@ -27,11 +27,16 @@
 #include "qgsvectordataprovider.h"
 #include "qgswkbtypes.h"
 #include "qgssettings.h"
+#include "qgspostgresprovider.h"
 
 #include <QApplication>
+#include <QDateTime>
 #include <QThread>
+#include <QtEndian>
 
 #include <climits>
+#include <cmath>
+#include <limits>
 
 // for htonl
 #ifdef Q_OS_WIN
@@ -1035,7 +1040,7 @@ PGresult *QgsPostgresConn::PQexec( const QString &query, bool logError )
   if ( res )
   {
     int errorStatus = PQresultStatus( res );
-    if ( errorStatus != PGRES_COMMAND_OK && errorStatus != PGRES_TUPLES_OK )
+    if ( errorStatus != PGRES_COMMAND_OK && errorStatus != PGRES_TUPLES_OK && errorStatus != PGRES_COPY_IN )
     {
       if ( logError )
       {
@@ -1185,6 +1190,18 @@ PGresult *QgsPostgresConn::PQexecPrepared( const QString &stmtName, const QStrin
   return res;
 }
 
+int QgsPostgresConn::PQputCopyData( const QByteArray &data )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyData( mConn, data.constData(), data.size() );
+}
+
+int QgsPostgresConn::PQputCopyEnd( const QString &errorMessage )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyEnd( mConn, errorMessage.isNull() ? nullptr : errorMessage.toUtf8().constData() );
+}
+
 void QgsPostgresConn::PQfinish()
 {
   Q_ASSERT( mConn );
@@ -1365,6 +1382,302 @@ QString QgsPostgresConn::fieldExpression( const QgsField &fld, QString expr )
   }
 }
 
+QString QgsPostgresConn::binaryFieldExpression( const QgsField &fld )
+{
+  QString type = fld.typeName();
+  if ( type.startsWith( '_' ) )
+    type = type.mid( 1 );
+
+  bool binary = type == QLatin1String( "bool" ) ||
+                type == QLatin1String( "int2" ) ||
+                type == QLatin1String( "int4" ) ||
+                type == QLatin1String( "int8" ) ||
+                type == QLatin1String( "float4" ) ||
+                type == QLatin1String( "float8" ) ||
+                type == QLatin1String( "numeric" ) ||
+                type == QLatin1String( "date" ) ||
+                type == QLatin1String( "uuid" );
+
+  if ( type == QLatin1String( "timestamp" ) )
+  {
+    // servers built with floating point datetimes use a different binary representation
+    binary = qstrcmp( ::PQparameterStatus( mConn, "integer_datetimes" ), "on" ) == 0;
+  }
+
+  if ( fld.typeName().startsWith( '_' ) )
+  {
+    // text arrays have the same binary and text element representations
+    binary = binary ||
+             type == QLatin1String( "text" ) ||
+             type == QLatin1String( "varchar" ) ||
+             type == QLatin1String( "bpchar" );
+  }
+
+  if ( !binary )
+    return fieldExpression( fld );
+
+  // the cast makes sure that domains are returned with the type oid of their base type
+  return QStringLiteral( "%1::%2" ).arg( quotedIdentifier( fld.name() ), fld.typeName() );
+}
+
+// type oids from pg_type.h
+static const Oid BOOLOID = 16;
+static const Oid INT8OID = 20;
+static const Oid INT2OID = 21;
+static const Oid INT4OID = 23;
+static const Oid TEXTOID = 25;
+static const Oid FLOAT4OID = 700;
+static const Oid FLOAT8OID = 701;
+static const Oid BPCHAROID = 1042;
+static const Oid VARCHAROID = 1043;
+static const Oid DATEOID = 1082;
+static const Oid TIMESTAMPOID = 1114;
+static const Oid NUMERICOID = 1700;
+static const Oid UUIDOID = 2950;
+
+// binary values are sent in network byte order
+template <typename T> static T binaryValue( const char *p )
+{
+  return qFromBigEndian<T>( reinterpret_cast< const uchar * >( p ) );
+}
+
+// widening a float exposes its binary noise (0.1 -> 0.100000001490116), so
+// round it to the fewest significant digits which still give back the same float
+static double floatValue( float value )
+{
+  if ( value == 0 || !std::isfinite( value ) )
+    return value;
+
+  const int exponent = static_cast< int >( std::floor( std::log10( std::fabs( value ) ) ) );
+  for ( int precision = 6; precision < 9; ++precision )
+  {
+    const int shift = precision - 1 - exponent;
+    const double scale = std::pow( 10.0, std::abs( shift ) );
+    const double rounded = shift >= 0 ? std::round( value * scale ) / scale : std::round( value / scale ) * scale;
+    if ( static_cast< float >( rounded ) == value )
+      return rounded;
+  }
+  return value;
+}
+
+static double numericValue( const char *p, int len )
+{
+  if ( len < 8 )
+    return std::numeric_limits<double>::quiet_NaN();
+
+  const int ndigits = binaryValue<qint16>( p );
+  const int weight = binaryValue<qint16>( p + 2 );
+  const quint16 sign = binaryValue<quint16>( p + 4 );
+  const char *digits = p + 8;
+
+  if ( sign == 0xC000 || len < 8 + 2 * ndigits )
+    return std::numeric_limits<double>::quiet_NaN();
+  else if ( sign == 0xD000 )
+    return std::numeric_limits<double>::infinity();
+  else if ( sign == 0xF000 )
+    return -std::numeric_limits<double>::infinity();
+  else if ( ndigits == 0 )
+    return 0.0;
+
+  // digits are in base 10000, the first one is multiplied by 10000^weight.
+  // When the digits fit into the mantissa and the decimal exponent is small,
+  // a single multiplication or division by an exact power of ten gives a
+  // correctly rounded result. Otherwise let the string parser do the work.
+  static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                          1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+                                        };
+  const quint64 maxMantissa = Q_UINT64_C( 1 ) << 53;
+  quint64 mantissa = 0;
+  int i = 0;
+  for ( ; i < ndigits && mantissa < ( maxMantissa - 10000 ) / 10000; ++i )
+  {
+    mantissa = mantissa * 10000 + binaryValue<quint16>( digits + 2 * i );
+  }
+
+  const int exponent = 4 * ( weight - ndigits + 1 );
+  double value;
+  if ( i == ndigits && exponent >= -22 && exponent <= 22 )
+  {
+    value = exponent >= 0 ? mantissa * POWERS_OF_TEN[exponent] : mantissa / POWERS_OF_TEN[-exponent];
+  }
+  else
+  {
+    QByteArray text;
+    text.reserve( 4 * ndigits + 8 );
+    for ( i = 0; i < ndigits; ++i )
+      text += QByteArray::number( binaryValue<quint16>( digits + 2 * i ) ).rightJustified( 4, '0' );
+    text += 'e' + QByteArray::number( exponent );
+    value = text.toDouble();
+  }
+  return sign == 0x4000 ? -value : value;
+}
+
+static QVariant binaryScalarValue( Oid type, const char *p, int len )
+{
+  switch ( type )
+  {
+    case BOOLOID:
+      return len == 1 ? QVariant( *p != 0 ) : QVariant();
+
+    case INT2OID:
+      return len == 2 ? QVariant( static_cast< int >( binaryValue<qint16>( p ) ) ) : QVariant();
+
+    case INT4OID:
+      return len == 4 ? QVariant( binaryValue<qint32>( p ) ) : QVariant();
+
+    case INT8OID:
+      return len == 8 ? QVariant( binaryValue<qint64>( p ) ) : QVariant();
+
+    case FLOAT4OID:
+    {
+      if ( len != 4 )
+        return QVariant();
+      quint32 bits = binaryValue<quint32>( p );
+      float value;
+      memcpy( &value, &bits, sizeof( value ) );
+      return floatValue( value );
+    }
+
+    case FLOAT8OID:
+    {
+      if ( len != 8 )
+        return QVariant();
+      quint64 bits = binaryValue<quint64>( p );
+      double value;
+      memcpy( &value, &bits, sizeof( value ) );
+      return value;
+    }
+
+    case NUMERICOID:
+      return numericValue( p, len );
+
+    case DATEOID:
+    {
+      if ( len != 4 )
+        return QVariant();
+      // days since 2000-01-01, with the extremes representing +/-infinity
+      qint32 days = binaryValue<qint32>( p );
+      if ( days == std::numeric_limits<qint32>::max() || days == std::numeric_limits<qint32>::min() )
+        return QVariant( QVariant::Date );
+      return QDate( 2000, 1, 1 ).addDays( days );
+    }
+
+    case TIMESTAMPOID:
+    {
+      if ( len != 8 )
+        return QVariant();
+      // microseconds since 2000-01-01 00:00:00, with the extremes representing +/-infinity
+      qint64 usecs = binaryValue<qint64>( p );
+      if ( usecs == std::numeric_limits<qint64>::max() || usecs == std::numeric_limits<qint64>::min() )
+        return QVariant( QVariant::DateTime );
+      const qint64 usecsPerDay = Q_INT64_C( 86400000000 );
+      qint64 days = usecs / usecsPerDay;
+      qint64 usecsOfDay = usecs % usecsPerDay;
+      if ( usecsOfDay < 0 )
+      {
+        days--;
+        usecsOfDay += usecsPerDay;
+      }
+      // timestamps carry no time zone, so build them from the wall clock time
+      return QDateTime( QDate( 2000, 1, 1 ).addDays( days ), QTime( 0, 0 ).addMSecs( static_cast< int >( usecsOfDay / 1000 ) ) );
+    }
+
+    case UUIDOID:
+    {
+      if ( len != 16 )
+        return QVariant();
+      QByteArray hex = QByteArray::fromRawData( p, 16 ).toHex();
+      hex.insert( 20, '-' ).insert( 16, '-' ).insert( 12, '-' ).insert( 8, '-' );
+      return QString::fromLatin1( hex );
+    }
+
+    case TEXTOID:
+    case VARCHAROID:
+    case BPCHAROID:
+      return QString::fromUtf8( p, len );
+
+    default:
+      return QVariant();
+  }
+}
+
+static QVariant binaryArrayValue( const QgsField &fld, const char *p, int len )
+{
+  // header: number of dimensions, has nulls flag, element type and
+  // (size, lower bound) for each dimension, followed by the elements
+  // of all dimensions as (length, value) pairs
+  const char *end = p + len;
+  if ( len < 12 )
+    return QVariant( fld.type() );
+
+  const int ndim = binaryValue<qint32>( p );
+  const Oid elementType = binaryValue<quint32>( p + 8 );
+  p += 12;
+  if ( ndim < 0 || end - p < 8 * ndim )
+    return QVariant( fld.type() );
+
+  int count = ndim > 0 ? 1 : 0;
+  for ( int dim = 0; dim < ndim; ++dim )
+  {
+    count *= binaryValue<qint32>( p );
+    p += 8;
+  }
+
+  QVariantList values;
+  QStringList strings;
+  for ( int i = 0; i < count && end - p >= 4; ++i )
+  {
+    const int elementLength = binaryValue<qint32>( p );
+    p += 4;
+    if ( elementLength > end - p )
+      break;
+
+    QVariant value = elementLength < 0 ? QVariant() : binaryScalarValue( elementType, p, elementLength );
+    if ( elementLength > 0 )
+      p += elementLength;
+
+    if ( fld.type() == QVariant::StringList )
+    {
+      // NULL elements become null strings, as a QStringList cannot hold NULL values
+      strings << ( value.isValid() ? value.toString() : QString() );
+    }
+    else
+    {
+      if ( !value.isValid() || !value.convert( fld.subType() ) )
+        value = QVariant( fld.subType() );
+      values << value;
+    }
+  }
+
+  if ( fld.type() == QVariant::StringList )
+    return strings;
+  return values;
+}
+
+QVariant QgsPostgresConn::getBinaryValue( const QgsField &fld, QgsPostgresResult &queryResult, int row, int col )
+{
+  const Oid type = queryResult.PQftype( col );
+  if ( type == TEXTOID )
+  {
+    // fetched as text by binaryFieldExpression()
+    return QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+  }
+
+  if ( queryResult.PQgetisnull( row, col ) )
+    return QVariant( fld.type() );
+
+  const char *p = ::PQgetvalue( queryResult.result(), row, col );
+  const int len = ::PQgetlength( queryResult.result(), row, col );
+
+  if ( fld.type() == QVariant::List || fld.type() == QVariant::StringList )
+    return binaryArrayValue( fld, p, len );
+
+  QVariant value = binaryScalarValue( type, p, len );
+  if ( !value.isValid() || ( value.type() != fld.type() && !value.convert( fld.type() ) ) )
+    value = QVariant( fld.type() );
+  return value;
+}
+
 void QgsPostgresConn::deduceEndian()
 {
   // need to store the PostgreSQL endian format used in binary cursors
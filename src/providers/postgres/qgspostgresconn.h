@@ -252,6 +252,8 @@ class QgsPostgresConn : public QObject
     PGresult *PQgetResult();
     PGresult *PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes );
     PGresult *PQexecPrepared( const QString &stmtName, const QStringList &params );
+    int PQputCopyData( const QByteArray &data );
+    int PQputCopyEnd( const QString &errorMessage = QString() );
 
     bool begin();
     bool commit();
@@ -308,6 +310,17 @@ class QgsPostgresConn : public QObject
 
     QString fieldExpression( const QgsField &fld, QString expr = "%1" );
 
+    /** Returns the expression used to fetch a field from a binary cursor.
+     * Fields of types which can be decoded by getBinaryValue() are fetched
+     * in their binary representation, all others as text.
+     */
+    QString binaryFieldExpression( const QgsField &fld );
+
+    /** Returns the value of a field fetched from a binary cursor using
+     * binaryFieldExpression(), converted to the field's type.
+     */
+    static QVariant getBinaryValue( const QgsField &fld, QgsPostgresResult &queryResult, int row, int col );
+
     QString connInfo() const { return mConnInfo; }
 
     static const int GEOM_TYPE_SELECT_LIMIT;
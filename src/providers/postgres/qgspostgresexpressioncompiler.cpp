@@ -134,6 +134,22 @@ QStringList QgsPostgresExpressionCompiler::sqlArgumentsFromFunctionName( const Q
   return args;
 }
 
+QString QgsPostgresExpressionCompiler::compileAggregate( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldName )
+{
+  switch ( aggregate )
+  {
+    case QgsAggregateCalculator::Mean:
+      // avg of integers is numeric, no need for a lossy cast to real
+      return QStringLiteral( "avg(%1)" ).arg( quotedIdentifier( fieldName ) );
+    case QgsAggregateCalculator::StDev:
+      return QStringLiteral( "stddev_pop(%1)" ).arg( quotedIdentifier( fieldName ) );
+    case QgsAggregateCalculator::StDevSample:
+      return QStringLiteral( "stddev_samp(%1)" ).arg( quotedIdentifier( fieldName ) );
+    default:
+      return QgsSqlExpressionCompiler::compileAggregate( aggregate, fieldName );
+  }
+}
+
 QString QgsPostgresExpressionCompiler::castToReal( const QString &value ) const
 {
   return QStringLiteral( "((%1)::real)" ).arg( value );
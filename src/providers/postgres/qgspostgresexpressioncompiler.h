@@ -27,6 +27,8 @@ class QgsPostgresExpressionCompiler : public QgsSqlExpressionCompiler
 
     explicit QgsPostgresExpressionCompiler( QgsPostgresFeatureSource *source );
 
+    virtual QString compileAggregate( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldName ) override;
+
   protected:
 
     virtual QString quotedIdentifier( const QString &identifier ) override;
@@ -25,6 +25,15 @@
 
 #include <QElapsedTimer>
 #include <QObject>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+//! Largest number of rows fetched by a single FETCH statement
+static const int MAXIMUM_FETCH_ROWS = 10000;
+
+//! Approximate upper limit on the size of the values fetched by a single FETCH statement
+static const qint64 MAXIMUM_FETCH_BYTES = 8 * 1024 * 1024;
 
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
@@ -47,6 +56,10 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
     mIsTransactionConnection = true;
   }
 
+  // transaction connections are shared with other users, so they must not be
+  // kept busy by a background fetch
+  mPrefetchEnabled = !mIsTransactionConnection;
+
   if ( !mConn )
   {
     mClosed = true;
@@ -249,53 +262,35 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
 
   if ( mFeatureQueue.empty() && !mLastFetch )
   {
-    QElapsedTimer timer;
-    timer.start();
-
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+    // use the batch prefetched while the previous one was being decoded, if any
+    FetchBatch batch = mPrefetching ? mPrefetch.result() : fetchBatch( mFeatureQueueSize );
+    mPrefetch = QFuture<FetchBatch>();
+    mPrefetching = false;
 
-    lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+    QgsPostgresResult queryResult( batch.result );
+    if ( !batch.error.isEmpty() )
     {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, batch.error ), QObject::tr( "PostGIS" ) );
     }
 
-    QgsPostgresResult queryResult;
-    for ( ;; )
-    {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
-        break;
-
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
-      {
-        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
-      }
+    QgsDebugMsgLevel( QString( "fetched %1 of %2 features (%3 bytes) in %4 ms" ).arg( batch.rows ).arg( batch.requested ).arg( batch.bytes ).arg( batch.elapsed ), 4 );
 
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
+    mLastFetch = batch.rows < batch.requested;
+    updateFeatureQueueSize( batch );
 
-      mLastFetch = rows < mFeatureQueueSize;
-
-      for ( int row = 0; row < rows; row++ )
-      {
-        mFeatureQueue.enqueue( QgsFeature() );
-        getFeature( queryResult, row, mFeatureQueue.back() );
-      } // for each row in queue
-    }
-    unlock();
-
-    if ( timer.elapsed() > 500 && mFeatureQueueSize > 1 )
+    // request the next batch before decoding this one, so that the server
+    // and the network are kept busy while the rows are converted to features
+    if ( mPrefetchEnabled && !mLastFetch )
     {
-      mFeatureQueueSize /= 2;
+      mPrefetch = QtConcurrent::run( this, &QgsPostgresFeatureIterator::fetchBatch, mFeatureQueueSize );
+      mPrefetching = true;
     }
-    else if ( timer.elapsed() < 50 && mFeatureQueueSize < 10000 )
+
+    for ( int row = 0; row < batch.rows; row++ )
     {
-      mFeatureQueueSize *= 2;
-    }
+      mFeatureQueue.enqueue( QgsFeature() );
+      getFeature( queryResult, row, mFeatureQueue.back() );
+    } // for each row in queue
   }
 
   if ( mFeatureQueue.empty() )
@@ -359,6 +354,89 @@ bool QgsPostgresFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::
   return mOrderByCompiled;
 }
 
+QgsPostgresFeatureIterator::FetchBatch QgsPostgresFeatureIterator::fetchBatch( int size )
+{
+  FetchBatch batch;
+  batch.requested = size;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( size ).arg( mCursorName );
+
+  lock();
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    batch.error = mConn->PQerrorMessage();
+  }
+
+  for ( ;; )
+  {
+    PGresult *result = mConn->PQgetResult();
+    if ( !result )
+      break;
+
+    if ( ::PQresultStatus( result ) != PGRES_TUPLES_OK )
+    {
+      batch.error = mConn->PQerrorMessage();
+      ::PQclear( result );
+      continue;
+    }
+
+    if ( batch.result || ::PQntuples( result ) == 0 )
+    {
+      ::PQclear( result );
+      continue;
+    }
+
+    batch.result = result;
+    batch.rows = ::PQntuples( result );
+    int columns = ::PQnfields( result );
+    for ( int row = 0; row < batch.rows; ++row )
+    {
+      for ( int col = 0; col < columns; ++col )
+        batch.bytes += ::PQgetlength( result, row, col );
+    }
+  }
+  unlock();
+
+  batch.elapsed = timer.elapsed();
+  return batch;
+}
+
+void QgsPostgresFeatureIterator::cancelPrefetch()
+{
+  if ( !mPrefetching )
+    return;
+
+  FetchBatch batch = mPrefetch.result();
+  mPrefetch = QFuture<FetchBatch>();
+  mPrefetching = false;
+  if ( batch.result )
+    ::PQclear( batch.result );
+}
+
+void QgsPostgresFeatureIterator::updateFeatureQueueSize( const FetchBatch &batch )
+{
+  // adapt to latency: keep each round trip between 50 and 500 ms
+  if ( batch.elapsed > 500 && mFeatureQueueSize > 1 )
+  {
+    mFeatureQueueSize /= 2;
+  }
+  else if ( batch.elapsed < 50 && mFeatureQueueSize < MAXIMUM_FETCH_ROWS )
+  {
+    mFeatureQueueSize = std::min( mFeatureQueueSize * 2, MAXIMUM_FETCH_ROWS );
+  }
+
+  // adapt to row width: wide rows (e.g. large geometries) get smaller batches,
+  // so that memory use and the time to the first decoded row stay bounded
+  if ( batch.rows > 0 && batch.bytes > 0 )
+  {
+    qint64 maximumRows = MAXIMUM_FETCH_BYTES * batch.rows / batch.bytes;
+    mFeatureQueueSize = static_cast< int >( std::max( qint64( 1 ), std::min( qint64( mFeatureQueueSize ), maximumRows ) ) );
+  }
+}
+
 void QgsPostgresFeatureIterator::lock()
 {
   if ( mIsTransactionConnection )
@@ -377,6 +455,7 @@ bool QgsPostgresFeatureIterator::rewind()
     return false;
 
   // move cursor to first record
+  cancelPrefetch();
 
   lock();
   mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
@@ -393,6 +472,8 @@ bool QgsPostgresFeatureIterator::close()
   if ( !mConn )
     return false;
 
+  cancelPrefetch();
+
   lock();
   mConn->closeCursor( mCursorName );
   unlock();
@@ -640,7 +721,7 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    query += delim + mConn->binaryFieldExpression( mSource->mFields.at( idx ) );
   }
 
   query += " FROM " + mSource->mQuery;
@@ -817,7 +898,7 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
     return;
 
   const QgsField fld = mSource->mFields.at( idx );
-  QVariant v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+  QVariant v = QgsPostgresConn::getBinaryValue( fld, queryResult, row, col );
   feature.setAttribute( idx, v );
 
   col++;
@@ -869,3 +950,51 @@ QgsFeatureIterator QgsPostgresFeatureSource::getFeatures( const QgsFeatureReques
 {
   return QgsFeatureIterator( new QgsPostgresFeatureIterator( this, false, request ) );
 }
+
+bool QgsPostgresFeatureSource::uniqueValueCounts( int index, QList< QPair< QVariant, long > > &counts )
+{
+  counts.clear();
+
+  if ( index < 0 || index >= mFields.count() )
+    return false;
+
+  QgsPostgresConn *conn = mTransactionConnection;
+  if ( !conn )
+    conn = QgsPostgresConnPool::instance()->acquireConnection( mConnInfo );
+  if ( !conn )
+    return false;
+
+  QgsField fld = mFields.at( index );
+  QString sql = QStringLiteral( "SELECT %1 AS value,count(*) AS n FROM %2" )
+                .arg( QgsPostgresConn::quotedIdentifier( fld.name() ),
+                      mQuery );
+
+  if ( !mSqlWhereClause.isEmpty() )
+  {
+    sql += QStringLiteral( " WHERE %1" ).arg( mSqlWhereClause );
+  }
+
+  sql += QStringLiteral( " GROUP BY %1" ).arg( QgsPostgresConn::quotedIdentifier( fld.name() ) );
+
+  QgsField valueField( fld );
+  valueField.setName( QStringLiteral( "value" ) );
+  sql = QStringLiteral( "SELECT %1,n FROM (%2) foo" ).arg( conn->fieldExpression( valueField ), sql );
+
+  // this may be called from a background task, while a transaction connection is in use elsewhere
+  conn->lock();
+  QgsPostgresResult res( conn->PQexec( sql ) );
+  conn->unlock();
+
+  if ( !mTransactionConnection )
+    QgsPostgresConnPool::instance()->releaseConnection( conn );
+
+  if ( res.PQresultStatus() != PGRES_TUPLES_OK )
+    return false;
+
+  for ( int i = 0; i < res.PQntuples(); i++ )
+  {
+    QVariant value = res.PQgetisnull( i, 0 ) ? QVariant( fld.type() ) : QgsPostgresProvider::convertValue( fld.type(), fld.subType(), res.PQgetvalue( i, 0 ) );
+    counts << qMakePair( value, static_cast< long >( res.PQgetvalue( i, 1 ).toLongLong() ) );
+  }
+  return true;
+}
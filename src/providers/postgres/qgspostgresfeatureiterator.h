@@ -17,6 +17,7 @@
 
 #include "qgsfeatureiterator.h"
 
+#include <QFuture>
 #include <QQueue>
 
 #include "qgspostgresprovider.h"
@@ -33,6 +34,7 @@ class QgsPostgresFeatureSource : public QgsAbstractFeatureSource
     ~QgsPostgresFeatureSource();
 
     virtual QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) override;
+    virtual bool uniqueValueCounts( int index, QList< QPair< QVariant, long > > &counts ) override;
 
   private:
 
@@ -86,6 +88,23 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
 
   private:
 
+    //! Rows fetched from the cursor by a single FETCH statement
+    struct FetchBatch
+    {
+      //! Query result, ownership is transferred to the consumer of the batch
+      PGresult *result = nullptr;
+      //! Number of rows requested
+      int requested = 0;
+      //! Number of rows returned
+      int rows = 0;
+      //! Total size of the returned values in bytes
+      qint64 bytes = 0;
+      //! Time taken by the fetch in milliseconds
+      qint64 elapsed = 0;
+      //! Error message, if the fetch failed
+      QString error;
+    };
+
     QgsPostgresConn *mConn = nullptr;
 
 
@@ -94,6 +113,18 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
+    /**
+     * Fetches the next \a size rows from the cursor. This may run on a worker
+     * thread while the previous batch is being decoded.
+     */
+    FetchBatch fetchBatch( int size );
+
+    //! Waits for a pending prefetch to finish and discards its rows
+    void cancelPrefetch();
+
+    //! Adjusts the batch size to the latency and row width of a fetched batch
+    void updateFeatureQueueSize( const FetchBatch &batch );
+
     QString mCursorName;
 
     /**
@@ -105,6 +136,15 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     //! Maximal size of the feature queue
     int mFeatureQueueSize;
 
+    //! Next batch of rows, fetched in the background while the current one is decoded
+    QFuture<FetchBatch> mPrefetch;
+
+    //! Set to true while mPrefetch holds a batch which has not been consumed
+    bool mPrefetching = false;
+
+    //! Set to true if batches may be fetched in the background
+    bool mPrefetchEnabled = false;
+
     //! Number of retrieved features
     int mFetched;
 
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsapplication.h"
+#include "qgsdatasourcemetadatacache.h"
 #include "qgsfeature.h"
 #include "qgsfield.h"
 #include "qgsgeometry.h"
@@ -27,6 +28,7 @@
 #include "qgsvectorlayer.h"
 
 #include <QMessageBox>
+#include <QtEndian>
 
 #include "qgsvectorlayerexporter.h"
 #include "qgspostgresprovider.h"
@@ -34,6 +36,7 @@
 #include "qgspostgresconnpool.h"
 #include "qgspostgresdataitems.h"
 #include "qgspostgresfeatureiterator.h"
+#include "qgspostgresexpressioncompiler.h"
 #include "qgspostgrestransaction.h"
 #include "qgslogger.h"
 #include "qgsfeedback.h"
@@ -1194,7 +1197,7 @@ bool QgsPostgresProvider::hasSufficientPermsAndCapabilities()
       testAccess = connectionRO()->PQexec( sql );
       if ( testAccess.PQresultStatus() == PGRES_TUPLES_OK && testAccess.PQntuples() == 1 )
       {
-        mEnabledCapabilities |= QgsVectorDataProvider::AddAttributes | QgsVectorDataProvider::DeleteAttributes | QgsVectorDataProvider::RenameAttributes;
+        mEnabledCapabilities |= QgsVectorDataProvider::AddAttributes | QgsVectorDataProvider::DeleteAttributes | QgsVectorDataProvider::RenameAttributes | QgsVectorDataProvider::CreateSpatialIndex;
       }
     }
   }
@@ -1615,6 +1618,64 @@ QSet<QVariant> QgsPostgresProvider::uniqueValues( int index, int limit ) const
   return uniqueValues;
 }
 
+bool QgsPostgresProvider::uniqueValueCounts( int index, QList< QPair< QVariant, long > > &counts ) const
+{
+  QgsPostgresFeatureSource source( this );
+  return source.uniqueValueCounts( index, counts );
+}
+
+QVariant QgsPostgresProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+                                         const QgsAggregateCalculator::AggregateParameters &parameters,
+                                         QgsExpressionContext *context, bool &ok ) const
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  if ( index < 0 || index >= mAttributeFields.count() )
+    return QVariant();
+
+  // only aggregates of numeric fields are guaranteed to match those calculated by QGIS
+  QgsField fld = field( index );
+  if ( !fld.isNumeric() )
+    return QVariant();
+
+  if ( !QgsSettings().value( QStringLiteral( "qgis/compileExpressions" ), true ).toBool() )
+    return QVariant();
+
+  QgsPostgresFeatureSource source( this );
+  QgsPostgresExpressionCompiler aggregateCompiler( &source );
+  QString aggregateSql = aggregateCompiler.compileAggregate( aggregate, fld.name() );
+  if ( aggregateSql.isEmpty() )
+    return QVariant();
+
+  QString whereClause = filterWhereClause();
+  QString sql = QStringLiteral( "SELECT %1 FROM %2%3" ).arg( aggregateSql, mQuery, whereClause );
+
+  if ( !parameters.filter.isEmpty() )
+  {
+    // the filter must be completely compiled, there is no way to double-check the features
+    QgsExpression filter( parameters.filter );
+    QgsPostgresExpressionCompiler filterCompiler( &source );
+    if ( filter.hasParserError() || filterCompiler.compile( &filter ) != QgsSqlExpressionCompiler::Complete )
+      return QVariant();
+
+    sql += QStringLiteral( "%1(%2)" ).arg( whereClause.isEmpty() ? " WHERE " : " AND ", filterCompiler.result() );
+  }
+
+  QgsPostgresConn *conn = connectionRO();
+  conn->lock();
+  QgsPostgresResult res( conn->PQexec( sql ) );
+  conn->unlock();
+  if ( res.PQresultStatus() != PGRES_TUPLES_OK || res.PQntuples() != 1 )
+    return QVariant();
+
+  ok = true;
+  if ( res.PQgetisnull( 0, 0 ) )
+    return QVariant();
+
+  return QVariant( res.PQgetvalue( 0, 0 ).toDouble() );
+}
+
 QStringList QgsPostgresProvider::uniqueStringsMatching( int index, const QString &substring, int limit, QgsFeedback *feedback ) const
 {
   QStringList results;
@@ -1966,6 +2027,14 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   if ( mIsQuery )
     return false;
 
+  if ( flags & QgsFeatureSink::FastInsert )
+  {
+    // the caller does not need the new feature ids, so bulk load the features if possible
+    QList<int> copyFieldIds;
+    if ( copyableFields( flist, copyFieldIds ) )
+      return copyFeatures( flist, copyFieldIds );
+  }
+
   QgsPostgresConn *conn = connectionRW();
   if ( !conn )
   {
@@ -2224,6 +2293,7 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
     returnvalue &= conn->commit();
 
     mShared->addFeaturesCounted( flist.size() );
+    QgsApplication::dataSourceMetadataCache()->invalidate( dataSourceUri() );
   }
   catch ( PGException &e )
   {
@@ -2237,6 +2307,270 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   return returnvalue;
 }
 
+bool QgsPostgresProvider::copyableFields( const QgsFeatureList &flist, QList<int> &fieldIds ) const
+{
+  fieldIds.clear();
+
+  if ( mSpatialColType != SctNone && mSpatialColType != SctGeometry )
+    return false;
+
+  int attributeCount = flist.at( 0 ).attributes().count();
+  for ( int idx = 0; idx < attributeCount && idx < mAttributeFields.count(); ++idx )
+  {
+    const QgsField fld = mAttributeFields.at( idx );
+    if ( fld.name().isEmpty() || fld.name() == mGeometryColumn )
+      continue;
+
+    // values of these types are not passed as text literals
+    if ( fld.type() == QVariant::Map || fld.type() == QVariant::List || fld.type() == QVariant::StringList || fld.type() == QVariant::ByteArray )
+      return false;
+
+    const QString defVal = defaultValueClause( idx );
+    if ( defVal.isNull() )
+    {
+      fieldIds << idx;
+      continue;
+    }
+
+    // COPY cannot evaluate a default for some rows only: leave the column out if
+    // every feature uses the default, and fall back to INSERT if only some do.
+    // A NULL value is stored as NULL, except for primary key columns which the
+    // INSERT path also fills with their default (e.g. from a sequence).
+    const bool nullIsDefault = mPrimaryKeyAttrs.contains( idx ) &&
+                               ( mPrimaryKeyType == PktInt || mPrimaryKeyType == PktFidMap || mPrimaryKeyType == PktUint64 );
+    int defaults = 0;
+    Q_FOREACH ( const QgsFeature &feature, flist )
+    {
+      QVariant value = feature.attribute( idx );
+      if ( value.isNull() ? nullIsDefault : value.toString() == defVal )
+        ++defaults;
+    }
+
+    if ( defaults == 0 )
+      fieldIds << idx;
+    else if ( defaults != flist.size() )
+      return false;
+  }
+
+  // COPY needs at least one column
+  return !mGeometryColumn.isNull() || !fieldIds.isEmpty();
+}
+
+void QgsPostgresProvider::appendCopyRow( const QgsFeature &feature, const QList<int> &fieldIds, int srid, QByteArray &buffer ) const
+{
+  char delim = 0;
+
+  if ( !mGeometryColumn.isNull() )
+  {
+    if ( feature.hasGeometry() )
+    {
+      QgsGeometry convertedGeom( convertToProviderType( feature.geometry() ) );
+      QByteArray wkb( convertedGeom ? convertedGeom.exportToWkb() : feature.geometry().exportToWkb() );
+
+      if ( srid > 0 && wkb.size() >= 5 )
+      {
+        // turn the WKB into EWKB, which carries the SRID of the column
+        const uchar *data = reinterpret_cast< const uchar * >( wkb.constData() );
+        bool littleEndian = data[0] == 1;
+        quint32 type = littleEndian ? qFromLittleEndian<quint32>( data + 1 ) : qFromBigEndian<quint32>( data + 1 );
+        type |= 0x20000000;
+
+        QByteArray ewkb( 9, Qt::Uninitialized );
+        uchar *header = reinterpret_cast< uchar * >( ewkb.data() );
+        header[0] = data[0];
+        if ( littleEndian )
+        {
+          qToLittleEndian<quint32>( type, header + 1 );
+          qToLittleEndian<quint32>( static_cast< quint32 >( srid ), header + 5 );
+        }
+        else
+        {
+          qToBigEndian<quint32>( type, header + 1 );
+          qToBigEndian<quint32>( static_cast< quint32 >( srid ), header + 5 );
+        }
+        wkb = ewkb + wkb.mid( 5 );
+      }
+
+      buffer += wkb.toHex();
+    }
+    else
+    {
+      buffer += "\\N";
+    }
+    delim = '\t';
+  }
+
+  Q_FOREACH ( int idx, fieldIds )
+  {
+    if ( delim )
+      buffer += delim;
+    delim = '\t';
+
+    QVariant value = feature.attribute( idx );
+    if ( value.isNull() )
+    {
+      buffer += "\\N";
+      continue;
+    }
+
+    const QByteArray text = value.toString().toUtf8();
+    for ( const char *c = text.constData(), *end = c + text.size(); c != end; ++c )
+    {
+      switch ( *c )
+      {
+        case '\\':
+          buffer += "\\\\";
+          break;
+        case '\t':
+          buffer += "\\t";
+          break;
+        case '\n':
+          buffer += "\\n";
+          break;
+        case '\r':
+          buffer += "\\r";
+          break;
+        default:
+          buffer += *c;
+      }
+    }
+  }
+
+  buffer += '\n';
+}
+
+bool QgsPostgresProvider::copyFeatures( const QgsFeatureList &flist, const QList<int> &fieldIds )
+{
+  // size of the chunks of data sent to the server
+  const int copyBufferSize = 1 << 20;
+
+  QgsPostgresConn *conn = connectionRW();
+  if ( !conn )
+  {
+    return false;
+  }
+  conn->lock();
+
+  bool returnvalue = true;
+  bool copying = false;
+
+  try
+  {
+    conn->begin();
+
+    QStringList columns;
+    if ( !mGeometryColumn.isNull() )
+      columns << quotedIdentifier( mGeometryColumn );
+    Q_FOREACH ( int idx, fieldIds )
+      columns << quotedIdentifier( mAttributeFields.at( idx ).name() );
+
+    QgsPostgresResult result( conn->PQexec( QStringLiteral( "COPY %1(%2) FROM STDIN" ).arg( mQuery, columns.join( ',' ) ) ) );
+    if ( result.PQresultStatus() != PGRES_COPY_IN )
+      throw PGException( result );
+    copying = true;
+
+    int srid = ( mRequestedSrid.isEmpty() ? mDetectedSrid : mRequestedSrid ).toInt();
+
+    QByteArray buffer;
+    buffer.reserve( copyBufferSize + copyBufferSize / 4 );
+    for ( QgsFeatureList::const_iterator it = flist.constBegin(); it != flist.constEnd(); ++it )
+    {
+      appendCopyRow( *it, fieldIds, srid, buffer );
+
+      if ( buffer.size() >= copyBufferSize )
+      {
+        if ( conn->PQputCopyData( buffer ) != 1 )
+          throw PGException( conn->PQerrorMessage() );
+        buffer.clear();
+      }
+    }
+
+    if ( !buffer.isEmpty() && conn->PQputCopyData( buffer ) != 1 )
+      throw PGException( conn->PQerrorMessage() );
+
+    copying = false;
+    if ( conn->PQputCopyEnd() != 1 )
+      throw PGException( conn->PQerrorMessage() );
+
+    result = conn->PQgetResult();
+    while ( PGresult *extra = conn->PQgetResult() )
+      ::PQclear( extra );
+
+    if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+      throw PGException( result );
+
+    returnvalue &= conn->commit();
+
+    mShared->addFeaturesCounted( flist.size() );
+    QgsApplication::dataSourceMetadataCache()->invalidate( dataSourceUri() );
+  }
+  catch ( PGException &e )
+  {
+    pushError( tr( "PostGIS error while adding features: %1" ).arg( e.errorMessage() ) );
+    if ( copying )
+    {
+      conn->PQputCopyEnd( QStringLiteral( "aborted" ) );
+      while ( PGresult *extra = conn->PQgetResult() )
+        ::PQclear( extra );
+    }
+    conn->rollback();
+    returnvalue = false;
+  }
+
+  conn->unlock();
+  return returnvalue;
+}
+
+bool QgsPostgresProvider::createSpatialIndex()
+{
+  if ( mIsQuery || mGeometryColumn.isNull() || mSpatialColType == SctTopoGeometry )
+    return false;
+
+  QgsPostgresConn *conn = connectionRW();
+  if ( !conn )
+  {
+    return false;
+  }
+  conn->lock();
+
+  bool returnvalue = true;
+
+  try
+  {
+    // features added with FastInsert are bulk loaded into a table without spatial
+    // index; building the index once after loading is much cheaper than updating it
+    // for every row
+    QgsPostgresResult result( conn->PQexec( QStringLiteral( "SELECT 1 FROM pg_index i "
+                                            "JOIN pg_attribute a ON a.attrelid=i.indrelid AND a.attnum=ANY(i.indkey) "
+                                            "JOIN pg_class c ON c.oid=i.indexrelid "
+                                            "JOIN pg_am am ON am.oid=c.relam "
+                                            "WHERE i.indrelid=%1::regclass AND a.attname=%2 AND am.amname='gist'" )
+                                            .arg( quotedValue( mQuery ), quotedValue( mGeometryColumn ) ) ) );
+    if ( result.PQresultStatus() != PGRES_TUPLES_OK )
+      throw PGException( result );
+
+    if ( result.PQntuples() == 0 )
+    {
+      result = conn->PQexec( QStringLiteral( "CREATE INDEX ON %1 USING GIST (%2)" ).arg( mQuery, quotedIdentifier( mGeometryColumn ) ) );
+      if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+        throw PGException( result );
+    }
+
+    // refresh the planner statistics after loading
+    result = conn->PQexec( QStringLiteral( "ANALYZE %1" ).arg( mQuery ) );
+    if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+      throw PGException( result );
+  }
+  catch ( PGException &e )
+  {
+    pushError( tr( "PostGIS error while creating spatial index: %1" ).arg( e.errorMessage() ) );
+    returnvalue = false;
+  }
+
+  conn->unlock();
+  return returnvalue;
+}
+
 bool QgsPostgresProvider::deleteFeatures( const QgsFeatureIds &id )
 {
   bool returnvalue = true;
@@ -2286,6 +2620,7 @@ bool QgsPostgresProvider::deleteFeatures( const QgsFeatureIds &id )
     }
 
     mShared->addFeaturesCounted( -id.size() );
+    QgsApplication::dataSourceMetadataCache()->invalidate( dataSourceUri() );
   }
   catch ( PGException &e )
   {
@@ -3076,6 +3411,15 @@ long QgsPostgresProvider::featureCount() const
   if ( featuresCounted >= 0 )
     return featuresCounted;
 
+  QgsDataSourceMetadataCache *metadataCache = QgsApplication::dataSourceMetadataCache();
+  const QString changeToken = metadataChangeToken();
+  long cachedCount = metadataCache->metadata( dataSourceUri(), changeToken ).featureCount;
+  if ( cachedCount >= 0 )
+  {
+    mShared->setFeaturesCounted( cachedCount );
+    return cachedCount;
+  }
+
   // get total number of features
   QString sql;
 
@@ -3097,6 +3441,8 @@ long QgsPostgresProvider::featureCount() const
 
   long num = result.PQgetvalue( 0, 0 ).toLong();
   mShared->setFeaturesCounted( num );
+  if ( result.PQresultStatus() == PGRES_TUPLES_OK )
+    metadataCache->setFeatureCount( dataSourceUri(), changeToken, num );
 
   QgsDebugMsg( "number of features: " + QString::number( num ) );
 
@@ -3113,6 +3459,15 @@ QgsRectangle QgsPostgresProvider::extent() const
 
   if ( mLayerExtent.isEmpty() )
   {
+    QgsDataSourceMetadataCache *metadataCache = QgsApplication::dataSourceMetadataCache();
+    const QString changeToken = metadataChangeToken();
+    QgsRectangle cachedExtent = metadataCache->metadata( dataSourceUri(), changeToken ).extent;
+    if ( !cachedExtent.isNull() )
+    {
+      mLayerExtent = cachedExtent;
+      return mLayerExtent;
+    }
+
     QString sql;
     QgsPostgresResult result;
     QString ext;
@@ -3199,6 +3554,7 @@ QgsRectangle QgsPostgresProvider::extent() const
         mLayerExtent.setYMinimum( ex[2].toDouble() );
         mLayerExtent.setXMaximum( ex[3].toDouble() );
         mLayerExtent.setYMaximum( ex[4].toDouble() );
+        metadataCache->setExtent( dataSourceUri(), changeToken, mLayerExtent );
       }
       else
       {
@@ -3215,6 +3571,37 @@ QgsRectangle QgsPostgresProvider::extent() const
 void QgsPostgresProvider::updateExtents()
 {
   mLayerExtent.setMinimal();
+  QgsApplication::dataSourceMetadataCache()->invalidate( dataSourceUri() );
+}
+
+QString QgsPostgresProvider::metadataChangeToken() const
+{
+  // uncommitted changes of a transaction must not leak into the shared cache
+  if ( mIsQuery || mTransaction )
+    return QString();
+
+  // relfilenode changes on TRUNCATE, which is not reflected in the row counters.
+  // The counters stay at zero when track_counts is off and after pg_stat_reset(),
+  // so they do not tell whether the table changed and the cache must not be used.
+  QString sql = QStringLiteral( "SELECT s.n_tup_ins,s.n_tup_upd,s.n_tup_del,c.relfilenode,current_setting('track_counts')::boolean"
+                                " FROM pg_catalog.pg_stat_all_tables s"
+                                " JOIN pg_catalog.pg_class c ON c.oid=s.relid WHERE s.relid=regclass(%1)::oid" ).arg( quotedValue( mQuery ) );
+  QgsPostgresResult result( connectionRO()->PQexec( sql ) );
+  if ( result.PQresultStatus() != PGRES_TUPLES_OK || result.PQntuples() != 1 )
+    return QString();
+
+  if ( result.PQgetvalue( 0, 4 ) != QLatin1String( "t" ) )
+    return QString();
+
+  if ( result.PQgetvalue( 0, 0 ).toLongLong() == 0 && result.PQgetvalue( 0, 1 ).toLongLong() == 0 && result.PQgetvalue( 0, 2 ).toLongLong() == 0 )
+    return QString();
+
+  // the statistics collector reports changes of other sessions with a delay of up
+  // to about a second, which a change token cannot account for
+  return QStringLiteral( "%1:%2:%3:%4" ).arg( result.PQgetvalue( 0, 0 ),
+         result.PQgetvalue( 0, 1 ),
+         result.PQgetvalue( 0, 2 ),
+         result.PQgetvalue( 0, 3 ) );
 }
 
 bool QgsPostgresProvider::getGeometryDetails()
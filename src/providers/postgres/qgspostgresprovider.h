@@ -140,6 +140,10 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     QVariant minimumValue( int index ) const override;
     QVariant maximumValue( int index ) const override;
     virtual QSet< QVariant > uniqueValues( int index, int limit = -1 ) const override;
+    virtual bool uniqueValueCounts( int index, QList< QPair< QVariant, long > > &counts ) const override;
+    virtual QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+                                const QgsAggregateCalculator::AggregateParameters &parameters,
+                                QgsExpressionContext *context, bool &ok ) const override;
     virtual QStringList uniqueStringsMatching( int index, const QString &substring, int limit = -1,
         QgsFeedback *feedback = nullptr ) const override;
     virtual void enumValues( int index, QStringList &enumList ) const override;
@@ -160,6 +164,7 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     bool changeAttributeValues( const QgsChangedAttributesMap &attr_map ) override;
     bool changeGeometryValues( const QgsGeometryMap &geometry_map ) override;
     bool changeFeatures( const QgsChangedAttributesMap &attr_map, const QgsGeometryMap &geometry_map ) override;
+    bool createSpatialIndex() override;
 
     //! Get the postgres connection
     PGconn *pgConnection();
@@ -232,6 +237,15 @@ class QgsPostgresProvider : public QgsVectorDataProvider
   private:
     Relkind relkind() const;
 
+    /**
+     * Returns a token identifying the current state of the table, built from its
+     * row change statistics, used to validate entries of the data source metadata
+     * cache. Returns an empty string if the metadata cache should not be used, e.g.
+     * for queries, views, layers in a transaction, or when the statistics are not
+     * collected (track_counts off) or were reset.
+     */
+    QString metadataChangeToken() const;
+
     bool declareCursor( const QString &cursorName,
                         const QgsAttributeList &fetchAttributes,
                         bool fetchGeometry,
@@ -395,6 +409,10 @@ class QgsPostgresProvider : public QgsVectorDataProvider
           : mWhat( r.PQresultErrorMessage() )
         {}
 
+        explicit PGException( const QString &message )
+          : mWhat( message )
+        {}
+
         QString errorMessage() const
         {
           return mWhat;
@@ -410,6 +428,18 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     QgsVectorDataProvider::Capabilities mEnabledCapabilities;
 
     void appendGeomParam( const QgsGeometry &geom, QStringList &param ) const;
+
+    /** Returns true if the features in \a flist can be bulk loaded with COPY, and sets
+     * \a fieldIds to the attributes which have to be sent. Attributes for which all
+     * features use the default value are left out.
+     */
+    bool copyableFields( const QgsFeatureList &flist, QList<int> &fieldIds ) const;
+
+    //! Adds features with COPY, without returning their feature ids
+    bool copyFeatures( const QgsFeatureList &flist, const QList<int> &fieldIds );
+
+    //! Appends a feature in COPY text format to \a buffer
+    void appendCopyRow( const QgsFeature &feature, const QList<int> &fieldIds, int srid, QByteArray &buffer ) const;
     void appendPkParams( QgsFeatureId fid, QStringList &param ) const;
 
     QString paramValue( const QString &fieldvalue, const QString &defaultValue ) const;
@@ -15,12 +15,14 @@ email                : hugo dot mercier at oslandia dot com
  ***************************************************************************/
 
 #include <string.h>
+#include <algorithm>
 #include <iostream>
 #include <cstdint>
 #include <stdexcept>
 
 #include <QCoreApplication>
 #include <QBuffer>
+#include <QHash>
 
 #include "qgsapplication.h"
 #include "qgsvectorlayer.h"
@@ -79,6 +81,20 @@ void deleteGeometryBlob( void *p )
 // function called when a lived layer is deleted
 void invalidateTable( void *b );
 
+// number of features assumed for layers which do not know their feature count
+static const double UNKNOWN_FEATURE_COUNT = 1e6;
+
+// number of equality filters on the same column after which a cursor builds a hash index of the column
+static const int LOOKUP_INDEX_THRESHOLD = 2;
+
+// filters passed to the provider, determined by vtableBestIndex and passed to vtableFilter as idxNum
+enum FilterFlag
+{
+  PkFilter = 1, // feature id filter
+  RectFilter = 2, // bounding box filter, from the _search_frame_ column or a spatial predicate
+  ExpressionFilter = 4, // comparisons of columns with values
+};
+
 struct VTable
 {
     // minimal set of members (see sqlite3.h)
@@ -98,6 +114,8 @@ struct VTable
       , mPkColumn( -1 )
       , mCrs( -1 )
       , mValid( true )
+      , mHasGeometry( false )
+      , mFeatureCount( 0 )
     {
       if ( mLayer )
       {
@@ -117,6 +135,8 @@ struct VTable
       , mPkColumn( -1 )
       , mCrs( -1 )
       , mValid( true )
+      , mHasGeometry( false )
+      , mFeatureCount( 0 )
     {
       mProvider = static_cast<QgsVectorDataProvider *>( QgsProviderRegistry::instance()->createProvider( provider, source ) );
       if ( !mProvider )
@@ -162,6 +182,17 @@ struct VTable
 
     QgsFields fields() const { return mFields; }
 
+    //! Index of the geometry column, or -1 if the table has no geometry
+    int geometryColumn() const { return mHasGeometry ? mFields.count() + 1 : -1; }
+
+    //! Number of features of the layer when the table was created, used to estimate the cost of scans
+    double estimatedFeatureCount() const { return mFeatureCount; }
+
+    QgsFeatureIterator getFeatures( const QgsFeatureRequest &request )
+    {
+      return mLayer ? mLayer->getFeatures( request ) : mProvider->getFeatures( request );
+    }
+
   private:
 
     VTable( const VTable &other );
@@ -193,6 +224,10 @@ struct VTable
 
     QgsFields mFields;
 
+    bool mHasGeometry;
+
+    double mFeatureCount;
+
     void init_()
     {
       mFields = mLayer ? mLayer->fields() : mProvider->fields();
@@ -231,6 +266,7 @@ struct VTable
         // we are using them to set the geometry type and srid
         // these will be reused by the provider when it will introspect the query to detect types
         sqlFields << QStringLiteral( "geometry geometry(%1,%2)" ).arg( provider->wkbType() ).arg( provider->crs().postgisSrid() );
+        mHasGeometry = true;
       }
 
       QgsAttributeList pkAttributeIndexes = provider->pkAttributeIndexes();
@@ -242,6 +278,10 @@ struct VTable
       mCreationStr = "CREATE TABLE vtable (" + sqlFields.join( QStringLiteral( "," ) ) + ")";
 
       mCrs = provider->crs().postgisSrid();
+
+      // the count is unknown for some providers, assume a large table then
+      long count = mLayer ? mLayer->featureCount() : mProvider->featureCount();
+      mFeatureCount = count >= 0 ? count : UNKNOWN_FEATURE_COUNT;
     }
 };
 
@@ -261,6 +301,12 @@ struct VTableCursor
   QgsFeatureIterator mIterator;
   bool mEof;
 
+  // hash index of the column used in equality filters, see lookup()
+  int mLookupAttribute = -1;
+  int mLookupCount = 0;
+  QHash<qint64, QgsFeatureIds> mIntLookup;
+  QHash<QString, QgsFeatureIds> mStringLookup;
+
   explicit VTableCursor( VTable *vtab )
     : mVtab( vtab )
     , mEof( true )
@@ -274,12 +320,70 @@ struct VTableCursor
       return;
     }
 
-    mIterator = mVtab->layer() ? mVtab->layer()->getFeatures( request ) : mVtab->provider()->getFeatures( request );
+    mIterator = mVtab->getFeatures( request );
     // get on the first record
     mEof = false;
     next();
   }
 
+  /**
+   * Looks up the ids of the features whose attribute equals a value. The cursor is filtered repeatedly
+   * by the same column when its table is the inner table of a join, so the column is materialized as
+   * a hash index once it has been filtered more than a few times.
+   * Returns false if the lookup cannot be done with an index.
+   */
+  bool lookup( int attributeIndex, sqlite3_value *value, QgsFeatureIds &ids )
+  {
+    if ( !mVtab->valid() || attributeIndex < 0 || attributeIndex >= mVtab->fields().count() )
+      return false;
+
+    QVariant::Type type = mVtab->fields().at( attributeIndex ).type();
+    bool intKey = ( type == QVariant::Int || type == QVariant::UInt || type == QVariant::LongLong ) && sqlite3_value_type( value ) == SQLITE_INTEGER;
+    bool stringKey = type == QVariant::String && sqlite3_value_type( value ) == SQLITE_TEXT;
+    if ( !intKey && !stringKey )
+      return false;
+
+    if ( attributeIndex != mLookupAttribute )
+    {
+      mLookupAttribute = attributeIndex;
+      mLookupCount = 0;
+      mIntLookup.clear();
+      mStringLookup.clear();
+    }
+    if ( ++mLookupCount < LOOKUP_INDEX_THRESHOLD )
+      return false;
+
+    if ( mLookupCount == LOOKUP_INDEX_THRESHOLD )
+    {
+      QgsFeatureRequest request;
+      request.setFlags( QgsFeatureRequest::NoGeometry ).setSubsetOfAttributes( QgsAttributeList() << attributeIndex );
+      QgsFeatureIterator it = mVtab->getFeatures( request );
+      QgsFeature f;
+      while ( it.nextFeature( f ) )
+      {
+        QVariant v = f.attribute( attributeIndex );
+        if ( v.isNull() )
+          continue;
+        if ( type == QVariant::String )
+          mStringLookup[v.toString()] << f.id();
+        else
+          mIntLookup[v.toLongLong()] << f.id();
+      }
+    }
+
+    if ( intKey )
+    {
+      ids = mIntLookup.value( sqlite3_value_int64( value ) );
+    }
+    else
+    {
+      int n = sqlite3_value_bytes( value );
+      const char *t = reinterpret_cast<const char *>( sqlite3_value_text( value ) );
+      ids = mStringLookup.value( QString::fromUtf8( t, n ) );
+    }
+    return true;
+  }
+
   void next()
   {
     if ( !mEof )
@@ -472,99 +576,117 @@ int vtableRename( sqlite3_vtab *vtab, const char *newName )
   return SQLITE_OK;
 }
 
+bool isComparisonConstraint( unsigned char op )
+{
+  return ( op == SQLITE_INDEX_CONSTRAINT_EQ ) || // if no PK
+         ( op == SQLITE_INDEX_CONSTRAINT_GT ) ||
+         ( op == SQLITE_INDEX_CONSTRAINT_LE ) ||
+         ( op == SQLITE_INDEX_CONSTRAINT_LT ) ||
+         ( op == SQLITE_INDEX_CONSTRAINT_GE )
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+         || ( op == SQLITE_INDEX_CONSTRAINT_LIKE )
+#endif
+         ;
+}
+
 int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info *indexInfo )
 {
   VTable *vtab = reinterpret_cast< VTable * >( pvtab );
+
+  // The plan is passed to vtableFilter in idxStr: the columns used by the statement on the first line
+  // (empty if unknown), then the column and operator of each comparison constraint, in argv order
+  QStringList plan;
+#if SQLITE_VERSION_NUMBER >= 3010000
+  if ( sqlite3_libversion_number() >= 3010000 )
+    plan << QString::number( static_cast< quint64 >( indexInfo->colUsed ) );
+  else
+#endif
+    plan << QString();
+
+  int pkConstraint = -1;
+  int rectConstraint = -1;
+  QList<int> comparisonConstraints;
   for ( int i = 0; i < indexInfo->nConstraint; i++ )
   {
-    // request for primary key filter with '='
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         ( vtab->pkColumn() == indexInfo->aConstraint[i].iColumn ) &&
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
+    const sqlite3_index_info::sqlite3_index_constraint &constraint = indexInfo->aConstraint[i];
+    if ( !constraint.usable )
+      continue;
+
+    if ( ( vtab->pkColumn() == constraint.iColumn ) && ( constraint.op == SQLITE_INDEX_CONSTRAINT_EQ ) )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 1; // PK filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
-    }
-
-    // request for filter with a comparison operator
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         ( indexInfo->aConstraint[i].iColumn > 0 ) &&
-         ( indexInfo->aConstraint[i].iColumn <= vtab->fields().count() ) &&
-         ( ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) || // if no PK
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GT ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LE ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LT ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GE )
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-           || ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LIKE )
+      // request for primary key filter with '='
+      pkConstraint = i;
+      break;
+    }
+    else if ( rectConstraint < 0 && 0 == constraint.iColumn && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ )
+    {
+      // request for rtree filtering
+      rectConstraint = i;
+    }
+#ifdef SQLITE_INDEX_CONSTRAINT_FUNCTION
+    else if ( rectConstraint < 0 && vtab->geometryColumn() == constraint.iColumn && constraint.op >= SQLITE_INDEX_CONSTRAINT_FUNCTION )
+    {
+      // spatial predicate overloaded by vtableFindFunction
+      rectConstraint = i;
+    }
 #endif
-         ) )
+    else if ( constraint.iColumn > 0 && constraint.iColumn <= vtab->fields().count() && isComparisonConstraint( constraint.op ) )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 3; // expression filter
-      indexInfo->estimatedCost = 2.0; // probably better than no index
+      // request for filter with a comparison operator
+      comparisonConstraints << i;
+    }
+  }
 
-      QString expr = vtab->fields().at( indexInfo->aConstraint[i].iColumn - 1 ).name();
-      switch ( indexInfo->aConstraint[i].op )
-      {
-        case SQLITE_INDEX_CONSTRAINT_EQ:
-          expr += QLatin1String( " = " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GT:
-          expr += QLatin1String( " > " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LE:
-          expr += QLatin1String( " <= " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LT:
-          expr += QLatin1String( " < " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GE:
-          expr += QLatin1String( " >= " );
-          break;
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-        case SQLITE_INDEX_CONSTRAINT_LIKE:
-          expr += QLatin1String( " LIKE " );
-          break;
+  // estimate the cost as the number of features fetched from the layer
+  double rows = vtab->estimatedFeatureCount();
+  int idxNum = 0;
+  if ( pkConstraint >= 0 )
+  {
+    indexInfo->aConstraintUsage[pkConstraint].argvIndex = 1;
+    indexInfo->aConstraintUsage[pkConstraint].omit = 1;
+    idxNum = PkFilter;
+    rows = 1;
+#if SQLITE_VERSION_NUMBER >= 3009000
+    if ( sqlite3_libversion_number() >= 3009000 )
+      indexInfo->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
 #endif
-        default:
-          break;
-      }
-
-      QByteArray ba = expr.toUtf8();
-      char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
-      memcpy( cp, ba.constData(), ba.size() + 1 );
-
-      indexInfo->idxStr = cp;
-      indexInfo->needToFreeIdxStr = 1;
-      return SQLITE_OK;
+  }
+  else
+  {
+    int argvIndex = 0;
+    if ( rectConstraint >= 0 )
+    {
+      const sqlite3_index_info::sqlite3_index_constraint &constraint = indexInfo->aConstraint[rectConstraint];
+      indexInfo->aConstraintUsage[rectConstraint].argvIndex = ++argvIndex;
+      // do not test for equality on _search_frame_, since it is used for filtering, not to return an actual value,
+      // but spatial predicates must still be evaluated on the features intersecting the bounding box
+      indexInfo->aConstraintUsage[rectConstraint].omit = constraint.iColumn == 0 ? 1 : 0;
+      idxNum |= RectFilter;
+      rows /= 10;
     }
-
-    // request for rtree filtering
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         ( 0 == indexInfo->aConstraint[i].iColumn ) &&
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
+    Q_FOREACH ( int i, comparisonConstraints )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      // do not test for equality, since it is used for filtering, not to return an actual value
+      const sqlite3_index_info::sqlite3_index_constraint &constraint = indexInfo->aConstraint[i];
+      indexInfo->aConstraintUsage[i].argvIndex = ++argvIndex;
       indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 2; // RTree filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
+      plan << QStringLiteral( "%1 %2" ).arg( constraint.iColumn ).arg( constraint.op );
+      idxNum |= ExpressionFilter;
+      rows /= constraint.op == SQLITE_INDEX_CONSTRAINT_EQ ? 10 : 2;
     }
   }
-  indexInfo->idxNum = 0;
-  indexInfo->estimatedCost = 10.0;
-  indexInfo->idxStr = nullptr;
-  indexInfo->needToFreeIdxStr = 0;
+
+  indexInfo->idxNum = idxNum;
+  indexInfo->estimatedCost = std::max( rows, 1.0 );
+#if SQLITE_VERSION_NUMBER >= 3008002
+  if ( sqlite3_libversion_number() >= 3008002 )
+    indexInfo->estimatedRows = static_cast< sqlite3_int64 >( std::max( rows, 1.0 ) );
+#endif
+
+  QByteArray ba = plan.join( QStringLiteral( "\n" ) ).toUtf8();
+  char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
+  memcpy( cp, ba.constData(), ba.size() + 1 );
+  indexInfo->idxStr = cp;
+  indexInfo->needToFreeIdxStr = 1;
   return SQLITE_OK;
 }
 
@@ -584,55 +706,137 @@ int vtableClose( sqlite3_vtab_cursor *cursor )
   return SQLITE_OK;
 }
 
+QString comparisonValue( sqlite3_value *value )
+{
+  switch ( sqlite3_value_type( value ) )
+  {
+    case SQLITE_INTEGER:
+      return QString::number( sqlite3_value_int64( value ) );
+    case SQLITE_FLOAT:
+      return QString::number( sqlite3_value_double( value ) );
+    case SQLITE_TEXT:
+    {
+      int n = sqlite3_value_bytes( value );
+      const char *t = reinterpret_cast<const char *>( sqlite3_value_text( value ) );
+      QString str = QString::fromUtf8( t, n );
+      return QgsExpression::quotedString( str );
+    }
+    case SQLITE_NULL:
+    case SQLITE_BLOB: // comparison to blob ignored
+    default:
+      // comparisons with null are never true
+      return QStringLiteral( "NULL" );
+  }
+}
+
 int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, int argc, sqlite3_value **argv )
 {
   Q_UNUSED( argc );
-  Q_UNUSED( idxStr );
+
+  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
+  VTable *vtab = c->mVtab;
+  QStringList plan = QString::fromUtf8( idxStr ).split( '\n' );
 
   QgsFeatureRequest request;
-  if ( idxNum == 1 )
+  int arg = 0;
+  if ( idxNum & PkFilter )
   {
     // id filter
-    request.setFilterFid( sqlite3_value_int( argv[0] ) );
+    request.setFilterFid( sqlite3_value_int64( argv[arg++] ) );
   }
-  else if ( idxNum == 2 )
+  if ( idxNum & RectFilter )
   {
     // rtree filter
-    const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( argv[0] ) );
-    int bytes = sqlite3_value_bytes( argv[0] );
-    QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
-    request.setFilterRect( r );
+    sqlite3_value *value = argv[arg++];
+    if ( sqlite3_value_type( value ) == SQLITE_BLOB )
+    {
+      const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( value ) );
+      int bytes = sqlite3_value_bytes( value );
+      QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
+      request.setFilterRect( r );
+    }
   }
-  else if ( idxNum == 3 )
+
+  QSet<int> filterAttributes;
+  if ( idxNum & ExpressionFilter )
   {
-    // comparison operator filter
+    // comparison operator filters
     // build an expression filter and rely on expression compiler if available
-    QString expr = idxStr;
-    switch ( sqlite3_value_type( argv[0] ) )
+    QStringList exprs;
+    int attributeIndex = -1;
+    int op = 0;
+    for ( int i = 1; i < plan.size(); i++, arg++ )
     {
-      case SQLITE_INTEGER:
-        expr += QString::number( sqlite3_value_int64( argv[0] ) );
-        break;
-      case SQLITE_FLOAT:
-        expr += QString::number( sqlite3_value_double( argv[0] ) );
-        break;
-      case SQLITE_TEXT:
+      QStringList constraint = plan.at( i ).split( ' ' );
+      attributeIndex = constraint.value( 0 ).toInt() - 1;
+      op = constraint.value( 1 ).toInt();
+      filterAttributes << attributeIndex;
+
+      QString expr = QgsExpression::quotedColumnRef( vtab->fields().at( attributeIndex ).name() );
+      switch ( op )
       {
-        int n = sqlite3_value_bytes( argv[0] );
-        const char *t = reinterpret_cast<const char *>( sqlite3_value_text( argv[0] ) );
-        QString str = QString::fromUtf8( t, n );
-        expr += "'" + str.replace( QLatin1String( "'" ), QLatin1String( "''" ) ) + "'";
-        break;
+        case SQLITE_INDEX_CONSTRAINT_EQ:
+          expr += QLatin1String( " = " );
+          break;
+        case SQLITE_INDEX_CONSTRAINT_GT:
+          expr += QLatin1String( " > " );
+          break;
+        case SQLITE_INDEX_CONSTRAINT_LE:
+          expr += QLatin1String( " <= " );
+          break;
+        case SQLITE_INDEX_CONSTRAINT_LT:
+          expr += QLatin1String( " < " );
+          break;
+        case SQLITE_INDEX_CONSTRAINT_GE:
+          expr += QLatin1String( " >= " );
+          break;
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+        case SQLITE_INDEX_CONSTRAINT_LIKE:
+          expr += QLatin1String( " LIKE " );
+          break;
+#endif
+        default:
+          break;
       }
-      case SQLITE_NULL:
-      case SQLITE_BLOB: // comparison to blob ignored
-      default:
-        expr += QLatin1String( " is null" );
-        break;
+      expr += comparisonValue( argv[arg] );
+      exprs << expr;
+    }
+
+    QgsFeatureIds ids;
+    if ( idxNum == ExpressionFilter && exprs.size() == 1 && op == SQLITE_INDEX_CONSTRAINT_EQ &&
+         c->lookup( attributeIndex, argv[arg - 1], ids ) )
+    {
+      // equality lookup in a hash index of the column
+      request.setFilterFids( ids );
+    }
+    else
+    {
+      request.setFilterExpression( exprs.join( QStringLiteral( " AND " ) ) );
     }
-    request.setFilterExpression( expr );
   }
-  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
+
+  // only fetch the columns used by the statement
+  bool ok = false;
+  quint64 columnsUsed = plan.value( 0 ).toULongLong( &ok );
+  if ( ok )
+  {
+    int nFields = vtab->fields().count();
+    // the last bit stands for all columns past the 63rd
+    if ( nFields < 63 )
+    {
+      QgsAttributeList attributes;
+      for ( int i = 0; i < nFields; i++ )
+      {
+        if ( columnsUsed & ( Q_UINT64_C( 1 ) << ( i + 1 ) ) || filterAttributes.contains( i ) )
+          attributes << i;
+      }
+      request.setSubsetOfAttributes( attributes );
+    }
+    int geometryColumn = vtab->geometryColumn();
+    if ( geometryColumn < 0 || ( geometryColumn < 63 && !( columnsUsed & ( Q_UINT64_C( 1 ) << geometryColumn ) ) && !( idxNum & RectFilter ) ) )
+      request.setFlags( request.flags() | QgsFeatureRequest::NoGeometry );
+  }
+
   c->filter( request );
   return SQLITE_OK;
 }
@@ -705,6 +909,62 @@ int vtableColumn( sqlite3_vtab_cursor *cursor, sqlite3_context *ctxt, int idx )
   return SQLITE_OK;
 }
 
+#ifdef SQLITE_INDEX_CONSTRAINT_FUNCTION
+// Spatial predicates overloaded for geometries of virtual tables, so that they can be passed to
+// vtableBestIndex as constraints. They are still evaluated on each feature intersecting the bounding box.
+
+void intersectsFunction( sqlite3_context *ctxt, int nArgs, sqlite3_value **args )
+{
+  Q_UNUSED( nArgs );
+  if ( sqlite3_value_type( args[0] ) != SQLITE_BLOB || sqlite3_value_type( args[1] ) != SQLITE_BLOB )
+  {
+    sqlite3_result_int( ctxt, -1 );
+    return;
+  }
+  QgsGeometry g1 = spatialiteBlobToQgsGeometry( reinterpret_cast< const char * >( sqlite3_value_blob( args[0] ) ), sqlite3_value_bytes( args[0] ) );
+  QgsGeometry g2 = spatialiteBlobToQgsGeometry( reinterpret_cast< const char * >( sqlite3_value_blob( args[1] ) ), sqlite3_value_bytes( args[1] ) );
+  if ( g1.isNull() || g2.isNull() )
+  {
+    sqlite3_result_int( ctxt, -1 );
+    return;
+  }
+  sqlite3_result_int( ctxt, g1.intersects( g2 ) ? 1 : 0 );
+}
+
+void mbrIntersectsFunction( sqlite3_context *ctxt, int nArgs, sqlite3_value **args )
+{
+  Q_UNUSED( nArgs );
+  if ( sqlite3_value_type( args[0] ) != SQLITE_BLOB || sqlite3_value_type( args[1] ) != SQLITE_BLOB )
+  {
+    sqlite3_result_int( ctxt, -1 );
+    return;
+  }
+  QgsRectangle r1 = spatialiteBlobBbox( reinterpret_cast< const char * >( sqlite3_value_blob( args[0] ) ), sqlite3_value_bytes( args[0] ) );
+  QgsRectangle r2 = spatialiteBlobBbox( reinterpret_cast< const char * >( sqlite3_value_blob( args[1] ) ), sqlite3_value_bytes( args[1] ) );
+  sqlite3_result_int( ctxt, r1.intersects( r2 ) ? 1 : 0 );
+}
+
+int vtableFindFunction( sqlite3_vtab *pvtab, int nArg, const char *zName, void ( **pxFunc )( sqlite3_context *, int, sqlite3_value ** ), void **ppArg )
+{
+  Q_UNUSED( pvtab );
+  Q_UNUSED( ppArg );
+  if ( nArg != 2 )
+    return 0;
+
+  QString name = QString::fromUtf8( zName ).toLower();
+  if ( name == QLatin1String( "st_intersects" ) || name == QLatin1String( "intersects" ) )
+  {
+    *pxFunc = intersectsFunction;
+    return SQLITE_INDEX_CONSTRAINT_FUNCTION;
+  }
+  if ( name == QLatin1String( "mbrintersects" ) || name == QLatin1String( "st_envintersects" ) )
+  {
+    *pxFunc = mbrIntersectsFunction;
+    return SQLITE_INDEX_CONSTRAINT_FUNCTION;
+  }
+  return 0;
+}
+#endif
 
 static QCoreApplication *sCoreApp = nullptr;
 
@@ -927,7 +1187,11 @@ int qgsvlayerModuleInit( sqlite3 *db, char **pzErrMsg, void *unused /*const sqli
   module.xSync = nullptr;
   module.xCommit = nullptr;
   module.xRollback = nullptr;
+#ifdef SQLITE_INDEX_CONSTRAINT_FUNCTION
+  module.xFindFunction = sqlite3_libversion_number() >= 3025000 ? vtableFindFunction : nullptr;
+#else
   module.xFindFunction = nullptr;
+#endif
   module.xSavepoint = nullptr;
   module.xRelease = nullptr;
   module.xRollbackTo = nullptr;
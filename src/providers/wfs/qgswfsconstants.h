@@ -46,6 +46,7 @@ struct QgsWFSConstants
   static const QString URI_PARAM_INVERTAXISORIENTATION;
   static const QString URI_PARAM_VALIDATESQLFUNCTIONS;
   static const QString URI_PARAM_HIDEDOWNLOADPROGRESSDIALOG;
+  static const QString URI_PARAM_PERSISTENTCACHE;
 
   //
   static const QString VERSION_AUTO;
@@ -284,6 +284,12 @@ bool QgsWFSDataSourceURI::hideDownloadProgressDialog() const
   return mURI.hasParam( QgsWFSConstants::URI_PARAM_HIDEDOWNLOADPROGRESSDIALOG );
 }
 
+bool QgsWFSDataSourceURI::persistentCache() const
+{
+  return mURI.hasParam( QgsWFSConstants::URI_PARAM_PERSISTENTCACHE ) &&
+         mURI.param( QgsWFSConstants::URI_PARAM_PERSISTENTCACHE ).toInt() == 1;
+}
+
 QString QgsWFSDataSourceURI::build( const QString &baseUri,
                                     const QString &typeName,
                                     const QString &crsString,
@@ -138,6 +138,9 @@ class QgsWFSDataSourceURI
     //! Whether to hide download progress dialog in QGIS main app. Defaults to false
     bool hideDownloadProgressDialog() const;
 
+    //! Whether downloaded features should be kept in an on-disk cache reused across sessions. Defaults to false
+    bool persistentCache() const;
+
     //! Return authorization parameters
     QgsWFSAuthorization &auth() { return mAuth; }
 
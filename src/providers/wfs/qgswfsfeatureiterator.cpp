@@ -29,7 +29,10 @@
 #include "qgsexception.h"
 
 #include <QDir>
+#include <QFuture>
+#include <QFutureWatcher>
 #include <QProgressDialog>
+#include <QtConcurrentRun>
 #include <QTimer>
 #include <QStyle>
 
@@ -458,6 +461,17 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
              false /* cache */ );
 
     int featureCountForThisResponse = 0;
+    // Chunks of the response are parsed in a worker thread, while the next
+    // chunk is downloaded and the features of the previous one are cached
+    // and notified. The parser must not be used while a parsing is pending.
+    // The end of a parsing also wakes up the event loop, so that its features
+    // are notified without waiting for the next chunk of data.
+    QFuture<bool> pendingParsing;
+    QFutureWatcher<bool> pendingParsingWatcher;
+    connect( &pendingParsingWatcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit );
+    bool parsingPending = false;
+    QString pendingParsingErrorMsg;
+    QByteArray queuedData;
     while ( true )
     {
       loop.exec( QEventLoop::ExcludeUserInputEvents );
@@ -484,9 +498,33 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
         data = mResponse;
         finished = true;
       }
-      // Parse the received chunk of data
+      // Keep receiving data while the previous chunk is still being parsed
+      if ( parsingPending && !finished && !pendingParsing.isFinished() )
+      {
+        queuedData.append( data );
+        continue;
+      }
+      if ( !queuedData.isEmpty() )
+      {
+        data.prepend( queuedData );
+        queuedData.clear();
+      }
+      // Wait for the parsing of the previous chunk of data
       QString gmlProcessErrorMsg;
-      if ( !parser->processData( data, finished, gmlProcessErrorMsg ) )
+      bool parsingSuccess = true;
+      if ( parsingPending )
+      {
+        parsingSuccess = pendingParsing.result();
+        parsingPending = false;
+        gmlProcessErrorMsg = pendingParsingErrorMsg;
+      }
+      // The last chunk is parsed synchronously, so that the state of the parser
+      // is complete before leaving the loop
+      if ( parsingSuccess && finished )
+      {
+        parsingSuccess = parser->processData( data, finished, gmlProcessErrorMsg );
+      }
+      if ( !parsingSuccess )
       {
         success = false;
         mErrorMessage = tr( "Error when parsing GetFeature response" ) + " : " + gmlProcessErrorMsg;
@@ -566,6 +604,19 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
 
       QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> featurePtrList =
         parser->getAndStealReadyFeatures();
+      const QString srsName = parser->srsName();
+      const QgsRectangle layerExtent = parser->layerExtent();
+
+      if ( !finished && !data.isEmpty() )
+      {
+        // Parse the received chunk of data
+        pendingParsing = QtConcurrent::run( [parser, data, &pendingParsingErrorMsg]
+        {
+          return parser->processData( data, false, pendingParsingErrorMsg );
+        } );
+        pendingParsingWatcher.setFuture( pendingParsing );
+        parsingPending = true;
+      }
 
       mTotalDownloadedFeatureCount += featurePtrList.size();
 
@@ -580,16 +631,16 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
         // EPSG:XXXX srsName and not EPSG urns
         if ( pagingIter == 1 && featureCountForThisResponse == 0 &&
              mShared->mWFSVersion.startsWith( QLatin1String( "1.1" ) ) &&
-             parser->srsName().startsWith( QLatin1String( "EPSG:" ) ) &&
-             !parser->layerExtent().isNull() &&
+             srsName.startsWith( QLatin1String( "EPSG:" ) ) &&
+             !layerExtent.isNull() &&
              !mShared->mURI.ignoreAxisOrientation() &&
              !mShared->mURI.invertAxisOrientation() )
         {
-          QgsCoordinateReferenceSystem crs = QgsCoordinateReferenceSystem::fromOgcWmsCrs( parser->srsName() );
+          QgsCoordinateReferenceSystem crs = QgsCoordinateReferenceSystem::fromOgcWmsCrs( srsName );
           if ( crs.isValid() && crs.hasAxisInverted() &&
-               !mShared->mCapabilityExtent.contains( parser->layerExtent() ) )
+               !mShared->mCapabilityExtent.contains( layerExtent ) )
           {
-            QgsRectangle invertedRectangle( parser->layerExtent() );
+            QgsRectangle invertedRectangle( layerExtent );
             invertedRectangle.invert();
             if ( mShared->mCapabilityExtent.contains( invertedRectangle ) )
             {
@@ -668,6 +719,8 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
       }
     }
 
+    if ( parsingPending )
+      pendingParsing.waitForFinished();
     delete parser;
 
     if ( mStop )
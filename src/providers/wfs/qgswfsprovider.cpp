@@ -668,7 +668,8 @@ bool QgsWFSProvider::setSubsetString( const QString &theSQL, bool updateFeatureC
 
   // Invalid and cancel current download before altering fields, etc...
   // (crashes might happen if not done at the beginning)
-  mShared->invalidateCache();
+  // A persistent cache is kept, as it remains valid for the previous subset
+  mShared->invalidateCache( false );
 
   mSubsetString = theSQL;
   clearMinMaxCache();
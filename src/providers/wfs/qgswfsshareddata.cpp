@@ -35,6 +35,13 @@
 
 #include <sqlite3.h>
 
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QLockFile>
+
+// Bump when the layout of the persistent cache changes
+static const int PERSISTENT_CACHE_FORMAT_VERSION = 2;
+
 QgsWFSSharedData::QgsWFSSharedData( const QString &uri )
   : mURI( uri )
   , mSourceCRS( 0 )
@@ -50,6 +57,8 @@ QgsWFSSharedData::QgsWFSSharedData( const QString &uri )
   , mGenCounter( 0 )
   , mFeatureCount( 0 )
   , mFeatureCountExact( false )
+  , mPersistentCache( false )
+  , mCacheComplete( false )
   , mGetFeatureHitsIssued( false )
   , mTotalFeaturesAttemptedToBeCached( 0 )
   , mTryFetchingOneFeature( false )
@@ -62,7 +71,7 @@ QgsWFSSharedData::~QgsWFSSharedData()
 {
   QgsDebugMsg( QString( "~QgsWFSSharedData()" ) );
 
-  invalidateCache();
+  invalidateCache( false );
 }
 
 QString QgsWFSSharedData::srsName() const
@@ -214,9 +223,17 @@ bool QgsWFSSharedData::createCache()
 {
   Q_ASSERT( mCacheDbname.isEmpty() );
 
-  static int sTmpCounter = 0;
-  ++sTmpCounter;
-  mCacheDbname =  QDir( QgsWFSUtils::acquireCacheDirectory() ).filePath( QStringLiteral( "wfs_cache_%1.sqlite" ).arg( sTmpCounter ) );
+  if ( mURI.persistentCache() && acquirePersistentCache() )
+  {
+    if ( openPersistentCache() )
+      return true;
+  }
+  else
+  {
+    static int sTmpCounter = 0;
+    ++sTmpCounter;
+    mCacheDbname =  QDir( QgsWFSUtils::acquireCacheDirectory() ).filePath( QStringLiteral( "wfs_cache_%1.sqlite" ).arg( sTmpCounter ) );
+  }
 
   QgsFields cacheFields;
   Q_FOREACH ( const QgsField &field, mFields )
@@ -428,6 +445,26 @@ bool QgsWFSSharedData::createCache()
       }
     }
 
+    if ( mPersistentCache )
+    {
+      QStringList statements;
+      statements << QStringLiteral( "CREATE TABLE __qgis_cache_metadata (key VARCHAR PRIMARY KEY, value VARCHAR)" );
+      statements << QStringLiteral( "CREATE TABLE __qgis_cached_regions (xmin REAL, ymin REAL, xmax REAL, ymax REAL, download_limit INTEGER)" );
+      statements << QStringLiteral( "INSERT INTO __qgis_cache_metadata VALUES ('format_version', '%1')" ).arg( PERSISTENT_CACHE_FORMAT_VERSION );
+      statements << QStringLiteral( "INSERT INTO __qgis_cache_metadata VALUES ('cache_key', '%1')" ).arg( persistentCacheKey() );
+      statements << QStringLiteral( "INSERT INTO __qgis_cache_metadata VALUES ('table_name', '%1')" ).arg( mCacheTablename );
+      statements << QStringLiteral( "INSERT INTO __qgis_cache_metadata VALUES ('creation_time', '%1')" ).arg( QDateTime::currentMSecsSinceEpoch() );
+      Q_FOREACH ( const QString &statement, statements )
+      {
+        rc = sqlite3_exec( db, statement.toUtf8(), nullptr, nullptr, nullptr );
+        if ( rc != SQLITE_OK )
+        {
+          QgsDebugMsg( QString( "%1 failed" ).arg( statement ) );
+          ret = false;
+        }
+      }
+    }
+
     ( void )sqlite3_exec( db, "COMMIT", nullptr, nullptr, nullptr );
 
     QgsSLConnect::sqlite3_close( db );
@@ -442,11 +479,17 @@ bool QgsWFSSharedData::createCache()
     return false;
   }
 
+  return connectToCache();
+}
+
+bool QgsWFSSharedData::connectToCache()
+{
   // Some pragmas to speed-up writing. We don't need much integrity guarantee
-  // regarding crashes, since this is a temporary DB
+  // regarding crashes, since this is a temporary DB. A persistent cache that
+  // would be damaged is simply discarded by openPersistentCache()
   QgsDataSourceUri dsURI;
   dsURI.setDatabase( mCacheDbname );
-  dsURI.setDataSource( QLatin1String( "" ), mCacheTablename, geometryFieldname, QLatin1String( "" ), fidName );
+  dsURI.setDataSource( QLatin1String( "" ), mCacheTablename, QStringLiteral( "__spatialite_geometry" ), QLatin1String( "" ), QStringLiteral( "__ogc_fid" ) );
   QStringList pragmas;
   pragmas << QStringLiteral( "synchronous=OFF" );
   pragmas << QStringLiteral( "journal_mode=WAL" ); // WAL is needed to avoid reader to block writers
@@ -467,6 +510,193 @@ bool QgsWFSSharedData::createCache()
   return true;
 }
 
+QString QgsWFSSharedData::persistentCacheKey() const
+{
+  // Everything that changes which features are requested, or how they are stored
+  QStringList components;
+  components << QString::number( PERSISTENT_CACHE_FORMAT_VERSION );
+  components << mURI.baseURL( false ).toString();
+  components << mURI.typeName();
+  components << mWFSVersion;
+  components << srsName();
+  components << mURI.outputFormat();
+  components << mWFSFilter;
+  components << mSortBy;
+  components << mGeometryAttribute;
+  components << QString::number( mDistinctSelect );
+  components << QString::number( mURI.ignoreAxisOrientation() );
+  components << QString::number( mURI.invertAxisOrientation() );
+  Q_FOREACH ( const QgsField &field, mFields )
+    components << QStringLiteral( "%1:%2" ).arg( field.name() ).arg( field.type() );
+
+  return QString( QCryptographicHash::hash( components.join( '\n' ).toUtf8(), QCryptographicHash::Md5 ).toHex() );
+}
+
+bool QgsWFSSharedData::acquirePersistentCache()
+{
+  QString dbname = QDir( QgsWFSUtils::persistentCacheDirectory() ).filePath( QStringLiteral( "wfs_cache_%1.sqlite" ).arg( persistentCacheKey() ) );
+
+  QLockFile *lock = new QLockFile( dbname + ".lock" );
+  // Only consider the lock stale if its owner is no longer running
+  lock->setStaleLockTime( 0 );
+  if ( !lock->tryLock( 0 ) )
+  {
+    QgsDebugMsg( QString( "Persistent cache %1 is already in use. Using a temporary cache" ).arg( dbname ) );
+    delete lock;
+    return false;
+  }
+
+  mPersistentCacheLock = lock;
+  mPersistentCache = true;
+  mCacheDbname = dbname;
+
+  // make room for the new content of this cache
+  QgsWFSUtils::trimPersistentCacheDirectory( mCacheDbname );
+  return true;
+}
+
+bool QgsWFSSharedData::openPersistentCache()
+{
+  if ( !QFile::exists( mCacheDbname ) )
+    return false;
+
+  QMap<QString, QString> metadata;
+  QVector<QgsFeature> regions;
+  int featureCount = -1;
+  int maxGenCounter = 0;
+
+  sqlite3 *db = nullptr;
+  if ( QgsSLConnect::sqlite3_open_v2( mCacheDbname.toUtf8(), &db, SQLITE_OPEN_READONLY, nullptr ) == SQLITE_OK )
+  {
+    sqlite3_stmt *stmt = nullptr;
+    if ( sqlite3_prepare_v2( db, "SELECT key, value FROM __qgis_cache_metadata", -1, &stmt, nullptr ) == SQLITE_OK )
+    {
+      while ( sqlite3_step( stmt ) == SQLITE_ROW )
+      {
+        metadata.insert( QString::fromUtf8( reinterpret_cast< const char * >( sqlite3_column_text( stmt, 0 ) ) ),
+                         QString::fromUtf8( reinterpret_cast< const char * >( sqlite3_column_text( stmt, 1 ) ) ) );
+      }
+    }
+    sqlite3_finalize( stmt );
+    stmt = nullptr;
+
+    if ( metadata.value( QStringLiteral( "format_version" ) ).toInt() == PERSISTENT_CACHE_FORMAT_VERSION &&
+         metadata.value( QStringLiteral( "cache_key" ) ) == persistentCacheKey() &&
+         sqlite3_prepare_v2( db, "SELECT xmin, ymin, xmax, ymax, download_limit FROM __qgis_cached_regions", -1, &stmt, nullptr ) == SQLITE_OK )
+    {
+      while ( sqlite3_step( stmt ) == SQLITE_ROW )
+      {
+        QgsFeature f;
+        f.setGeometry( QgsGeometry::fromRect( QgsRectangle( sqlite3_column_double( stmt, 0 ), sqlite3_column_double( stmt, 1 ),
+                       sqlite3_column_double( stmt, 2 ), sqlite3_column_double( stmt, 3 ) ) ) );
+        f.setId( regions.size() );
+        f.initAttributes( 1 );
+        f.setAttribute( 0, QVariant( sqlite3_column_int( stmt, 4 ) != 0 ) );
+        regions.push_back( f );
+      }
+      sqlite3_finalize( stmt );
+      stmt = nullptr;
+
+      mCacheTablename = metadata.value( QStringLiteral( "table_name" ) );
+      QString sql = QStringLiteral( "SELECT COUNT(*), MAX(%1) FROM %2" ).arg( quotedIdentifier( QgsWFSConstants::FIELD_GEN_COUNTER ),
+                    quotedIdentifier( mCacheTablename ) );
+      if ( sqlite3_prepare_v2( db, sql.toUtf8(), -1, &stmt, nullptr ) == SQLITE_OK && sqlite3_step( stmt ) == SQLITE_ROW )
+      {
+        featureCount = sqlite3_column_int( stmt, 0 );
+        maxGenCounter = sqlite3_column_int( stmt, 1 );
+      }
+    }
+    sqlite3_finalize( stmt );
+  }
+  QgsSLConnect::sqlite3_close( db );
+
+  // the server content may have changed since the cache was filled
+  const double maxAge = QgsWFSUtils::persistentCacheMaxAge();
+  const qint64 creationTime = metadata.value( QStringLiteral( "creation_time" ) ).toLongLong();
+  if ( featureCount >= 0 && maxAge > 0 && static_cast< double >( QDateTime::currentMSecsSinceEpoch() - creationTime ) > maxAge )
+  {
+    QgsMessageLog::logMessage( tr( "Discarding expired persistent cache %1" ).arg( mCacheDbname ), tr( "WFS" ) );
+    featureCount = -1;
+  }
+  else if ( featureCount < 0 )
+  {
+    QgsMessageLog::logMessage( tr( "Discarding unusable persistent cache %1" ).arg( mCacheDbname ), tr( "WFS" ) );
+  }
+
+  if ( featureCount < 0 || !connectToCache() )
+  {
+    QFile::remove( mCacheDbname );
+    QFile::remove( mCacheDbname + "-wal" );
+    QFile::remove( mCacheDbname + "-shm" );
+    return false;
+  }
+
+  // record the use of the cache, which keeps it from being trimmed as least recently used
+  executePersistentCacheSql( QStringList() << QStringLiteral( "INSERT OR REPLACE INTO __qgis_cache_metadata VALUES ('last_used', '%1')" ).arg( QDateTime::currentMSecsSinceEpoch() ) );
+
+  QgsDebugMsg( QString( "Reusing persistent cache %1 with %2 features and %3 cached regions" ).arg( mCacheDbname ).arg( featureCount ).arg( regions.size() ) );
+  mRegions = regions;
+  mCachedRegions = QgsSpatialIndex();
+  Q_FOREACH ( const QgsFeature &region, mRegions )
+    mCachedRegions.insertFeature( region );
+  mCacheComplete = metadata.value( QStringLiteral( "complete" ) ).toInt() == 1;
+  mFeatureCount = featureCount;
+  mFeatureCountExact = mCacheComplete;
+  mTotalFeaturesAttemptedToBeCached = featureCount;
+  // so that iterators see the features cached by previous sessions
+  mGenCounter = maxGenCounter + 1;
+
+  QStringList extent = metadata.value( QStringLiteral( "extent" ) ).split( ',' );
+  if ( extent.size() == 4 )
+    mComputedExtent = QgsRectangle( extent[0].toDouble(), extent[1].toDouble(), extent[2].toDouble(), extent[3].toDouble() );
+
+  return true;
+}
+
+bool QgsWFSSharedData::executePersistentCacheSql( const QStringList &statements )
+{
+  sqlite3 *db = nullptr;
+  bool ret = QgsSLConnect::sqlite3_open( mCacheDbname.toUtf8(), &db ) == SQLITE_OK;
+  if ( ret )
+  {
+    ( void )sqlite3_exec( db, "BEGIN", nullptr, nullptr, nullptr );
+    Q_FOREACH ( const QString &statement, statements )
+    {
+      if ( sqlite3_exec( db, statement.toUtf8(), nullptr, nullptr, nullptr ) != SQLITE_OK )
+      {
+        QgsDebugMsg( QString( "%1 failed" ).arg( statement ) );
+        ret = false;
+        break;
+      }
+    }
+    ( void )sqlite3_exec( db, ret ? "COMMIT" : "ROLLBACK", nullptr, nullptr, nullptr );
+  }
+  QgsSLConnect::sqlite3_close( db );
+  return ret;
+}
+
+QgsRectangle QgsWFSSharedData::uncoveredRect( const QgsRectangle &rect ) const
+{
+  QList<QgsGeometry> covered;
+  Q_FOREACH ( QgsFeatureId id, mCachedRegions.intersects( rect ) )
+  {
+    // regions that hit the download limit are only partially cached
+    if ( !mRegions[id].attributes().value( 0 ).toBool() )
+      covered << mRegions[id].geometry();
+  }
+  if ( covered.isEmpty() )
+    return rect;
+
+  QgsGeometry uncovered = QgsGeometry::fromRect( rect ).difference( QgsGeometry::unaryUnion( covered ) );
+  // Ignore slivers left by rounding errors on the region edges
+  if ( uncovered.isNull() || uncovered.isEmpty() || uncovered.area() <= rect.width() * rect.height() * 1e-10 )
+    return QgsRectangle();
+
+  // The server can only be queried by rectangle. Features of the covered parts
+  // of that rectangle are deduplicated when serialized.
+  return uncovered.boundingBox().intersect( &rect );
+}
+
 int QgsWFSSharedData::registerToCache( QgsWFSFeatureIterator *iterator, const QgsRectangle &rect )
 {
   // This locks prevents 2 readers to register at the same time (and particularly
@@ -494,7 +724,15 @@ int QgsWFSSharedData::registerToCache( QgsWFSFeatureIterator *iterator, const Qg
   // when "Only request features overlapping the view extent" : the offline editor
   // want to request all features whereas the map renderer only the view)
   bool newDownloadNeeded = false;
-  if ( !rect.isEmpty() && mRect != rect && !( mDownloader && mRect.isEmpty() ) )
+  bool cachedRegionsCoverRequest = false;
+  QgsRectangle downloadRect( rect );
+  if ( mCacheComplete )
+  {
+    // All the features of the layer are already in the persistent cache
+    QgsDebugMsg( "Persistent cache holds all features" );
+    cachedRegionsCoverRequest = true;
+  }
+  else if ( !rect.isEmpty() && mRequestRect != rect && !( mDownloader && mRect.isEmpty() ) )
   {
     QList<QgsFeatureId> intersectingRequests = mCachedRegions.intersects( rect );
     newDownloadNeeded = true;
@@ -524,6 +762,19 @@ int QgsWFSSharedData::registerToCache( QgsWFSFeatureIterator *iterator, const Qg
         break;
       }
     }
+
+    // With a persistent cache, the request may be covered by several cached
+    // regions. Otherwise only download the part that is not cached yet
+    if ( newDownloadNeeded && mPersistentCache )
+    {
+      downloadRect = uncoveredRect( rect );
+      if ( downloadRect.isNull() )
+      {
+        QgsDebugMsg( "Cached regions already cover this area of interest" );
+        newDownloadNeeded = false;
+      }
+    }
+    cachedRegionsCoverRequest = !newDownloadNeeded;
   }
   // If there's a ongoing download with a BBOX and we request a new download
   // without it, then we need a new download.
@@ -532,21 +783,29 @@ int QgsWFSSharedData::registerToCache( QgsWFSFeatureIterator *iterator, const Qg
     newDownloadNeeded = true;
   }
 
-  if ( newDownloadNeeded || !mDownloader )
+  if ( newDownloadNeeded || ( !mDownloader && !cachedRegionsCoverRequest ) )
   {
-    mRect = rect;
+    mRect = downloadRect;
+    mRequestRect = rect;
     // to prevent deadlock when waiting the end of the downloader thread that will try to take the mutex in serializeFeatures()
     mMutex.unlock();
     delete mDownloader;
     mMutex.lock();
     mDownloadFinished = false;
-    mComputedExtent = QgsRectangle();
+    // The extent of a persistent cache covers all the cached features, not only the ones being downloaded
+    if ( !mPersistentCache )
+      mComputedExtent = QgsRectangle();
     mDownloader = new QgsWFSThreadedFeatureDownloader( this );
     QEventLoop loop;
     connect( mDownloader, &QgsWFSThreadedFeatureDownloader::ready, &loop, &QEventLoop::quit );
     mDownloader->start();
     loop.exec( QEventLoop::ExcludeUserInputEvents );
   }
+  else if ( !mDownloader )
+  {
+    // The request is served from the persistent cache only
+    mDownloadFinished = true;
+  }
   if ( mDownloadFinished )
     return -1;
 
@@ -974,6 +1233,8 @@ void QgsWFSSharedData::endOfDownload( bool success, int featureCount,
 
   bool bDownloadLimit = truncatedResponse || ( !mCaps.supportsPaging && featureCount == mMaxFeatures && mMaxFeatures > 0 );
 
+  QStringList persistentStatements;
+
   mDownloadFinished = true;
   if ( success && !mRect.isEmpty() )
   {
@@ -1015,6 +1276,8 @@ void QgsWFSSharedData::endOfDownload( bool success, int featureCount,
     {
       mRegions.clear();
       mCachedRegions = QgsSpatialIndex();
+      if ( mPersistentCache )
+        persistentStatements << QStringLiteral( "DELETE FROM __qgis_cached_regions" );
     }
 
     // In case the download was successful, we will remember this bbox
@@ -1027,6 +1290,34 @@ void QgsWFSSharedData::endOfDownload( bool success, int featureCount,
     f.setAttribute( 0, QVariant( bDownloadLimit ) );
     mRegions.push_back( f );
     mCachedRegions.insertFeature( f );
+    if ( mPersistentCache )
+    {
+      persistentStatements << QStringLiteral( "INSERT INTO __qgis_cached_regions VALUES (%1, %2, %3, %4, %5)" )
+                           .arg( qgsDoubleToString( mRect.xMinimum() ),
+                                 qgsDoubleToString( mRect.yMinimum() ),
+                                 qgsDoubleToString( mRect.xMaximum() ),
+                                 qgsDoubleToString( mRect.yMaximum() ) )
+                           .arg( bDownloadLimit ? 1 : 0 );
+    }
+  }
+
+  if ( mRect.isEmpty() && success && !bDownloadLimit )
+    mCacheComplete = true;
+
+  if ( mPersistentCache )
+  {
+    QString extent;
+    if ( !mComputedExtent.isNull() )
+    {
+      extent = QStringLiteral( "%1,%2,%3,%4" ).arg( qgsDoubleToString( mComputedExtent.xMinimum() ),
+               qgsDoubleToString( mComputedExtent.yMinimum() ),
+               qgsDoubleToString( mComputedExtent.xMaximum() ),
+               qgsDoubleToString( mComputedExtent.yMaximum() ) );
+    }
+    persistentStatements << QStringLiteral( "INSERT OR REPLACE INTO __qgis_cache_metadata VALUES ('extent', '%1')" ).arg( extent );
+    persistentStatements << QStringLiteral( "INSERT OR REPLACE INTO __qgis_cache_metadata VALUES ('complete', '%1')" ).arg( mCacheComplete ? 1 : 0 );
+    if ( !executePersistentCacheSql( persistentStatements ) )
+      QgsMessageLog::logMessage( tr( "Cannot update persistent cache %1" ).arg( mCacheDbname ), tr( "WFS" ) );
   }
 
   if ( mRect.isEmpty() && success && !bDownloadLimit && !mFeatureCountExact )
@@ -1056,7 +1347,7 @@ void QgsWFSSharedData::endOfDownload( bool success, int featureCount,
 
 // This is called by the destructor or QgsWFSProvider::reloadData(). The effect is to invalid
 // all the caching state, so that a new request results in fresh download
-void QgsWFSSharedData::invalidateCache()
+void QgsWFSSharedData::invalidateCache( bool removePersistentCache )
 {
   // Cf explanations in registerToCache() for the locking strategy
   QMutexLocker lockerMyself( &mMutexRegisterToCache );
@@ -1073,6 +1364,8 @@ void QgsWFSSharedData::invalidateCache()
   mCachedRegions = QgsSpatialIndex();
   mRegions.clear();
   mRect = QgsRectangle();
+  mRequestRect = QgsRectangle();
+  mCacheComplete = false;
   mGetFeatureHitsIssued = false;
   mFeatureCount = 0;
   mFeatureCountExact = false;
@@ -1088,12 +1381,21 @@ void QgsWFSSharedData::invalidateCache()
 
   if ( !mCacheDbname.isEmpty() )
   {
-    QFile::remove( mCacheDbname );
-    QFile::remove( mCacheDbname + "-wal" );
-    QFile::remove( mCacheDbname + "-shm" );
-    QgsWFSUtils::releaseCacheDirectory();
+    if ( !mPersistentCache || removePersistentCache )
+    {
+      QFile::remove( mCacheDbname );
+      QFile::remove( mCacheDbname + "-wal" );
+      QFile::remove( mCacheDbname + "-shm" );
+    }
+    if ( !mPersistentCache )
+      QgsWFSUtils::releaseCacheDirectory();
     mCacheDbname.clear();
   }
+
+  // releases the lock file
+  delete mPersistentCacheLock;
+  mPersistentCacheLock = nullptr;
+  mPersistentCache = false;
 }
 
 void QgsWFSSharedData::setFeatureCount( int featureCount )
@@ -21,6 +21,8 @@
 #include "qgswfscapabilities.h"
 #include "qgsogcutils.h"
 
+class QLockFile;
+
 /** This class holds data, and logic, shared between QgsWFSProvider, QgsWFSFeatureIterator
  *  and QgsWFSFeatureDownloader. It manages the on-disk cache, as a SpatiaLite
  *  database.
@@ -43,6 +45,18 @@
  *
  *  It contains also methods used in WFS-T context to update the cache content,
  *  from the changes initiated by the user.
+ *
+ *  When the persistentCache=1 URI parameter is set, the database is not a
+ *  temporary file, but is stored in the persistent cache directory under a name
+ *  derived from the service URL, typename, filter and layer schema, and is reused
+ *  by later sessions. It then also contains:
+ *  - __qgis_cache_metadata: key/value pairs describing the cache state
+ *  - __qgis_cached_regions: the BBOX of the successful downloads, and whether
+ *    they hit the download limit
+ *  so that only the areas not covered yet by the cache are requested to the server.
+ *  A persistent cache older than the wfs/persistent_cache_max_age_days setting is
+ *  discarded when it is opened, and the least recently used caches are removed when
+ *  the persistent cache directory grows over the wfs/persistent_cache_max_size_mb setting.
  */
 class QgsWFSSharedData : public QObject
 {
@@ -67,8 +81,10 @@ class QgsWFSSharedData : public QObject
     void endOfDownload( bool success, int featureCount, bool truncatedResponse, bool interrupted, const QString &errorMsg );
 
     /** Used by QgsWFSProvider::reloadData(). The effect is to invalid
-        all the caching state, so that a new request results in fresh download */
-    void invalidateCache();
+        all the caching state, so that a new request results in fresh download.
+        If removePersistentCache is false, a persistent cache is closed but kept
+        on disk for later sessions. */
+    void invalidateCache( bool removePersistentCache = true );
 
     //! Give a feature id, find the correspond fid/gml.id. Used by WFS-T
     QString findGmlId( QgsFeatureId fid );
@@ -147,6 +163,10 @@ class QgsWFSSharedData : public QObject
     //! Current BBOX used by the downloader
     QgsRectangle mRect;
 
+    /** BBOX requested by the iterator that started the current download. With a
+        persistent cache, mRect might only be the part of it not cached yet */
+    QgsRectangle mRequestRect;
+
     //! Server-side or user-side limit of downloaded features (in a single GetFeature()). Valid if > 0
     int mMaxFeatures;
 
@@ -220,6 +240,15 @@ class QgsWFSSharedData : public QObject
     //! Tablename of the on-disk cache
     QString mCacheTablename;
 
+    //! Whether the on-disk cache is a persistent cache, kept across sessions
+    bool mPersistentCache;
+
+    //! Prevents several layers or QGIS instances from writing the same persistent cache
+    QLockFile *mPersistentCacheLock = nullptr;
+
+    //! Whether the persistent cache holds all the features of the layer
+    bool mCacheComplete;
+
     //! Spatial index of requested cached regions
     QgsSpatialIndex mCachedRegions;
 
@@ -246,6 +275,25 @@ class QgsWFSSharedData : public QObject
     //! Create the on-disk cache and connect to it
     bool createCache();
 
+    //! Connect the cache data provider to the on-disk cache
+    bool connectToCache();
+
+    //! Return the identifier of the persistent cache matching the layer definition
+    QString persistentCacheKey() const;
+
+    //! Lock the persistent cache of the layer. Returns false if it is used by someone else
+    bool acquirePersistentCache();
+
+    //! Connect to an existing persistent cache and restore its state. Returns false if it cannot be reused
+    bool openPersistentCache();
+
+    //! Execute SQL statements on the persistent cache, in a single transaction
+    bool executePersistentCacheSql( const QStringList &statements );
+
+    /** Return the bounding box of the part of rect that is not covered by cached
+        regions, or a null rectangle if rect is completely covered */
+    QgsRectangle uncoveredRect( const QgsRectangle &rect ) const;
+
     //! Log error to QgsMessageLog and raise it to the provider
     void pushError( const QString &errorMsg );
 };
@@ -28,6 +28,8 @@
 #include <QSharedMemory>
 #include <QDateTime>
 #include <QCryptographicHash>
+#include <QLockFile>
+#include <algorithm>
 
 QMutex QgsWFSUtils::sMutex;
 QThread *QgsWFSUtils::sThread = nullptr;
@@ -74,6 +76,88 @@ QString QgsWFSUtils::getCacheDirectory( bool createIfNotExisting )
   return QDir( baseDirectory ).filePath( processPath );
 }
 
+QString QgsWFSUtils::persistentCacheDirectory()
+{
+  QString baseDirectory( getBaseCacheDirectory( true ) );
+  QMutexLocker locker( &sMutex );
+  if ( !QDir( baseDirectory ).exists( QStringLiteral( "persistent" ) ) )
+  {
+    QgsDebugMsg( QString( "Creating persistent cache dir %1/persistent" ).arg( baseDirectory ) );
+    QDir( baseDirectory ).mkpath( QStringLiteral( "persistent" ) );
+  }
+  return QDir( baseDirectory ).filePath( QStringLiteral( "persistent" ) );
+}
+
+double QgsWFSUtils::persistentCacheMaxAge()
+{
+  QgsSettings settings;
+  // not rounded, so that fractional settings do not become 0 and never expire
+  return settings.value( QStringLiteral( "wfs/persistent_cache_max_age_days" ), 7 ).toDouble() * 24 * 3600 * 1000;
+}
+
+void QgsWFSUtils::trimPersistentCacheDirectory( const QString &keepDbname )
+{
+  QgsSettings settings;
+  const qint64 maxSize = settings.value( QStringLiteral( "wfs/persistent_cache_max_size_mb" ), 1024 ).toLongLong() * 1024 * 1024;
+  if ( maxSize <= 0 )
+    return;
+
+  struct CacheFile
+  {
+    QString dbname;
+    qint64 size;
+    QDateTime lastUsed;
+  };
+
+  // A cache is written to whenever it is used, so the most recent modification
+  // of its database or write-ahead log tells when it was last used
+  QList< CacheFile > caches;
+  qint64 totalSize = 0;
+  QDir dir( persistentCacheDirectory() );
+  Q_FOREACH ( const QFileInfo &info, dir.entryInfoList( QStringList() << QStringLiteral( "wfs_cache_*.sqlite" ), QDir::Files ) )
+  {
+    CacheFile cache;
+    cache.dbname = info.absoluteFilePath();
+    cache.size = info.size();
+    cache.lastUsed = info.lastModified();
+    Q_FOREACH ( const QString &suffix, QStringList() << QStringLiteral( "-wal" ) << QStringLiteral( "-shm" ) )
+    {
+      QFileInfo auxInfo( cache.dbname + suffix );
+      if ( !auxInfo.exists() )
+        continue;
+      cache.size += auxInfo.size();
+      cache.lastUsed = std::max( cache.lastUsed, auxInfo.lastModified() );
+    }
+    totalSize += cache.size;
+    caches << cache;
+  }
+
+  if ( totalSize <= maxSize )
+    return;
+
+  std::sort( caches.begin(), caches.end(), []( const CacheFile & a, const CacheFile & b ) { return a.lastUsed < b.lastUsed; } );
+  Q_FOREACH ( const CacheFile &cache, caches )
+  {
+    if ( totalSize <= maxSize )
+      break;
+    if ( QFileInfo( cache.dbname ) == QFileInfo( keepDbname ) )
+      continue;
+
+    // caches used by other layers or QGIS instances are locked
+    QLockFile lock( cache.dbname + ".lock" );
+    lock.setStaleLockTime( 0 );
+    if ( !lock.tryLock( 0 ) )
+      continue;
+
+    QgsDebugMsg( QString( "Removing least recently used persistent cache %1" ).arg( cache.dbname ) );
+    QFile::remove( cache.dbname );
+    QFile::remove( cache.dbname + "-wal" );
+    QFile::remove( cache.dbname + "-shm" );
+    totalSize -= cache.size;
+    lock.unlock();
+  }
+}
+
 QString QgsWFSUtils::acquireCacheDirectory()
 {
   return getCacheDirectory( true );
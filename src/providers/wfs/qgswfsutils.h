@@ -36,6 +36,19 @@ class QgsWFSUtils
     //! Initial cleanup.
     static void init();
 
+    /** Return the name of the directory holding the caches that persist across sessions.
+        Unlike the temporary directory, it is never cleaned up automatically. */
+    static QString persistentCacheDirectory();
+
+    /** Return the age in milliseconds after which a persistent cache is discarded, as set by
+        the wfs/persistent_cache_max_age_days setting. A value <= 0 means that caches never expire. */
+    static double persistentCacheMaxAge();
+
+    /** Remove the least recently used persistent caches, until the persistent cache directory
+        fits in the wfs/persistent_cache_max_size_mb setting. Caches in use, and the cache
+        named keepDbname, are never removed. */
+    static void trimPersistentCacheDirectory( const QString &keepDbname );
+
     //! Removes a possible namespace prefix from a typename
     static QString removeNamespacePrefix( const QString &tname );
     //! Returns namespace prefix (or an empty string if there is no prefix)
@@ -64,6 +64,12 @@ class SERVER_EXPORT QgsAccessControl : public QgsFeatureFilterProvider
       delete mPluginsAccessControls;
     }
 
+    /** Returns true if no access control filter plugin is registered, in which case
+     * every permission is granted and layers do not need to be loaded to check them.
+     * \since QGIS 3.0
+     */
+    bool isEmpty() const { return mPluginsAccessControls->isEmpty(); }
+
     /** Resolve features' filter of layers
      * \param layers to filter
      */
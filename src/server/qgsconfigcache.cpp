@@ -45,6 +45,7 @@ const QgsProject *QgsConfigCache::project( const QString &path )
   if ( ! mProjectCache[ path ] )
   {
     std::unique_ptr<QgsProject> prj( new QgsProject() );
+    prj->setLazyLayerLoading( mLazyProjectLayers );
     if ( prj->read( path ) )
     {
       mProjectCache.insert( path, prj.release() );
@@ -54,6 +55,51 @@ const QgsProject *QgsConfigCache::project( const QString &path )
   return mProjectCache[ path ];
 }
 
+void QgsConfigCache::unloadIdleLayers( int maximumLayers )
+{
+  Q_FOREACH ( const QString &path, mProjectCache.keys() )
+  {
+    QgsProject *prj = mProjectCache.object( path );
+    if ( prj && prj->lazyLayerLoading() )
+    {
+      int count = prj->unloadIdleLayers( maximumLayers );
+      if ( count > 0 )
+      {
+        QgsMessageLog::logMessage( QStringLiteral( "Unloaded %1 idle layers of project '%2'" ).arg( count ).arg( path ),
+                                   QStringLiteral( "Server" ), QgsMessageLog::INFO );
+      }
+    }
+  }
+}
+
+QgsMapLayer *QgsConfigCache::loadLayer( const QgsProject *project, const QString &layerId )
+{
+  if ( QgsProject *prj = cachedProject( project ) )
+    return prj->loadLayer( layerId );
+
+  return project ? project->mapLayer( layerId ) : nullptr;
+}
+
+void QgsConfigCache::loadAllLayers( const QgsProject *project )
+{
+  if ( QgsProject *prj = cachedProject( project ) )
+    prj->loadAllLayers();
+}
+
+QgsProject *QgsConfigCache::cachedProject( const QgsProject *project ) const
+{
+  if ( !project )
+    return nullptr;
+
+  Q_FOREACH ( const QString &path, mProjectCache.keys() )
+  {
+    QgsProject *prj = mProjectCache.object( path );
+    if ( prj == project )
+      return prj;
+  }
+  return nullptr;
+}
+
 QgsServerProjectParser *QgsConfigCache::serverConfiguration( const QString &filePath )
 {
   QgsMessageLog::logMessage(
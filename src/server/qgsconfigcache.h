@@ -55,9 +55,45 @@ class SERVER_EXPORT QgsConfigCache : public QObject
      */
     const QgsProject *project( const QString &path );
 
+    /** Sets whether projects are read with lazy layer loading, so that layers
+     * are only created when first used by a request. This applies to projects
+     * read after the call.
+     * \see QgsProject::setLazyLayerLoading()
+     * \since QGIS 3.0
+     */
+    void setLazyProjectLayers( bool lazy ) { mLazyProjectLayers = lazy; }
+
+    /** Unloads the least recently used layers of cached projects read with lazy
+     * layer loading, keeping at most \a maximumLayers loaded layers per project.
+     * Must not be called while a request is using the projects.
+     * \see QgsProject::unloadIdleLayers()
+     * \since QGIS 3.0
+     */
+    void unloadIdleLayers( int maximumLayers );
+
+    /** Returns the layer with the given \a layerId of a cached \a project, loading
+     * it first if the project was read with lazy layer loading and the layer is not
+     * loaded yet. For a project which is not cached, this is the same as
+     * QgsProject::mapLayer().
+     * \returns the layer or nullptr if it does not exist or could not be loaded
+     * \see QgsProject::loadLayer()
+     * \since QGIS 3.0
+     */
+    QgsMapLayer *loadLayer( const QgsProject *project, const QString &layerId );
+
+    /** Loads all layers of a cached \a project which was read with lazy layer
+     * loading, so that QgsProject::mapLayers() returns them all.
+     * \see QgsProject::loadAllLayers()
+     * \since QGIS 3.0
+     */
+    void loadAllLayers( const QgsProject *project );
+
   private:
     QgsConfigCache() SIP_FORCE;
 
+    //! Returns the cached project matching \a project, or nullptr if it is not cached
+    QgsProject *cachedProject( const QgsProject *project ) const;
+
     //! Check for configuration file updates (remove entry from cache if file changes)
     QFileSystemWatcher mFileSystemWatcher;
 
@@ -68,6 +104,8 @@ class SERVER_EXPORT QgsConfigCache : public QObject
     QCache<QString, QgsWmsConfigParser> mWMSConfigCache;
     QCache<QString, QgsProject> mProjectCache;
 
+    bool mLazyProjectLayers = false;
+
   private slots:
     //! Removes changed entry from this cache
     void removeChangedEntry( const QString &path );
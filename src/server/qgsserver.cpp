@@ -222,6 +222,7 @@ bool QgsServer::init()
   // init and configure cache
   QgsMSLayerCache::instance();
   QgsMSLayerCache::instance()->setMaxCacheLayers( sSettings.maxCacheLayers() );
+  QgsConfigCache::instance()->setLazyProjectLayers( sSettings.lazyProjectLayers() );
 
   // log settings currently used
   sSettings.logSummary();
@@ -405,6 +406,10 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
   // Terminate the response
   responseDecorator.finish();
 
+  // release layers of lazily loaded projects which are no longer in use
+  if ( sSettings.lazyProjectLayers() )
+    mConfigCache->unloadIdleLayers( sSettings.maxCacheLayers() );
+
   // We are done using requestHandler in plugins, make sure we don't access
   // to a deleted request handler from Python bindings
   sServerInterface->clearRequestHandler();
@@ -46,8 +46,11 @@ QgsServerProjectParser::QgsServerProjectParser( QDomDocument *xmlDoc, const QStr
   , mProject( QgsConfigCache::instance()->project( filePath ) )
   , mProjectPath( filePath )
 {
-  QMap<QString, QgsMapLayer *> layers = mProject->mapLayers();
-  mProjectLayerElements.reserve( layers.size() );
+  // layers of a lazily loaded project which are not loaded yet are taken from
+  // the project XML, without loading them
+  QMap<QString, QgsMapLayer *> layers = mProject->layerStore()->mapLayers();
+  QStringList unloadedLayerIds = mProject->unloadedLayerIds();
+  mProjectLayerElements.reserve( layers.size() + unloadedLayerIds.size() );
   Q_FOREACH ( QgsMapLayer *layer, layers )
   {
     QDomDocument doc;
@@ -64,6 +67,20 @@ QgsServerProjectParser::QgsServerProjectParser( QDomDocument *xmlDoc, const QStr
     mProjectLayerElementsByName.insert( name, el );
     mProjectLayerElementsById.insert( layer->id(), el );
   }
+  Q_FOREACH ( const QString &layerId, unloadedLayerIds )
+  {
+    QDomElement el = mProject->unloadedLayerElement( layerId ).cloneNode().toElement();
+    mProjectLayerElements.push_back( el );
+
+    QString name = el.firstChildElement( QStringLiteral( "shortname" ) ).text();
+    if ( name.isEmpty() )
+    {
+      name = el.firstChildElement( QStringLiteral( "layername" ) ).text();
+    }
+
+    mProjectLayerElementsByName.insert( name, el );
+    mProjectLayerElementsById.insert( layerId, el );
+  }
 
   mRestrictedLayers = findRestrictedLayers();
 
@@ -99,16 +116,21 @@ bool QgsServerProjectParser::useLayerIds() const
 
 QStringList QgsServerProjectParser::layersNames() const
 {
+  // names of layers which are not loaded are read from the project XML
+  QStringList layerIds = mProject->mapLayers().keys() + mProject->unloadedLayerIds();
+  layerIds.sort();
+
   QStringList names;
-  Q_FOREACH ( QgsMapLayer *layer, mProject->mapLayers() )
+  Q_FOREACH ( const QString &layerId, layerIds )
   {
-    if ( ! layer->shortName().isEmpty() )
+    QgsServerProjectUtils::LayerProperties layer = QgsServerProjectUtils::layerProperties( *mProject, layerId );
+    if ( ! layer.shortName.isEmpty() )
     {
-      names.append( layer->shortName() );
+      names.append( layer.shortName );
     }
     else
     {
-      names.append( layer->name() );
+      names.append( layer.name );
     }
   }
 
@@ -1069,19 +1091,7 @@ QSet<QString> QgsServerProjectParser::findRestrictedLayers() const
   {
     if ( restrictedLayersNames.contains( layer->name() ) )
     {
-      QString shortName = layer->layer()->shortName();
-      if ( QgsServerProjectUtils::wmsUseLayerIds( *mProject ) )
-      {
-        restrictedLayers.insert( layer->layerId() );
-      }
-      else if ( ! shortName.isEmpty() )
-      {
-        restrictedLayers.insert( shortName );
-      }
-      else
-      {
-        restrictedLayers.insert( layer->name() );
-      }
+      restrictedLayers.insert( QgsServerProjectUtils::wmsLayerNickname( *mProject, layer->layerId() ) );
     }
   }
 
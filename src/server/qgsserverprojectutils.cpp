@@ -16,6 +16,9 @@
  ***************************************************************************/
 
 #include "qgsserverprojectutils.h"
+#include "qgsmaplayerstylemanager.h"
+#include "qgsvectorlayer.h"
+#include "qgsxmlutils.h"
 
 bool QgsServerProjectUtils::owsServiceCapabilities( const QgsProject &project )
 {
@@ -338,3 +341,135 @@ QStringList QgsServerProjectUtils::wcsLayerIds( const QgsProject &project )
 {
   return project.readListEntry( QStringLiteral( "WCSLayers" ), QStringLiteral( "/" ) );
 }
+
+QString QgsServerProjectUtils::wmsLayerNickname( const QgsProject &project, const QString &layerId )
+{
+  if ( wmsUseLayerIds( project ) )
+    return layerId;
+
+  QString shortName;
+  QString name;
+  QDomElement layerElem = project.unloadedLayerElement( layerId );
+  if ( !layerElem.isNull() )
+  {
+    shortName = layerElem.firstChildElement( QStringLiteral( "shortname" ) ).text();
+    name = layerElem.firstChildElement( QStringLiteral( "layername" ) ).text();
+  }
+  else if ( QgsMapLayer *layer = project.mapLayer( layerId ) )
+  {
+    shortName = layer->shortName();
+    name = layer->name();
+  }
+
+  return shortName.isEmpty() ? name : shortName;
+}
+
+QgsServerProjectUtils::LayerProperties QgsServerProjectUtils::layerProperties( const QgsProject &project, const QString &layerId )
+{
+  LayerProperties properties;
+
+  if ( QgsMapLayer *layer = project.mapLayer( layerId ) )
+  {
+    properties.valid = true;
+    properties.id = layer->id();
+    properties.type = layer->type();
+    properties.name = layer->name();
+    properties.shortName = layer->shortName();
+    properties.title = layer->title();
+    properties.abstract = layer->abstract();
+    properties.keywordList = layer->keywordList();
+    if ( QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer ) )
+      properties.hasGeometry = vl->wkbType() != QgsWkbTypes::NoGeometry;
+    properties.crs = layer->crs();
+    properties.extent = layer->extent();
+    properties.hasScaleBasedVisibility = layer->hasScaleBasedVisibility();
+    properties.minimumScale = layer->minimumScale();
+    properties.maximumScale = layer->maximumScale();
+    properties.dataUrl = layer->dataUrl();
+    properties.dataUrlFormat = layer->dataUrlFormat();
+    properties.legendUrl = layer->legendUrl();
+    properties.legendUrlFormat = layer->legendUrlFormat();
+    properties.attribution = layer->attribution();
+    properties.attributionUrl = layer->attributionUrl();
+    properties.metadataUrl = layer->metadataUrl();
+    properties.metadataUrlType = layer->metadataUrlType();
+    properties.metadataUrlFormat = layer->metadataUrlFormat();
+    properties.styles = layer->styleManager()->styles();
+    return properties;
+  }
+
+  // read the properties the same way QgsMapLayer::readLayerXml() does
+  QDomElement layerElem = project.unloadedLayerElement( layerId );
+  if ( layerElem.isNull() )
+    return properties;
+
+  properties.valid = true;
+  properties.id = layerId;
+
+  QString type = layerElem.attribute( QStringLiteral( "type" ) );
+  if ( type == QLatin1String( "vector" ) )
+  {
+    properties.type = QgsMapLayer::VectorLayer;
+    properties.hasGeometry = layerElem.attribute( QStringLiteral( "geometry" ) ) != QgsWkbTypes::geometryDisplayString( QgsWkbTypes::NullGeometry );
+  }
+  else if ( type == QLatin1String( "raster" ) )
+    properties.type = QgsMapLayer::RasterLayer;
+  else
+    properties.type = QgsMapLayer::PluginLayer;
+
+  properties.name = layerElem.firstChildElement( QStringLiteral( "layername" ) ).text();
+  properties.shortName = layerElem.firstChildElement( QStringLiteral( "shortname" ) ).text();
+  properties.title = layerElem.firstChildElement( QStringLiteral( "title" ) ).text();
+  properties.abstract = layerElem.firstChildElement( QStringLiteral( "abstract" ) ).text();
+
+  QStringList keywords;
+  QDomElement keywordListElem = layerElem.firstChildElement( QStringLiteral( "keywordList" ) );
+  for ( QDomNode n = keywordListElem.firstChild(); !n.isNull(); n = n.nextSibling() )
+  {
+    keywords << n.toElement().text();
+  }
+  properties.keywordList = keywords.join( QStringLiteral( ", " ) );
+
+  properties.crs.readXml( layerElem.namedItem( QStringLiteral( "srs" ) ) );
+  QDomElement extentElem = layerElem.firstChildElement( QStringLiteral( "extent" ) );
+  if ( !extentElem.isNull() )
+    properties.extent = QgsXmlUtils::readRectangle( extentElem );
+
+  properties.hasScaleBasedVisibility = layerElem.attribute( QStringLiteral( "hasScaleBasedVisibilityFlag" ) ).toInt() == 1;
+  if ( layerElem.hasAttribute( QStringLiteral( "minimumScale" ) ) )
+  {
+    // older element, when scales were reversed
+    properties.maximumScale = layerElem.attribute( QStringLiteral( "minimumScale" ) ).toDouble();
+    properties.minimumScale = layerElem.attribute( QStringLiteral( "maximumScale" ) ).toDouble();
+  }
+  else
+  {
+    properties.maximumScale = layerElem.attribute( QStringLiteral( "maxScale" ) ).toDouble();
+    properties.minimumScale = layerElem.attribute( QStringLiteral( "minScale" ) ).toDouble();
+  }
+
+  QDomElement dataUrlElem = layerElem.firstChildElement( QStringLiteral( "dataUrl" ) );
+  properties.dataUrl = dataUrlElem.text();
+  properties.dataUrlFormat = dataUrlElem.attribute( QStringLiteral( "format" ) );
+  QDomElement legendUrlElem = layerElem.firstChildElement( QStringLiteral( "legendUrl" ) );
+  properties.legendUrl = legendUrlElem.text();
+  properties.legendUrlFormat = legendUrlElem.attribute( QStringLiteral( "format" ) );
+  QDomElement attribElem = layerElem.firstChildElement( QStringLiteral( "attribution" ) );
+  properties.attribution = attribElem.text();
+  properties.attributionUrl = attribElem.attribute( QStringLiteral( "href" ) );
+  QDomElement metaUrlElem = layerElem.firstChildElement( QStringLiteral( "metadataUrl" ) );
+  properties.metadataUrl = metaUrlElem.text();
+  properties.metadataUrlType = metaUrlElem.attribute( QStringLiteral( "type" ) );
+  properties.metadataUrlFormat = metaUrlElem.attribute( QStringLiteral( "format" ) );
+
+  // same style names as QgsMapLayerStyleManager::readXml() and reset()
+  QgsMapLayerStyleManager styleManager( nullptr );
+  QDomElement styleMgrElem = layerElem.firstChildElement( QStringLiteral( "map-layer-style-manager" ) );
+  if ( !styleMgrElem.isNull() )
+    styleManager.readXml( styleMgrElem );
+  else
+    styleManager.reset();
+  properties.styles = styleManager.styles();
+
+  return properties;
+}
@@ -20,6 +20,9 @@
 
 #include "qgis_server.h"
 #include "qgsproject.h"
+#include "qgsmaplayer.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgsrectangle.h"
 
 #ifdef SIP_RUN
 % ModuleHeaderCode
@@ -295,6 +298,68 @@ namespace QgsServerProjectUtils
     * \returns the Layer ids list.
     */
   SERVER_EXPORT QStringList wcsLayerIds( const QgsProject &project );
+
+  /** Returns the name under which a layer is published in WMS: its id if the project
+    * uses layer ids, otherwise its short name or, if not set, its name. For a layer
+    * which is not loaded yet (see QgsProject::setLazyLayerLoading()), the name is read
+    * from the project XML without loading the layer.
+    * \param project the QGIS project
+    * \param layerId the layer id in the project
+    * \returns the layer nickname, or an empty string if the layer does not exist.
+    * \since QGIS 3.0
+    */
+  SERVER_EXPORT QString wmsLayerNickname( const QgsProject &project, const QString &layerId );
+
+#ifndef SIP_RUN
+
+  /** Properties of a project layer which are published in capabilities documents.
+    * \see layerProperties()
+    * \note not available in Python bindings
+    * \since QGIS 3.0
+    */
+  struct LayerProperties
+  {
+    //! False if the layer does not exist in the project
+    bool valid = false;
+    QString id;
+    QgsMapLayer::LayerType type = QgsMapLayer::VectorLayer;
+    QString name;
+    QString shortName;
+    QString title;
+    QString abstract;
+    QString keywordList;
+    //! False for vector layers without geometry
+    bool hasGeometry = true;
+    QgsCoordinateReferenceSystem crs;
+    QgsRectangle extent;
+    bool hasScaleBasedVisibility = false;
+    double minimumScale = 0;
+    double maximumScale = 0;
+    QString dataUrl;
+    QString dataUrlFormat;
+    QString legendUrl;
+    QString legendUrlFormat;
+    QString attribution;
+    QString attributionUrl;
+    QString metadataUrl;
+    QString metadataUrlType;
+    QString metadataUrlFormat;
+    QStringList styles;
+  };
+
+  /** Returns the properties of a project layer which are published in capabilities
+    * documents. For a layer which is not loaded (see QgsProject::setLazyLayerLoading()),
+    * they are read from the project XML without loading the layer. In that case the
+    * extent is the one stored in the project.
+    * \param project the QGIS project
+    * \param layerId the layer id in the project
+    * \returns the layer properties, which are not valid if the layer does not exist
+    * \note not available in Python bindings
+    * \since QGIS 3.0
+    */
+  SERVER_EXPORT LayerProperties layerProperties( const QgsProject &project, const QString &layerId );
+
+#endif
 };
 
 #endif
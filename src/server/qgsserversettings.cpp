@@ -130,6 +130,17 @@ void QgsServerSettings::initSettings()
                                QVariant()
                              };
   mSettings[ sCacheSize.envVar ] = sCacheSize;
+
+  // lazy project layers
+  const Setting sLazyLayers = { QgsServerSettingsEnv::QGIS_SERVER_LAZY_PROJECT_LAYERS,
+                                QgsServerSettingsEnv::DEFAULT_VALUE,
+                                "Load project layers when first used by a request",
+                                "/qgis/server_lazy_project_layers",
+                                QVariant::Bool,
+                                QVariant( false ),
+                                QVariant()
+                              };
+  mSettings[ sLazyLayers.envVar ] = sLazyLayers;
 }
 
 void QgsServerSettings::load()
@@ -291,6 +302,11 @@ int QgsServerSettings::maxCacheLayers() const
   return value( QgsServerSettingsEnv::MAX_CACHE_LAYERS ).toInt();
 }
 
+bool QgsServerSettings::lazyProjectLayers() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_LAZY_PROJECT_LAYERS ).toBool();
+}
+
 QString QgsServerSettings::projectFile() const
 {
   return value( QgsServerSettingsEnv::QGIS_PROJECT_FILE ).toString();
@@ -56,7 +56,8 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_PROJECT_FILE,
       MAX_CACHE_LAYERS,
       QGIS_SERVER_CACHE_DIRECTORY,
-      QGIS_SERVER_CACHE_SIZE
+      QGIS_SERVER_CACHE_SIZE,
+      QGIS_SERVER_LAZY_PROJECT_LAYERS
     };
     Q_ENUM( EnvVar )
 };
@@ -119,6 +120,14 @@ class SERVER_EXPORT QgsServerSettings
       */
     int maxCacheLayers() const;
 
+    /**
+      * Returns whether layers of projects are loaded lazily, when first used
+      * by a request.
+      * \returns true if layers are loaded lazily, false otherwise.
+      * \since QGIS 3.0
+      */
+    bool lazyProjectLayers() const;
+
     /** Returns the log level.
       * \returns the log level.
       */
@@ -18,6 +18,7 @@
  ***************************************************************************/
 #include "qgswcsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 #include "qgswcsgetcapabilities.h"
 
 #include "qgsproject.h"
@@ -263,8 +264,9 @@ namespace QgsWcs
     QStringList wcsLayersId = QgsServerProjectUtils::wcsLayerIds( *project );
     for ( int i = 0; i < wcsLayersId.size(); ++i )
     {
-      QgsMapLayer *layer = project->mapLayer( wcsLayersId.at( i ) );
-      if ( layer->type() != QgsMapLayer::LayerType::RasterLayer )
+      // load the layer if the project was read lazily
+      QgsMapLayer *layer = QgsConfigCache::instance()->loadLayer( project, wcsLayersId.at( i ) );
+      if ( !layer || layer->type() != QgsMapLayer::LayerType::RasterLayer )
       {
         continue;
       }
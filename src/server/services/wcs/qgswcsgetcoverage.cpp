@@ -18,6 +18,7 @@
  ***************************************************************************/
 #include "qgswcsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 #include "qgswcsgetcoverage.h"
 
 #include "qgsrasterlayer.h"
@@ -78,8 +79,9 @@ namespace QgsWcs
     QgsRasterLayer *rLayer = nullptr;
     for ( int i = 0; i < wcsLayersId.size(); ++i )
     {
-      QgsMapLayer *layer = project->mapLayer( wcsLayersId.at( i ) );
-      if ( layer->type() != QgsMapLayer::LayerType::RasterLayer )
+      // load the layer if the project was read lazily
+      QgsMapLayer *layer = QgsConfigCache::instance()->loadLayer( project, wcsLayersId.at( i ) );
+      if ( !layer || layer->type() != QgsMapLayer::LayerType::RasterLayer )
       {
         continue;
       }
@@ -21,6 +21,7 @@
  ***************************************************************************/
 #include "qgswfsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 #include "qgswfsgetcapabilities.h"
 
 #include "qgsproject.h"
@@ -263,12 +264,28 @@ namespace QgsWfs
     QStringList wfstDeleteLayersId = QgsServerProjectUtils::wfstDeleteLayerIds( *project );
     for ( int i = 0; i < wfsLayerIds.size(); ++i )
     {
-      QgsMapLayer *layer = project->mapLayer( wfsLayerIds.at( i ) );
-      if ( layer->type() != QgsMapLayer::LayerType::VectorLayer )
+      // published properties are read from the project XML if the layer is not
+      // loaded, so that capabilities do not load a lazily read project
+      const QgsServerProjectUtils::LayerProperties layer = QgsServerProjectUtils::layerProperties( *project, wfsLayerIds.at( i ) );
+      if ( !layer.valid || layer.type != QgsMapLayer::LayerType::VectorLayer )
       {
         continue;
       }
-      if ( accessControl && !accessControl->layerReadPermission( layer ) )
+      // access control filters and WFS-T operations need the layer itself
+      bool transactional = wfstUpdateLayersId.contains( layer.id ) ||
+                           wfstInsertLayersId.contains( layer.id ) ||
+                           wfstDeleteLayersId.contains( layer.id );
+      bool accessControlled = accessControl && !accessControl->isEmpty();
+      QgsVectorLayer *vlayer = nullptr;
+      if ( transactional || accessControlled )
+      {
+        vlayer = qobject_cast<QgsVectorLayer *>( QgsConfigCache::instance()->loadLayer( project, layer.id ) );
+        if ( !vlayer )
+        {
+          continue;
+        }
+      }
+      if ( accessControlled && !accessControl->layerReadPermission( vlayer ) )
       {
         continue;
       }
@@ -277,9 +294,9 @@ namespace QgsWfs
 
       //create Name
       QDomElement nameElem = doc.createElement( QStringLiteral( "Name" ) );
-      QString typeName = layer->name();
-      if ( !layer->shortName().isEmpty() )
-        typeName = layer->shortName();
+      QString typeName = layer.name;
+      if ( !layer.shortName.isEmpty() )
+        typeName = layer.shortName;
       typeName = typeName.replace( QLatin1String( " " ), QLatin1String( "_" ) );
       QDomText nameText = doc.createTextNode( typeName );
       nameElem.appendChild( nameText );
@@ -287,17 +304,17 @@ namespace QgsWfs
 
       //create Title
       QDomElement titleElem = doc.createElement( QStringLiteral( "Title" ) );
-      QString title = layer->title();
+      QString title = layer.title;
       if ( title.isEmpty() )
       {
-        title = layer->name();
+        title = layer.name;
       }
       QDomText titleText = doc.createTextNode( title );
       titleElem.appendChild( titleText );
       layerElem.appendChild( titleElem );
 
       //create Abstract
-      QString abstract = layer->abstract();
+      QString abstract = layer.abstract;
       if ( !abstract.isEmpty() )
       {
         QDomElement abstractElem = doc.createElement( QStringLiteral( "Abstract" ) );
@@ -307,7 +324,7 @@ namespace QgsWfs
       }
 
       //create keywords
-      QString keywords = layer->keywordList();
+      QString keywords = layer.keywordList;
       if ( !keywords.isEmpty() )
       {
         QDomElement keywordsElem = doc.createElement( QStringLiteral( "Keywords" ) );
@@ -318,12 +335,12 @@ namespace QgsWfs
 
       //create SRS
       QDomElement srsElem = doc.createElement( QStringLiteral( "SRS" ) );
-      QDomText srsText = doc.createTextNode( layer->crs().authid() );
+      QDomText srsText = doc.createTextNode( layer.crs.authid() );
       srsElem.appendChild( srsText );
       layerElem.appendChild( srsElem );
 
       //create LatLongBoundingBox
-      QgsRectangle layerExtent = layer->extent();
+      QgsRectangle layerExtent = layer.extent;
       QDomElement bBoxElement = doc.createElement( QStringLiteral( "LatLongBoundingBox" ) );
       bBoxElement.setAttribute( QStringLiteral( "minx" ), QString::number( layerExtent.xMinimum() ) );
       bBoxElement.setAttribute( QStringLiteral( "miny" ), QString::number( layerExtent.yMinimum() ) );
@@ -332,13 +349,13 @@ namespace QgsWfs
       layerElem.appendChild( bBoxElement );
 
       // layer metadata URL
-      QString metadataUrl = layer->metadataUrl();
+      QString metadataUrl = layer.metadataUrl;
       if ( !metadataUrl.isEmpty() )
       {
         QDomElement metaUrlElem = doc.createElement( QStringLiteral( "MetadataURL" ) );
-        QString metadataUrlType = layer->metadataUrlType();
+        QString metadataUrlType = layer.metadataUrlType;
         metaUrlElem.setAttribute( QStringLiteral( "type" ), metadataUrlType );
-        QString metadataUrlFormat = layer->metadataUrlFormat();
+        QString metadataUrlFormat = layer.metadataUrlFormat;
         if ( metadataUrlFormat == QLatin1String( "text/xml" ) )
         {
           metaUrlElem.setAttribute( QStringLiteral( "format" ), QStringLiteral( "XML" ) );
@@ -357,13 +374,10 @@ namespace QgsWfs
       //wfs:Query element
       QDomElement queryElement = doc.createElement( QStringLiteral( "Query" )/*wfs:Query*/ );
       operationsElement.appendChild( queryElement );
-      if ( wfstUpdateLayersId.contains( layer->id() ) ||
-           wfstInsertLayersId.contains( layer->id() ) ||
-           wfstDeleteLayersId.contains( layer->id() ) )
+      if ( transactional )
       {
-        QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( layer );
         QgsVectorDataProvider *provider = vlayer->dataProvider();
-        if ( ( provider->capabilities() & QgsVectorDataProvider::AddFeatures ) && wfstInsertLayersId.contains( layer->id() ) )
+        if ( ( provider->capabilities() & QgsVectorDataProvider::AddFeatures ) && wfstInsertLayersId.contains( layer.id ) )
         {
           //wfs:Insert element
           QDomElement insertElement = doc.createElement( QStringLiteral( "Insert" )/*wfs:Insert*/ );
@@ -371,13 +385,13 @@ namespace QgsWfs
         }
         if ( ( provider->capabilities() & QgsVectorDataProvider::ChangeAttributeValues ) &&
              ( provider->capabilities() & QgsVectorDataProvider::ChangeGeometries ) &&
-             wfstUpdateLayersId.contains( layer->id() ) )
+             wfstUpdateLayersId.contains( layer.id ) )
         {
           //wfs:Update element
           QDomElement updateElement = doc.createElement( QStringLiteral( "Update" )/*wfs:Update*/ );
           operationsElement.appendChild( updateElement );
         }
-        if ( ( provider->capabilities() & QgsVectorDataProvider::DeleteFeatures ) && wfstDeleteLayersId.contains( layer->id() ) )
+        if ( ( provider->capabilities() & QgsVectorDataProvider::DeleteFeatures ) && wfstDeleteLayersId.contains( layer.id ) )
         {
           //wfs:Delete element
           QDomElement deleteElement = doc.createElement( QStringLiteral( "Delete" )/*wfs:Delete*/ );
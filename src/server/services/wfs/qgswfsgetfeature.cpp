@@ -21,6 +21,7 @@
  ***************************************************************************/
 #include "qgswfsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 #include "qgsfields.h"
 #include "qgsexpression.h"
 #include "qgsgeometry.h"
@@ -112,19 +113,25 @@ namespace QgsWfs
     QMap<QString, QgsMapLayer *> mapLayerMap;
     for ( int i = 0; i < wfsLayerIds.size(); ++i )
     {
-      QgsMapLayer *layer = project->mapLayer( wfsLayerIds.at( i ) );
-      if ( layer->type() != QgsMapLayer::LayerType::VectorLayer )
+      const QgsServerProjectUtils::LayerProperties properties = QgsServerProjectUtils::layerProperties( *project, wfsLayerIds.at( i ) );
+      if ( !properties.valid || properties.type != QgsMapLayer::LayerType::VectorLayer )
       {
         continue;
       }
 
-      QString name = layer->name();
-      if ( !layer->shortName().isEmpty() )
-        name = layer->shortName();
+      QString name = properties.name;
+      if ( !properties.shortName.isEmpty() )
+        name = properties.shortName;
       name = name.replace( ' ', '_' );
 
       if ( typeNameList.contains( name ) )
       {
+        // only the requested layers of a lazily read project are loaded
+        QgsMapLayer *layer = QgsConfigCache::instance()->loadLayer( project, properties.id );
+        if ( !layer )
+        {
+          continue;
+        }
         // store layers
         mapLayerMap[name] = layer;
         // update request metadata
@@ -21,6 +21,7 @@
  ***************************************************************************/
 #include "qgswfsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 #include "qgsfields.h"
 #include "qgsexpression.h"
 #include "qgsgeometry.h"
@@ -234,15 +235,15 @@ namespace QgsWfs
     QMap<QString, QgsVectorLayer *> mapLayerMap;
     for ( int i = 0; i < wfsLayerIds.size(); ++i )
     {
-      QgsMapLayer *layer = project->mapLayer( wfsLayerIds.at( i ) );
-      if ( layer->type() != QgsMapLayer::LayerType::VectorLayer )
+      const QgsServerProjectUtils::LayerProperties properties = QgsServerProjectUtils::layerProperties( *project, wfsLayerIds.at( i ) );
+      if ( !properties.valid || properties.type != QgsMapLayer::LayerType::VectorLayer )
       {
         continue;
       }
 
-      QString name = layer->name();
-      if ( !layer->shortName().isEmpty() )
-        name = layer->shortName();
+      QString name = properties.name;
+      if ( !properties.shortName.isEmpty() )
+        name = properties.shortName;
       name = name.replace( ' ', '_' );
 
       if ( !typeNameList.contains( name ) )
@@ -250,6 +251,13 @@ namespace QgsWfs
         continue;
       }
 
+      // only the requested layers of a lazily read project are loaded
+      QgsMapLayer *layer = QgsConfigCache::instance()->loadLayer( project, properties.id );
+      if ( !layer )
+      {
+        continue;
+      }
+
       // get vector layer
       QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( layer );
       if ( !vlayer )
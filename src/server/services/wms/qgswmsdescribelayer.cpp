@@ -21,6 +21,7 @@
 #include "qgswmsutils.h"
 #include "qgswmsdescribelayer.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 
 namespace QgsWms
 {
@@ -113,6 +114,13 @@ namespace QgsWms
     // WCS layers
     QStringList wcsLayerIds = QgsServerProjectUtils::wcsLayerIds( *project );
 
+    // load the requested layers of a lazily read project
+    Q_FOREACH ( const QString &layerId, project->unloadedLayerIds() )
+    {
+      if ( layersList.contains( QgsServerProjectUtils::wmsLayerNickname( *project, layerId ) ) )
+        QgsConfigCache::instance()->loadLayer( project, layerId );
+    }
+
     Q_FOREACH ( QgsMapLayer *layer, project->mapLayers() )
     {
       QString name = layer->name();
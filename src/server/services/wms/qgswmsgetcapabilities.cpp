@@ -35,6 +35,7 @@
 #include "qgslayertreemodel.h"
 #include "qgslayertree.h"
 #include "qgsmaplayerstylemanager.h"
+#include "qgsconfigcache.h"
 
 #include "qgsexception.h"
 #include "qgsexpressionnodeimpl.h"
@@ -72,7 +73,7 @@ namespace QgsWms
     void appendCrsElementsToLayer( QDomDocument &doc, QDomElement &layerElement,
                                    const QStringList &crsList, const QStringList &constrainedCrsList );
 
-    void appendLayerStyles( QDomDocument &doc, QDomElement &layerElem, QgsMapLayer *currentLayer,
+    void appendLayerStyles( QDomDocument &doc, QDomElement &layerElem, const QgsServerProjectUtils::LayerProperties &currentLayer,
                             const QgsProject *project, const QString &version, const QgsServerRequest &request );
 
     void appendLayersFromTreeGroup( QDomDocument &doc,
@@ -142,6 +143,13 @@ namespace QgsWms
 
     QgsServerRequest::Parameters parameters = request.parameters();
 
+    // project settings publish the attributes and the drawing order of every layer,
+    // so layers of a lazily read project have to be loaded
+    if ( projectSettings )
+    {
+      QgsConfigCache::instance()->loadAllLayers( project );
+    }
+
     // Get service URL
     QUrl href = serviceUrl( request, project );
 
@@ -740,8 +748,8 @@ namespace QgsWms
     QDomElement wfsLayersElem = doc.createElement( QStringLiteral( "WFSLayers" ) );
     for ( int i = 0; i < wfsLayerIds.size(); ++i )
     {
-      QgsMapLayer *layer = project->mapLayer( wfsLayerIds.at( i ) );
-      if ( layer->type() != QgsMapLayer::LayerType::VectorLayer )
+      QgsServerProjectUtils::LayerProperties layer = QgsServerProjectUtils::layerProperties( *project, wfsLayerIds.at( i ) );
+      if ( !layer.valid || layer.type != QgsMapLayer::LayerType::VectorLayer )
       {
         continue;
       }
@@ -749,11 +757,11 @@ namespace QgsWms
       QDomElement wfsLayerElem = doc.createElement( QStringLiteral( "WFSLayer" ) );
       if ( QgsServerProjectUtils::wmsUseLayerIds( *project ) )
       {
-        wfsLayerElem.setAttribute( QStringLiteral( "name" ), layer->id() );
+        wfsLayerElem.setAttribute( QStringLiteral( "name" ), layer.id );
       }
       else
       {
-        wfsLayerElem.setAttribute( QStringLiteral( "name" ), layer->name() );
+        wfsLayerElem.setAttribute( QStringLiteral( "name" ), layer.name );
       }
       wfsLayersElem.appendChild( wfsLayerElem );
     }
@@ -890,30 +898,41 @@ namespace QgsWms
         else
         {
           QgsLayerTreeLayer *treeLayer = static_cast<QgsLayerTreeLayer *>( treeNode );
-          QgsMapLayer *l = treeLayer->layer();
-          if ( restrictedLayers.contains( l->name() ) ) //unpublished layer
+          // published properties are read from the project XML if the layer is not
+          // loaded, so that capabilities do not load a lazily read project
+          const QgsServerProjectUtils::LayerProperties l = QgsServerProjectUtils::layerProperties( *project, treeLayer->layerId() );
+          if ( !l.valid )
+          {
+            continue;
+          }
+          if ( restrictedLayers.contains( l.name ) ) //unpublished layer
           {
             continue;
           }
 
+          // access control filters need the layer itself
           QgsAccessControl *accessControl = serverIface->accessControls();
-          if ( accessControl && !accessControl->layerReadPermission( l ) )
+          if ( accessControl && !accessControl->isEmpty() )
           {
-            continue;
+            QgsMapLayer *layer = QgsConfigCache::instance()->loadLayer( project, l.id );
+            if ( !layer || !accessControl->layerReadPermission( layer ) )
+            {
+              continue;
+            }
           }
 
-          QString wmsName =  l->name();
+          QString wmsName =  l.name;
           if ( useLayerIds )
           {
-            wmsName = l->id();
+            wmsName = l.id;
           }
-          else if ( !l->shortName().isEmpty() )
+          else if ( !l.shortName.isEmpty() )
           {
-            wmsName = l->shortName();
+            wmsName = l.shortName;
           }
 
           // queryable layer
-          if ( project->nonIdentifiableLayers().contains( l->id() ) )
+          if ( project->nonIdentifiableLayers().contains( l.id ) )
           {
             layerElem.setAttribute( QStringLiteral( "queryable" ), QStringLiteral( "0" ) );
           }
@@ -928,16 +947,16 @@ namespace QgsWms
           layerElem.appendChild( nameElem );
 
           QDomElement titleElem = doc.createElement( QStringLiteral( "Title" ) );
-          QString title = l->title();
+          QString title = l.title;
           if ( title.isEmpty() )
           {
-            title = l->name();
+            title = l.name;
           }
           QDomText titleText = doc.createTextNode( title );
           titleElem.appendChild( titleText );
           layerElem.appendChild( titleElem );
 
-          QString abstract = l->abstract();
+          QString abstract = l.abstract;
           if ( !abstract.isEmpty() )
           {
             QDomElement abstractElem = doc.createElement( QStringLiteral( "Abstract" ) );
@@ -947,9 +966,9 @@ namespace QgsWms
           }
 
           //keyword list
-          if ( !l->keywordList().isEmpty() )
+          if ( !l.keywordList.isEmpty() )
           {
-            QStringList keywordStringList = l->keywordList().split( ',' );
+            QStringList keywordStringList = l.keywordList.split( ',' );
 
             QDomElement keywordListElem = doc.createElement( QStringLiteral( "KeywordList" ) );
             for ( int i = 0; i < keywordStringList.size(); ++i )
@@ -966,37 +985,23 @@ namespace QgsWms
             layerElem.appendChild( keywordListElem );
           }
 
-          //vector layer without geometry
-          bool geometryLayer = true;
-          if ( l->type() == QgsMapLayer::VectorLayer )
-          {
-            QgsVectorLayer *vLayer = qobject_cast<QgsVectorLayer *>( l );
-            if ( vLayer )
-            {
-              if ( vLayer->wkbType() == QgsWkbTypes::NoGeometry )
-              {
-                geometryLayer = false;
-              }
-            }
-          }
-
-          //CRS
-          if ( geometryLayer )
+          //CRS, unless vector layer without geometry
+          if ( l.hasGeometry )
           {
             QStringList crsList;
-            crsList << l->crs().authid();
+            crsList << l.crs.authid();
             QStringList outputCrsList = QgsServerProjectUtils::wmsOutputCrsList( *project );
             appendCrsElementsToLayer( doc, layerElem, crsList, outputCrsList );
 
             //Ex_GeographicBoundingBox
-            appendLayerBoundingBoxes( doc, layerElem, l->extent(), l->crs(), crsList, outputCrsList );
+            appendLayerBoundingBoxes( doc, layerElem, l.extent, l.crs, crsList, outputCrsList );
           }
 
           // add details about supported styles of the layer
           appendLayerStyles( doc, layerElem, l, project, version, request );
 
           //min/max scale denominatorScaleBasedVisibility
-          if ( l->hasScaleBasedVisibility() )
+          if ( l.hasScaleBasedVisibility )
           {
             if ( version == QLatin1String( "1.1.1" ) )
             {
@@ -1004,19 +1009,19 @@ namespace QgsWms
               double SCALE_TO_SCALEHINT = OGC_PX_M * M_SQRT2;
 
               QDomElement scaleHintElem = doc.createElement( QStringLiteral( "ScaleHint" ) );
-              scaleHintElem.setAttribute( QStringLiteral( "min" ), QString::number( l->maximumScale() * SCALE_TO_SCALEHINT ) );
-              scaleHintElem.setAttribute( QStringLiteral( "max" ), QString::number( l->minimumScale() * SCALE_TO_SCALEHINT ) );
+              scaleHintElem.setAttribute( QStringLiteral( "min" ), QString::number( l.maximumScale * SCALE_TO_SCALEHINT ) );
+              scaleHintElem.setAttribute( QStringLiteral( "max" ), QString::number( l.minimumScale * SCALE_TO_SCALEHINT ) );
               layerElem.appendChild( scaleHintElem );
             }
             else
             {
-              QString minScaleString = QString::number( l->maximumScale() );
+              QString minScaleString = QString::number( l.maximumScale );
               QDomElement minScaleElem = doc.createElement( QStringLiteral( "MinScaleDenominator" ) );
               QDomText minScaleText = doc.createTextNode( minScaleString );
               minScaleElem.appendChild( minScaleText );
               layerElem.appendChild( minScaleElem );
 
-              QString maxScaleString = QString::number( l->minimumScale() );
+              QString maxScaleString = QString::number( l.minimumScale );
               QDomElement maxScaleElem = doc.createElement( QStringLiteral( "MaxScaleDenominator" ) );
               QDomText maxScaleText = doc.createTextNode( maxScaleString );
               maxScaleElem.appendChild( maxScaleText );
@@ -1025,12 +1030,12 @@ namespace QgsWms
           }
 
           // layer data URL
-          QString dataUrl = l->dataUrl();
+          QString dataUrl = l.dataUrl;
           if ( !dataUrl.isEmpty() )
           {
             QDomElement dataUrlElem = doc.createElement( QStringLiteral( "DataURL" ) );
             QDomElement dataUrlFormatElem = doc.createElement( QStringLiteral( "Format" ) );
-            QString dataUrlFormat = l->dataUrlFormat();
+            QString dataUrlFormat = l.dataUrlFormat;
             QDomText dataUrlFormatText = doc.createTextNode( dataUrlFormat );
             dataUrlFormatElem.appendChild( dataUrlFormatText );
             dataUrlElem.appendChild( dataUrlFormatElem );
@@ -1043,7 +1048,7 @@ namespace QgsWms
           }
 
           // layer attribution
-          QString attribution = l->attribution();
+          QString attribution = l.attribution;
           if ( !attribution.isEmpty() )
           {
             QDomElement attribElem = doc.createElement( QStringLiteral( "Attribution" ) );
@@ -1051,7 +1056,7 @@ namespace QgsWms
             QDomText attribText = doc.createTextNode( attribution );
             attribTitleElem.appendChild( attribText );
             attribElem.appendChild( attribTitleElem );
-            QString attributionUrl = l->attributionUrl();
+            QString attributionUrl = l.attributionUrl;
             if ( !attributionUrl.isEmpty() )
             {
               QDomElement attribORElem = doc.createElement( QStringLiteral( "OnlineResource" ) );
@@ -1064,11 +1069,11 @@ namespace QgsWms
           }
 
           // layer metadata URL
-          QString metadataUrl = l->metadataUrl();
+          QString metadataUrl = l.metadataUrl;
           if ( !metadataUrl.isEmpty() )
           {
             QDomElement metaUrlElem = doc.createElement( QStringLiteral( "MetadataURL" ) );
-            QString metadataUrlType = l->metadataUrlType();
+            QString metadataUrlType = l.metadataUrlType;
             if ( version == QLatin1String( "1.1.1" ) )
             {
               metaUrlElem.setAttribute( QStringLiteral( "type" ), metadataUrlType );
@@ -1085,7 +1090,7 @@ namespace QgsWms
             {
               metaUrlElem.setAttribute( QStringLiteral( "type" ), metadataUrlType );
             }
-            QString metadataUrlFormat = l->metadataUrlFormat();
+            QString metadataUrlFormat = l.metadataUrlFormat;
             if ( !metadataUrlFormat.isEmpty() )
             {
               QDomElement metaUrlFormatElem = doc.createElement( QStringLiteral( "Format" ) );
@@ -1103,7 +1108,7 @@ namespace QgsWms
 
           if ( projectSettings )
           {
-            appendLayerProjectSettings( doc, layerElem, l );
+            appendLayerProjectSettings( doc, layerElem, project->mapLayer( l.id ) );
           }
         }
 
@@ -1111,7 +1116,7 @@ namespace QgsWms
       }
     }
 
-    void appendLayerStyles( QDomDocument &doc, QDomElement &layerElem, QgsMapLayer *currentLayer,
+    void appendLayerStyles( QDomDocument &doc, QDomElement &layerElem, const QgsServerProjectUtils::LayerProperties &currentLayer,
                             const QgsProject *project, const QString &version, const QgsServerRequest &request )
     {
       // Get service URL
@@ -1120,7 +1125,7 @@ namespace QgsWms
       //href needs to be a prefix
       QString hrefString = href.toString( QUrl::FullyDecoded );
       hrefString.append( href.hasQuery() ? "&" : "?" );
-      Q_FOREACH ( QString styleName, currentLayer->styleManager()->styles() )
+      Q_FOREACH ( QString styleName, currentLayer.styles )
       {
         QDomElement styleElem = doc.createElement( QStringLiteral( "Style" ) );
         QDomElement styleNameElem = doc.createElement( QStringLiteral( "Name" ) );
@@ -1135,12 +1140,12 @@ namespace QgsWms
         // QString LegendURL for explicit layerbased GetLegendGraphic request
         QDomElement getLayerLegendGraphicElem = doc.createElement( QStringLiteral( "LegendURL" ) );
 
-        QString customHrefString = currentLayer->legendUrl();
+        QString customHrefString = currentLayer.legendUrl;
 
         QStringList getLayerLegendGraphicFormats;
         if ( !customHrefString.isEmpty() )
         {
-          getLayerLegendGraphicFormats << currentLayer->legendUrlFormat();
+          getLayerLegendGraphicFormats << currentLayer.legendUrlFormat;
         }
         else
         {
@@ -1159,11 +1164,11 @@ namespace QgsWms
         // no parameters on custom hrefUrl, because should link directly to graphic
         if ( customHrefString.isEmpty() )
         {
-          QString layerName =  currentLayer->name();
+          QString layerName =  currentLayer.name;
           if ( QgsServerProjectUtils::wmsUseLayerIds( *project ) )
-            layerName = currentLayer->id();
-          else if ( !currentLayer->shortName().isEmpty() )
-            layerName = currentLayer->shortName();
+            layerName = currentLayer.id;
+          else if ( !currentLayer.shortName.isEmpty() )
+            layerName = currentLayer.shortName;
           QUrl mapUrl( hrefString );
           mapUrl.addQueryItem( QStringLiteral( "SERVICE" ), QStringLiteral( "WMS" ) );
           mapUrl.addQueryItem( QStringLiteral( "VERSION" ), version );
@@ -1586,6 +1591,10 @@ namespace QgsWms
       for ( int i = 0; i < projectLayerOrder.size(); ++i )
       {
         QgsMapLayer *l = projectLayerOrder.at( i );
+        if ( !l ) //layer which could not be loaded
+        {
+          continue;
+        }
 
         if ( restrictedLayers.contains( l->name() ) ) //unpublished layer
         {
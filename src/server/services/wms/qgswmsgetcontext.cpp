@@ -28,6 +28,7 @@
 #include "qgslayertreemodel.h"
 #include "qgslayertree.h"
 #include "qgsmaplayerstylemanager.h"
+#include "qgsconfigcache.h"
 
 #include "qgsexception.h"
 
@@ -35,7 +36,7 @@ namespace QgsWms
 {
   namespace
   {
-    void appendOwsLayerStyles( QDomDocument &doc, QDomElement &layerElem, QgsMapLayer *currentLayer );
+    void appendOwsLayerStyles( QDomDocument &doc, QDomElement &layerElem, const QgsServerProjectUtils::LayerProperties &currentLayer );
 
     void appendOwsLayersFromTreeGroup( QDomDocument &doc,
                                        QDomElement &parentLayer,
@@ -234,22 +235,33 @@ namespace QgsWms
         else
         {
           QgsLayerTreeLayer *treeLayer = static_cast<QgsLayerTreeLayer *>( treeNode );
-          QgsMapLayer *l = treeLayer->layer();
-          if ( restrictedLayers.contains( l->name() ) ) //unpublished layer
+          // published properties are read from the project XML if the layer is not
+          // loaded, so that the context does not load a lazily read project
+          const QgsServerProjectUtils::LayerProperties l = QgsServerProjectUtils::layerProperties( *project, treeLayer->layerId() );
+          if ( !l.valid )
+          {
+            continue;
+          }
+          if ( restrictedLayers.contains( l.name ) ) //unpublished layer
           {
             continue;
           }
 
+          // access control filters need the layer itself
           QgsAccessControl *accessControl = serverIface->accessControls();
-          if ( accessControl && !accessControl->layerReadPermission( l ) )
+          if ( accessControl && !accessControl->isEmpty() )
           {
-            continue;
+            QgsMapLayer *layer = QgsConfigCache::instance()->loadLayer( project, l.id );
+            if ( !layer || !accessControl->layerReadPermission( layer ) )
+            {
+              continue;
+            }
           }
 
           QDomElement layerElem = doc.createElement( QStringLiteral( "Layer" ) );
 
           // queryable layer
-          if ( project->nonIdentifiableLayers().contains( l->id() ) )
+          if ( project->nonIdentifiableLayers().contains( l.id ) )
           {
             layerElem.setAttribute( QStringLiteral( "queryable" ), QStringLiteral( "false" ) );
           }
@@ -278,14 +290,14 @@ namespace QgsWms
           // OWSContext Layer opacity is set to 1
           layerElem.setAttribute( QStringLiteral( "opacity" ), 1 );
 
-          QString wmsName =  l->name();
+          QString wmsName =  l.name;
           if ( QgsServerProjectUtils::wmsUseLayerIds( *project ) )
           {
-            wmsName = l->id();
+            wmsName = l.id;
           }
-          else if ( !l->shortName().isEmpty() )
+          else if ( !l.shortName.isEmpty() )
           {
-            wmsName = l->shortName();
+            wmsName = l.shortName;
           }
           // layer wms name
           layerElem.setAttribute( QStringLiteral( "name" ), wmsName );
@@ -294,10 +306,10 @@ namespace QgsWms
 
           // layer title
           QDomElement titleElem = doc.createElement( QStringLiteral( "ows:Title" ) );
-          QString title = l->title();
+          QString title = l.title;
           if ( title.isEmpty() )
           {
-            title = l->name();
+            title = l.name;
           }
           QDomText titleText = doc.createTextNode( title );
           titleElem.appendChild( titleText );
@@ -326,7 +338,7 @@ namespace QgsWms
           serverElem.appendChild( orServerElem );
           layerElem.appendChild( serverElem );
 
-          QString abstract = l->abstract();
+          QString abstract = l.abstract;
           if ( !abstract.isEmpty() )
           {
             QDomElement abstractElem = doc.createElement( QStringLiteral( "ows:Abstract" ) );
@@ -336,10 +348,10 @@ namespace QgsWms
           }
 
           //min/max scale denominatorScaleBasedVisibility
-          if ( l->hasScaleBasedVisibility() )
+          if ( l.hasScaleBasedVisibility )
           {
-            QString minScaleString = QString::number( l->maximumScale() );
-            QString maxScaleString = QString::number( l->minimumScale() );
+            QString minScaleString = QString::number( l.maximumScale );
+            QString maxScaleString = QString::number( l.minimumScale );
             QDomElement minScaleElem = doc.createElement( QStringLiteral( "sld:MinScaleDenominator" ) );
             QDomText minScaleText = doc.createTextNode( minScaleString );
             minScaleElem.appendChild( minScaleText );
@@ -354,9 +366,9 @@ namespace QgsWms
           appendOwsLayerStyles( doc, layerElem, l );
 
           //keyword list
-          if ( !l->keywordList().isEmpty() )
+          if ( !l.keywordList.isEmpty() )
           {
-            QStringList keywordStringList = l->keywordList().split( ',' );
+            QStringList keywordStringList = l.keywordList.split( ',' );
             bool sia2045 = QgsServerProjectUtils::wmsInfoFormatSia2045( *project );
 
             QDomElement keywordsElem = doc.createElement( QStringLiteral( "ows:Keywords" ) );
@@ -375,11 +387,11 @@ namespace QgsWms
           }
 
           // layer data URL
-          QString dataUrl = l->dataUrl();
+          QString dataUrl = l.dataUrl;
           if ( !dataUrl.isEmpty() )
           {
             QDomElement dataUrlElem = doc.createElement( QStringLiteral( "DataURL" ) );
-            QString dataUrlFormat = l->dataUrlFormat();
+            QString dataUrlFormat = l.dataUrlFormat;
             dataUrlElem.setAttribute( QStringLiteral( "format" ), dataUrlFormat );
             QDomElement dataORElem = doc.createElement( QStringLiteral( "OnlineResource" ) );
             dataORElem.setAttribute( QStringLiteral( "xmlns:xlink" ), QStringLiteral( "http://www.w3.org/1999/xlink" ) );
@@ -390,11 +402,11 @@ namespace QgsWms
           }
 
           // layer metadata URL
-          QString metadataUrl = l->metadataUrl();
+          QString metadataUrl = l.metadataUrl;
           if ( !metadataUrl.isEmpty() )
           {
             QDomElement metaUrlElem = doc.createElement( QStringLiteral( "MetadataURL" ) );
-            QString metadataUrlFormat = l->metadataUrlFormat();
+            QString metadataUrlFormat = l.metadataUrlFormat;
             metaUrlElem.setAttribute( QStringLiteral( "format" ), metadataUrlFormat );
             QDomElement metaUrlORElem = doc.createElement( QStringLiteral( "OnlineResource" ) );
             metaUrlORElem.setAttribute( QStringLiteral( "xmlns:xlink" ), QStringLiteral( "http://www.w3.org/1999/xlink" ) );
@@ -407,8 +419,8 @@ namespace QgsWms
           // update combineBBox
           try
           {
-            QgsCoordinateTransform t( l->crs(), project->crs() );
-            QgsRectangle BBox = t.transformBoundingBox( l->extent() );
+            QgsCoordinateTransform t( l.crs, project->crs() );
+            QgsRectangle BBox = t.transformBoundingBox( l.extent );
             if ( combinedBBox.isEmpty() )
             {
               combinedBBox = BBox;
@@ -435,9 +447,9 @@ namespace QgsWms
       }// end of for
     }
 
-    void appendOwsLayerStyles( QDomDocument &doc, QDomElement &layerElem, QgsMapLayer *currentLayer )
+    void appendOwsLayerStyles( QDomDocument &doc, QDomElement &layerElem, const QgsServerProjectUtils::LayerProperties &currentLayer )
     {
-      Q_FOREACH ( QString styleName, currentLayer->styleManager()->styles() )
+      Q_FOREACH ( QString styleName, currentLayer.styles )
       {
         QDomElement styleListElem = doc.createElement( QStringLiteral( "StyleList" ) );
         //only one default style in project file mode
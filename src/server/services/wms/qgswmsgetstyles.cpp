@@ -21,6 +21,7 @@
 #include "qgswmsutils.h"
 #include "qgswmsgetstyles.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 
 #include "qgsrenderer.h"
 #include "qgsvectorlayer.h"
@@ -133,6 +134,13 @@ namespace QgsWms
       // WMS restricted layers
       QStringList restrictedLayers = QgsServerProjectUtils::wmsRestrictedLayers( *project );
 
+      // load the requested layers of a lazily read project
+      Q_FOREACH ( const QString &layerId, project->unloadedLayerIds() )
+      {
+        if ( layerList.contains( QgsServerProjectUtils::wmsLayerNickname( *project, layerId ) ) )
+          QgsConfigCache::instance()->loadLayer( project, layerId );
+      }
+
       Q_FOREACH ( QgsMapLayer *layer, project->mapLayers() )
       {
         QString name = layer->name();
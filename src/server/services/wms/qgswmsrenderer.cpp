@@ -47,6 +47,7 @@
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
 #include "qgssldconfigparser.h"
+#include "qgsconfigcache.h"
 #include "qgssymbol.h"
 #include "qgsrenderer.h"
 #include "qgspaintenginehack.h"
@@ -2554,13 +2555,30 @@ namespace QgsWms
     {
       if ( restrictedLayersNames.contains( layer->name() ) )
       {
-        mRestrictedLayers.append( layerNickname( *layer->layer() ) );
+        mRestrictedLayers.append( QgsServerProjectUtils::wmsLayerNickname( *mProject, layer->layerId() ) );
       }
     }
   }
 
   void QgsRenderer::initNicknameLayers()
   {
+    // with lazy layer loading, only load the layers the request refers to
+    QStringList unloadedLayerIds = mProject->unloadedLayerIds();
+    if ( !unloadedLayerIds.isEmpty() && mWmsParameters.sld().isEmpty() )
+    {
+      QStringList nicknames = mWmsParameters.allLayersNickname() + mWmsParameters.queryLayersNickname();
+      Q_FOREACH ( const QString &layerId, unloadedLayerIds )
+      {
+        if ( nicknames.contains( QgsServerProjectUtils::wmsLayerNickname( *mProject, layerId ) ) )
+          QgsConfigCache::instance()->loadLayer( mProject, layerId );
+      }
+    }
+    else if ( !unloadedLayerIds.isEmpty() )
+    {
+      // a SLD may refer to any layer
+      QgsConfigCache::instance()->loadAllLayers( mProject );
+    }
+
     Q_FOREACH ( QgsMapLayer *ml, mProject->mapLayers() )
     {
       mNicknameLayers[ layerNickname( *ml ) ] = ml;
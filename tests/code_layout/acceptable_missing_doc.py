@@ -214,7 +214,7 @@ ACCEPTABLE_MISSING_DOCS = {
     "QgsException": ["QgsException(const QString &what)"],
     "QgsEllipseSymbolLayerWidget": ["QgsEllipseSymbolLayerWidget(const QgsVectorLayer *vl, QWidget *parent=0)", "create(const QgsVectorLayer *vl)"],
     "QgsSingleBandPseudoColorRendererWidget": ["create(QgsRasterLayer *layer, const QgsRectangle &extent)", "setFromRenderer(const QgsRasterRenderer *r)", "QgsSingleBandPseudoColorRendererWidget(QgsRasterLayer *layer, const QgsRectangle &extent=QgsRectangle())", "Mode", "loadMinMax(int bandNo, double min, double max, int origin)"],
-    "QgsSvgCache": ["instance()", "replaceParamsAndCacheSvg(QgsSvgCacheEntry *entry)", "cachePicture(QgsSvgCacheEntry *entry, bool forceVectorOutput=false)", "cacheImage(QgsSvgCacheEntry *entry)", "takeEntryFromList(QgsSvgCacheEntry *entry)"],
+    "QgsSvgCache": ["instance()", "replaceParamsAndCacheSvg(QgsSvgCacheEntry *entry)", "cachePicture(QgsSvgCacheEntry *entry, bool forceVectorOutput=false)", "cacheImage(QgsSvgCacheEntry *entry)"],
     "QgsMessageViewer": ["setCheckBoxText(const QString &text)", "setMessageAsPlainText(const QString &msg)", "checkBoxState()", "setCheckBoxState(Qt::CheckState state)", "setCheckBoxVisible(bool visible)", "setCheckBoxQgsSettingsLabel(const QString &label)", "setMessageAsHtml(const QString &msg)", "QgsMessageViewer(QWidget *parent=nullptr, Qt::WindowFlags fl=QgsGuiUtils::ModalDialogFlags, bool deleteOnClose=true)"],
     "QgsLabelSorter": ["QgsLabelSorter(const QgsMapSettings &mapSettings)", "operator()(pal::LabelPosition *lp1, pal::LabelPosition *lp2) const "],
     "QgsVectorFieldSymbolLayer": ["AngleUnits", "setDistanceMapUnitScale(const QgsMapUnitScale &scale)", "setScale(double s)", "distanceMapUnitScale() const ", "yAttribute() const ", "setXAttribute(const QString &attribute)", "VectorFieldType", "setDistanceUnit(QgsSymbol::OutputUnit unit)", "setAngleOrientation(AngleOrientation orientation)", "xAttribute() const ", "scale() const ", "angleOrientation() const ", "setAngleUnits(AngleUnits units)", "AngleOrientation", "vectorFieldType() const ", "create(const QgsStringMap &properties=QgsStringMap())", "setYAttribute(const QString &attribute)", "distanceUnit() const ", "angleUnits() const ", "createFromSld(QDomElement &element)", "setVectorFieldType(VectorFieldType type)"],
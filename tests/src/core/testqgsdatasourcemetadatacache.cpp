@@ -0,0 +1,146 @@
+/***************************************************************************
+                         testqgsdatasourcemetadatacache.cpp
+                         ----------------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsdatasourcemetadatacache.h"
+#include "qgsrectangle.h"
+
+#include <QTemporaryDir>
+
+class TestQgsDataSourceMetadataCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void cache();
+    void changeToken();
+    void disabled();
+    void database();
+};
+
+void TestQgsDataSourceMetadataCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsDataSourceMetadataCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsDataSourceMetadataCache::cache()
+{
+  QgsDataSourceMetadataCache cache;
+  QVERIFY( cache.isEnabled() );
+  QVERIFY( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "1" ) ).extent.isNull() );
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "1" ) ).featureCount, -1L );
+
+  cache.setExtent( QStringLiteral( "a" ), QStringLiteral( "1" ), QgsRectangle( 1, 2, 3, 4 ) );
+  cache.setFeatureCount( QStringLiteral( "a" ), QStringLiteral( "1" ), 5 );
+  QCOMPARE( cache.count(), 1 );
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "1" ) ).extent, QgsRectangle( 1, 2, 3, 4 ) );
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "1" ) ).featureCount, 5L );
+  QCOMPARE( cache.metadata( QStringLiteral( "b" ), QStringLiteral( "1" ) ).featureCount, -1L );
+
+  // no token, no caching
+  cache.setFeatureCount( QStringLiteral( "b" ), QString(), 5 );
+  QCOMPARE( cache.count(), 1 );
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QString() ).featureCount, -1L );
+
+  cache.invalidate( QStringLiteral( "a" ) );
+  QCOMPARE( cache.count(), 0 );
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "1" ) ).featureCount, -1L );
+}
+
+void TestQgsDataSourceMetadataCache::changeToken()
+{
+  QgsDataSourceMetadataCache cache;
+  cache.setExtent( QStringLiteral( "a" ), QStringLiteral( "1" ), QgsRectangle( 1, 2, 3, 4 ) );
+  cache.setFeatureCount( QStringLiteral( "a" ), QStringLiteral( "1" ), 5 );
+
+  // metadata stored for an older state of the data source is not returned...
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "2" ) ).featureCount, -1L );
+
+  // ... and is dropped once metadata for the new state is stored
+  cache.setFeatureCount( QStringLiteral( "a" ), QStringLiteral( "2" ), 6 );
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "2" ) ).featureCount, 6L );
+  QVERIFY( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "2" ) ).extent.isNull() );
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "1" ) ).featureCount, -1L );
+}
+
+void TestQgsDataSourceMetadataCache::disabled()
+{
+  QgsDataSourceMetadataCache cache;
+  cache.setFeatureCount( QStringLiteral( "a" ), QStringLiteral( "1" ), 5 );
+  cache.setEnabled( false );
+  QCOMPARE( cache.count(), 0 );
+  cache.setFeatureCount( QStringLiteral( "a" ), QStringLiteral( "1" ), 5 );
+  QCOMPARE( cache.metadata( QStringLiteral( "a" ), QStringLiteral( "1" ) ).featureCount, -1L );
+}
+
+void TestQgsDataSourceMetadataCache::database()
+{
+  QTemporaryDir dir;
+  QString path = dir.path() + QStringLiteral( "/metadata.db" );
+  QString uri = QStringLiteral( "dbname='test' password='secret' table=\"a\"" );
+
+  {
+    QgsDataSourceMetadataCache cache;
+    QVERIFY( cache.setDatabasePath( path ) );
+    QCOMPARE( cache.databasePath(), path );
+    cache.setExtent( uri, QStringLiteral( "1" ), QgsRectangle( 1, 2, 3, 4 ) );
+    cache.setFeatureCount( uri, QStringLiteral( "1" ), 5 );
+    cache.setFeatureCount( QStringLiteral( "b" ), QStringLiteral( "1" ), 7 );
+  }
+
+  // credentials are not written to the database
+  QFile file( path );
+  QVERIFY( file.open( QIODevice::ReadOnly ) );
+  QVERIFY( !file.readAll().contains( "secret" ) );
+  file.close();
+
+  // metadata survives the cache
+  QgsDataSourceMetadataCache cache;
+  QVERIFY( cache.setDatabasePath( path ) );
+  QCOMPARE( cache.count(), 0 );
+  QCOMPARE( cache.metadata( uri, QStringLiteral( "1" ) ).extent, QgsRectangle( 1, 2, 3, 4 ) );
+  QCOMPARE( cache.metadata( uri, QStringLiteral( "1" ) ).featureCount, 5L );
+  QCOMPARE( cache.metadata( uri, QStringLiteral( "2" ) ).featureCount, -1L );
+  QCOMPARE( cache.metadata( QStringLiteral( "b" ), QStringLiteral( "1" ) ).featureCount, 7L );
+  QVERIFY( cache.metadata( QStringLiteral( "b" ), QStringLiteral( "1" ) ).extent.isNull() );
+
+  // invalidation and clearing are persisted too
+  cache.invalidate( uri );
+  cache.setDatabasePath( QString() );
+  QVERIFY( cache.databasePath().isEmpty() );
+  cache.clear();
+  QVERIFY( cache.setDatabasePath( path ) );
+  QCOMPARE( cache.metadata( uri, QStringLiteral( "1" ) ).featureCount, -1L );
+  QCOMPARE( cache.metadata( QStringLiteral( "b" ), QStringLiteral( "1" ) ).featureCount, 7L );
+  cache.clear();
+  cache.setDatabasePath( QString() );
+  QVERIFY( cache.setDatabasePath( path ) );
+  QCOMPARE( cache.metadata( QStringLiteral( "b" ), QStringLiteral( "1" ) ).featureCount, -1L );
+}
+
+QGSTEST_MAIN( TestQgsDataSourceMetadataCache )
+#include "testqgsdatasourcemetadatacache.moc"
@@ -44,6 +44,8 @@
 #include "qgscircularstring.h"
 #include "qgsgeometrycollection.h"
 #include "qgsgeometryfactory.h"
+#include "qgsgeometryengine.h"
+#include "qgspreparedgeometrycache.h"
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -116,6 +118,7 @@ class TestQgsGeometry : public QObject
     void exportToGeoJSON();
 
     void wkbInOut();
+    void lazyWkb();
 
     void directionNeutralSegmentation();
     void poleOfInaccessibility();
@@ -123,6 +126,8 @@ class TestQgsGeometry : public QObject
     void makeValid();
 
     void isSimple();
+    void testPredicates();
+    void preparedGeometryCache();
 
     void reshapeGeometryLineMerge();
     void createCollectionOfType();
@@ -5306,6 +5311,85 @@ void TestQgsGeometry::wkbInOut()
   QCOMPARE( badHeader.wkbType(), QgsWkbTypes::Unknown );
 }
 
+void TestQgsGeometry::lazyWkb()
+{
+  // geometries created from wkb are parsed on demand, so results must match the parsed geometry
+  QList< QgsGeometry > geometries;
+  geometries << QgsGeometry::fromWkt( QStringLiteral( "Point (1 2)" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "PointZM (1 2 3 4)" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "LineString (1 2, 3 -4, 5 6)" ) )
+             << QgsGeometry( new QgsLineString() )
+             << QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 3 2, 3 3, 2 2))" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "MultiPoint ((1 2),(-3 4))" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "MultiLineStringM ((1 2 3, 4 5 6),(7 8 9, 10 11 12))" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon (((0 0, 1 0, 1 1, 0 0)),((5 5, 6 5, 6 6, 5 5)))" ) )
+             << QgsGeometry( new QgsMultiPolygonV2() );
+
+  Q_FOREACH ( const QgsGeometry &parsed, geometries )
+  {
+    QVERIFY( !parsed.isNull() );
+    QByteArray wkb = parsed.exportToWkb();
+
+    QgsGeometry lazy;
+    lazy.fromWkb( wkb );
+    QVERIFY( !lazy.isNull() );
+    QCOMPARE( lazy.wkbType(), parsed.wkbType() );
+    QCOMPARE( lazy.type(), parsed.type() );
+    QCOMPARE( lazy.isMultipart(), parsed.isMultipart() );
+    QCOMPARE( lazy.isEmpty(), parsed.isEmpty() );
+    QCOMPARE( lazy.boundingBox(), parsed.boundingBox() );
+    QCOMPARE( lazy.exportToWkb(), wkb );
+    for ( int i = -1; i < 15; ++i )
+    {
+      QCOMPARE( lazy.vertexAt( i ), parsed.vertexAt( i ) );
+    }
+
+    // parsing on demand
+    QCOMPARE( lazy.exportToWkt(), parsed.exportToWkt() );
+  }
+
+  // modifying a copy of a lazy geometry must not change the original
+  QgsGeometry original;
+  original.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "LineString (1 2, 3 4)" ) ).exportToWkb() );
+  QgsGeometry copy( original );
+  QVERIFY( copy.moveVertex( 10, 20, 0 ) );
+  QCOMPARE( copy.exportToWkt(), QStringLiteral( "LineString (10 20, 3 4)" ) );
+  QCOMPARE( copy.boundingBox(), QgsRectangle( 3, 4, 10, 20 ) );
+  QCOMPARE( original.exportToWkt(), QStringLiteral( "LineString (1 2, 3 4)" ) );
+  QCOMPARE( original.boundingBox(), QgsRectangle( 1, 2, 3, 4 ) );
+
+  // trailing bytes are not part of the exported geometry
+  QByteArray wkb = QgsGeometry::fromWkt( QStringLiteral( "Point (1 2)" ) ).exportToWkb();
+  QgsGeometry trailing;
+  trailing.fromWkb( wkb + QByteArray( "xyz" ) );
+  QCOMPARE( trailing.exportToWkb(), wkb );
+
+  // raw buffers are owned by the geometry and read without copying them
+  QByteArray lineWkb = QgsGeometry::fromWkt( QStringLiteral( "LineString (1 2, 3 4)" ) ).exportToWkb();
+  unsigned char *buffer = new unsigned char[lineWkb.size()];
+  memcpy( buffer, lineWkb.constData(), lineWkb.size() );
+  QgsGeometry owner;
+  owner.fromWkb( buffer, lineWkb.size() );
+  QCOMPARE( owner.wkbType(), QgsWkbTypes::LineString );
+  QByteArray exported = owner.exportToWkb();
+  QCOMPARE( exported, lineWkb );
+  QVERIFY( exported.constData() != reinterpret_cast< const char * >( buffer ) );
+  QgsGeometry sharing( owner );
+  owner = QgsGeometry();
+  // the copy keeps the buffer alive
+  QCOMPARE( sharing.exportToWkt(), QStringLiteral( "LineString (1 2, 3 4)" ) );
+  QVERIFY( sharing.moveVertex( 10, 20, 0 ) );
+  QCOMPARE( sharing.exportToWkt(), QStringLiteral( "LineString (10 20, 3 4)" ) );
+  sharing = QgsGeometry();
+  QCOMPARE( exported, lineWkb );
+
+  // types which can't be deferred are parsed immediately
+  QgsGeometry curve;
+  curve.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) ).exportToWkb() );
+  QCOMPARE( curve.wkbType(), QgsWkbTypes::CircularString );
+  QCOMPARE( curve.exportToWkt(), QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) );
+}
+
 void TestQgsGeometry::directionNeutralSegmentation()
 {
   //Tests, if segmentation of a circularstring is the same in both directions
@@ -5520,6 +5604,98 @@ void TestQgsGeometry::isSimple()
   }
 }
 
+void TestQgsGeometry::testPredicates()
+{
+  QgsGeometry square = QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( square.geometry() ) );
+  const QgsGeometryEngine::SpatialPredicates all = QgsGeometryEngine::Intersects | QgsGeometryEngine::Touches | QgsGeometryEngine::Crosses
+      | QgsGeometryEngine::Within | QgsGeometryEngine::Overlaps | QgsGeometryEngine::Contains | QgsGeometryEngine::Disjoint | QgsGeometryEngine::Equals;
+
+  QList< QgsGeometry > candidates;
+  candidates << QgsGeometry::fromWkt( QStringLiteral( "Point (5 5)" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "Point (20 20)" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "LineString (-5 5, 15 5)" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) )
+             << QgsGeometry::fromWkt( QStringLiteral( "Polygon ((10 0, 20 0, 20 10, 10 10, 10 0))" ) )
+             << QgsGeometry();
+
+  for ( int prepared = 0; prepared < 2; ++prepared )
+  {
+    if ( prepared )
+      engine->prepareGeometry();
+
+    // results must match the individual predicate methods
+    Q_FOREACH ( const QgsGeometry &candidate, candidates )
+    {
+      const QgsAbstractGeometry *geom = candidate.geometry();
+      QgsGeometryEngine::SpatialPredicates expected;
+      if ( engine->intersects( geom ) )
+        expected |= QgsGeometryEngine::Intersects;
+      if ( engine->touches( geom ) )
+        expected |= QgsGeometryEngine::Touches;
+      if ( engine->crosses( geom ) )
+        expected |= QgsGeometryEngine::Crosses;
+      if ( engine->within( geom ) )
+        expected |= QgsGeometryEngine::Within;
+      if ( engine->overlaps( geom ) )
+        expected |= QgsGeometryEngine::Overlaps;
+      if ( engine->contains( geom ) )
+        expected |= QgsGeometryEngine::Contains;
+      if ( engine->disjoint( geom ) )
+        expected |= QgsGeometryEngine::Disjoint;
+      if ( engine->isEqual( geom ) )
+        expected |= QgsGeometryEngine::Equals;
+
+      QCOMPARE( engine->testPredicates( geom, all ), expected );
+      QCOMPARE( engine->testPredicates( geom, QgsGeometryEngine::Intersects ), expected & QgsGeometryEngine::Intersects );
+    }
+
+    QCOMPARE( engine->filterByPredicate( candidates, QgsGeometryEngine::Intersects ), QList< int >() << 0 << 2 << 3 << 4 );
+    QCOMPARE( engine->filterByPredicate( candidates, QgsGeometryEngine::Contains ), QList< int >() << 0 << 3 );
+    QCOMPARE( engine->filterByPredicate( candidates, QgsGeometryEngine::Touches ), QList< int >() << 4 );
+    QCOMPARE( engine->filterByPredicate( candidates, QgsGeometryEngine::Disjoint ), QList< int >() << 1 );
+  }
+}
+
+void TestQgsGeometry::preparedGeometryCache()
+{
+  QgsPreparedGeometryCache cache( 2 );
+  QVERIFY( !cache.engine( QgsGeometry() ) );
+
+  QgsGeometry square = QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  QgsGeometryEngine *engine = cache.engine( square );
+  QVERIFY( engine );
+  QVERIFY( engine->intersects( QgsGeometry::fromWkt( QStringLiteral( "Point (5 5)" ) ).geometry() ) );
+  QCOMPARE( cache.count(), 1 );
+  QVERIFY( cache.contains( square ) );
+
+  // copies share a cache entry
+  QgsGeometry copy = square;
+  QVERIFY( cache.contains( copy ) );
+  engine = cache.engine( copy );
+  QVERIFY( engine->intersects( QgsGeometry::fromWkt( QStringLiteral( "Point (5 5)" ) ).geometry() ) );
+  QCOMPARE( cache.count(), 1 );
+
+  // modifying a geometry detaches it from the cached one
+  copy.translate( 100, 100 );
+  QVERIFY( !cache.contains( copy ) );
+  QVERIFY( cache.contains( square ) );
+  engine = cache.engine( copy );
+  QVERIFY( !engine->intersects( QgsGeometry::fromWkt( QStringLiteral( "Point (5 5)" ) ).geometry() ) );
+  QCOMPARE( cache.count(), 2 );
+
+  // least recently used geometries are removed
+  QgsGeometry other = QgsGeometry::fromWkt( QStringLiteral( "Point (1 1)" ) );
+  cache.engine( other );
+  QCOMPARE( cache.count(), 2 );
+  QVERIFY( !cache.contains( square ) );
+  QVERIFY( cache.contains( copy ) );
+  QVERIFY( cache.contains( other ) );
+
+  cache.clear();
+  QCOMPARE( cache.count(), 0 );
+}
+
 void TestQgsGeometry::reshapeGeometryLineMerge()
 {
   int res;
@@ -17,6 +17,8 @@
 #include "qgstest.h"
 #include <QUrl>
 
+#include <cmath>
+
 //qgis includes...
 #include <qgsgeometry.h>
 #include <qgsgml.h>
@@ -77,6 +79,10 @@ class TestQgsGML : public QObject
     void testThroughOGRGeometry();
     void testThroughOGRGeometry_urn_EPSG_4326();
     void testAccents();
+    void testCoordinatesTokenizer();
+    void testPosListTokenizer();
+    void benchmarkGML2();
+    void benchmarkGML3();
 };
 
 const QString data1( "<myns:FeatureCollection "
@@ -1152,5 +1158,168 @@ void TestQgsGML::testAccents()
   delete features[0].first;
 }
 
+void TestQgsGML::testCoordinatesTokenizer()
+{
+  QgsFields fields;
+  QgsGmlStreamingParser gmlParser( QStringLiteral( "mytypename" ), QStringLiteral( "mygeom" ), fields );
+  QCOMPARE( gmlParser.processData( QByteArray( "<myns:FeatureCollection "
+                                   "xmlns:myns='http://myns' "
+                                   "xmlns:gml='http://www.opengis.net/gml'>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.1'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:coordinates>0,0\n 1.5,2e2\t-3,-4.25E-1,7 x,1 5,</gml:coordinates>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.2'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:coordinates cs=';' ts='|'>1e1;-2.5|3;4;5|x;1|6 ; 7</gml:coordinates>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.3'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:coordinates cs='::'>1::2 3::4</gml:coordinates>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "</myns:FeatureCollection>" ), true ), true );
+  QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> features = gmlParser.getAndStealReadyFeatures();
+  QCOMPARE( features.size(), 3 );
+
+  QgsPolyline line = features[0].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 3 );
+  QCOMPARE( line[0], QgsPointXY( 0, 0 ) );
+  QCOMPARE( line[1], QgsPointXY( 1.5, 200 ) );
+  QCOMPARE( line[2], QgsPointXY( -3, -0.425 ) );
+
+  line = features[1].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 3 );
+  QCOMPARE( line[0], QgsPointXY( 10, -2.5 ) );
+  QCOMPARE( line[1], QgsPointXY( 3, 4 ) );
+  QCOMPARE( line[2], QgsPointXY( 6, 7 ) );
+
+  line = features[2].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 2 );
+  QCOMPARE( line[0], QgsPointXY( 1, 2 ) );
+  QCOMPARE( line[1], QgsPointXY( 3, 4 ) );
+
+  for ( int i = 0; i < features.size(); i++ )
+    delete features[i].first;
+}
+
+void TestQgsGML::testPosListTokenizer()
+{
+  QgsFields fields;
+  QgsGmlStreamingParser gmlParser( QStringLiteral( "mytypename" ), QStringLiteral( "mygeom" ), fields );
+  QCOMPARE( gmlParser.processData( QByteArray( "<myns:FeatureCollection "
+                                   "xmlns:myns='http://myns' "
+                                   "xmlns:gml='http://www.opengis.net/gml'>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.1'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:posList srsDimension='3'>1 2 3\n4 5 6\t7.5e-1   -8 9 12345678.123456789 0.000001 0</gml:posList>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "<gml:featureMember>"
+                                   "<myns:mytypename fid='mytypename.2'>"
+                                   "<myns:mygeom>"
+                                   "<gml:LineString srsName='EPSG:27700'>"
+                                   "<gml:posList>1 2 abc 4 -5 6 7</gml:posList>"
+                                   "</gml:LineString>"
+                                   "</myns:mygeom>"
+                                   "</myns:mytypename>"
+                                   "</gml:featureMember>"
+                                   "</myns:FeatureCollection>" ), true ), true );
+  QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> features = gmlParser.getAndStealReadyFeatures();
+  QCOMPARE( features.size(), 2 );
+
+  QgsPolyline line = features[0].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 4 );
+  QCOMPARE( line[0], QgsPointXY( 1, 2 ) );
+  QCOMPARE( line[1], QgsPointXY( 4, 5 ) );
+  QCOMPARE( line[2], QgsPointXY( 0.75, -8 ) );
+  QCOMPARE( line[3].x(), 12345678.123456789 );
+  QCOMPARE( line[3].y(), 0.000001 );
+
+  // the position with an invalid coordinate and the incomplete one are skipped
+  line = features[1].first->geometry().asPolyline();
+  QCOMPARE( line.size(), 2 );
+  QCOMPARE( line[0], QgsPointXY( 1, 2 ) );
+  QCOMPARE( line[1], QgsPointXY( -5, 6 ) );
+
+  for ( int i = 0; i < features.size(); i++ )
+    delete features[i].first;
+}
+
+static QByteArray benchmarkCorpus( bool gml3 )
+{
+  const int featureCount = 1000;
+  const int vertexCount = 100;
+  QByteArray data( "<myns:FeatureCollection "
+                   "xmlns:myns='http://myns' "
+                   "xmlns:gml='http://www.opengis.net/gml'>" );
+  for ( int i = 0; i < featureCount; i++ )
+  {
+    QByteArray coordinates;
+    for ( int j = 0; j <= vertexCount; j++ )
+    {
+      const double angle = 2 * M_PI * ( j % vertexCount ) / vertexCount;
+      const QByteArray x = QByteArray::number( 500000 + 1000 * ( i % 100 ) + 100 * std::cos( angle ), 'f', 3 );
+      const QByteArray y = QByteArray::number( 200000 + 1000 * ( i / 100 ) + 100 * std::sin( angle ), 'f', 3 );
+      if ( j > 0 )
+        coordinates += ' ';
+      coordinates += x + ( gml3 ? " " : "," ) + y;
+    }
+    data += "<gml:featureMember><myns:mytypename fid='mytypename." + QByteArray::number( i ) + "'><myns:mygeom>";
+    if ( gml3 )
+      data += "<gml:Polygon srsName='EPSG:27700'><gml:exterior><gml:LinearRing><gml:posList>" + coordinates +
+              "</gml:posList></gml:LinearRing></gml:exterior></gml:Polygon>";
+    else
+      data += "<gml:Polygon srsName='EPSG:27700'><gml:outerBoundaryIs><gml:LinearRing><gml:coordinates>" + coordinates +
+              "</gml:coordinates></gml:LinearRing></gml:outerBoundaryIs></gml:Polygon>";
+    data += "</myns:mygeom></myns:mytypename></gml:featureMember>";
+  }
+  data += "</myns:FeatureCollection>";
+  return data;
+}
+
+static void benchmarkParsing( const QByteArray &data )
+{
+  QgsFields fields;
+  QBENCHMARK
+  {
+    QgsGmlStreamingParser gmlParser( QStringLiteral( "mytypename" ), QStringLiteral( "mygeom" ), fields );
+    QCOMPARE( gmlParser.processData( data, true ), true );
+    QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> features = gmlParser.getAndStealReadyFeatures();
+    QCOMPARE( features.size(), 1000 );
+    QCOMPARE( features[0].first->geometry().asPolygon()[0].size(), 101 );
+    for ( int i = 0; i < features.size(); i++ )
+      delete features[i].first;
+  }
+}
+
+void TestQgsGML::benchmarkGML2()
+{
+  benchmarkParsing( benchmarkCorpus( false ) );
+}
+
+void TestQgsGML::benchmarkGML3()
+{
+  benchmarkParsing( benchmarkCorpus( true ) );
+}
+
 QGSTEST_MAIN( TestQgsGML )
 #include "testqgsgml.moc"
@@ -22,6 +22,7 @@
 #include "qgsrenderchecker.h"
 #include "qgssymbollayerutils.h"
 #include "qgsapplication.h"
+#include <memory>
 
 class TestQgsImageOperation : public QObject
 {
@@ -76,6 +77,8 @@ class TestQgsImageOperation : public QObject
     void gaussianBlur();
     void gaussianBlurSmall();
     void gaussianBlurNoChange();
+    void benchmarkStackBlur();
+    void benchmarkGaussianBlur();
 
     //flip
     void flipHorizontal();
@@ -428,6 +431,29 @@ void TestQgsImageOperation::gaussianBlurNoChange()
   QVERIFY( result );
 }
 
+void TestQgsImageOperation::benchmarkStackBlur()
+{
+  QImage image( mSampleImage );
+  image = image.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+
+  QBENCHMARK
+  {
+    QImage blurred = image.copy();
+    QgsImageOperation::stackBlur( blurred, 10 );
+  }
+}
+
+void TestQgsImageOperation::benchmarkGaussianBlur()
+{
+  QImage image( mSampleImage );
+  image = image.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+
+  QBENCHMARK
+  {
+    std::unique_ptr< QImage > blurred( QgsImageOperation::gaussianBlur( image, 30 ) );
+  }
+}
+
 void TestQgsImageOperation::flipHorizontal()
 {
   QImage image( mSampleImage );
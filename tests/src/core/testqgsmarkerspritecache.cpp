@@ -0,0 +1,200 @@
+/***************************************************************************
+                         testqgsmarkerspritecache.cpp
+                         ----------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QImage>
+#include <QPainter>
+
+#include "qgsapplication.h"
+#include "qgsmarkerspritecache.h"
+#include "qgsmarkersymbollayer.h"
+#include "qgsproperty.h"
+#include "qgsrendercontext.h"
+#include "qgssymbol.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+
+class TestQgsMarkerSpriteCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void cache();
+    void cacheFull();
+    void dataDefinedMarkers();
+    void fractionalPoints();
+
+  private:
+    QImage renderMarkers( bool forceVectorOutput );
+    QImage renderMarker( QPointF point, bool forceVectorOutput );
+    static QPointF alphaCentroid( const QImage &image );
+};
+
+void TestQgsMarkerSpriteCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsMarkerSpriteCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsMarkerSpriteCache::cache()
+{
+  QgsMarkerSpriteCache cache;
+  QVERIFY( !cache.isEnabled() );
+
+  QImage image( 5, 5, QImage::Format_ARGB32_Premultiplied );
+  QVERIFY( !cache.insertSprite( QStringLiteral( "a" ), image, QPointF( -2, -2 ) ) );
+  QVERIFY( !cache.sprite( QStringLiteral( "a" ) ) );
+
+  cache.setEnabled( true );
+  QVERIFY( cache.insertSprite( QStringLiteral( "a" ), image, QPointF( -2, -2 ) ) );
+  QCOMPARE( cache.count(), 1 );
+  QVERIFY( cache.sprite( QStringLiteral( "a" ) ) );
+  QCOMPARE( cache.sprite( QStringLiteral( "a" ) )->origin, QPointF( -2, -2 ) );
+  QCOMPARE( cache.sprite( QStringLiteral( "a" ) )->image.size(), QSize( 5, 5 ) );
+  QVERIFY( !cache.sprite( QStringLiteral( "b" ) ) );
+
+  // disabling clears the cache
+  cache.setEnabled( false );
+  QCOMPARE( cache.count(), 0 );
+}
+
+void TestQgsMarkerSpriteCache::cacheFull()
+{
+  QgsMarkerSpriteCache cache( 2 );
+  cache.setEnabled( true );
+  QImage image( 5, 5, QImage::Format_ARGB32_Premultiplied );
+  QVERIFY( cache.insertSprite( QStringLiteral( "a" ), image, QPointF() ) );
+  QVERIFY( cache.insertSprite( QStringLiteral( "b" ), image, QPointF() ) );
+  QVERIFY( !cache.insertSprite( QStringLiteral( "c" ), image, QPointF() ) );
+  QVERIFY( !cache.isEnabled() );
+  QCOMPARE( cache.count(), 0 );
+}
+
+void TestQgsMarkerSpriteCache::dataDefinedMarkers()
+{
+  // markers drawn from cached sprites must match markers drawn directly
+  QImage cached = renderMarkers( false );
+  QImage direct = renderMarkers( true );
+  QCOMPARE( cached, direct );
+}
+
+void TestQgsMarkerSpriteCache::fractionalPoints()
+{
+  // markers drawn from cached sprites keep the fractional position of their point
+  QList< QPointF > points;
+  points << QPointF( 20.25, 20 ) << QPointF( 20.5, 20.5 ) << QPointF( 20.75, 20.3 ) << QPointF( 20, 20.6 );
+  Q_FOREACH ( QPointF point, points )
+  {
+    QPointF cached = alphaCentroid( renderMarker( point, false ) );
+    QPointF direct = alphaCentroid( renderMarker( point, true ) );
+    QGSCOMPARENEAR( cached.x(), direct.x(), 0.05 );
+    QGSCOMPARENEAR( cached.y(), direct.y(), 0.05 );
+    QGSCOMPARENEAR( cached.x(), point.x(), 0.05 );
+    QGSCOMPARENEAR( cached.y(), point.y(), 0.05 );
+  }
+}
+
+QImage TestQgsMarkerSpriteCache::renderMarker( QPointF point, bool forceVectorOutput )
+{
+  QgsSimpleMarkerSymbolLayer *layer = new QgsSimpleMarkerSymbolLayer( QgsSimpleMarkerSymbolLayerBase::Circle, 4 );
+  layer->setStrokeStyle( Qt::NoPen );
+  // a data defined size makes the layer draw sprites instead of its single static image
+  layer->setDataDefinedProperty( QgsSymbolLayer::PropertySize, QgsProperty::fromExpression( QStringLiteral( "4" ) ) );
+  QgsMarkerSymbol symbol( QgsSymbolLayerList() << layer );
+
+  QImage image( 40, 40, QImage::Format_ARGB32_Premultiplied );
+  image.fill( 0 );
+  QPainter painter( &image );
+  painter.setRenderHint( QPainter::Antialiasing );
+
+  QgsRenderContext context;
+  context.setPainter( &painter );
+  context.setScaleFactor( 96 / 25.4 );
+  context.setForceVectorOutput( forceVectorOutput );
+
+  symbol.startRender( context );
+  // the first point renders the sprite, the second one is drawn from the cache
+  symbol.renderPoint( point, nullptr, context );
+  image.fill( 0 );
+  symbol.renderPoint( point, nullptr, context );
+  symbol.stopRender( context );
+  painter.end();
+  return image;
+}
+
+QPointF TestQgsMarkerSpriteCache::alphaCentroid( const QImage &image )
+{
+  double sum = 0;
+  double sumX = 0;
+  double sumY = 0;
+  for ( int y = 0; y < image.height(); ++y )
+  {
+    const QRgb *line = reinterpret_cast< const QRgb * >( image.constScanLine( y ) );
+    for ( int x = 0; x < image.width(); ++x )
+    {
+      double alpha = qAlpha( line[x] );
+      sum += alpha;
+      // pixel centers are at half integers
+      sumX += alpha * ( x + 0.5 );
+      sumY += alpha * ( y + 0.5 );
+    }
+  }
+  return sum > 0 ? QPointF( sumX / sum, sumY / sum ) : QPointF();
+}
+
+QImage TestQgsMarkerSpriteCache::renderMarkers( bool forceVectorOutput )
+{
+  QgsSimpleMarkerSymbolLayer *layer = new QgsSimpleMarkerSymbolLayer( QgsSimpleMarkerSymbolLayerBase::Square, 5 );
+  layer->setDataDefinedProperty( QgsSymbolLayer::PropertyFillColor, QgsProperty::fromExpression( QStringLiteral( "case when \"cls\" = 1 then 'red' else 'blue' end" ) ) );
+  layer->setDataDefinedProperty( QgsSymbolLayer::PropertySize, QgsProperty::fromExpression( QStringLiteral( "3 + \"cls\"" ) ) );
+  QgsMarkerSymbol symbol( QgsSymbolLayerList() << layer );
+
+  QImage image( 200, 200, QImage::Format_ARGB32_Premultiplied );
+  image.fill( 0 );
+  QPainter painter( &image );
+  painter.setRenderHint( QPainter::Antialiasing );
+
+  QgsRenderContext context;
+  context.setPainter( &painter );
+  context.setScaleFactor( 96 / 25.4 );
+  context.setForceVectorOutput( forceVectorOutput );
+
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "cls" ), QVariant::Int ) );
+
+  symbol.startRender( context, fields );
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature f( fields, i );
+    f.setAttribute( 0, i % 2 );
+    context.expressionContext().setFeature( f );
+    symbol.renderPoint( QPointF( 10 + ( i % 10 ) * 18, 10 + ( i / 10 ) * 18 ), &f, context );
+  }
+  symbol.stopRender( context );
+  painter.end();
+  return image;
+}
+
+QGSTEST_MAIN( TestQgsMarkerSpriteCache )
+#include "testqgsmarkerspritecache.moc"
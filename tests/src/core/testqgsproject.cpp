@@ -14,18 +14,37 @@
  ***************************************************************************/
 #include "qgstest.h"
 
+#include <QDomDocument>
+#include <QFileInfo>
 #include <QObject>
+#include <QThread>
 
 #include "qgsapplication.h"
+#include "qgslayertree.h"
+#include "qgsmapthemecollection.h"
 #include "qgsmarkersymbollayer.h"
 #include "qgspathresolver.h"
 #include "qgsproject.h"
+#include "qgsprojectbadlayerhandler.h"
+#include "qgsprojectsnapshot.h"
 #include "qgssinglesymbolrenderer.h"
 #include "qgssettings.h"
 #include "qgsunittypes.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
 
 
+//! Bad layer handler which counts the layers it is given
+class TestBadLayerHandler : public QgsProjectBadLayerHandler
+{
+  public:
+    explicit TestBadLayerHandler( int *count ) : mCount( count ) {}
+    void handleBadLayers( const QList<QDomNode> &layers ) override { *mCount += layers.count(); }
+
+  private:
+    int *mCount = nullptr;
+};
+
 class TestQgsProject : public QObject
 {
     Q_OBJECT
@@ -40,6 +59,9 @@ class TestQgsProject : public QObject
     void testPathResolverSvg();
     void testProjectUnits();
     void variablesChanged();
+    void parallelLayerLoading();
+    void lazyLayerLoading();
+    void projectSnapshot();
 };
 
 void TestQgsProject::init()
@@ -318,6 +340,187 @@ void TestQgsProject::variablesChanged()
   delete prj;
 }
 
+void TestQgsProject::parallelLayerLoading()
+{
+  QString dataDir( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+  QString projectFilename = dir.path() + "/project.qgs";
+
+  QgsProject project;
+  QgsVectorLayer *points = new QgsVectorLayer( dataDir + "/points.shp", "points", "ogr" );
+  QgsVectorLayer *lines = new QgsVectorLayer( dataDir + "/lines.shp", "lines", "ogr" );
+  QgsVectorLayer *polys = new QgsVectorLayer( dataDir + "/polys.shp", "polys", "ogr" );
+  QVERIFY( points->isValid() && lines->isValid() && polys->isValid() );
+  project.addMapLayers( QList<QgsMapLayer *>() << points << lines << polys );
+  QVERIFY( project.write( projectFilename ) );
+
+  QgsSettings settings;
+  Q_FOREACH ( bool parallel, QList<bool>() << false << true )
+  {
+    settings.setValue( QStringLiteral( "qgis/parallelLayerLoading" ), parallel );
+
+    QgsProject loaded;
+    QVERIFY( loaded.read( projectFilename ) );
+    QCOMPARE( loaded.count(), 3 );
+    Q_FOREACH ( QgsMapLayer *layer, project.mapLayers() )
+    {
+      QgsVectorLayer *loadedLayer = qobject_cast< QgsVectorLayer * >( loaded.mapLayer( layer->id() ) );
+      QVERIFY( loadedLayer );
+      QVERIFY( loadedLayer->isValid() );
+      QCOMPARE( loadedLayer->featureCount(), qobject_cast< QgsVectorLayer * >( layer )->featureCount() );
+      // preloaded providers are handed over to the main thread
+      QCOMPARE( loadedLayer->dataProvider()->thread(), QThread::currentThread() );
+    }
+  }
+  settings.remove( QStringLiteral( "qgis/parallelLayerLoading" ) );
+}
+
+void TestQgsProject::lazyLayerLoading()
+{
+  QString dataDir( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+  QString projectFilename = dir.path() + "/project.qgs";
+
+  // a layer whose data is gone by the time the project is read
+  Q_FOREACH ( const QString &ext, QStringList() << "shp" << "shx" << "dbf" << "prj" )
+    QVERIFY( QFile::copy( dataDir + "/points." + ext, dir.path() + "/missing." + ext ) );
+
+  QgsProject project;
+  QgsVectorLayer *points = new QgsVectorLayer( dataDir + "/points.shp", "points", "ogr" );
+  QgsVectorLayer *lines = new QgsVectorLayer( dataDir + "/lines.shp", "lines", "ogr" );
+  QgsVectorLayer *polys = new QgsVectorLayer( dataDir + "/polys.shp", "polys", "ogr" );
+  QgsVectorLayer *missing = new QgsVectorLayer( dir.path() + "/missing.shp", "missing", "ogr" );
+  QVERIFY( missing->isValid() );
+  project.addMapLayers( QList<QgsMapLayer *>() << points << lines << polys << missing );
+  QgsMapThemeCollection::MapThemeRecord theme;
+  theme.setLayerRecords( QList<QgsMapThemeCollection::MapThemeLayerRecord>() << QgsMapThemeCollection::MapThemeLayerRecord( lines ) );
+  project.mapThemeCollection()->insert( QStringLiteral( "theme" ), theme );
+  QVERIFY( project.write( projectFilename ) );
+  QString missingId = missing->id();
+  project.removeMapLayer( missing );
+  Q_FOREACH ( const QString &ext, QStringList() << "shp" << "shx" << "dbf" << "prj" )
+    QVERIFY( QFile::remove( dir.path() + "/missing." + ext ) );
+
+  QgsProject loaded;
+  int badLayers = 0;
+  loaded.setBadLayerHandler( new TestBadLayerHandler( &badLayers ) );
+  loaded.setLazyLayerLoading( true );
+  QVERIFY( loaded.read( projectFilename ) );
+  QCOMPARE( badLayers, 0 );
+
+  // nothing is loaded, but the layer tree is complete
+  QCOMPARE( loaded.count(), 0 );
+  QCOMPARE( loaded.unloadedLayerIds().count(), 4 );
+  QCOMPARE( loaded.layerTreeRoot()->findLayers().count(), 4 );
+  QCOMPARE( loaded.unloadedLayerElement( lines->id() ).firstChildElement( QStringLiteral( "layername" ) ).text(), QStringLiteral( "lines" ) );
+
+  // a layer which fails to load is passed to the bad layer handler
+  QVERIFY( !loaded.loadLayer( missingId ) );
+  QCOMPARE( badLayers, 1 );
+  QVERIFY( !loaded.unloadedLayerIds().contains( missingId ) );
+
+  // looking layers up does not load them
+  QVERIFY( !loaded.mapLayer( lines->id() ) );
+  QVERIFY( loaded.mapLayersByName( QStringLiteral( "lines" ) ).isEmpty() );
+  QVERIFY( loaded.mapLayers().isEmpty() );
+
+  // layers are loaded when requested
+  QgsMapLayer *layer = loaded.loadLayer( lines->id() );
+  QVERIFY( layer );
+  QVERIFY( layer->isValid() );
+  QCOMPARE( loaded.count(), 1 );
+  QCOMPARE( loaded.mapLayer( lines->id() ), layer );
+  QVERIFY( loaded.unloadedLayerElement( lines->id() ).isNull() );
+  QCOMPARE( loaded.layerTreeRoot()->findLayer( lines->id() )->layer(), layer );
+  // references to the layer are resolved once it is loaded
+  QCOMPARE( loaded.mapThemeCollection()->mapThemeVisibleLayerIds( QStringLiteral( "theme" ) ), QStringList() << lines->id() );
+  QVERIFY( loaded.loadLayer( polys->id() ) );
+  QCOMPARE( loaded.count(), 2 );
+
+  // the least recently used layer is unloaded first, its tree node is kept
+  loaded.loadLayer( polys->id() );
+  QCOMPARE( loaded.unloadIdleLayers( 1 ), 1 );
+  QCOMPARE( loaded.count(), 1 );
+  QVERIFY( loaded.mapLayer( polys->id() ) );
+  QVERIFY( !loaded.unloadedLayerElement( lines->id() ).isNull() );
+  QCOMPARE( loaded.layerTreeRoot()->findLayers().count(), 4 );
+
+  // all remaining layers can be loaded at once
+  loaded.loadAllLayers();
+  QCOMPARE( loaded.mapLayers().count(), 3 );
+  QVERIFY( loaded.unloadedLayerIds().isEmpty() );
+}
+
+void TestQgsProject::projectSnapshot()
+{
+  QString dataDir( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+  QString projectFilename = dir.path() + "/project.qgs";
+
+  QgsSettings settings;
+  settings.setValue( QStringLiteral( "qgis/projectSnapshots" ), true );
+
+  QgsProject project;
+  project.setTitle( QStringLiteral( "snapshot <&> \"title\"" ) );
+  QgsVectorLayer *points = new QgsVectorLayer( dataDir + "/points.shp", "points", "ogr" );
+  QgsVectorLayer *lines = new QgsVectorLayer( dataDir + "/lines.shp", "lines", "ogr" );
+  project.addMapLayers( QList<QgsMapLayer *>() << points << lines );
+  QVERIFY( project.write( projectFilename ) );
+  QVERIFY( QFile::exists( QgsProjectSnapshot::snapshotPath( projectFilename ) ) );
+  QVERIFY( QgsProjectSnapshot::isUpToDate( projectFilename ) );
+
+  // the snapshot holds the same document as the project file
+  QFile projectFile( projectFilename );
+  QVERIFY( projectFile.open( QIODevice::ReadOnly ) );
+  QDomDocument xmlDoc;
+  QVERIFY( xmlDoc.setContent( &projectFile ) );
+  projectFile.close();
+  QDomDocument snapshotDoc;
+  QVERIFY( QgsProjectSnapshot::read( projectFilename, snapshotDoc ) );
+  QCOMPARE( snapshotDoc.elementsByTagName( QStringLiteral( "*" ) ).count(), xmlDoc.elementsByTagName( QStringLiteral( "*" ) ).count() );
+  QCOMPARE( snapshotDoc.documentElement().attribute( QStringLiteral( "projectname" ) ), project.title() );
+  QCOMPARE( snapshotDoc.elementsByTagName( QStringLiteral( "maplayer" ) ).count(), 2 );
+
+  QgsProject loaded;
+  QVERIFY( loaded.read( projectFilename ) );
+  QCOMPARE( loaded.title(), project.title() );
+  QCOMPARE( loaded.count(), 2 );
+  QVERIFY( loaded.mapLayer( points->id() )->isValid() );
+
+  // a snapshot is ignored once the project content changes, even if its size and
+  // modification time are preserved
+  QVERIFY( projectFile.open( QIODevice::ReadOnly ) );
+  QByteArray content = projectFile.readAll();
+  projectFile.close();
+  const QDateTime modified = QFileInfo( projectFilename ).lastModified();
+  int titleIndex = content.indexOf( "snapshot" );
+  QVERIFY( titleIndex >= 0 );
+  content[ titleIndex ] = 'S';
+  QVERIFY( projectFile.open( QIODevice::ReadWrite ) );
+  projectFile.write( content );
+#if QT_VERSION >= 0x050A00
+  QVERIFY( projectFile.setFileTime( modified, QFileDevice::FileModificationTime ) );
+#endif
+  projectFile.close();
+  QVERIFY( !QgsProjectSnapshot::isUpToDate( projectFilename ) );
+  QVERIFY( !QgsProjectSnapshot::read( projectFilename, snapshotDoc ) );
+  QVERIFY( project.write( projectFilename ) );
+  QVERIFY( QgsProjectSnapshot::isUpToDate( projectFilename ) );
+
+  // a snapshot is ignored once the project file changes
+  QVERIFY( projectFile.open( QIODevice::Append ) );
+  projectFile.write( "\n" );
+  projectFile.close();
+  QVERIFY( !QgsProjectSnapshot::isUpToDate( projectFilename ) );
+  QVERIFY( !QgsProjectSnapshot::read( projectFilename, snapshotDoc ) );
+  QVERIFY( loaded.read( projectFilename ) );
+  QCOMPARE( loaded.count(), 2 );
+
+  settings.remove( QStringLiteral( "qgis/projectSnapshots" ) );
+}
 
 QGSTEST_MAIN( TestQgsProject )
 #include "testqgsproject.moc"
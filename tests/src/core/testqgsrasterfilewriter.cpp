@@ -24,6 +24,7 @@
 #include <QDesktopServices>
 
 #include "cpl_conv.h"
+#include "gdal.h"
 
 //qgis includes...
 #include <qgsrasterchecker.h>
@@ -49,6 +50,8 @@ class TestQgsRasterFileWriter: public QObject
     void writeTest();
     void testCreateOneBandRaster();
     void testCreateMultiBandRaster();
+    void testParallelWrite();
+    void testCloudOptimized();
   private:
     bool writeTest( const QString &rasterName );
     void log( const QString &msg );
@@ -270,6 +273,87 @@ void TestQgsRasterFileWriter::testCreateMultiBandRaster()
   delete rlayer;
 }
 
+void TestQgsRasterFileWriter::testParallelWrite()
+{
+  QString sourceFile = mTestDataDir + "/raster/band3_float32_noct_epsg4326.tif";
+  std::unique_ptr<QgsRasterLayer> layer( new QgsRasterLayer( sourceFile, QStringLiteral( "source" ) ) );
+  QVERIFY( layer->isValid() );
+  QgsRasterDataProvider *provider = layer->dataProvider();
+
+  Q_FOREACH ( bool parallel, QList< bool >() << false << true )
+  {
+    QTemporaryFile tmpFile;
+    tmpFile.open();
+    tmpFile.close();
+    QString filename = tmpFile.fileName();
+
+    QgsRasterPipe pipe;
+    QVERIFY( pipe.set( provider->clone() ) );
+
+    // many small parts, so that several are read at the same time
+    QgsRasterFileWriter writer( filename );
+    writer.setMaxTileWidth( 7 );
+    writer.setMaxTileHeight( 5 );
+    writer.setParallelProcessing( parallel );
+    QVERIFY( writer.parallelProcessing() == parallel );
+    QCOMPARE( writer.writeRaster( &pipe, provider->xSize(), provider->ySize(), provider->extent(), provider->crs() ), QgsRasterFileWriter::NoError );
+
+    QgsRasterChecker checker;
+    bool ok = checker.runTest( QStringLiteral( "gdal" ), filename, QStringLiteral( "gdal" ), sourceFile );
+    mReport += checker.report();
+    QVERIFY( ok );
+  }
+}
+
+void TestQgsRasterFileWriter::testCloudOptimized()
+{
+  QString sourceFile = mTestDataDir + "/raster/band1_byte_noct_epsg4326.tif";
+  std::unique_ptr<QgsRasterLayer> layer( new QgsRasterLayer( sourceFile, QStringLiteral( "source" ) ) );
+  QVERIFY( layer->isValid() );
+  QgsRasterDataProvider *provider = layer->dataProvider();
+
+  QTemporaryFile tmpFile;
+  tmpFile.open();
+  tmpFile.close();
+  QString filename = tmpFile.fileName();
+
+  QgsRasterPipe pipe;
+  QVERIFY( pipe.set( provider->clone() ) );
+
+  QgsRasterFileWriter writer( filename );
+  writer.setCloudOptimized( true );
+  QVERIFY( writer.cloudOptimized() );
+  writer.setPyramidsList( QList< int >() << 2 << 4 );
+  writer.setCreateOptions( QStringList() << QStringLiteral( "COMPRESS=DEFLATE" ) );
+  QCOMPARE( writer.writeRaster( &pipe, provider->xSize(), provider->ySize(), provider->extent(), provider->crs() ), QgsRasterFileWriter::NoError );
+  QVERIFY( writer.stageTime( QgsRasterFileWriter::CloudOptimizing ) >= 0 );
+  QVERIFY( !QFile::exists( filename + ".tmp.tif" ) );
+
+  QgsRasterChecker checker;
+  bool ok = checker.runTest( QStringLiteral( "gdal" ), filename, QStringLiteral( "gdal" ), sourceFile );
+  mReport += checker.report();
+  QVERIFY( ok );
+
+  GDALDatasetH dataset = GDALOpen( filename.toUtf8().constData(), GA_ReadOnly );
+  QVERIFY( dataset );
+  GDALRasterBandH band = GDALGetRasterBand( dataset, 1 );
+  QCOMPARE( GDALGetOverviewCount( band ), 2 );
+  int blockXSize = 0;
+  int blockYSize = 0;
+  GDALGetBlockSize( band, &blockXSize, &blockYSize );
+  // tiled, not stripped
+  QCOMPARE( blockXSize, 256 );
+  QCOMPARE( blockYSize, 256 );
+  QCOMPARE( QString( GDALGetMetadataItem( dataset, "COMPRESSION", "IMAGE_STRUCTURE" ) ), QStringLiteral( "DEFLATE" ) );
+  GDALClose( dataset );
+
+  // only GeoTIFF output can be cloud optimized
+  QgsRasterFileWriter hfaWriter( filename + ".img" );
+  hfaWriter.setOutputFormat( QStringLiteral( "HFA" ) );
+  hfaWriter.setCloudOptimized( true );
+  QCOMPARE( hfaWriter.writeRaster( &pipe, provider->xSize(), provider->ySize(), provider->extent(), provider->crs() ), QgsRasterFileWriter::DestProviderError );
+}
+
 void TestQgsRasterFileWriter::log( const QString &msg )
 {
   mReport += msg + "<br>";
@@ -36,6 +36,8 @@ class TestQgsStatisticSummary: public QObject
     void maxMin();
     void countMissing();
     void noValues();
+    void merge();
+    void approximate();
 
   private:
 
@@ -339,5 +341,93 @@ void TestQgsStatisticSummary::noValues()
   QVERIFY( std::isnan( s.statistic( QgsStatisticalSummary::InterQuartileRange ) ) );
 }
 
+void TestQgsStatisticSummary::merge()
+{
+  // summaries of parts of the values must merge to the summary of all values
+  QList<double> values;
+  for ( int i = 0; i < 1000; ++i )
+    values << ( i * 37 ) % 101 - 20.5;
+
+  QgsStatisticalSummary all( QgsStatisticalSummary::All );
+  all.calculate( values );
+
+  QgsStatisticalSummary merged( QgsStatisticalSummary::All );
+  QgsStatisticalSummary part( QgsStatisticalSummary::All );
+  for ( int i = 0; i < values.count(); ++i )
+  {
+    part.addValue( values.at( i ) );
+    if ( i % 300 == 299 )
+    {
+      merged.merge( part );
+      part.reset();
+    }
+  }
+  part.addVariant( QVariant() );
+  merged.merge( part );
+  // merging an empty summary changes nothing
+  merged.merge( QgsStatisticalSummary( QgsStatisticalSummary::All ) );
+  merged.finalize();
+
+  QCOMPARE( merged.count(), all.count() );
+  QCOMPARE( merged.countMissing(), 1 );
+  QGSCOMPARENEAR( merged.sum(), all.sum(), 0.000001 );
+  QGSCOMPARENEAR( merged.mean(), all.mean(), 0.000001 );
+  QGSCOMPARENEAR( merged.stDev(), all.stDev(), 0.000001 );
+  QGSCOMPARENEAR( merged.sampleStDev(), all.sampleStDev(), 0.000001 );
+  QCOMPARE( merged.min(), all.min() );
+  QCOMPARE( merged.max(), all.max() );
+  QCOMPARE( merged.median(), all.median() );
+  QCOMPARE( merged.firstQuartile(), all.firstQuartile() );
+  QCOMPARE( merged.thirdQuartile(), all.thirdQuartile() );
+  QCOMPARE( merged.variety(), all.variety() );
+  QCOMPARE( merged.minority(), all.minority() );
+  QCOMPARE( merged.majority(), all.majority() );
+}
+
+void TestQgsStatisticSummary::approximate()
+{
+  QgsStatisticalSummary exact( QgsStatisticalSummary::All );
+  QgsStatisticalSummary approx( QgsStatisticalSummary::Median | QgsStatisticalSummary::FirstQuartile
+                                | QgsStatisticalSummary::ThirdQuartile | QgsStatisticalSummary::Variety
+                                | QgsStatisticalSummary::StDev );
+  approx.setApproximate( true );
+  QVERIFY( approx.approximate() );
+
+  // a shuffled sequence of 10000 distinct values, split between two summaries
+  QgsStatisticalSummary approxPart( approx.statistics() );
+  approxPart.setApproximate( true );
+  for ( int i = 0; i < 10000; ++i )
+  {
+    double value = ( i * 7919 ) % 10000;
+    exact.addValue( value );
+    if ( i % 2 )
+      approx.addValue( value );
+    else
+      approxPart.addValue( value );
+  }
+  approx.merge( approxPart );
+  exact.finalize();
+  approx.finalize();
+
+  // approximated statistics are close to the exact ones
+  QCOMPARE( approx.count(), 10000 );
+  QGSCOMPARENEAR( approx.median(), exact.median(), 25 );
+  QGSCOMPARENEAR( approx.firstQuartile(), exact.firstQuartile(), 25 );
+  QGSCOMPARENEAR( approx.thirdQuartile(), exact.thirdQuartile(), 25 );
+  QGSCOMPARENEAR( approx.variety(), 10000, 500 );
+
+  // other statistics are always exact
+  QGSCOMPARENEAR( approx.stDev(), exact.stDev(), 0.000001 );
+  QCOMPARE( approx.min(), exact.min() );
+  QCOMPARE( approx.max(), exact.max() );
+
+  // few values give exact results
+  QgsStatisticalSummary small( QgsStatisticalSummary::Median | QgsStatisticalSummary::Variety );
+  small.setApproximate( true );
+  small.calculate( QList< double >() << 4 << 2 << 3 << 2 << 5 << 8 );
+  QCOMPARE( small.variety(), 5 );
+  QCOMPARE( small.median(), 3.5 );
+}
+
 QGSTEST_MAIN( TestQgsStatisticSummary )
 #include "testqgsstatisticalsummary.moc"
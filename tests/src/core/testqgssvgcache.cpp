@@ -0,0 +1,128 @@
+/***************************************************************************
+                         testqgssvgcache.cpp
+                         -------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QImage>
+#include <QtConcurrentMap>
+#include <functional>
+
+#include "qgsapplication.h"
+#include "qgssvgcache.h"
+
+class TestQgsSvgCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void hitsAndMisses();
+    void imageBudget();
+    void threadedAccess();
+
+  private:
+    QString mSvgPath;
+};
+
+void TestQgsSvgCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  mSvgPath = QStringLiteral( TEST_DATA_DIR ) + "/svg_params.svg";
+}
+
+void TestQgsSvgCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsSvgCache::hitsAndMisses()
+{
+  QgsSvgCache cache;
+  bool fitsInCache = false;
+  QImage image = cache.svgAsImage( mSvgPath, 20, Qt::red, Qt::blue, 1, 1, fitsInCache );
+  QVERIFY( fitsInCache );
+  QCOMPARE( image.width(), 20 );
+  QCOMPARE( cache.missCount(), 1 );
+  QCOMPARE( cache.hitCount(), 0 );
+  QVERIFY( cache.totalSize( QgsSvgCache::Image ) >= 20 * 20 * 4 );
+  QVERIFY( cache.totalSize( QgsSvgCache::SvgContent ) > 0 );
+
+  QImage image2 = cache.svgAsImage( mSvgPath, 20, Qt::red, Qt::blue, 1, 1, fitsInCache );
+  QCOMPARE( image2, image );
+  QCOMPARE( cache.hitCount(), 1 );
+  QCOMPARE( cache.missCount(), 1 );
+
+  // different parameters are a separate entry
+  cache.svgAsImage( mSvgPath, 20, Qt::green, Qt::blue, 1, 1, fitsInCache );
+  QCOMPARE( cache.missCount(), 2 );
+}
+
+void TestQgsSvgCache::imageBudget()
+{
+  QgsSvgCache cache;
+  // budgets are split between the cache shards, which leaves room for two
+  // 20x20 images in each shard
+  const qint64 budget = 8 * 2 * 20 * 20 * 4;
+  cache.setMaximumSize( QgsSvgCache::Image, budget );
+  QCOMPARE( cache.maximumSize( QgsSvgCache::Image ), budget );
+
+  // entries are spread over the shards by their parameters, so rendering more
+  // images than the shards can hold releases some of them
+  bool fitsInCache = false;
+  QImage image;
+  for ( int i = 0; i < 17; ++i )
+  {
+    image = cache.svgAsImage( mSvgPath, 20, QColor( 10 * i, 0, 0 ), Qt::blue, 1, 1, fitsInCache );
+    QVERIFY( fitsInCache );
+    QCOMPARE( image.width(), 20 );
+    QVERIFY( cache.totalSize( QgsSvgCache::Image ) <= budget );
+  }
+  QVERIFY( cache.evictionCount() >= 1 );
+  QCOMPARE( cache.missCount(), 17 );
+
+  // the most recently used image is kept
+  QImage image2 = cache.svgAsImage( mSvgPath, 20, QColor( 160, 0, 0 ), Qt::blue, 1, 1, fitsInCache );
+  QCOMPARE( image2, image );
+  QCOMPARE( cache.hitCount(), 1 );
+
+  // an image larger than the budget is not stored
+  QImage large = cache.svgAsImage( mSvgPath, 100, Qt::red, Qt::blue, 1, 1, fitsInCache );
+  QVERIFY( !fitsInCache );
+  QVERIFY( large.isNull() );
+}
+
+void TestQgsSvgCache::threadedAccess()
+{
+  QgsSvgCache cache;
+  QList< int > sizes;
+  for ( int i = 0; i < 200; ++i )
+    sizes << 10 + i % 10;
+
+  QString path = mSvgPath;
+  std::function< int( int ) > render = [&cache, path]( int size ) -> int
+  {
+    bool fitsInCache = false;
+    return cache.svgAsImage( path, size, Qt::red, Qt::blue, 1, 1, fitsInCache ).width();
+  };
+  QList< int > widths = QtConcurrent::blockingMapped( sizes, render );
+  QCOMPARE( widths, sizes );
+  QCOMPARE( cache.hitCount() + cache.missCount(), 200 );
+}
+
+QGSTEST_MAIN( TestQgsSvgCache )
+#include "testqgssvgcache.moc"
@@ -17,6 +17,9 @@
 #include <QString>
 #include <QStringList>
 #include <QApplication>
+#include <QTemporaryDir>
+
+#include <memory>
 
 #include "qgsvectorlayer.h" //defines QgsFieldMap
 #include "qgsvectorfilewriter.h" //logic for writing shpfiles
@@ -27,6 +30,9 @@
 #include "qgsapplication.h" //search path for srs.db
 #include "qgslogger.h"
 #include "qgsfield.h"
+#include "qgsfeatureiterator.h"
+#include "qgsvectordataprovider.h"
+#include "qgscoordinatetransform.h"
 #include "qgis.h" //defines GEOWkt
 
 #if defined(linux)
@@ -79,10 +85,15 @@ class TestQgsVectorFileWriter: public QObject
     void projectedPlygonGridTest();
     //! This is a regression test ticket 1141 (broken Polish characters support since r8592) https://issues.qgis.org/issues/1141
     void regression1141();
+    //! Tests that the threaded export pipeline writes the same features as a sequential export
+    void pipelinedExport();
+    //! Benchmarks exporting a reprojected layer
+    void benchmarkPipelinedExport();
 
   private:
     // a little util fn used by all tests
     bool cleanupFile( QString fileBase );
+    QgsVectorLayer *createPointLayer( int featureCount );
     QString mEncoding;
     QgsVectorFileWriter::WriterError mError;
     QgsCoordinateReferenceSystem mCRS;
@@ -108,6 +119,7 @@ void TestQgsVectorFileWriter::initTestCase()
           "******************\n" );
   // init QGIS's paths - true means that all path will be inited from prefix
   QgsApplication::init();
+  QgsApplication::initQgis();
   QgsApplication::showSettings();
   //create some objects that will be used in all tests...
 
@@ -460,5 +472,79 @@ void TestQgsVectorFileWriter::regression1141()
   QVERIFY( QgsVectorFileWriter::deleteShapeFile( fileName ) );
 }
 
+QgsVectorLayer *TestQgsVectorFileWriter::createPointLayer( int featureCount )
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:4326&field=id:integer&field=name:string(20)" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < featureCount; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttribute( 0, i );
+    f.setAttribute( 1, QStringLiteral( "point %1" ).arg( i ) );
+    f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( -170 + ( i % 340 ), -80 + ( i / 340 ) % 160 ) ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+void TestQgsVectorFileWriter::pipelinedExport()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createPointLayer( 5432 ) );
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "GPKG" );
+  options.ct = QgsCoordinateTransform( layer->crs(), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+
+  options.parallelProcessing = false;
+  QString sequentialFile = dir.path() + "/sequential.gpkg";
+  QCOMPARE( QgsVectorFileWriter::writeAsVectorFormat( layer.get(), sequentialFile, options ), QgsVectorFileWriter::NoError );
+
+  options.parallelProcessing = true;
+  options.transactionBatchSize = 1000;
+  QString pipelinedFile = dir.path() + "/pipelined.gpkg";
+  QCOMPARE( QgsVectorFileWriter::writeAsVectorFormat( layer.get(), pipelinedFile, options ), QgsVectorFileWriter::NoError );
+
+  QgsVectorLayer sequential( sequentialFile, QStringLiteral( "sequential" ), QStringLiteral( "ogr" ) );
+  QgsVectorLayer pipelined( pipelinedFile, QStringLiteral( "pipelined" ), QStringLiteral( "ogr" ) );
+  QVERIFY( sequential.isValid() );
+  QVERIFY( pipelined.isValid() );
+  QCOMPARE( pipelined.featureCount(), 5432L );
+  QCOMPARE( pipelined.featureCount(), sequential.featureCount() );
+
+  // features are written in their original order
+  QgsFeatureIterator sequentialIt = sequential.getFeatures();
+  QgsFeatureIterator pipelinedIt = pipelined.getFeatures();
+  QgsFeature sequentialFeature;
+  QgsFeature pipelinedFeature;
+  while ( sequentialIt.nextFeature( sequentialFeature ) )
+  {
+    QVERIFY( pipelinedIt.nextFeature( pipelinedFeature ) );
+    QCOMPARE( pipelinedFeature.attribute( QStringLiteral( "id" ) ), sequentialFeature.attribute( QStringLiteral( "id" ) ) );
+    QCOMPARE( pipelinedFeature.geometry().exportToWkt( 3 ), sequentialFeature.geometry().exportToWkt( 3 ) );
+  }
+}
+
+void TestQgsVectorFileWriter::benchmarkPipelinedExport()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createPointLayer( 100000 ) );
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "GPKG" );
+  options.ct = QgsCoordinateTransform( layer->crs(), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  options.transactionBatchSize = 10000;
+
+  int run = 0;
+  QBENCHMARK
+  {
+    QString fileName = dir.path() + QStringLiteral( "/benchmark%1.gpkg" ).arg( run++ );
+    QCOMPARE( QgsVectorFileWriter::writeAsVectorFormat( layer.get(), fileName, options ), QgsVectorFileWriter::NoError );
+  }
+}
+
 QGSTEST_MAIN( TestQgsVectorFileWriter )
 #include "testqgsvectorfilewriter.moc"
@@ -32,6 +32,8 @@
 #include <qgsproject.h>
 #include <qgssymbol.h>
 #include <qgssinglesymbolrenderer.h>
+#include <qgscategorizedsymbolrenderer.h>
+#include "qgsvectorlayerfeaturecounter.h"
 //qgis test includes
 #include "qgsrenderchecker.h"
 
@@ -105,6 +107,7 @@ class TestQgsVectorLayer : public QObject
     void maximumValue();
     void isSpatial();
     void testAddTopologicalPoints();
+    void countSymbolFeatures();
 };
 
 void TestQgsVectorLayer::initTestCase()
@@ -378,5 +381,34 @@ void TestQgsVectorLayer::testAddTopologicalPoints()
   delete layerLine;
 }
 
+void TestQgsVectorLayer::countSymbolFeatures()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=cls:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  // enough features to be counted in several batches
+  QgsFeatureList features;
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeature f( layer.fields() );
+    f.setAttribute( 0, i % 3 );
+    features << f;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsCategoryList categories;
+  categories << QgsRendererCategory( 0, QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), QStringLiteral( "zero" ) )
+             << QgsRendererCategory( 1, QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), QStringLiteral( "one" ) )
+             << QgsRendererCategory( 2, QgsSymbol::defaultSymbol( QgsWkbTypes::PointGeometry ), QStringLiteral( "two" ), false );
+  layer.setRenderer( new QgsCategorizedSymbolRenderer( QStringLiteral( "cls" ), categories ) );
+
+  QgsVectorLayerFeatureCounter counter( &layer );
+  QVERIFY( counter.run() );
+  QCOMPARE( counter.featureCount( QStringLiteral( "0" ) ), 1667L );
+  QCOMPARE( counter.featureCount( QStringLiteral( "1" ) ), 1667L );
+  // features of categories which are not rendered are not counted
+  QCOMPARE( counter.featureCount( QStringLiteral( "2" ) ), -1L );
+}
+
 QGSTEST_MAIN( TestQgsVectorLayer )
 #include "testqgsvectorlayer.moc"
@@ -25,6 +25,7 @@
 #include <qgsapplication.h>
 #include <qgsvectorlayereditbuffer.h>
 #include <qgscacheindexfeatureid.h>
+#include <qgscacheindexspatial.h>
 #include <QDebug>
 
 /** @ingroup UnitTests
@@ -56,6 +57,9 @@ class TestVectorLayerCache : public QObject
     void testFullCacheThroughRequest();
     void testCanUseCacheForRequest();
     void testCacheGeom();
+    void testMemoryLimit();
+    void testSpatialIndex();
+    void testSpatialIndexIncompleteRequest();
 
     void onCommittedFeaturesAdded( const QString &, const QgsFeatureList & );
 
@@ -393,6 +397,131 @@ void TestVectorLayerCache::testCacheGeom()
   QVERIFY( !cache.hasFullCache() );
 }
 
+void TestVectorLayerCache::testMemoryLimit()
+{
+  QgsVectorLayerCache cache( mPointsLayer, 1000 );
+  cache.setFullCache( true );
+  QVERIFY( cache.hasFullCache() );
+  qint64 fullUsage = cache.cacheMemoryUsage();
+  QVERIFY( fullUsage > 0 );
+
+  // features are restored from their compact form
+  QgsFeatureIterator it = mPointsLayer->getFeatures();
+  QgsFeature f;
+  QgsFeature cachedFeature;
+  QgsFeatureId lastId = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QVERIFY( cache.featureAtId( f.id(), cachedFeature ) );
+    QCOMPARE( cachedFeature.id(), f.id() );
+    QCOMPARE( cachedFeature.attributes(), f.attributes() );
+    QCOMPARE( cachedFeature.geometry().exportToWkt(), f.geometry().exportToWkt() );
+    lastId = f.id();
+  }
+
+  // limiting the memory removes the least recently used features
+  cache.setCacheMemoryLimit( fullUsage / 2 );
+  QCOMPARE( cache.cacheMemoryLimit(), fullUsage / 2 );
+  QVERIFY( cache.cacheMemoryUsage() <= fullUsage / 2 );
+  QVERIFY( cache.cachedFeatureIds().count() < mPointsLayer->featureCount() );
+  QVERIFY( !cache.hasFullCache() );
+  QVERIFY( cache.isFidCached( lastId ) );
+
+  // changes to cached features are accounted for
+  cache.setCacheMemoryLimit( 0 );
+  qint64 usage = cache.cacheMemoryUsage();
+  mPointsLayer->startEditing();
+  QVERIFY( mPointsLayer->changeAttributeValue( lastId, 0, QStringLiteral( "a much longer class name than before" ) ) );
+  QVERIFY( cache.cacheMemoryUsage() > usage );
+  QVERIFY( cache.featureAtId( lastId, cachedFeature ) );
+  QCOMPARE( cachedFeature.attribute( 0 ).toString(), QStringLiteral( "a much longer class name than before" ) );
+  mPointsLayer->rollBack();
+}
+
+void TestVectorLayerCache::testSpatialIndex()
+{
+  QgsVectorLayerCache cache( mPointsLayer, 1000 );
+  cache.addCacheIndex( new QgsCacheIndexSpatial( &cache ) );
+
+  QgsRectangle extent = mPointsLayer->extent();
+  QgsRectangle rect( extent.xMinimum(), extent.yMinimum(), extent.center().x(), extent.center().y() );
+  QgsFeatureIterator it;
+  QVERIFY( !cache.canUseCacheForRequest( QgsFeatureRequest().setFilterRect( rect ), it ) );
+
+  // fetch the features of a rectangle through the cache
+  QgsFeature f;
+  QgsFeatureIds rectIds;
+  it = cache.getFeatures( QgsFeatureRequest().setFilterRect( rect ) );
+  while ( it.nextFeature( f ) )
+    rectIds << f.id();
+  QVERIFY( !rectIds.isEmpty() );
+  QVERIFY( !cache.hasFullCache() );
+
+  // requests within the rectangle are answered by the index
+  QgsRectangle inner( rect );
+  inner.scale( 0.5 );
+  QVERIFY( cache.canUseCacheForRequest( QgsFeatureRequest().setFilterRect( inner ), it ) );
+  QgsFeatureIds cachedIds;
+  while ( it.nextFeature( f ) )
+    cachedIds << f.id();
+  QgsFeatureIds layerIds;
+  it = mPointsLayer->getFeatures( QgsFeatureRequest().setFilterRect( inner ) );
+  while ( it.nextFeature( f ) )
+    layerIds << f.id();
+  QCOMPARE( cachedIds, layerIds );
+
+  // but not the ones outside of it
+  QVERIFY( !cache.canUseCacheForRequest( QgsFeatureRequest().setFilterRect( extent ), it ) );
+
+  // removing a feature from the cache invalidates the rectangle
+  QVERIFY( cache.removeCachedFeature( *rectIds.constBegin() ) );
+  QVERIFY( !cache.canUseCacheForRequest( QgsFeatureRequest().setFilterRect( rect ), it ) );
+}
+
+void TestVectorLayerCache::testSpatialIndexIncompleteRequest()
+{
+  QgsVectorLayerCache cache( mPointsLayer, 1000 );
+  cache.addCacheIndex( new QgsCacheIndexSpatial( &cache ) );
+
+  QgsRectangle extent = mPointsLayer->extent();
+  QgsFeature f;
+  QgsFeatureIds layerIds;
+  QgsFeatureIterator it = mPointsLayer->getFeatures( QgsFeatureRequest().setFilterRect( extent ) );
+  while ( it.nextFeature( f ) )
+    layerIds << f.id();
+  QVERIFY( layerIds.count() > 1 );
+
+  // a limited request does not cover its rectangle
+  int count = 0;
+  it = cache.getFeatures( QgsFeatureRequest().setFilterRect( extent ).setLimit( 1 ) );
+  while ( it.nextFeature( f ) )
+    count++;
+  QCOMPARE( count, 1 );
+  QVERIFY( !cache.canUseCacheForRequest( QgsFeatureRequest().setFilterRect( extent ), it ) );
+
+  // neither does an exact intersection test
+  QgsFeatureIds exactIds;
+  it = cache.getFeatures( QgsFeatureRequest().setFilterRect( extent ).setFlags( QgsFeatureRequest::ExactIntersect ) );
+  while ( it.nextFeature( f ) )
+    exactIds << f.id();
+  QVERIFY( exactIds.count() <= layerIds.count() );
+  QVERIFY( !cache.canUseCacheForRequest( QgsFeatureRequest().setFilterRect( extent ), it ) );
+
+  // so the full request for the same rectangle returns all the features
+  QgsFeatureIds cachedIds;
+  it = cache.getFeatures( QgsFeatureRequest().setFilterRect( extent ) );
+  while ( it.nextFeature( f ) )
+    cachedIds << f.id();
+  QCOMPARE( cachedIds, layerIds );
+
+  // and is then answered by the index
+  QVERIFY( cache.canUseCacheForRequest( QgsFeatureRequest().setFilterRect( extent ), it ) );
+  cachedIds.clear();
+  while ( it.nextFeature( f ) )
+    cachedIds << f.id();
+  QCOMPARE( cachedIds, layerIds );
+}
+
 void TestVectorLayerCache::onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &features )
 {
   Q_UNUSED( layerId )
@@ -64,6 +64,8 @@ class TestVectorLayerJoinBuffer : public QObject
     void testCacheUpdate();
     void testRemoveJoinOnLayerDelete();
     void testResolveReferences();
+    void testJoinBatch_data();
+    void testJoinBatch();
 
   private:
     QgsProject mProject;
@@ -664,6 +666,108 @@ void TestVectorLayerJoinBuffer::testResolveReferences()
   delete vlA;
 }
 
+void TestVectorLayerJoinBuffer::testJoinBatch_data()
+{
+  QTest::addColumn<QString>( "targetField" );
+  QTest::addColumn<QString>( "joinField" );
+
+  QTest::newRow( "integer keys" ) << "id_t" << "id_j";
+  QTest::newRow( "string keys" ) << "code_t" << "code_j";
+  QTest::newRow( "mixed keys" ) << "id_t" << "code_j";
+}
+
+void TestVectorLayerJoinBuffer::testJoinBatch()
+{
+  QFETCH( QString, targetField );
+  QFETCH( QString, joinField );
+
+  // more target features than fit in a single batch, and only some of them have a joined feature
+  std::unique_ptr< QgsVectorLayer > vlT( new QgsVectorLayer( QStringLiteral( "None?field=id_t:integer&field=code_t:string" ), QStringLiteral( "T" ), QStringLiteral( "memory" ) ) );
+  std::unique_ptr< QgsVectorLayer > vlJ( new QgsVectorLayer( QStringLiteral( "None?field=id_j:integer&field=code_j:string&field=value_j:integer" ), QStringLiteral( "J" ), QStringLiteral( "memory" ) ) );
+  QVERIFY( vlT->isValid() );
+  QVERIFY( vlJ->isValid() );
+
+  QgsFeatureList targetFeatures;
+  for ( int i = 0; i < 700; ++i )
+  {
+    QgsFeature f( vlT->fields() );
+    if ( i % 50 == 0 )
+      f.setAttributes( QgsAttributes() << QVariant() << QVariant() );
+    else
+      f.setAttributes( QgsAttributes() << i % 400 << QString::number( i % 400 ) );
+    targetFeatures << f;
+  }
+  QVERIFY( vlT->dataProvider()->addFeatures( targetFeatures ) );
+
+  QgsFeatureList joinFeatures;
+  for ( int i = 0; i < 400; i += 3 )
+  {
+    QgsFeature f( vlJ->fields() );
+    f.setAttributes( QgsAttributes() << i << QString::number( i ) << i * 10 );
+    joinFeatures << f;
+  }
+  QVERIFY( vlJ->dataProvider()->addFeatures( joinFeatures ) );
+
+  QgsVectorLayerJoinInfo joinInfo;
+  joinInfo.setTargetFieldName( targetField );
+  joinInfo.setJoinLayer( vlJ.get() );
+  joinInfo.setJoinFieldName( joinField );
+  joinInfo.setPrefix( QStringLiteral( "J_" ) );
+
+  auto joinedValues = [&vlT]( const QgsFeatureRequest & request )
+  {
+    QMap< QgsFeatureId, QVariant > values;
+    QgsFeatureIterator fi = vlT->getFeatures( request );
+    QgsFeature f;
+    while ( fi.nextFeature( f ) )
+      values.insert( f.id(), f.attribute( QStringLiteral( "J_value_j" ) ) );
+    return values;
+  };
+
+  joinInfo.setUsingMemoryCache( true );
+  vlT->addJoin( joinInfo );
+  QVERIFY( vlT->joinBuffer()->memoryCacheSize() > 0 );
+  QMap< QgsFeatureId, QVariant > cached = joinedValues( QgsFeatureRequest() );
+  vlT->removeJoin( vlJ->id() );
+
+  joinInfo.setUsingMemoryCache( false );
+  vlT->addJoin( joinInfo );
+  QCOMPARE( vlT->joinBuffer()->memoryCacheSize(), 0LL );
+  QMap< QgsFeatureId, QVariant > batched = joinedValues( QgsFeatureRequest() );
+
+  QCOMPARE( batched.count(), 700 );
+  QCOMPARE( batched, cached );
+
+  int matched = 0;
+  for ( const QVariant &value : qgsAsConst( batched ) )
+  {
+    if ( !value.isNull() )
+      matched++;
+  }
+  QVERIFY( matched > 0 );
+  QVERIFY( matched < 700 );
+
+  // a subset of attributes which only contains the joined field
+  int joinedIndex = vlT->fields().lookupField( QStringLiteral( "J_value_j" ) );
+  QCOMPARE( joinedValues( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() << joinedIndex ) ), cached );
+
+  // rewinding discards the features read ahead
+  QgsFeatureIterator fi = vlT->getFeatures();
+  QgsFeature f;
+  for ( int i = 0; i < 10; ++i )
+    QVERIFY( fi.nextFeature( f ) );
+  QVERIFY( fi.rewind() );
+  int count = 0;
+  while ( fi.nextFeature( f ) )
+  {
+    QCOMPARE( f.attribute( QStringLiteral( "J_value_j" ) ), cached.value( f.id() ) );
+    count++;
+  }
+  QCOMPARE( count, 700 );
+
+  vlT->removeJoin( vlJ->id() );
+}
+
 
 QGSTEST_MAIN( TestVectorLayerJoinBuffer )
 #include "testqgsvectorlayerjoinbuffer.moc"
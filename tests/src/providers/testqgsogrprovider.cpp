@@ -0,0 +1,246 @@
+/***************************************************************************
+                         testqgsogrprovider.cpp
+                         ----------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+
+//qgis includes...
+#include <qgsapplication.h>
+#include <qgscoordinatereferencesystem.h>
+#include <qgsdatasourcemetadatacache.h>
+#include <qgsfeatureiterator.h>
+#include <qgsgeometry.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorfilewriter.h>
+#include <qgsvectorlayer.h>
+
+/** \ingroup UnitTests
+ * This is a unit test for the ogr provider
+ */
+class TestQgsOgrProvider : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {}// will be called before each testfunction is executed.
+    void cleanup() {}// will be called after every testfunction.
+
+    void subsetOfAttributes();
+    void rewind();
+    void metadataCache();
+    void benchmarkRead();
+    void benchmarkReadSubsetOfAttributes();
+    void benchmarkReadLarge();
+    void benchmarkReadLargeSubsetOfAttributes();
+    void benchmarkReadLargeFirstFeatures();
+
+  private:
+    QgsVectorLayer *mPointsLayer = nullptr;
+
+    //! Generated layer large enough to measure the throughput of batched reads
+    QgsVectorLayer *mLargeLayer = nullptr;
+    QTemporaryDir mLargeLayerDir;
+};
+
+//! Number of features of the generated layer used by the throughput benchmarks
+static const int LARGE_LAYER_FEATURE_COUNT = 50000;
+
+//runs before all tests
+void TestQgsOgrProvider::initTestCase()
+{
+  // init QGIS's paths - true means that all path will be inited from prefix
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  QString points = QStringLiteral( TEST_DATA_DIR ) + "/points.shp";
+  mPointsLayer = new QgsVectorLayer( points, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  QVERIFY( mPointsLayer->isValid() );
+
+  QVERIFY( mLargeLayerDir.isValid() );
+  QString largePath = mLargeLayerDir.path() + "/large.gpkg";
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "id" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "value" ), QVariant::Double ) );
+  {
+    QgsVectorFileWriter writer( largePath, QStringLiteral( "UTF-8" ), fields, QgsWkbTypes::Point,
+                                QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QStringLiteral( "GPKG" ) );
+    QCOMPARE( writer.hasError(), QgsVectorFileWriter::NoError );
+    for ( int i = 0; i < LARGE_LAYER_FEATURE_COUNT; ++i )
+    {
+      QgsFeature f( fields );
+      f.setAttributes( QgsAttributes() << i << QStringLiteral( "feature %1" ).arg( i ) << i * 0.5 );
+      f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( ( i % 360 ) - 180.0, ( i % 180 ) - 90.0 ) ) );
+      QVERIFY( writer.addFeature( f ) );
+    }
+  }
+  mLargeLayer = new QgsVectorLayer( largePath, QStringLiteral( "large" ), QStringLiteral( "ogr" ) );
+  QVERIFY( mLargeLayer->isValid() );
+}
+
+//runs after all tests
+void TestQgsOgrProvider::cleanupTestCase()
+{
+  delete mPointsLayer;
+  delete mLargeLayer;
+  QgsApplication::exitQgis();
+}
+
+void TestQgsOgrProvider::subsetOfAttributes()
+{
+  QMap< QgsFeatureId, QgsAttributes > allAttributes;
+  QgsFeature f;
+  QgsFeatureIterator it = mPointsLayer->getFeatures();
+  while ( it.nextFeature( f ) )
+    allAttributes.insert( f.id(), f.attributes() );
+  QCOMPARE( allAttributes.count(), static_cast< int >( mPointsLayer->featureCount() ) );
+
+  // only the requested attributes are read, in their original positions
+  it = mPointsLayer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() << 3 << 1 ).setFlags( QgsFeatureRequest::NoGeometry ) );
+  int count = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QVERIFY( allAttributes.contains( f.id() ) );
+    QCOMPARE( f.attributes().count(), mPointsLayer->fields().count() );
+    QCOMPARE( f.attribute( 1 ), allAttributes.value( f.id() ).at( 1 ) );
+    QCOMPARE( f.attribute( 3 ), allAttributes.value( f.id() ).at( 3 ) );
+    QVERIFY( !f.attribute( 0 ).isValid() );
+    QVERIFY( !f.hasGeometry() );
+    count++;
+  }
+  QCOMPARE( count, allAttributes.count() );
+}
+
+void TestQgsOgrProvider::rewind()
+{
+  QgsFeatureIterator it = mPointsLayer->getFeatures();
+  QgsFeature f;
+  QgsFeatureIds firstPass;
+  for ( int i = 0; i < 5 && it.nextFeature( f ); ++i )
+    firstPass << f.id();
+
+  // rewinding in the middle of a batch restarts from the first feature
+  QVERIFY( it.rewind() );
+  QgsFeatureIds secondPass;
+  while ( it.nextFeature( f ) )
+    secondPass << f.id();
+
+  QCOMPARE( secondPass.count(), static_cast< int >( mPointsLayer->featureCount() ) );
+  QVERIFY( secondPass.contains( firstPass ) );
+}
+
+void TestQgsOgrProvider::metadataCache()
+{
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+  Q_FOREACH ( const QString &ext, QStringList() << "shp" << "shx" << "dbf" << "prj" )
+    QVERIFY( QFile::copy( QStringLiteral( TEST_DATA_DIR ) + "/points." + ext, dir.path() + "/points." + ext ) );
+  QString points = dir.path() + "/points.shp";
+
+  QgsDataSourceMetadataCache *cache = QgsApplication::dataSourceMetadataCache();
+  cache->clear();
+
+  QgsVectorLayer layer( points, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  QVERIFY( layer.isValid() );
+  long count = layer.featureCount();
+  QCOMPARE( count, mPointsLayer->featureCount() );
+  QgsRectangle extent = layer.extent();
+  QCOMPARE( cache->count(), 1 );
+
+  // a second layer on the same unchanged file reuses the metadata
+  QgsVectorLayer sameLayer( points, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  QCOMPARE( sameLayer.featureCount(), count );
+  QCOMPARE( sameLayer.extent(), extent );
+
+  // changing the file makes the metadata stale
+  QgsFeature f( layer.fields() );
+  f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( extent.xMaximum() + 100, extent.yMaximum() + 100 ) ) );
+  QVERIFY( layer.dataProvider()->addFeature( f ) );
+
+  QgsVectorLayer changedLayer( points, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  QCOMPARE( changedLayer.featureCount(), count + 1 );
+  QCOMPARE( changedLayer.extent().xMaximum(), extent.xMaximum() + 100 );
+}
+
+void TestQgsOgrProvider::benchmarkRead()
+{
+  QBENCHMARK
+  {
+    QgsFeature f;
+    QgsFeatureIterator it = mPointsLayer->getFeatures();
+    while ( it.nextFeature( f ) )
+      ;
+  }
+}
+
+void TestQgsOgrProvider::benchmarkReadSubsetOfAttributes()
+{
+  QBENCHMARK
+  {
+    QgsFeature f;
+    QgsFeatureIterator it = mPointsLayer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() << 1 ).setFlags( QgsFeatureRequest::NoGeometry ) );
+    while ( it.nextFeature( f ) )
+      ;
+  }
+}
+
+void TestQgsOgrProvider::benchmarkReadLarge()
+{
+  QBENCHMARK
+  {
+    QgsFeature f;
+    QgsFeatureIterator it = mLargeLayer->getFeatures();
+    int count = 0;
+    while ( it.nextFeature( f ) )
+      count++;
+    QCOMPARE( count, LARGE_LAYER_FEATURE_COUNT );
+  }
+}
+
+void TestQgsOgrProvider::benchmarkReadLargeSubsetOfAttributes()
+{
+  QBENCHMARK
+  {
+    QgsFeature f;
+    QgsFeatureIterator it = mLargeLayer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() << 2 ).setFlags( QgsFeatureRequest::NoGeometry ) );
+    int count = 0;
+    while ( it.nextFeature( f ) )
+      count++;
+    QCOMPARE( count, LARGE_LAYER_FEATURE_COUNT );
+  }
+}
+
+void TestQgsOgrProvider::benchmarkReadLargeFirstFeatures()
+{
+  // batches start small, so requests for a few features stay cheap
+  QBENCHMARK
+  {
+    QgsFeature f;
+    QgsFeatureIterator it = mLargeLayer->getFeatures( QgsFeatureRequest().setLimit( 3 ) );
+    int count = 0;
+    while ( it.nextFeature( f ) )
+      count++;
+    QCOMPARE( count, 3 );
+  }
+}
+
+QGSTEST_MAIN( TestQgsOgrProvider )
+#include "testqgsogrprovider.moc"
@@ -16,7 +16,7 @@ import qgis  # NOQA
 
 import os
 
-from qgis.core import QgsSettings, QgsVectorLayer, QgsFeatureRequest
+from qgis.core import QgsSettings, QgsVectorLayer, QgsFeatureRequest, QgsAggregateCalculator
 
 from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant
 
@@ -57,6 +57,51 @@ class TestPyQgsMssqlProvider(unittest.TestCase, ProviderTestCase):
         QgsSettings().setValue('/qgis/compileExpressions', False)
 
     # HERE GO THE PROVIDER SPECIFIC TESTS
+    def testAggregate(self):
+        aggregates = [[QgsAggregateCalculator.Count, 5],
+                      [QgsAggregateCalculator.CountDistinct, 5],
+                      [QgsAggregateCalculator.CountMissing, 0],
+                      [QgsAggregateCalculator.Min, -200],
+                      [QgsAggregateCalculator.Max, 400],
+                      [QgsAggregateCalculator.Sum, 800],
+                      [QgsAggregateCalculator.Mean, 160],
+                      [QgsAggregateCalculator.Range, 600],
+                      [QgsAggregateCalculator.StDev, 205.9126],
+                      [QgsAggregateCalculator.StDevSample, 230.2173]]
+        params = QgsAggregateCalculator.AggregateParameters()
+        for a in aggregates:
+            # calculated by the provider
+            val, ok = self.source.aggregate(a[0], 1, params, None)
+            self.assertTrue(ok)
+            self.assertAlmostEqual(val, a[1], 3)
+
+            # same result when calculated by QGIS
+            self.disableCompiler()
+            val, ok = self.vl.aggregate(a[0], 'cnt', params)
+            self.enableCompiler()
+            self.assertTrue(ok)
+            self.assertAlmostEqual(val, a[1], 3)
+
+        # filters are compiled into the query
+        params.filter = '"cnt" > 100'
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Sum, 1, params, None)
+        self.assertTrue(ok)
+        self.assertEqual(val, 900)
+        params.filter = '"cnt" > 1000'
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Sum, 1, params, None)
+        self.assertTrue(ok)
+        self.assertEqual(val, 0)
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Max, 1, params, None)
+        self.assertTrue(ok)
+        self.assertFalse(val)
+
+        # not handled by the provider
+        params.filter = ''
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Median, 1, params, None)
+        self.assertFalse(ok)
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Max, 2, params, None)
+        self.assertFalse(ok)
+
     def testDateTimeTypes(self):
         vl = QgsVectorLayer('%s table="qgis_test"."date_times" sql=' %
                             (self.dbconn), "testdatetimes", "mssql")
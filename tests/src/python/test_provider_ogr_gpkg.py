@@ -19,7 +19,7 @@ import tempfile
 import shutil
 from osgeo import gdal, ogr
 
-from qgis.core import QgsVectorLayer, QgsVectorLayerExporter, QgsFeature, QgsGeometry, QgsRectangle, QgsSettings
+from qgis.core import QgsVectorLayer, QgsVectorLayerExporter, QgsFeature, QgsGeometry, QgsRectangle, QgsSettings, QgsAggregateCalculator
 from qgis.PyQt.QtCore import QCoreApplication
 from qgis.testing import start_app, unittest
 
@@ -224,6 +224,82 @@ class TestPyQgsOGRProviderGpkg(unittest.TestCase):
         got = [feat for feat in vl.getFeatures()]
         self.assertEqual(len(got), 1)
 
+    def testAggregate(self):
+
+        tmpfile = os.path.join(self.basetestpath, 'testAggregate.gpkg')
+        ds = ogr.GetDriverByName('GPKG').CreateDataSource(tmpfile)
+        lyr = ds.CreateLayer('test', geom_type=ogr.wkbPoint)
+        lyr.CreateField(ogr.FieldDefn('cnt', ogr.OFTInteger))
+        lyr.CreateField(ogr.FieldDefn('name', ogr.OFTString))
+        for cnt in [-200, 300, 100, 200, 400, None]:
+            f = ogr.Feature(lyr.GetLayerDefn())
+            if cnt is not None:
+                f['cnt'] = cnt
+            f['name'] = 'name'
+            lyr.CreateFeature(f)
+            f = None
+        ds = None
+
+        vl = QgsVectorLayer('{}|layerid=0'.format(tmpfile), 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+        provider = vl.dataProvider()
+        cnt_idx = vl.fields().lookupField('cnt')
+        name_idx = vl.fields().lookupField('name')
+
+        aggregates = [[QgsAggregateCalculator.Count, 5],
+                      [QgsAggregateCalculator.CountDistinct, 5],
+                      [QgsAggregateCalculator.CountMissing, 1],
+                      [QgsAggregateCalculator.Min, -200],
+                      [QgsAggregateCalculator.Max, 400],
+                      [QgsAggregateCalculator.Sum, 800],
+                      [QgsAggregateCalculator.Mean, 160],
+                      [QgsAggregateCalculator.Range, 600]]
+        params = QgsAggregateCalculator.AggregateParameters()
+        for a in aggregates:
+            # calculated by the provider
+            val, ok = provider.aggregate(a[0], cnt_idx, params, None)
+            self.assertTrue(ok)
+            self.assertAlmostEqual(val, a[1], 3)
+
+            # same result when calculated by QGIS
+            QgsSettings().setValue('/qgis/compileExpressions', False)
+            val, ok = vl.aggregate(a[0], 'cnt', params)
+            QgsSettings().setValue('/qgis/compileExpressions', True)
+            self.assertTrue(ok)
+            self.assertAlmostEqual(val, a[1], 3)
+
+        # filters are compiled into the query
+        params.filter = '"cnt" > 100'
+        val, ok = provider.aggregate(QgsAggregateCalculator.Sum, cnt_idx, params, None)
+        self.assertTrue(ok)
+        self.assertEqual(val, 900)
+        params.filter = '"cnt" > 1000'
+        val, ok = provider.aggregate(QgsAggregateCalculator.Sum, cnt_idx, params, None)
+        self.assertTrue(ok)
+        self.assertEqual(val, 0)
+        val, ok = provider.aggregate(QgsAggregateCalculator.Max, cnt_idx, params, None)
+        self.assertTrue(ok)
+        self.assertFalse(val)
+
+        # subset strings are combined with the filter
+        vl.setSubsetString('"cnt" < 300')
+        params.filter = '"cnt" > 0'
+        val, ok = provider.aggregate(QgsAggregateCalculator.Sum, cnt_idx, params, None)
+        self.assertTrue(ok)
+        self.assertEqual(val, 300)
+
+        # not handled by the provider
+        params.filter = ''
+        val, ok = provider.aggregate(QgsAggregateCalculator.Median, cnt_idx, params, None)
+        self.assertFalse(ok)
+        val, ok = provider.aggregate(QgsAggregateCalculator.StDev, cnt_idx, params, None)
+        self.assertFalse(ok)
+        val, ok = provider.aggregate(QgsAggregateCalculator.Max, name_idx, params, None)
+        self.assertFalse(ok)
+        vl.setSubsetString('SELECT fid, cnt FROM test WHERE cnt > 0')
+        val, ok = provider.aggregate(QgsAggregateCalculator.Sum, cnt_idx, params, None)
+        self.assertFalse(ok)
+
     def testStyle(self):
 
         # First test with invalid URI
@@ -24,16 +24,26 @@ from qgis.core import (
     QgsFeatureRequest,
     QgsFeature,
     QgsFieldConstraints,
+    QgsGeometry,
+    QgsPointXY,
     QgsDataProvider,
     NULL,
     QgsVectorLayerUtils,
     QgsSettings,
+    QgsAggregateCalculator,
     QgsTransactionGroup,
     QgsReadWriteContext,
-    QgsRectangle
+    QgsRectangle,
+    QgsProject,
+    QgsVectorLayerFeatureCounter,
+    QgsCategorizedSymbolRenderer,
+    QgsRendererCategory,
+    QgsSymbol,
+    QgsWkbTypes,
+    QgsFeatureSink
 )
 from qgis.gui import QgsGui
-from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant, QDir
+from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant, QDir, QTemporaryDir, QThread
 from qgis.testing import start_app, unittest
 from qgis.PyQt.QtXml import QDomDocument
 from utilities import unitTestDataPath
@@ -117,6 +127,50 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         self.assertFalse(self.source.defaultValueClause(1))
         self.assertEqual(self.source.defaultValueClause(2), '\'qgis\'::text')
 
+    def testAggregate(self):
+        aggregates = [[QgsAggregateCalculator.Count, 5],
+                      [QgsAggregateCalculator.CountDistinct, 5],
+                      [QgsAggregateCalculator.CountMissing, 0],
+                      [QgsAggregateCalculator.Min, -200],
+                      [QgsAggregateCalculator.Max, 400],
+                      [QgsAggregateCalculator.Sum, 800],
+                      [QgsAggregateCalculator.Mean, 160],
+                      [QgsAggregateCalculator.Range, 600],
+                      [QgsAggregateCalculator.StDev, 205.9126]]
+        params = QgsAggregateCalculator.AggregateParameters()
+        for a in aggregates:
+            # calculated by the provider
+            val, ok = self.source.aggregate(a[0], 1, params, None)
+            self.assertTrue(ok)
+            self.assertAlmostEqual(val, a[1], 3)
+
+            # same result when calculated by QGIS
+            self.disableCompiler()
+            val, ok = self.vl.aggregate(a[0], 'cnt', params)
+            self.enableCompiler()
+            self.assertTrue(ok)
+            self.assertAlmostEqual(val, a[1], 3)
+
+        # filters are compiled into the query
+        params.filter = '"cnt" > 100'
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Sum, 1, params, None)
+        self.assertTrue(ok)
+        self.assertEqual(val, 900)
+        params.filter = '"cnt" > 1000'
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Sum, 1, params, None)
+        self.assertTrue(ok)
+        self.assertEqual(val, 0)
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Max, 1, params, None)
+        self.assertTrue(ok)
+        self.assertFalse(val)
+
+        # not handled by the provider
+        params.filter = ''
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Median, 1, params, None)
+        self.assertFalse(ok)
+        val, ok = self.source.aggregate(QgsAggregateCalculator.Max, 2, params, None)
+        self.assertFalse(ok)
+
     def testDateTimeTypes(self):
         vl = QgsVectorLayer('%s table="qgis_test"."date_times" sql=' % (self.dbconn), "testdatetimes", "postgres")
         self.assertTrue(vl.isValid())
@@ -153,6 +207,32 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         }
         self.assertEqual(values, expected)
 
+    def testBinaryTypes(self):
+        vl = QgsVectorLayer('{} table="qgis_test"."binary_types" sql='.format(self.dbconn), "testbinary", "postgres")
+        self.assertTrue(vl.isValid())
+
+        features = {f['id']: f for f in vl.getFeatures()}
+
+        f = features[1]
+        self.assertEqual(f['int2_field'], -5)
+        self.assertEqual(f['int8_field'], 9007199254740993)
+        self.assertEqual(f['float4_field'], 1.5)
+        self.assertEqual(f['numeric_field'], 12345.6789)
+        self.assertEqual(f['date_field'], QDate(1999, 12, 31))
+        self.assertEqual(f['datetime_field'], QDateTime(QDate(1969, 7, 20), QTime(20, 17, 40, 123)))
+        self.assertEqual(f['uuid_field'], 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11')
+        # a NULL element is a null QString, which PyQt returns as an empty string
+        self.assertEqual(f['text_array_field'], ['a', '', 'b,c'])
+
+        f = features[2]
+        for field in ['int2_field', 'int8_field', 'float4_field', 'numeric_field', 'date_field', 'datetime_field', 'uuid_field', 'text_array_field']:
+            self.assertEqual(f[field], NULL, field)
+
+        # float4 values come back in their shortest form, without binary noise
+        f = features[3]
+        self.assertEqual(f['float4_field'], 0.1)
+        self.assertEqual(f['text_array_field'], [''])
+
     def testQueryLayers(self):
         def test_query(dbconn, query, key):
             ql = QgsVectorLayer('%s srid=4326 table="%s" (geom) key=\'%s\' sql=' % (dbconn, query.replace('"', '\\"'), key), "testgeom", "postgres")
@@ -658,6 +738,73 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         testKey(lyr, '"f1","F2","f3"', ['f1', 'F2', 'f3'])
         testKey(lyr, None, ['id'])
 
+    def testBulkImport(self):
+        """Test exporting with COPY, which is used for features added with FastInsert"""
+        lyr = QgsVectorLayer('Point?crs=epsg:4326&field=f1:int&field=f2:string(20)&field=f3:double', 'x', 'memory')
+        self.assertTrue(lyr.isValid())
+        features = []
+        for i in range(2500):
+            f = QgsFeature(lyr.fields())
+            f.setAttributes([i, 'a\tb\nc\\d{}'.format(i), None if i % 2 else i / 4.0])
+            if i % 10:
+                f.setGeometry(QgsGeometry.fromPoint(QgsPointXY(i, -i)))
+            features.append(f)
+        lyr.dataProvider().addFeatures(features)
+
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.bulk_import')
+        uri = '%s table="qgis_test"."bulk_import" (g)' % self.dbconn
+        err = QgsVectorLayerExporter.exportLayer(lyr, uri, "postgres", lyr.crs())
+        self.assertEqual(err[0], QgsVectorLayerExporter.NoError,
+                         'unexpected import error {0}'.format(err))
+
+        olyr = QgsVectorLayer(uri, "y", "postgres")
+        self.assertTrue(olyr.isValid())
+        self.assertEqual(olyr.featureCount(), 2500)
+        self.assertEqual(olyr.crs().authid(), 'EPSG:4326')
+        # the key created by the exporter is filled by its default value
+        self.assertEqual(len(set(f['id'] for f in olyr.getFeatures())), 2500)
+
+        f = next(olyr.getFeatures(QgsFeatureRequest().setFilterExpression('f1=11')))
+        self.assertEqual(f['f2'], 'a\tb\nc\\d11')
+        self.assertEqual(f['f3'], NULL)
+        self.assertEqual(f.geometry().asWkt(), 'Point (11 -11)')
+        f = next(olyr.getFeatures(QgsFeatureRequest().setFilterExpression('f1=10')))
+        self.assertEqual(f['f3'], 2.5)
+        self.assertFalse(f.hasGeometry())
+
+        # the spatial index is built after loading
+        cur = self.con.cursor()
+        cur.execute("SELECT count(*) FROM pg_indexes WHERE schemaname='qgis_test' AND tablename='bulk_import' AND indexdef ILIKE '%gist%'")
+        self.assertEqual(cur.fetchone()[0], 1)
+        cur.close()
+
+    def testBulkImportNullDefault(self):
+        """Test that COPY stores NULL in a nullable column with a default"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.bulk_import_default')
+        self.execSQLCommand('CREATE TABLE qgis_test.bulk_import_default (id serial PRIMARY KEY, f1 int, f2 int DEFAULT 5)')
+        vl = QgsVectorLayer('%s table="qgis_test"."bulk_import_default" sql=' % self.dbconn, "x", "postgres")
+        self.assertTrue(vl.isValid())
+        self.assertEqual(vl.dataProvider().defaultValueClause(2), '5')
+
+        def add(values):
+            features = []
+            for f1, f2 in values:
+                f = QgsFeature(vl.fields())
+                f.setAttributes([None, f1, f2])
+                features.append(f)
+            self.assertTrue(vl.dataProvider().addFeatures(features, QgsFeatureSink.FastInsert)[0])
+
+        # NULL values are stored as NULL rather than replaced by the default...
+        add([(1, None), (2, None)])
+        # ... also when mixed with values
+        add([(3, None), (4, 7)])
+        # the default clause itself still uses the default
+        add([(5, '5'), (6, '5')])
+
+        values = {f['f1']: f['f2'] for f in vl.getFeatures()}
+        self.assertEqual(values, {1: NULL, 2: NULL, 3: NULL, 4: 7, 5: 5, 6: 5})
+        self.assertEqual(len(set(f['id'] for f in vl.getFeatures())), 6)
+
     def testStyle(self):
         self.execSQLCommand('DROP TABLE IF EXISTS layer_styles CASCADE')
 
@@ -809,6 +956,132 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
 
         self.assertEqual(vl2.extent(), originalExtent)
 
+    def testUniqueValueCounts(self):
+        """Test counting categorized features with a GROUP BY query"""
+        vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POINT table="qgis_test"."someData" (geom) sql=', 'test', 'postgres')
+        self.assertTrue(vl.isValid())
+
+        categories = [QgsRendererCategory('Apple', QgsSymbol.defaultSymbol(QgsWkbTypes.PointGeometry), 'apple'),
+                      QgsRendererCategory('Pear', QgsSymbol.defaultSymbol(QgsWkbTypes.PointGeometry), 'pear'),
+                      QgsRendererCategory(NULL, QgsSymbol.defaultSymbol(QgsWkbTypes.PointGeometry), 'null'),
+                      QgsRendererCategory('Orange', QgsSymbol.defaultSymbol(QgsWkbTypes.PointGeometry), 'orange', False)]
+        vl.setRenderer(QgsCategorizedSymbolRenderer('name', categories))
+
+        counter = QgsVectorLayerFeatureCounter(vl)
+        self.assertTrue(counter.run())
+        self.assertEqual(counter.featureCount('0'), 1)
+        self.assertEqual(counter.featureCount('1'), 1)
+        self.assertEqual(counter.featureCount('2'), 1)
+        # features of categories which are not rendered are not counted
+        self.assertEqual(counter.featureCount('3'), -1)
+
+        # the subset string is part of the query
+        vl.setSubsetString('pk > 2')
+        counter = QgsVectorLayerFeatureCounter(vl)
+        self.assertTrue(counter.run())
+        self.assertEqual(counter.featureCount('0'), 0)
+        self.assertEqual(counter.featureCount('1'), 1)
+        self.assertEqual(counter.featureCount('2'), 1)
+
+        # the counts are queried by the task through its own feature source, not the layer's provider
+        vl.setSubsetString('')
+        counter = QgsVectorLayerFeatureCounter(vl)
+        vl.setDataSource(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POINT table="qgis_test"."someData" (geom) sql=pk = 1', 'test', 'postgres')
+        self.assertTrue(counter.run())
+        self.assertEqual(counter.featureCount('0'), 1)
+        self.assertEqual(counter.featureCount('1'), 1)
+
+    def testParallelLayerLoading(self):
+        """Test reading a project with PostgreSQL layers when parallel layer loading is enabled"""
+        tmpdir = QTemporaryDir()
+        project_path = os.path.join(tmpdir.path(), 'pg_layers.qgs')
+
+        p = QgsProject()
+        for i in range(5):
+            vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POINT table="qgis_test"."someData" (geom) sql=', 'points{}'.format(i), 'postgres')
+            self.assertTrue(vl.isValid())
+            p.addMapLayer(vl)
+        vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POLYGON table="qgis_test"."some_poly_data" (geom) sql=', 'polys', 'postgres')
+        self.assertTrue(vl.isValid())
+        p.addMapLayer(vl)
+        self.assertTrue(p.write(project_path))
+
+        settings = QgsSettings()
+        previous = settings.value('qgis/parallelLayerLoading', True, bool)
+        for parallel in (False, True):
+            settings.setValue('qgis/parallelLayerLoading', parallel)
+            p2 = QgsProject()
+            self.assertTrue(p2.read(project_path))
+            layers = p2.mapLayers()
+            self.assertEqual(len(layers), 6)
+            for layer in layers.values():
+                self.assertTrue(layer.isValid())
+                # PostgreSQL providers are never preloaded on the thread pool,
+                # they are always created on the thread reading the project
+                self.assertEqual(layer.dataProvider().thread(), QThread.currentThread())
+                self.assertEqual(layer.featureCount(), self.vl.featureCount() if layer.name() != 'polys' else self.poly_vl.featureCount())
+        settings.setValue('qgis/parallelLayerLoading', previous)
+
+    def testIteratorPrefetch(self):
+        """Test iterators while the next batch of features is prefetched in the background"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.prefetch_data CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.prefetch_data ( pk INTEGER NOT NULL PRIMARY KEY, name TEXT, geom public.geometry(Point, 4326))')
+        self.execSQLCommand("INSERT INTO qgis_test.prefetch_data SELECT i, 'name' || i, ST_SetSRID(ST_MakePoint(i, -i), 4326) FROM generate_series(1, 5000) i")
+        vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POINT table="qgis_test"."prefetch_data" (geom) sql=', 'test', 'postgres')
+        self.assertTrue(vl.isValid())
+        expected = list(range(1, 5001))
+
+        # batches are returned in cursor order
+        request = QgsFeatureRequest().addOrderBy('pk')
+        self.assertEqual([f['pk'] for f in vl.getFeatures(request)], expected)
+        request = QgsFeatureRequest().addOrderBy('pk', False)
+        self.assertEqual([f['pk'] for f in vl.getFeatures(request)], list(reversed(expected)))
+        features = [f for f in vl.getFeatures(QgsFeatureRequest().addOrderBy('pk'))]
+        self.assertEqual([f['name'] for f in features], ['name{}'.format(i) for i in expected])
+        self.assertEqual([f.geometry().asPoint().x() for f in features], [float(i) for i in expected])
+
+        # rewind discards the prefetched batch
+        it = vl.getFeatures(QgsFeatureRequest().addOrderBy('pk'))
+        f = QgsFeature()
+        for i in range(10):
+            self.assertTrue(it.nextFeature(f))
+            self.assertEqual(f['pk'], i + 1)
+        self.assertTrue(it.rewind())
+        self.assertEqual([f['pk'] for f in it], expected)
+        self.assertTrue(it.rewind())
+        self.assertEqual([f['pk'] for f in it], expected)
+
+        # close while a batch is prefetched, then reuse the connection
+        it = vl.getFeatures(QgsFeatureRequest().addOrderBy('pk'))
+        for i in range(10):
+            self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.close())
+        self.assertFalse(it.nextFeature(f))
+        self.assertEqual(vl.featureCount(), 5000)
+        self.assertEqual([f['pk'] for f in vl.getFeatures(QgsFeatureRequest().addOrderBy('pk').setLimit(3))], [1, 2, 3])
+
+        # several iterators prefetching at once don't mix their features
+        it1 = vl.getFeatures(QgsFeatureRequest().addOrderBy('pk'))
+        it2 = vl.getFeatures(QgsFeatureRequest().addOrderBy('pk', False))
+        pks1 = []
+        pks2 = []
+        f1 = QgsFeature()
+        f2 = QgsFeature()
+        while it1.nextFeature(f1):
+            pks1.append(f1['pk'])
+            if it2.nextFeature(f2):
+                pks2.append(f2['pk'])
+        while it2.nextFeature(f2):
+            pks2.append(f2['pk'])
+        self.assertEqual(pks1, expected)
+        self.assertEqual(pks2, list(reversed(expected)))
+
+        # destroying an iterator with a pending prefetch
+        it = vl.getFeatures()
+        self.assertTrue(it.nextFeature(f))
+        del it
+        self.assertEqual(len([f for f in vl.getFeatures()]), 5000)
+
 
 class TestPyQgsPostgresProviderCompoundKey(unittest.TestCase, ProviderTestCase):
 
@@ -802,6 +802,48 @@ class TestQgsVirtualLayerProvider(unittest.TestCase, ProviderTestCase):
 
         QgsProject.instance().removeMapLayers([v1.id(), v2.id(), v3.id()])
 
+    def test_constraints(self):
+        ml1 = QgsVectorLayer("Point?srid=EPSG:4326&field=a:int&field=b:string", "t1", "memory")
+        ml2 = QgsVectorLayer("Point?srid=EPSG:4326&field=a:int&field=c:string", "t2", "memory")
+        features1 = []
+        features2 = []
+        for i in range(100):
+            f = QgsFeature(ml1.fields())
+            f.setAttributes([i % 10, 'b{}'.format(i % 3)])
+            f.setGeometry(QgsGeometry.fromWkt('POINT({} {})'.format(i % 10, i // 10)))
+            features1.append(f)
+            f = QgsFeature(ml2.fields())
+            f.setAttributes([i, None if i % 7 == 0 else 'c{}'.format(i)])
+            f.setGeometry(QgsGeometry.fromWkt('POINT({} {})'.format(i // 10, i % 10)))
+            features2.append(f)
+        ml1.dataProvider().addFeatures(features1)
+        ml2.dataProvider().addFeatures(features2)
+        QgsProject.instance().addMapLayers([ml1, ml2])
+
+        def query(sql):
+            df = QgsVirtualLayerDefinition()
+            df.setQuery(sql)
+            vl = QgsVectorLayer(df.toString(), "vl", "virtual")
+            self.assertTrue(vl.isValid(), sql)
+            return sorted(f.attributes() for f in vl.getFeatures())
+
+        # several comparisons pushed down together
+        self.assertEqual(query("SELECT a, b FROM t1 WHERE a >= 2 AND a < 5 AND b = 'b1'"),
+                         sorted([i % 10, 'b1'] for i in range(100) if 2 <= i % 10 < 5 and i % 3 == 1))
+        self.assertEqual(query("SELECT a FROM t2 WHERE c = NULL"), [])
+
+        # join on a column, looked up in the inner table for each feature of the outer table
+        self.assertEqual(query("SELECT t1.a AS a1, t2.a AS a2 FROM t1 CROSS JOIN t2 ON t2.a = t1.a WHERE t1.b = 'b0'"),
+                         sorted([i % 10, i % 10] for i in range(100) if i % 3 == 0))
+
+        # spatial predicates
+        self.assertEqual(query("SELECT a FROM t1 WHERE ST_Intersects(t1.geometry, BuildMbr(1.5, 1.5, 3.5, 2.5, 4326))"),
+                         [[2], [3]])
+        self.assertEqual(query("SELECT t1.a AS a1, t2.a AS a2 FROM t1, t2 WHERE ST_Intersects(t1.geometry, t2.geometry) AND t1.a = 3"),
+                         sorted([3, (i // 10) + 10 * 3] for i in range(100) if i % 10 == 3))
+
+        QgsProject.instance().removeMapLayers([ml1.id(), ml2.id()])
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -12,10 +12,12 @@ __copyright__ = 'Copyright 2016, Even Rouault'
 # This will get replaced with a git SHA1 when you do a git archive
 __revision__ = '$Format:%H$'
 
+import glob
 import hashlib
 import os
 import tempfile
 import shutil
+import sqlite3
 
 # Needed on Qt 5 so that the serialization of XML is consistent among all executions
 os.environ['QT_HASH_SEED'] = '1'
@@ -1185,6 +1187,145 @@ class TestPyQgsWFSProvider(unittest.TestCase, ProviderTestCase):
         values = [f['ogc_fid'] for f in vl.getFeatures(request)]
         self.assertEqual(values, [101])
 
+    def testPersistentCache(self):
+        """Test reuse of the persistent cache across sessions"""
+
+        endpoint = self.__class__.basetestpath + '/fake_qgis_http_endpoint_persistent_cache'
+        cache_directory = tempfile.mkdtemp()
+        QgsSettings().setValue('cache/directory', cache_directory)
+
+        with open(sanitize(endpoint, '?SERVICE=WFS?REQUEST=GetCapabilities?ACCEPTVERSIONS=2.0.0,1.1.0,1.0.0'), 'wb') as f:
+            f.write("""
+<wfs:WFS_Capabilities version="1.1.0" xmlns="http://www.opengis.net/wfs" xmlns:wfs="http://www.opengis.net/wfs" xmlns:ows="http://www.opengis.net/ows" xmlns:gml="http://schemas.opengis.net/gml">
+  <FeatureTypeList>
+    <FeatureType>
+      <Name>my:typename</Name>
+      <Title>Title</Title>
+      <Abstract>Abstract</Abstract>
+      <DefaultCRS>urn:ogc:def:crs:EPSG::4326</DefaultCRS>
+      <ows:WGS84BoundingBox>
+        <ows:LowerCorner>-80 60</ows:LowerCorner>
+        <ows:UpperCorner>-50 80</ows:UpperCorner>
+      </ows:WGS84BoundingBox>
+    </FeatureType>
+  </FeatureTypeList>
+</wfs:WFS_Capabilities>""".encode('UTF-8'))
+
+        with open(sanitize(endpoint, '?SERVICE=WFS&REQUEST=DescribeFeatureType&VERSION=1.1.0&TYPENAME=my:typename'), 'wb') as f:
+            f.write("""
+<xsd:schema xmlns:my="http://my" xmlns:gml="http://www.opengis.net/gml" xmlns:xsd="http://www.w3.org/2001/XMLSchema" elementFormDefault="qualified" targetNamespace="http://my">
+  <xsd:import namespace="http://www.opengis.net/gml"/>
+  <xsd:complexType name="typenameType">
+    <xsd:complexContent>
+      <xsd:extension base="gml:AbstractFeatureType">
+        <xsd:sequence>
+          <xsd:element maxOccurs="1" minOccurs="0" name="id" nillable="true" type="xsd:int"/>
+          <xsd:element maxOccurs="1" minOccurs="0" name="geometryProperty" nillable="true" type="gml:PointPropertyType"/>
+        </xsd:sequence>
+      </xsd:extension>
+    </xsd:complexContent>
+  </xsd:complexType>
+  <xsd:element name="typename" substitutionGroup="gml:_Feature" type="my:typenameType"/>
+</xsd:schema>
+""".encode('UTF-8'))
+
+        def feature_collection(features):
+            members = ''
+            for (fid, lat, lon) in features:
+                members += """
+    <my:typename gml:id="typename.%d">
+      <my:geometryProperty><gml:Point srsName="urn:ogc:def:crs:EPSG::4326"><gml:pos>%d %d</gml:pos></gml:Point></my:geometryProperty>
+      <my:id>%d</my:id>
+    </my:typename>""" % (fid, lat, lon, fid)
+            return ("""
+<wfs:FeatureCollection xmlns:wfs="http://www.opengis.net/wfs"
+                       xmlns:gml="http://www.opengis.net/gml"
+                       xmlns:my="http://my">
+  <gml:featureMembers>%s
+  </gml:featureMembers>
+</wfs:FeatureCollection>""" % members).encode('UTF-8')
+
+        uri = "url='http://" + endpoint + "' typename='my:typename' restrictToRequestBBOX=1 persistentCache=1"
+        south_url = sanitize(endpoint, '?SERVICE=WFS&REQUEST=GetFeature&VERSION=1.1.0&TYPENAME=my:typename&SRSNAME=urn:ogc:def:crs:EPSG::4326&BBOX=60,-70,70,-60,urn:ogc:def:crs:EPSG::4326')
+        with open(south_url, 'wb') as f:
+            f.write(feature_collection([(1, 65, -65)]))
+
+        vl = QgsVectorLayer(uri, 'test', 'WFS')
+        assert vl.isValid()
+        request = QgsFeatureRequest().setFilterRect(QgsRectangle(-70, 60, -60, 70))
+        values = [f['id'] for f in vl.getFeatures(request)]
+        self.assertEqual(values, [1])
+        del vl
+
+        # A new session is served from the cache, without querying the server
+        os.unlink(south_url)
+        vl = QgsVectorLayer(uri, 'test', 'WFS')
+        assert vl.isValid()
+        values = [f['id'] for f in vl.getFeatures(request)]
+        self.assertEqual(values, [1])
+
+        # Only the area not covered by the cache is requested
+        north_url = sanitize(endpoint, '?SERVICE=WFS&REQUEST=GetFeature&VERSION=1.1.0&TYPENAME=my:typename&SRSNAME=urn:ogc:def:crs:EPSG::4326&BBOX=70,-70,80,-60,urn:ogc:def:crs:EPSG::4326')
+        with open(north_url, 'wb') as f:
+            f.write(feature_collection([(2, 75, -65)]))
+
+        request = QgsFeatureRequest().setFilterRect(QgsRectangle(-70, 60, -60, 80))
+        values = sorted([f['id'] for f in vl.getFeatures(request)])
+        self.assertEqual(values, [1, 2])
+        del vl
+
+        os.unlink(north_url)
+        vl = QgsVectorLayer(uri, 'test', 'WFS')
+        assert vl.isValid()
+        values = sorted([f['id'] for f in vl.getFeatures(request)])
+        self.assertEqual(values, [1, 2])
+
+        # Reloading the layer discards the cache
+        with open(sanitize(endpoint, '?SERVICE=WFS&REQUEST=GetFeature&VERSION=1.1.0&TYPENAME=my:typename&SRSNAME=urn:ogc:def:crs:EPSG::4326&BBOX=60,-70,80,-60,urn:ogc:def:crs:EPSG::4326'), 'wb') as f:
+            f.write(feature_collection([(3, 75, -65)]))
+
+        vl.dataProvider().reloadData()
+        values = [f['id'] for f in vl.getFeatures(request)]
+        self.assertEqual(values, [3])
+        del vl
+
+        # An expired cache is discarded
+        with open(sanitize(endpoint, '?SERVICE=WFS&REQUEST=GetFeature&VERSION=1.1.0&TYPENAME=my:typename&SRSNAME=urn:ogc:def:crs:EPSG::4326&BBOX=60,-70,80,-60,urn:ogc:def:crs:EPSG::4326'), 'wb') as f:
+            f.write(feature_collection([(4, 75, -65)]))
+
+        persistent_directory = os.path.join(cache_directory, 'wfsprovider', 'persistent')
+        for filename in glob.glob(os.path.join(persistent_directory, 'wfs_cache_*.sqlite')):
+            conn = sqlite3.connect(filename)
+            conn.execute("UPDATE __qgis_cache_metadata SET value = '%d' WHERE key = 'creation_time'" % (QDateTime.currentMSecsSinceEpoch() - 2 * 24 * 3600 * 1000))
+            conn.commit()
+            conn.close()
+
+        QgsSettings().setValue('wfs/persistent_cache_max_age_days', 1)
+        vl = QgsVectorLayer(uri, 'test', 'WFS')
+        assert vl.isValid()
+        values = [f['id'] for f in vl.getFeatures(request)]
+        self.assertEqual(values, [4])
+        del vl
+        QgsSettings().remove('wfs/persistent_cache_max_age_days')
+
+        # The least recently used caches are removed when the directory is too large
+        stale_cache = os.path.join(persistent_directory, 'wfs_cache_stale.sqlite')
+        with open(stale_cache, 'wb') as f:
+            f.write(b'\0' * (2 * 1024 * 1024))
+        os.utime(stale_cache, (0, 0))
+
+        QgsSettings().setValue('wfs/persistent_cache_max_size_mb', 1)
+        vl = QgsVectorLayer(uri, 'test', 'WFS')
+        assert vl.isValid()
+        values = [f['id'] for f in vl.getFeatures(request)]
+        self.assertEqual(values, [4])
+        self.assertFalse(os.path.exists(stale_cache))
+        del vl
+        QgsSettings().remove('wfs/persistent_cache_max_size_mb')
+
+        QgsSettings().remove('cache/directory')
+        shutil.rmtree(cache_directory, True)
+
     def testWFS20TruncatedResponse(self):
         """Test WFS 2.0 truncatedResponse"""
 
@@ -151,6 +151,47 @@ class TestQgsAggregateCalculator(unittest.TestCase):
             val, ok = agg.calculate(t, 'flddbl')
             self.assertFalse(ok)
 
+    def testNumericManyValues(self):
+        """ Test calculation of numeric aggregates summarized in several parts"""
+
+        layer = QgsVectorLayer("Point?field=fldint:integer", "layer", "memory")
+        pr = layer.dataProvider()
+
+        # enough values for several batches, each split across workers
+        int_values = [None if i % 97 == 0 else (i * 7919) % 1000 for i in range(25000)]
+        features = []
+        for v in int_values:
+            f = QgsFeature()
+            f.setFields(layer.fields())
+            f.setAttributes([v])
+            features.append(f)
+        assert pr.addFeatures(features)
+
+        values = sorted([v for v in int_values if v is not None])
+        count = len(values)
+        mean = float(sum(values)) / count
+        stdev = (sum([(v - mean) ** 2 for v in values]) / count) ** 0.5
+        median = (values[count // 2 - 1] + values[count // 2]) / 2.0 if count % 2 == 0 else values[count // 2]
+
+        tests = [[QgsAggregateCalculator.Count, 'fldint', count],
+                 [QgsAggregateCalculator.CountMissing, 'fldint', len(int_values) - count],
+                 [QgsAggregateCalculator.Sum, 'fldint', sum(values)],
+                 [QgsAggregateCalculator.Mean, 'fldint', mean],
+                 [QgsAggregateCalculator.StDev, 'fldint', stdev],
+                 [QgsAggregateCalculator.Min, 'fldint', values[0]],
+                 [QgsAggregateCalculator.Max, 'fldint', values[-1]],
+                 [QgsAggregateCalculator.Median, 'fldint', median],
+                 [QgsAggregateCalculator.CountDistinct, 'fldint', len(set(values))],
+                 [QgsAggregateCalculator.Sum, 'fldint * 2', 2 * sum(values)],
+                 [QgsAggregateCalculator.Median, 'fldint * 2', 2 * median],
+                 ]
+
+        agg = QgsAggregateCalculator(layer)
+        for t in tests:
+            val, ok = agg.calculate(t[0], t[1])
+            self.assertTrue(ok)
+            self.assertAlmostEqual(val, t[2], 3)
+
     def testString(self):
         """ Test calculation of aggregates on string fields"""
 
@@ -183,6 +183,27 @@ class PyQgsDateTimeStatisticalSummary(unittest.TestCase):
                      'not a date'])
         self.assertEqual(s.countMissing(), 2)
 
+    def testMerge(self):
+        s = QgsDateTimeStatisticalSummary()
+        s.calculate([QDate(2015, 3, 4), QDate(2019, 12, 28), QDate()])
+        s2 = QgsDateTimeStatisticalSummary()
+        s2.calculate([QDate(1998, 1, 2), QDate(2015, 3, 4), NULL])
+        s.merge(s2)
+        s.finalize()
+        self.assertEqual(s.count(), 6)
+        self.assertEqual(s.countDistinct(), 4)
+        self.assertEqual(s.countMissing(), 2)
+        self.assertEqual(s.min(), QDateTime(QDate(1998, 1, 2), QTime()))
+        self.assertEqual(s.max(), QDateTime(QDate(2019, 12, 28), QTime()))
+
+        # merging into an empty summary
+        s3 = QgsDateTimeStatisticalSummary()
+        s3.merge(s2)
+        s3.finalize()
+        self.assertEqual(s3.count(), 3)
+        self.assertEqual(s3.min(), QDateTime(QDate(1998, 1, 2), QTime()))
+        self.assertEqual(s3.max(), QDateTime(QDate(2015, 3, 4), QTime()))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -805,6 +805,61 @@ class TestQgsDelimitedTextProviderOther(unittest.TestCase):
         requests = None
         self.runTest(filename, requests, **params)
 
+    def test_041_large_file(self):
+        # Large enough file to be scanned in parallel chunks, including multi-line
+        # records and blank lines which may straddle chunk boundaries
+        (filehandle, filename) = tempfile.mkstemp(suffix='.csv')
+        if os.name == "nt":
+            filename = filename.replace("\\", "/")
+        features = {}
+        multiline = []
+        line = 1
+        with os.fdopen(filehandle, "w") as f:
+            f.write("id,name,x,y\n")
+            for i in range(250000):
+                x = i % 360 - 180
+                y = i % 180 - 90
+                if i % 997 == 0:
+                    f.write("\n\n")
+                    line += 2
+                if i % 1009 == 0:
+                    f.write('{},"multi\nline\nname",{},{}\n'.format(i, x, y))
+                    features[line + 1] = (x, y)
+                    multiline.append(line + 1)
+                    line += 3
+                elif i % 1013 == 0:
+                    f.write('{},bad,x,y\n'.format(i))
+                    line += 1
+                else:
+                    f.write('{},name {} with some padding text,{},{}\n'.format(i, i, x, y))
+                    features[line + 1] = (x, y)
+                    line += 1
+        # several chunks, as chunks are capped at 4 MB
+        self.assertGreater(os.path.getsize(filename), 8 * 1024 * 1024)
+
+        url = MyUrl.fromLocalFile(filename)
+        url.addQueryItem("type", "csv")
+        url.addQueryItem("xField", "x")
+        url.addQueryItem("yField", "y")
+        url.addQueryItem("spatialIndex", "yes")
+        url.addQueryItem("watchFile", "no")
+        layer = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer.isValid())
+        self.assertEqual(layer.featureCount(), len(features))
+        self.assertEqual(layer.extent(), QgsRectangle(-180, -90, 179, 89))
+        self.assertEqual(layer.fields().field('id').typeName(), 'integer')
+        self.assertEqual(sorted(f.id() for f in layer.getFeatures()), sorted(features.keys()))
+
+        # multi-line records are read in full
+        for f in layer.getFeatures(QgsFeatureRequest().setFilterFids(multiline)):
+            self.assertEqual(f['name'], 'multi\nline\nname')
+
+        # features are found through the spatial index
+        request = QgsFeatureRequest().setFilterRect(QgsRectangle(-10, -10, 10, 10))
+        expected = set(fid for fid, (x, y) in features.items() if -10 <= x <= 10 and -10 <= y <= 10)
+        self.assertEqual(set(f.id() for f in layer.getFeatures(request)), expected)
+        del layer
+        os.remove(filename)
 
 if __name__ == '__main__':
     unittest.main()
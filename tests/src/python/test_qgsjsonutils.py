@@ -31,7 +31,7 @@ from qgis.core import (QgsJsonUtils,
                        QgsRelation,
                        QgsEditorWidgetSetup
                        )
-from qgis.PyQt.QtCore import QVariant, QTextCodec
+from qgis.PyQt.QtCore import QVariant, QTextCodec, QBuffer, QIODevice
 
 start_app()
 codec = QTextCodec.codecForName("System")
@@ -676,6 +676,68 @@ class TestQgsJsonUtils(unittest.TestCase):
 ]}"""
         self.assertEqual(exporter.exportFeatures([feature, feature2]), expected)
 
+    def testWriteFeatures(self):
+        """ Test writing features and feature collections to a device """
+
+        layer = QgsVectorLayer("LineString?crs=epsg:4326&field=name:string&field=population:int",
+                               "lines", "memory")
+        features = []
+        for i in range(3):
+            feature = QgsFeature(layer.fields())
+            feature.setGeometry(QgsGeometry.fromWkt('LineString({} 1.25, 2.123456789 -3, -0.00001 4e8)'.format(i)))
+            feature.setAttributes(['n\u00e4me "{}"/\n'.format(i), i * 1000])
+            features.append(feature)
+        self.assertTrue(layer.dataProvider().addFeatures(features))
+        features = [f for f in layer.getFeatures()]
+
+        exporter = QgsJsonExporter(layer)
+
+        # a single feature is identical to exportFeature()
+        buffer = QBuffer()
+        buffer.open(QIODevice.WriteOnly)
+        self.assertTrue(exporter.writeFeature(buffer, features[0], {'extra': 5}, 'fid'))
+        self.assertEqual(bytes(buffer.data()).decode('utf-8'), exporter.exportFeature(features[0], {'extra': 5}, 'fid'))
+
+        # feature collections, from a list or streamed from an iterator, are identical to exportFeatures()
+        buffer = QBuffer()
+        buffer.open(QIODevice.WriteOnly)
+        self.assertTrue(exporter.writeFeatures(buffer, features))
+        self.assertEqual(bytes(buffer.data()).decode('utf-8'), exporter.exportFeatures(features))
+
+        buffer = QBuffer()
+        buffer.open(QIODevice.WriteOnly)
+        self.assertTrue(exporter.writeFeatures(buffer, layer.getFeatures()))
+        self.assertEqual(bytes(buffer.data()).decode('utf-8'), exporter.exportFeatures(features))
+
+        # empty collection
+        buffer = QBuffer()
+        buffer.open(QIODevice.WriteOnly)
+        self.assertTrue(exporter.writeFeatures(buffer, []))
+        self.assertEqual(bytes(buffer.data()).decode('utf-8'), exporter.exportFeatures([]))
+
+        # writing to a device which is not open fails
+        self.assertFalse(exporter.writeFeatures(QBuffer(), features))
+
+    def testWriteGeometryTypes(self):
+        """ Test that geometries are written as exportToGeoJSON() does """
+
+        exporter = QgsJsonExporter()
+        exporter.setIncludeAttributes(False)
+        for precision in [0, 3, 6, 17]:
+            exporter.setPrecision(precision)
+            for wkt in ['Point(1.5 -2.25)',
+                        'LineString(0 0, 1.0005 -1.0005, 123456.7891234 0.1)',
+                        'Polygon((0 0, 10 0, 10 10, 0 0),(1 1, 2 1, 2 2, 1 1))',
+                        'MultiPoint((0 0),(1.123456789 2))',
+                        'MultiLineString((0 0, 1 1),(2 2, 3 3.333333333))',
+                        'MultiPolygon(((0 0, 1 0, 1 1, 0 0)),((5 5, 6 5, 6 6, 5 5),(5.1 5.1, 5.2 5.1, 5.2 5.2, 5.1 5.1)))',
+                        'CircularString(0 0, 1 1, 2 0)',
+                        'PointZ(1 2 3)']:
+                feature = QgsFeature(5)
+                geom = QgsGeometry.fromWkt(wkt)
+                feature.setGeometry(geom)
+                self.assertIn('\n   {}'.format(geom.exportToGeoJSON(precision)), exporter.exportFeature(feature))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -102,6 +102,22 @@ class PyQgsStringStatisticalSummary(unittest.TestCase):
         self.assertEqual(s.min(), '9')
         self.assertEqual(s.max(), 'eeee')
 
+    def testMerge(self):
+        s = QgsStringStatisticalSummary()
+        s.calculate(['cc', 'aaaa', '', 'eeee'])
+        s2 = QgsStringStatisticalSummary()
+        s2.calculate(['bbbbbbbb', 'aaaa', '', 'dddd', 'eeee'])
+        s.merge(s2)
+        s.finalize()
+        self.assertEqual(s.count(), 9)
+        self.assertEqual(s.countDistinct(), 6)
+        self.assertEqual(s.countMissing(), 2)
+        self.assertEqual(s.min(), 'aaaa')
+        self.assertEqual(s.max(), 'eeee')
+        self.assertEqual(s.minLength(), 0)
+        self.assertEqual(s.maxLength(), 8)
+        self.assertAlmostEqual(s.meanLength(), 3.3333333, 3)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -479,6 +479,24 @@ INSERT INTO qgis_test.boolean_table VALUES
 (2, FALSE),
 (3, NULL);
 
+CREATE TABLE qgis_test.binary_types
+(
+  id int PRIMARY KEY,
+  int2_field int2,
+  int8_field int8,
+  float4_field float4,
+  numeric_field numeric,
+  date_field date,
+  datetime_field timestamp without time zone,
+  uuid_field uuid,
+  text_array_field text[]
+);
+
+INSERT INTO qgis_test.binary_types VALUES
+(1, -5, 9007199254740993, 1.5, 12345.6789, '1999-12-31', '1969-07-20 20:17:40.123', 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11', '{"a", NULL, "b,c"}'),
+(2, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL),
+(3, NULL, NULL, 0.1, NULL, NULL, NULL, NULL, '{NULL}');
+
 -----------------------------
 -- Table for constraint tests
 --